@@ -458,8 +458,8 @@ class RqlQuery(object):
 
     # NB: Can't overload __len__ because Python doesn't
     #     allow us to return a non-integer
-    def count(self, *args):
-        return Count(self, *[func_wrap(arg) for arg in args])
+    def count(self, *args, **kwargs):
+        return Count(self, *[func_wrap(arg) for arg in args], **kwargs)
 
     def union(self, *args, **kwargs):
         func_kwargs = {}
@@ -50,7 +50,14 @@ module RethinkDB
       :min => -1,
       :max => -1,
       :changes => -1,
-      :wait => 0
+      :wait => 0,
+      :count => -1
+    }
+    # Methods that can also take a Hash as a regular argument (like
+    # `count`, which can count objects) only treat it as their optargs
+    # if all of its keys are among these.
+    @@optarg_names = {
+      :count => [:distinct, :approximate]
     }
     @@method_aliases = {
       :lt => :<,
@@ -104,7 +111,10 @@ module RethinkDB
           # Any time one of these operations is changed to support a
           # hash argument, we'll have to remember to fix
           # @@optarg_offsets, otherwise.
-          optargs = a.delete_at(opt_offset) if a[opt_offset].is_a?(Hash)
+          names = @@optarg_names[termtype.downcase]
+          optargs = a.delete_at(opt_offset) if a[opt_offset].is_a?(Hash) &&
+            (!names || (!a[opt_offset].empty? &&
+                        a[opt_offset].keys.all? {|k| names.include?(k.to_sym)}))
         end
 
         args = ((@body != RQL) ? [self] : []) + a + (b ? [new_func(&b)] : [])
@@ -0,0 +1,5 @@
+
+#include <boost/bind.hpp>
+int main(){ return 0; }
+
+
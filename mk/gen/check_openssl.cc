@@ -0,0 +1,9 @@
+
+
+#include <openssl/evp.h>
+#include <openssl/crypto.h>
+#include <openssl/ssl.h>
+#include <openssl/bn.h>
+int main(){ return 0; }
+
+
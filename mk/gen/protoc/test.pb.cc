@@ -0,0 +1,142 @@
+// Generated by the protocol buffer compiler.  DO NOT EDIT!
+// source: mk/gen/protoc/test.proto
+
+#include "mk/gen/protoc/test.pb.h"
+
+#include <algorithm>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/extension_set.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/generated_message_reflection.h>
+#include <google/protobuf/reflection_ops.h>
+#include <google/protobuf/wire_format.h>
+// @@protoc_insertion_point(includes)
+#include <google/protobuf/port_def.inc>
+
+PROTOBUF_PRAGMA_INIT_SEG
+
+namespace _pb = ::PROTOBUF_NAMESPACE_ID;
+namespace _pbi = _pb::internal;
+
+PROTOBUF_CONSTEXPR Foo::Foo(
+    ::_pbi::ConstantInitialized) {}
+struct FooDefaultTypeInternal {
+  PROTOBUF_CONSTEXPR FooDefaultTypeInternal()
+      : _instance(::_pbi::ConstantInitialized{}) {}
+  ~FooDefaultTypeInternal() {}
+  union {
+    Foo _instance;
+  };
+};
+PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 FooDefaultTypeInternal _Foo_default_instance_;
+static ::_pb::Metadata file_level_metadata_mk_2fgen_2fprotoc_2ftest_2eproto[1];
+static const ::_pb::EnumDescriptor* file_level_enum_descriptors_mk_2fgen_2fprotoc_2ftest_2eproto[1];
+static constexpr ::_pb::ServiceDescriptor const** file_level_service_descriptors_mk_2fgen_2fprotoc_2ftest_2eproto = nullptr;
+
+const uint32_t TableStruct_mk_2fgen_2fprotoc_2ftest_2eproto::offsets[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
+  ~0u,  // no _has_bits_
+  PROTOBUF_FIELD_OFFSET(::Foo, _internal_metadata_),
+  ~0u,  // no _extensions_
+  ~0u,  // no _oneof_case_
+  ~0u,  // no _weak_field_map_
+  ~0u,  // no _inlined_string_donated_
+};
+static const ::_pbi::MigrationSchema schemas[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
+  { 0, -1, -1, sizeof(::Foo)},
+};
+
+static const ::_pb::Message* const file_default_instances[] = {
+  &::_Foo_default_instance_._instance,
+};
+
+const char descriptor_table_protodef_mk_2fgen_2fprotoc_2ftest_2eproto[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) =
+  "\n\030mk/gen/protoc/test.proto\"\025\n\003Foo\"\016\n\003Bar"
+  "\022\007\n\003Baz\020\001"
+  ;
+static ::_pbi::once_flag descriptor_table_mk_2fgen_2fprotoc_2ftest_2eproto_once;
+const ::_pbi::DescriptorTable descriptor_table_mk_2fgen_2fprotoc_2ftest_2eproto = {
+    false, false, 49, descriptor_table_protodef_mk_2fgen_2fprotoc_2ftest_2eproto,
+    "mk/gen/protoc/test.proto",
+    &descriptor_table_mk_2fgen_2fprotoc_2ftest_2eproto_once, nullptr, 0, 1,
+    schemas, file_default_instances, TableStruct_mk_2fgen_2fprotoc_2ftest_2eproto::offsets,
+    file_level_metadata_mk_2fgen_2fprotoc_2ftest_2eproto, file_level_enum_descriptors_mk_2fgen_2fprotoc_2ftest_2eproto,
+    file_level_service_descriptors_mk_2fgen_2fprotoc_2ftest_2eproto,
+};
+PROTOBUF_ATTRIBUTE_WEAK const ::_pbi::DescriptorTable* descriptor_table_mk_2fgen_2fprotoc_2ftest_2eproto_getter() {
+  return &descriptor_table_mk_2fgen_2fprotoc_2ftest_2eproto;
+}
+
+// Force running AddDescriptors() at dynamic initialization time.
+PROTOBUF_ATTRIBUTE_INIT_PRIORITY2 static ::_pbi::AddDescriptorsRunner dynamic_init_dummy_mk_2fgen_2fprotoc_2ftest_2eproto(&descriptor_table_mk_2fgen_2fprotoc_2ftest_2eproto);
+const ::PROTOBUF_NAMESPACE_ID::EnumDescriptor* Foo_Bar_descriptor() {
+  ::PROTOBUF_NAMESPACE_ID::internal::AssignDescriptors(&descriptor_table_mk_2fgen_2fprotoc_2ftest_2eproto);
+  return file_level_enum_descriptors_mk_2fgen_2fprotoc_2ftest_2eproto[0];
+}
+bool Foo_Bar_IsValid(int value) {
+  switch (value) {
+    case 1:
+      return true;
+    default:
+      return false;
+  }
+}
+
+#if (__cplusplus < 201703) && (!defined(_MSC_VER) || (_MSC_VER >= 1900 && _MSC_VER < 1912))
+constexpr Foo_Bar Foo::Baz;
+constexpr Foo_Bar Foo::Bar_MIN;
+constexpr Foo_Bar Foo::Bar_MAX;
+constexpr int Foo::Bar_ARRAYSIZE;
+#endif  // (__cplusplus < 201703) && (!defined(_MSC_VER) || (_MSC_VER >= 1900 && _MSC_VER < 1912))
+
+// ===================================================================
+
+class Foo::_Internal {
+ public:
+};
+
+Foo::Foo(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                         bool is_message_owned)
+  : ::PROTOBUF_NAMESPACE_ID::internal::ZeroFieldsBase(arena, is_message_owned) {
+  // @@protoc_insertion_point(arena_constructor:Foo)
+}
+Foo::Foo(const Foo& from)
+  : ::PROTOBUF_NAMESPACE_ID::internal::ZeroFieldsBase() {
+  Foo* const _this = this; (void)_this;
+  _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+  // @@protoc_insertion_point(copy_constructor:Foo)
+}
+
+
+
+
+
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData Foo::_class_data_ = {
+    ::PROTOBUF_NAMESPACE_ID::internal::ZeroFieldsBase::CopyImpl,
+    ::PROTOBUF_NAMESPACE_ID::internal::ZeroFieldsBase::MergeImpl,
+};
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*Foo::GetClassData() const { return &_class_data_; }
+
+
+
+
+
+
+
+::PROTOBUF_NAMESPACE_ID::Metadata Foo::GetMetadata() const {
+  return ::_pbi::AssignDescriptors(
+      &descriptor_table_mk_2fgen_2fprotoc_2ftest_2eproto_getter, &descriptor_table_mk_2fgen_2fprotoc_2ftest_2eproto_once,
+      file_level_metadata_mk_2fgen_2fprotoc_2ftest_2eproto[0]);
+}
+
+// @@protoc_insertion_point(namespace_scope)
+PROTOBUF_NAMESPACE_OPEN
+template<> PROTOBUF_NOINLINE ::Foo*
+Arena::CreateMaybeMessage< ::Foo >(Arena* arena) {
+  return Arena::CreateMessageInternal< ::Foo >(arena);
+}
+PROTOBUF_NAMESPACE_CLOSE
+
+// @@protoc_insertion_point(global_scope)
+#include <google/protobuf/port_undef.inc>
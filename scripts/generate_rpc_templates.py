@@ -28,6 +28,21 @@ def generate_async_message_template(nargs):
     print
     print "template<%s>" % csep("class arg#_t")
     print "class %s {" % mailbox_t_str
+    print "    class local_message_t : public mailbox_local_message_t {"
+    print "    public:"
+    if nargs == 0:
+        print "        local_message_t() { }"
+    else:
+        if nargs == 1:
+            print "        explicit local_message_t(%s) :" % csep("const arg#_t &_arg#")
+        else:
+            print "        local_message_t(%s) :" % csep("const arg#_t &_arg#")
+        print "            %s" % csep("arg#(_arg#)")
+        print "        { }"
+    for i in xrange(nargs):
+        print "        arg%d_t arg%d;" % (i, i)
+    print "    };"
+    print
     print "    class write_impl_t : public mailbox_write_callback_t {"
     if nargs == 0:
         print "    public:"
@@ -51,6 +66,10 @@ def generate_async_message_template(nargs):
     for i in xrange(nargs):
         print "            serialize<cluster_version_t::CLUSTER>(wm, arg%d);" % i
     print "        }"
+    print "        scoped_ptr_t<mailbox_local_message_t> copy_for_local() {"
+    print "            return scoped_ptr_t<mailbox_local_message_t>("
+    print "                new local_message_t(%s));" % csep("arg#")
+    print "        }"
     print "#ifdef ENABLE_MESSAGE_PROFILER"
     print "        const char *message_profiler_tag() const {"
     if nargs == 0:
@@ -77,6 +96,16 @@ def generate_async_message_template(nargs):
         print "            if (bad(res)) { throw fake_archive_exc_t(); }"
     print "            parent->fun(interruptor%s);" % cpre("std::move(arg#)")
     print "        }"
+    if nargs == 0:
+        print "        void read_local(UNUSED mailbox_local_message_t *message,"
+        print "                        signal_t *interruptor) {"
+        print "            parent->fun(interruptor);"
+    else:
+        print "        void read_local(mailbox_local_message_t *message,"
+        print "                        signal_t *interruptor) {"
+        print "            local_message_t *m = static_cast<local_message_t *>(message);"
+        print "            parent->fun(interruptor%s);" % cpre("std::move(m->arg#)")
+    print "        }"
     print "    private:"
     print "        %s *parent;" % mailbox_t_str
     print "    };"
@@ -103,10 +132,10 @@ def generate_async_message_template(nargs):
     print
     print "private:"
     if nargs == 0:
-        print "    friend void send(mailbox_manager_t*, address_t);"
+        print "    friend void send(mailbox_manager_t*, message_lane_t, address_t);"
     else:
         print "    template<%s>" % csep("class a#_t")
-        print "    friend void send(mailbox_manager_t*,"
+        print "    friend void send(mailbox_manager_t*, message_lane_t,"
         print "                     typename mailbox_t< void(%s) >::address_t%s);" % (csep("a#_t"), cpre("const a#_t&"))
     print
     print "    std::function< void(signal_t *%s) > fun;" % cpre("arg#_t")
@@ -118,6 +147,7 @@ def generate_async_message_template(nargs):
     else:
         print "template<%s>" % csep("class arg#_t")
     print "void send(mailbox_manager_t *src,"
+    print "          message_lane_t lane,"
     print "          %s %s::address_t dest%s) {" % (("typename" if nargs > 0 else ""),
                                                     mailbox_t_str,
                                                     cpre("const arg#_t &arg#"))
@@ -125,7 +155,18 @@ def generate_async_message_template(nargs):
         print "    %s::write_impl_t writer;" % mailbox_t_str
     else:
         print "    typename %s::write_impl_t writer(%s);" % (mailbox_t_str, csep("arg#"))
-    print "    send_write(src, dest.addr, &writer);"
+    print "    send_write(src, dest.addr, &writer, lane);"
+    print "}"
+    print
+    if nargs == 0:
+        print "inline"
+    else:
+        print "template<%s>" % csep("class arg#_t")
+    print "void send(mailbox_manager_t *src,"
+    print "          %s %s::address_t dest%s) {" % (("typename" if nargs > 0 else ""),
+                                                    mailbox_t_str,
+                                                    cpre("const arg#_t &arg#"))
+    print "    send(src, message_lane_t::REPLICATION, dest%s);" % cpre("arg#")
     print "}"
     print
 
@@ -163,10 +204,10 @@ if __name__ == "__main__":
     print "    RDB_MAKE_ME_EQUALITY_COMPARABLE_1(mailbox_addr_t<T>, addr);"
     print
     print "private:"
-    print "    friend void send(mailbox_manager_t *, mailbox_addr_t<void()>);"
+    print "    friend void send(mailbox_manager_t *, message_lane_t, mailbox_addr_t<void()>);"
     for nargs in xrange(1, 15):
         print "    template <%s>" % ncsep("class a#_t", nargs)
-        print "    friend void send(mailbox_manager_t *,"
+        print "    friend void send(mailbox_manager_t *, message_lane_t,"
         print "                     typename mailbox_t< void(%s) >::address_t%s);" % (ncsep("a#_t", nargs), ncpre("const a#_t&", nargs))
     print
     print "    raw_mailbox_t::address_t addr;"
@@ -10,6 +10,7 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <net/if.h>
 #include <netdb.h>
 #include <netinet/tcp.h>
@@ -17,6 +18,7 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #include "utils.hpp"
 #include <boost/bind.hpp>
@@ -28,6 +30,7 @@
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/exponential_backoff.hpp"
 #include "concurrency/wait_any.hpp"
+#include "containers/archive/archive.hpp"
 #include "containers/printf_buffer.hpp"
 #include "logger.hpp"
 #include "perfmon/perfmon.hpp"
@@ -382,6 +385,15 @@ linux_tcp_conn_t::write_handler_t::write_handler_t(linux_tcp_conn_t *_parent) :
 { }
 
 void linux_tcp_conn_t::write_handler_t::coro_pool_callback(write_queue_op_t *operation, UNUSED signal_t *interruptor) {
+    if (operation->message != nullptr) {
+        parent->perform_write_message(operation->message);
+        parent->write_queue_limiter.unlock(operation->size);
+        delete operation->message;
+        operation->message = nullptr;
+        parent->release_write_queue_op(operation);
+        return;
+    }
+
     if (operation->buffer != nullptr) {
         parent->perform_write(operation->buffer, operation->size);
         if (operation->dealloc != nullptr) {
@@ -406,6 +418,7 @@ void linux_tcp_conn_t::internal_flush_write_buffer() {
     /* Swap in a new write buffer, and set up the old write buffer to be
     released once the write is over. */
     op->buffer = current_write_buffer->buffer;
+    op->message = nullptr;
     op->size = current_write_buffer->size;
     op->dealloc = current_write_buffer.release();
     op->cond = nullptr;
@@ -422,6 +435,28 @@ void linux_tcp_conn_t::internal_flush_write_buffer() {
 }
 
 void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
+    iovec iov;
+    iov.iov_base = const_cast<void *>(buf);
+    iov.iov_len = size;
+    perform_writev(&iov, 1);
+}
+
+void linux_tcp_conn_t::perform_write_message(const write_message_t *msg) {
+    intrusive_list_t<::write_buffer_t> *buffers =
+        const_cast<write_message_t *>(msg)->unsafe_expose_buffers();
+    scoped_array_t<iovec> iov(buffers->size());
+    size_t iovcnt = 0;
+    for (::write_buffer_t *b = buffers->head(); b != nullptr; b = buffers->next(b)) {
+        if (b->size > 0) {
+            iov[iovcnt].iov_base = b->data;
+            iov[iovcnt].iov_len = b->size;
+            ++iovcnt;
+        }
+    }
+    perform_writev(iov.data(), iovcnt);
+}
+
+void linux_tcp_conn_t::perform_writev(iovec *iov, size_t iovcnt) {
     assert_thread();
 
     if (write_closed.is_pulsed()) {
@@ -431,8 +466,8 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
         return;
     }
 
-    while (size > 0) {
-        ssize_t res = ::write(sock.get(), buf, size);
+    while (iovcnt > 0) {
+        ssize_t res = ::writev(sock.get(), iov, std::min<size_t>(iovcnt, IOV_MAX));
 
         if (res == -1 && (get_errno() == EAGAIN || get_errno() == EWOULDBLOCK)) {
             /* Wait for a notification from the event queue, or for an order to
@@ -470,12 +505,22 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
             break;
 
         } else {
-            rassert(res <= static_cast<ssize_t>(size));
-            buf = reinterpret_cast<const void *>(reinterpret_cast<const char *>(buf) + res);
-            size -= res;
             if (write_perfmon) {
                 write_perfmon->record(res);
             }
+            /* Skip the buffers that have been written completely, and the part of the
+            next one that has been written. */
+            size_t written = res;
+            while (iovcnt > 0 && written >= iov->iov_len) {
+                written -= iov->iov_len;
+                ++iov;
+                --iovcnt;
+            }
+            if (written > 0) {
+                rassert(iovcnt > 0);
+                iov->iov_base = static_cast<char *>(iov->iov_base) + written;
+                iov->iov_len -= written;
+            }
         }
     }
 }
@@ -496,6 +541,7 @@ void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THR
 
     /* Enqueue the write so it will happen eventually */
     op.buffer = buf;
+    op.message = nullptr;
     op.size = size;
     op.dealloc = nullptr;
     op.cond = &to_signal_when_done;
@@ -543,6 +589,46 @@ void linux_tcp_conn_t::write_buffered(const void *vbuf, size_t size, signal_t *c
     }
 }
 
+void linux_tcp_conn_t::write_buffered(write_message_t *msg, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
+    intrusive_list_t<::write_buffer_t> *buffers = msg->unsafe_expose_buffers();
+    const size_t size = msg->size();
+    if (size < WRITE_CHUNK_SIZE) {
+        /* It's cheaper to copy a small message than to give it a `writev()` of its
+        own. */
+        for (::write_buffer_t *b = buffers->head(); b != nullptr; b = buffers->next(b)) {
+            write_buffered(b->data, b->size, closer);
+        }
+        write_message_t sent(std::move(*msg));
+        return;
+    }
+
+    write_op_wrapper_t sentry(this, closer);
+    if (write_closed.is_pulsed()) {
+        throw tcp_conn_write_closed_exc_t();
+    }
+
+    /* Flush out any data that's been buffered, so that things don't get out of order */
+    if (current_write_buffer->size > 0) {
+        internal_flush_write_buffer();
+    }
+
+    write_queue_op_t *op = get_write_queue_op();
+    op->buffer = nullptr;
+    op->message = new write_message_t(std::move(*msg));
+    /* The message only counts against the write queue's limit up to the limit itself,
+    or it would never fit. */
+    op->size = std::min(size, WRITE_QUEUE_MAX_SIZE);
+    op->dealloc = nullptr;
+    op->cond = nullptr;
+    op->keepalive = auto_drainer_t::lock_t(drainer.get());
+    write_queue_limiter.co_lock(op->size);
+    write_queue.push(op);
+
+    if (write_closed.is_pulsed()) {
+        throw tcp_conn_write_closed_exc_t();
+    }
+}
+
 void linux_tcp_conn_t::writef(signal_t *closer, const char *format, ...) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
     va_list ap;
     va_start(ap, format);
@@ -569,6 +655,7 @@ void linux_tcp_conn_t::flush_buffer(signal_t *closer) THROWS_ONLY(tcp_conn_write
     write_queue_op_t op;
     cond_t to_signal_when_done;
     op.buffer = nullptr;
+    op.message = nullptr;
     op.dealloc = nullptr;
     op.cond = &to_signal_when_done;
     write_queue.push(&op);
@@ -860,6 +947,16 @@ size_t linux_secure_tcp_conn_t::read_internal(void *buffer, size_t size)
     }
 }
 
+void linux_secure_tcp_conn_t::perform_write_message(const write_message_t *msg) {
+    /* TLS has no `writev()`, so we write the buffers one by one. They still don't
+    have to be copied together first. */
+    intrusive_list_t<::write_buffer_t> *buffers =
+        const_cast<write_message_t *>(msg)->unsafe_expose_buffers();
+    for (::write_buffer_t *b = buffers->head(); b != nullptr; b = buffers->next(b)) {
+        perform_write(b->data, b->size);
+    }
+}
+
 void linux_secure_tcp_conn_t::perform_write(const void *buffer, size_t size) {
     assert_thread();
 
@@ -40,6 +40,9 @@
 #include "crypto/error.hpp"
 #include "perfmon/types.hpp"
 
+struct iovec;
+class write_message_t;
+
 /* linux_tcp_conn_t provides a disgusting wrapper around a TCP network connection. */
 
 class linux_tcp_conn_t :
@@ -137,6 +140,13 @@ public:
     void write_buffered(const void *buf, size_t size, signal_t *closer)
         THROWS_ONLY(tcp_conn_write_closed_exc_t);
 
+    /* This write_buffered() sends the buffers of `msg` and leaves it empty. Small
+    messages are copied into the write buffer like above, so that they get sent
+    together. Larger ones are queued up as they are, without copying them, and sent with
+    a single writev(); their buffers are freed once they have been written. */
+    void write_buffered(write_message_t *msg, signal_t *closer)
+        THROWS_ONLY(tcp_conn_write_closed_exc_t);
+
     void writef(signal_t *closer, const char *format, ...)
         THROWS_ONLY(tcp_conn_write_closed_exc_t) ATTR_FORMAT(printf, 3, 4);
 
@@ -273,6 +283,9 @@ private:
     struct write_queue_op_t : public intrusive_list_node_t<write_queue_op_t> {
         write_buffer_t *dealloc;
         const void *buffer;
+        /* If `message` isn't null, the op writes it instead of `buffer` and deletes
+        it afterwards. */
+        write_message_t *message;
         size_t size;
         cond_t *cond;
         auto_drainer_t::lock_t keepalive;
@@ -340,6 +353,13 @@ private:
     /* Used to actually perform a write. If the write end of the connection is open, then
     writes `size` bytes from `buffer` to the socket. */
     virtual void perform_write(const void *buffer, size_t size);
+
+    /* Like `perform_write()`, but writes all of the buffers of `msg`. */
+    virtual void perform_write_message(const write_message_t *msg);
+
+    /* Writes the `iovcnt` buffers in `iov` with as few calls to writev() as possible.
+    Changes `iov` to keep track of what's left to write. */
+    void perform_writev(iovec *iov, size_t iovcnt);
 };
 
 /* tls_conn_wrapper_t wraps a TLS connection. */
@@ -402,6 +422,8 @@ private:
     writes `size` bytes from `buffer` to the socket. */
     virtual void perform_write(const void *buffer, size_t size);
 
+    virtual void perform_write_message(const write_message_t *msg);
+
     void shutdown();
     void shutdown_socket();
 
@@ -16,6 +16,7 @@
 #include "arch/io/blocker_pool.hpp"
 #include "arch/io/timer_provider.hpp"
 #include "arch/timer.hpp"
+#include "containers/archive/archive.hpp"
 
 class linux_thread_t;
 class os_signal_cond_t;
@@ -170,6 +171,11 @@ public:
     linux_message_hub_t message_hub;
     timer_handler_t timer_handler;
 
+    /* Never accessed; keeps the buffers of destroyed `write_message_t`s for reuse on
+    this thread. Declared before `coro_runtime` so that it outlives the coroutines,
+    which may still destroy messages. */
+    write_buffer_pool_t write_buffer_pool;
+
     /* Never accessed; its constructor and destructor set up and tear down thread-local variables
     for coroutines. */
     coro_runtime_t coro_runtime;
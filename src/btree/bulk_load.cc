@@ -0,0 +1,185 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "btree/bulk_load.hpp"
+
+#include "btree/internal_node.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
+#include "btree/operations.hpp"
+
+btree_bulk_loader_t::btree_bulk_loader_t(value_sizer_t *sizer,
+                                         superblock_t *superblock,
+                                         repli_timestamp_t timestamp,
+                                         double fill_factor)
+    : sizer_(sizer), superblock_(superblock), timestamp_(timestamp),
+      fill_factor_(fill_factor), num_entries_(0), finished_(false) {
+    guarantee(superblock_->get_root_block_id() == NULL_BLOCK_ID,
+              "Bulk loading is only possible into an empty B-tree.");
+    guarantee(fill_factor_ > 0 && fill_factor_ <= 1);
+}
+
+void btree_bulk_loader_t::add(
+        const btree_key_t *key,
+        const std::function<void(buf_parent_t, void *)> &make_value) {
+    guarantee(!finished_);
+    if (num_entries_ != 0) {
+        guarantee(btree_key_cmp(last_key_.btree_key(), key) < 0,
+                  "Bulk loaded keys must be strictly increasing.");
+    }
+
+    if (!leaf_.empty()) {
+        bool filled;
+        {
+            buf_read_t read(&leaf_);
+            filled = leaf::is_filled(
+                sizer_, static_cast<const leaf_node_t *>(read.get_data_read()),
+                fill_factor_);
+        }
+        if (filled) {
+            finish_leaf();
+        }
+    }
+    if (leaf_.empty()) {
+        start_leaf();
+    }
+
+    scoped_malloc_t<void> value(sizer_->max_possible_size());
+    make_value(buf_parent_t(&leaf_), value.get());
+
+    bool full;
+    {
+        buf_read_t read(&leaf_);
+        full = leaf::is_full(
+            sizer_, static_cast<const leaf_node_t *>(read.get_data_read()),
+            key, value.get());
+    }
+    if (full) {
+        // The blocks that the value refers to stay children of the old leaf node.
+        // Values that move to another leaf node when it's split do the same.
+        finish_leaf();
+        start_leaf();
+    }
+
+    const repli_timestamp_t previous_leaf_recency = leaf_.get_recency();
+    leaf_.set_recency(superceding_recency(timestamp_, previous_leaf_recency));
+    {
+        buf_write_t write(&leaf_);
+        leaf::insert(sizer_,
+                     static_cast<leaf_node_t *>(write.get_data_write()),
+                     key,
+                     value.get(),
+                     timestamp_,
+                     previous_leaf_recency,
+                     key_modification_proof_t::real_proof());
+    }
+    last_key_.assign(key);
+    ++num_entries_;
+}
+
+void btree_bulk_loader_t::finish() {
+    guarantee(!finished_);
+    finished_ = true;
+    if (!leaf_.empty()) {
+        finish_leaf();
+    }
+
+    // Every level gets parents until there is one with a single node, the root.
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        if (level + 1 == levels_.size() && levels_[level].size() == 1) {
+            insert_root(levels_[level].front().block_id, superblock_);
+            break;
+        }
+        while (!levels_[level].empty()) {
+            write_internal_node(level, true);
+        }
+    }
+
+    const block_id_t stat_block_id = superblock_->get_stat_block_id();
+    if (stat_block_id != NULL_BLOCK_ID && num_entries_ != 0) {
+        buf_lock_t stat_block(buf_parent_t(superblock_->expose_buf().txn()),
+                              stat_block_id, access_t::write);
+        buf_write_t stat_block_write(&stat_block);
+        auto stat_block_buf = static_cast<btree_statblock_t *>(
+                stat_block_write.get_data_write(BTREE_STATBLOCK_SIZE));
+        stat_block_buf->population += num_entries_;
+    }
+}
+
+size_t btree_bulk_loader_t::child_cost(const child_t &child) const {
+    // Roughly the size of the pair and its offset.  This only decides when to write
+    // the next internal node; how many children go into it is up to
+    // `internal_node::is_full()`.
+    return child.last_key.btree_key()->full_size() + sizeof(block_id_t)
+        + sizeof(uint16_t);
+}
+
+void btree_bulk_loader_t::start_leaf() {
+    leaf_ = buf_lock_t(superblock_->expose_buf(), alt_create_t::create);
+    buf_write_t write(&leaf_);
+    leaf::init(sizer_, static_cast<leaf_node_t *>(write.get_data_write()));
+}
+
+void btree_bulk_loader_t::finish_leaf() {
+    child_t child;
+    child.block_id = leaf_.block_id();
+    child.last_key = last_key_;
+    leaf_.reset_buf_lock();
+    add_child(0, std::move(child));
+}
+
+void btree_bulk_loader_t::add_child(size_t level, child_t &&child) {
+    if (levels_.size() == level) {
+        levels_.emplace_back();
+        level_costs_.push_back(0);
+    }
+    level_costs_[level] += child_cost(child);
+    levels_[level].push_back(std::move(child));
+
+    // We only write a node once there are clearly enough children for a full node
+    // and another one, so that the node can be filled up.
+    if (level_costs_[level] > 2 * sizer_->block_size().value()) {
+        write_internal_node(level, false);
+    }
+}
+
+void btree_bulk_loader_t::write_internal_node(size_t level, bool final) {
+    std::deque<child_t> *children = &levels_[level];
+    guarantee(children->size() >= 2);
+
+    child_t parent;
+    size_t num_children = 1;
+    {
+        buf_lock_t buf(superblock_->expose_buf(), alt_create_t::create);
+        buf.set_recency(superceding_recency(buf.get_recency(), timestamp_));
+        buf_write_t write(&buf);
+        auto node = static_cast<internal_node_t *>(write.get_data_write());
+        internal_node::init(sizer_->block_size(), node);
+        while (num_children < children->size()) {
+            const size_t remaining = children->size() - num_children;
+            const bool takes_all = final
+                && static_cast<size_t>(internal_node::free_pairs(node)) >= remaining;
+            // Unless the node takes all the children, we leave at least two of them
+            // for the next node, so that there is never a node with a single child.
+            if (num_children >= 2 && !takes_all
+                && (remaining <= 2
+                    || internal_node::is_full(node)
+                    || internal_node::is_filled(sizer_->block_size(), node,
+                                                fill_factor_))) {
+                break;
+            }
+            DEBUG_VAR bool success = internal_node::insert(
+                node,
+                (*children)[num_children - 1].last_key.btree_key(),
+                (*children)[num_children - 1].block_id,
+                (*children)[num_children].block_id);
+            rassert(success, "could not insert internal btree node");
+            ++num_children;
+        }
+        parent.block_id = buf.block_id();
+        parent.last_key = (*children)[num_children - 1].last_key;
+    }
+    for (size_t i = 0; i < num_children; ++i) {
+        level_costs_[level] -= child_cost(children->front());
+        children->pop_front();
+    }
+    add_child(level + 1, std::move(parent));
+}
@@ -0,0 +1,77 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef BTREE_BULK_LOAD_HPP_
+#define BTREE_BULK_LOAD_HPP_
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "btree/keys.hpp"
+#include "buffer_cache/alt.hpp"
+#include "repli_timestamp.hpp"
+
+class superblock_t;
+class value_sizer_t;
+
+/* Builds the B-tree of `superblock`, which must be empty, bottom-up from entries that
+are added in strictly increasing key order.  Instead of walking down the tree and
+splitting nodes for every entry, it fills each leaf node up to `fill_factor` of its
+size, and then builds each level of internal nodes above the leaves in the same
+way.  Only the current leaf node is held at any time; the tree is attached to the
+superblock by `finish()`.
+
+The last node on each level may be underfull, like after deletions. */
+class btree_bulk_loader_t {
+public:
+    btree_bulk_loader_t(value_sizer_t *sizer,
+                        superblock_t *superblock,
+                        repli_timestamp_t timestamp,
+                        double fill_factor);
+
+    /* `make_value` is called with the leaf node that the entry goes to, and has to
+    write the value to its second argument (which has room for
+    `sizer->max_possible_size()` bytes).  Blocks that the value refers to must be
+    created as children of the given parent. */
+    void add(const btree_key_t *key,
+             const std::function<void(buf_parent_t, void *)> &make_value);
+
+    /* Attaches the tree to the superblock and updates its stat block.  Must be
+    called once, after the last `add()`. */
+    void finish();
+
+    int64_t num_entries() const { return num_entries_; }
+
+private:
+    struct child_t {
+        block_id_t block_id;
+        // The largest key in the child's subtree, which becomes its key in the parent.
+        store_key_t last_key;
+    };
+
+    size_t child_cost(const child_t &child) const;
+    void start_leaf();
+    void finish_leaf();
+    void add_child(size_t level, child_t &&child);
+    void write_internal_node(size_t level, bool final);
+
+    value_sizer_t *const sizer_;
+    superblock_t *const superblock_;
+    const repli_timestamp_t timestamp_;
+    const double fill_factor_;
+
+    buf_lock_t leaf_;
+    store_key_t last_key_;
+    int64_t num_entries_;
+
+    // `levels_[i]` holds the nodes on level `i` (where leaf nodes are on level 0)
+    // that don't have a parent yet, and `level_costs_[i]` the sum of their
+    // `child_cost()`s.
+    std::vector<std::deque<child_t> > levels_;
+    std::vector<size_t> level_costs_;
+
+    bool finished_;
+
+    DISABLE_COPYING(btree_bulk_loader_t);
+};
+
+#endif  // BTREE_BULK_LOAD_HPP_
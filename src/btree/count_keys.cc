@@ -0,0 +1,88 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "btree/count_keys.hpp"
+
+#include "btree/depth_first_traversal.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
+#include "btree/operations.hpp"
+#include "buffer_cache/alt.hpp"
+
+int64_t get_btree_population(superblock_t *superblock) {
+    const block_id_t stat_block_id = superblock->get_stat_block_id();
+    if (stat_block_id == NULL_BLOCK_ID) {
+        return -1;
+    }
+    // Like the writes, we acquire the stat block as a child of the transaction.
+    buf_lock_t stat_block(buf_parent_t(superblock->expose_buf().txn()),
+                          stat_block_id, access_t::read);
+    buf_read_t read(&stat_block);
+    uint32_t stat_block_size;
+    auto stat_block_buf = static_cast<const btree_statblock_t *>(
+        read.get_data_read(&stat_block_size));
+    guarantee(stat_block_size == BTREE_STATBLOCK_SIZE);
+    return stat_block_buf->population;
+}
+
+class count_keys_callback_t : public depth_first_traversal_callback_t {
+public:
+    count_keys_callback_t(const key_range_t *_range,
+                          const std::function<bool(const btree_key_t *)> *_key_filter)
+        : range(_range), key_filter(_key_filter), count(0) { }
+
+    continue_bool_t handle_pre_leaf(
+            const counted_t<counted_buf_lock_and_read_t> &buf,
+            UNUSED const btree_key_t *left_excl_or_null,
+            UNUSED const btree_key_t *right_incl,
+            UNUSED signal_t *interruptor,
+            bool *skip_out) {
+        // We count the keys right here, so the traversal doesn't have to call
+        // `handle_pair()` for them.
+        *skip_out = true;
+        const leaf_node_t *node =
+            static_cast<const leaf_node_t *>(buf->read->get_data_read());
+        for (auto it = leaf::inclusive_lower_bound(range->left.btree_key(), *node);
+             it != leaf::end(*node); ++it) {
+            const btree_key_t *key = (*it).first;
+            // `range->right` is exclusive
+            if (!range->right.unbounded &&
+                btree_key_cmp(key, range->right.key().btree_key()) >= 0) {
+                break;
+            }
+            if (!*key_filter || (*key_filter)(key)) {
+                ++count;
+            }
+        }
+        return continue_bool_t::CONTINUE;
+    }
+
+    continue_bool_t handle_pair(scoped_key_value_t &&, signal_t *) {
+        unreachable();
+    }
+
+    uint64_t get_count() const { return count; }
+
+private:
+    const key_range_t *range;
+    const std::function<bool(const btree_key_t *)> *key_filter;
+    uint64_t count;
+};
+
+uint64_t btree_count_keys(
+        superblock_t *superblock,
+        const key_range_t &range,
+        const std::function<bool(const btree_key_t *)> &key_filter,
+        release_superblock_t release_superblock,
+        signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    if (range.is_empty()) {
+        if (release_superblock == release_superblock_t::RELEASE) {
+            superblock->release();
+        }
+        return 0;
+    }
+    count_keys_callback_t callback(&range, &key_filter);
+    btree_depth_first_traversal(superblock, range, &callback, access_t::read,
+                                direction_t::FORWARD, release_superblock,
+                                interruptor);
+    return callback.get_count();
+}
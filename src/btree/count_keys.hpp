@@ -0,0 +1,31 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef BTREE_COUNT_KEYS_HPP_
+#define BTREE_COUNT_KEYS_HPP_
+
+#include <functional>
+
+#include "btree/keys.hpp"
+#include "btree/types.hpp"
+#include "concurrency/interruptor.hpp"
+
+class superblock_t;
+
+/* Returns the number of keys in the B-tree according to its stat block, or -1 if the
+B-tree doesn't have one (secondary index B-trees don't).  Writes update the stat block
+at their very end instead of on the way down the tree, so writes that are still in
+progress may or may not be counted.  This must be called while `superblock` is still
+held, so that writes which come after the caller are never counted. */
+int64_t get_btree_population(superblock_t *superblock);
+
+/* Counts the keys in `range` for which `key_filter` (if set) returns true.  This
+reads the keys of each leaf node in one go, without handing them out one by one and
+without ever looking at the values. */
+uint64_t btree_count_keys(
+    superblock_t *superblock,
+    const key_range_t &range,
+    const std::function<bool(const btree_key_t *)> &key_filter,
+    release_superblock_t release_superblock,
+    signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t);
+
+#endif  // BTREE_COUNT_KEYS_HPP_
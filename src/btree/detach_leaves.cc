@@ -0,0 +1,180 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "btree/detach_leaves.hpp"
+
+#include "errors.hpp"
+#include <boost/optional.hpp>
+
+#include "btree/internal_node.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
+#include "btree/operations.hpp"
+
+// The keys in a subtree are greater than `left_excl` and at most `right_incl`.  A
+// missing bound means that the subtree reaches to that end of the B-tree.
+struct subtree_bounds_t {
+    boost::optional<store_key_t> left_excl;
+    boost::optional<store_key_t> right_incl;
+};
+
+static subtree_bounds_t child_bounds(const internal_node_t *node,
+                                     int index,
+                                     const subtree_bounds_t &node_bounds) {
+    subtree_bounds_t bounds;
+    bounds.left_excl = index == 0
+        ? node_bounds.left_excl
+        : store_key_t(&internal_node::get_pair_by_index(node, index - 1)->key);
+    bounds.right_incl = index == node->npairs - 1
+        ? node_bounds.right_incl
+        : store_key_t(&internal_node::get_pair_by_index(node, index)->key);
+    return bounds;
+}
+
+static bool bounds_within_range(const subtree_bounds_t &bounds,
+                                const key_range_t &range) {
+    const bool left_ok = static_cast<bool>(bounds.left_excl)
+        ? range.left <= *bounds.left_excl
+        : range.left == store_key_t::min();
+    const bool right_ok = static_cast<bool>(bounds.right_incl)
+        ? range.right.unbounded || *bounds.right_incl < range.right.key()
+        : range.right.unbounded;
+    return left_ok && right_ok;
+}
+
+static bool leaf_has_keys_in_range(buf_lock_t *leaf_buf, const key_range_t &range) {
+    buf_read_t read(leaf_buf);
+    const leaf_node_t *node = static_cast<const leaf_node_t *>(read.get_data_read());
+    auto it = leaf::inclusive_lower_bound(range.left.btree_key(), *node);
+    return it != leaf::end(*node) && range.contains_key((*it).first);
+}
+
+bool btree_detach_leaves(
+        value_sizer_t *sizer,
+        superblock_t *superblock,
+        const key_range_t &range,
+        size_t max_leaves,
+        const value_deleter_t *balancing_detacher,
+        std::vector<buf_lock_t> *leaves_out,
+        key_range_t *erased_out) {
+    rassert(!range.is_empty());
+    rassert(leaves_out->empty());
+    const btree_key_t *key = range.left.btree_key();
+    const block_id_t root_id = superblock->get_root_block_id();
+    if (root_id == NULL_BLOCK_ID) {
+        return false;
+    }
+
+    // Walk down towards `range.left` like a write would, merging or leveling underfull
+    // nodes on the way, until `buf` is the parent of a leaf node.
+    buf_lock_t last_buf;
+    buf_lock_t buf(superblock->expose_buf(), root_id, access_t::write);
+    {
+        buf_read_t read(&buf);
+        if (node::is_leaf(static_cast<const node_t *>(read.get_data_read()))) {
+            return false;
+        }
+    }
+    subtree_bounds_t last_bounds;
+    subtree_bounds_t bounds;
+    buf_lock_t child;
+    int child_index;
+    for (;;) {
+        check_and_handle_underfull(
+            sizer, &buf, &last_buf, superblock, key, balancing_detacher);
+        // A merge can change the bounds of `buf`, or even make it the root (in which
+        // case `last_buf` has been deleted).
+        if (last_buf.empty() || superblock->get_root_block_id() == buf.block_id()) {
+            last_buf.reset_buf_lock();
+            bounds = subtree_bounds_t();
+        } else {
+            buf_read_t read(&last_buf);
+            auto node = static_cast<const internal_node_t *>(read.get_data_read());
+            bounds = child_bounds(
+                node, internal_node::get_offset_index(node, key), last_bounds);
+        }
+
+        block_id_t child_id;
+        {
+            buf_read_t read(&buf);
+            auto node = static_cast<const internal_node_t *>(read.get_data_read());
+            child_index = internal_node::get_offset_index(node, key);
+            child_id = internal_node::get_pair_by_index(node, child_index)->lnode;
+        }
+        child = buf_lock_t(&buf, child_id, access_t::write);
+        bool child_is_leaf;
+        {
+            buf_read_t read(&child);
+            child_is_leaf =
+                node::is_leaf(static_cast<const node_t *>(read.get_data_read()));
+        }
+        if (child_is_leaf) {
+            break;
+        }
+        last_buf = std::move(buf);
+        buf = std::move(child);
+        last_bounds = bounds;
+    }
+
+    // Find the run of children from `child_index` (or the one after it) whose keys
+    // all lie in `range`.  `buf` has to keep two children, or merging and leveling
+    // wouldn't be able to tell where it is in its parent.
+    std::vector<block_id_t> run;
+    int begin;
+    subtree_bounds_t erased_bounds;
+    {
+        buf_read_t read(&buf);
+        auto node = static_cast<const internal_node_t *>(read.get_data_read());
+        erased_bounds = child_bounds(node, child_index, bounds);
+        const bool child_within_range = bounds_within_range(erased_bounds, range);
+        begin = child_within_range ? child_index : child_index + 1;
+        for (int i = begin;
+             i < node->npairs && run.size() < max_leaves
+                 && static_cast<int>(run.size()) < node->npairs - 2;
+             ++i) {
+            subtree_bounds_t bounds_i = child_bounds(node, i, bounds);
+            if (!bounds_within_range(bounds_i, range)) {
+                break;
+            }
+            run.push_back(internal_node::get_pair_by_index(node, i)->lnode);
+            erased_bounds = bounds_i;
+        }
+        if ((run.empty() || !child_within_range)
+                && leaf_has_keys_in_range(&child, range)) {
+            return false;
+        }
+    }
+
+    if (!static_cast<bool>(erased_bounds.right_incl)
+            || (!range.right.unbounded
+                && !(*erased_bounds.right_incl < range.right.key()))) {
+        *erased_out = range;
+    } else {
+        *erased_out = key_range_t(key_range_t::closed, range.left,
+                                  key_range_t::closed, *erased_bounds.right_incl);
+    }
+    if (run.empty()) {
+        return true;
+    }
+
+    // Acquire the leaf nodes before their parent changes, like a merge does.
+    for (size_t i = 0; i < run.size(); ++i) {
+        if (begin + static_cast<int>(i) == child_index) {
+            leaves_out->push_back(std::move(child));
+        } else {
+            leaves_out->emplace_back(&buf, run[i], access_t::write);
+        }
+    }
+    child.reset_buf_lock();
+    {
+        buf_write_t write(&buf);
+        internal_node::remove_children(
+            sizer->block_size(),
+            static_cast<internal_node_t *>(write.get_data_write()),
+            begin, begin + run.size());
+    }
+    for (block_id_t leaf_id : run) {
+        buf.detach_child(leaf_id);
+    }
+    check_and_handle_underfull(
+        sizer, &buf, &last_buf, superblock, key, balancing_detacher);
+    return true;
+}
@@ -0,0 +1,37 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef BTREE_DETACH_LEAVES_HPP_
+#define BTREE_DETACH_LEAVES_HPP_
+
+#include <vector>
+
+#include "btree/keys.hpp"
+#include "buffer_cache/alt.hpp"
+
+class superblock_t;
+class value_deleter_t;
+class value_sizer_t;
+
+/* Erases keys at the start of `range` by taking whole leaf nodes out of the B-tree,
+instead of deleting their keys one by one.  It walks down to the parent of the leaf
+node that `range.left` falls into, removes up to `max_leaves` of its children whose
+keys all lie in `range`, and merges or levels the parent if that left it underfull.
+
+Returns `false` without changing anything if it can't make progress that way: if the
+root is a leaf node, or if the leaf node that `range.left` falls into also holds keys
+outside of `range` and some inside of it.  Those keys have to be erased one by one.
+
+Otherwise it returns `true` and sets `*erased_out` to a range that starts at
+`range.left` and holds no keys anymore.  The removed leaf nodes are handed out in
+`*leaves_out`, still write-locked, so that the caller can take care of their values
+and mark them deleted in the same transaction after it has released the superblock.
+They aren't counted in the stat block yet either. */
+bool btree_detach_leaves(
+    value_sizer_t *sizer,
+    superblock_t *superblock,
+    const key_range_t &range,
+    size_t max_leaves,
+    const value_deleter_t *balancing_detacher,
+    std::vector<buf_lock_t> *leaves_out,
+    key_range_t *erased_out);
+
+#endif  // BTREE_DETACH_LEAVES_HPP_
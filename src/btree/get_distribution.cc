@@ -1,100 +1,230 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "btree/get_distribution.hpp"
 
+#include <algorithm>
+
+#include "btree/count_keys.hpp"
 #include "btree/internal_node.hpp"
 #include "btree/node.hpp"
 #include "btree/leaf_node.hpp"
-#include "btree/parallel_traversal.hpp"
+#include "btree/operations.hpp"
 #include "buffer_cache/alt.hpp"
+#include "concurrency/pmap.hpp"
+#include "math.hpp"
+#include "random.hpp"
 #include "utils.hpp"
 
-class get_distribution_traversal_helper_t : public btree_traversal_helper_t, public home_thread_mixin_debug_only_t {
-public:
-    get_distribution_traversal_helper_t(int _depth_limit, std::vector<store_key_t> *_keys)
-        : depth_limit(_depth_limit), key_count(0), keys(_keys)
-    { }
+// How many random walks run at the same time.
+const int DISTRIBUTION_WALK_CONCURRENCY = 16;
+
+typedef std::function<int64_t(const void *)> value_bytes_fn_t;
 
-    void read_stat_block(buf_lock_t *stat_block) {
-        guarantee (stat_block != nullptr);
-        buf_read_t read(stat_block);
-        uint32_t sb_size;
-        const btree_statblock_t *sb_data =
-            static_cast<const btree_statblock_t *>(read.get_data_read(&sb_size));
-        guarantee(sb_size == BTREE_STATBLOCK_SIZE);
-        key_count = sb_data->population;
+static void get_leaf_size(const leaf_node_t *node,
+                          const value_bytes_fn_t &value_bytes,
+                          int64_t *count_out,
+                          int64_t *bytes_out) {
+    *count_out = 0;
+    *bytes_out = 0;
+    for (auto it = leaf::begin(*node); it != leaf::end(*node); ++it) {
+        ++*count_out;
+        *bytes_out += (*it).first->full_size() + value_bytes((*it).second);
     }
+}
 
-    // This is free to call mark_deleted.
-    void process_a_leaf(buf_lock_t *leaf_node_buf,
-                        const btree_key_t *,
-                        const btree_key_t *,
-                        signal_t * /*interruptor*/,
-                        int * /*population_change_out*/) THROWS_ONLY(interrupted_exc_t) {
-        buf_read_t read(leaf_node_buf);
-        const leaf_node_t *node
-            = static_cast<const leaf_node_t *>(read.get_data_read());
+// A node at the depth limit, whose children are the buckets
+// `buckets[first_bucket]` to `buckets[first_bucket + children.size() - 1]`.
+struct frontier_node_t {
+    buf_lock_t lock;
+    size_t first_bucket;
+    std::vector<block_id_t> children;
+};
 
-        for (auto it = leaf::begin(*node); it != leaf::end(*node); ++it) {
-            const btree_key_t *key = (*it).first;
-            keys->push_back(store_key_t(key->size, key->contents));
+static void collect_buckets(buf_lock_t *lock,
+                            const store_key_t &left_key,
+                            int depth,
+                            int depth_limit,
+                            const value_bytes_fn_t &value_bytes,
+                            std::vector<frontier_node_t> *frontier_out,
+                            std::vector<key_distribution_bucket_t> *buckets_out) {
+    std::vector<std::pair<store_key_t, block_id_t> > children;
+    {
+        buf_read_t read(lock);
+        const node_t *node = static_cast<const node_t *>(read.get_data_read());
+        if (node::is_leaf(node)) {
+            // The leaf node is shallow enough to give every key its own bucket.
+            const leaf_node_t *leaf_node = reinterpret_cast<const leaf_node_t *>(node);
+            for (auto it = leaf::begin(*leaf_node); it != leaf::end(*leaf_node); ++it) {
+                key_distribution_bucket_t bucket;
+                bucket.left_key.assign((*it).first);
+                bucket.key_count = 1;
+                bucket.bytes = (*it).first->full_size() + value_bytes((*it).second);
+                buckets_out->push_back(bucket);
+            }
+            return;
+        }
+        const internal_node_t *internal_node =
+            reinterpret_cast<const internal_node_t *>(node);
+        for (int i = 0; i < internal_node->npairs; ++i) {
+            // The key of each pair is the largest key of its child, which makes it
+            // the start of the next child's range.  The last pair has no key.
+            store_key_t child_left_key = left_key;
+            if (i > 0) {
+                child_left_key.assign(
+                    &internal_node::get_pair_by_index(internal_node, i - 1)->key);
+            }
+            children.push_back(std::make_pair(
+                child_left_key,
+                internal_node::get_pair_by_index(internal_node, i)->lnode));
         }
     }
 
-    void postprocess_internal_node(buf_lock_t *internal_node_buf) {
-        buf_read_t read(internal_node_buf);
-        const internal_node_t *node
-            = static_cast<const internal_node_t *>(read.get_data_read());
-
-        /* Notice, we iterate all but the last pair because the last pair
-         * doesn't actually have a key and we're looking for the split points.
-         * */
-        for (int i = 0; i < (node->npairs - 1); i++) {
-            const btree_internal_pair *pair = internal_node::get_pair_by_index(node, i);
-            keys->push_back(store_key_t(pair->key.size, pair->key.contents));
+    if (depth < depth_limit) {
+        // Start acquiring all of the children before we wait for the first one.
+        std::vector<buf_lock_t> child_locks;
+        child_locks.reserve(children.size());
+        for (const auto &child : children) {
+            child_locks.emplace_back(lock, child.second, access_t::read);
         }
+        lock->reset_buf_lock();
+        for (size_t i = 0; i < children.size(); ++i) {
+            collect_buckets(&child_locks[i], children[i].first, depth + 1,
+                            depth_limit, value_bytes, frontier_out, buckets_out);
+            child_locks[i].reset_buf_lock();
+        }
+    } else {
+        frontier_node_t frontier_node;
+        frontier_node.first_bucket = buckets_out->size();
+        for (const auto &child : children) {
+            key_distribution_bucket_t bucket;
+            bucket.left_key = child.first;
+            bucket.key_count = 0;
+            bucket.bytes = 0;
+            buckets_out->push_back(bucket);
+            frontier_node.children.push_back(child.second);
+        }
+        frontier_node.lock = std::move(*lock);
+        frontier_out->push_back(std::move(frontier_node));
     }
+}
 
-    void filter_interesting_children(buf_parent_t,
-                                     ranged_block_ids_t *ids_source,
-                                     interesting_children_callback_t *cb) {
-        if (ids_source->get_level() < depth_limit) {
-            int num_block_ids = ids_source->num_block_ids();
-            for (int i = 0; i < num_block_ids; ++i) {
-                block_id_t block_id;
-                const btree_key_t *left, *right;
-                ids_source->get_block_id_and_bounding_interval(i, &block_id, &left, &right);
-
-                cb->receive_interesting_child(i);
+/* Walks down from `block_id` to a leaf node, picking one of the children of each
+internal node at random.  The key count and bytes of the leaf node, multiplied by the
+number of children of each node on the way, estimate the size of the whole subtree. */
+static void random_walk(buf_lock_t *parent,
+                        block_id_t block_id,
+                        const value_bytes_fn_t &value_bytes,
+                        double *key_count_out,
+                        double *bytes_out) {
+    double weight = 1;
+    buf_lock_t lock(parent, block_id, access_t::read);
+    while (true) {
+        block_id_t child_id;
+        {
+            buf_read_t read(&lock);
+            const node_t *node = static_cast<const node_t *>(read.get_data_read());
+            if (node::is_leaf(node)) {
+                int64_t count, bytes;
+                get_leaf_size(reinterpret_cast<const leaf_node_t *>(node),
+                              value_bytes, &count, &bytes);
+                *key_count_out = weight * count;
+                *bytes_out = weight * bytes;
+                return;
             }
-        } else {
-            //We're over the depth limit and thus disinterested in all children
+            const internal_node_t *internal_node =
+                reinterpret_cast<const internal_node_t *>(node);
+            weight *= internal_node->npairs;
+            child_id = internal_node::get_pair_by_index(
+                internal_node, randint(internal_node->npairs))->lnode;
         }
-
-        cb->no_more_interesting_children();
+        buf_lock_t child(&lock, child_id, access_t::read);
+        lock.reset_buf_lock();
+        lock = std::move(child);
     }
+}
 
-    access_t btree_superblock_mode() {
-        return access_t::read;
-    }
+// `num_walks` random walks from children `first_child` to
+// `first_child + num_children - 1` of a frontier node, whose average is split evenly
+// between the buckets of those children.
+struct walk_task_t {
+    size_t frontier_index;
+    size_t first_child;
+    size_t num_children;
+    int num_walks;
+};
 
-    access_t btree_node_mode() {
-        return access_t::read;
+void get_btree_key_distribution(
+        superblock_t *superblock,
+        int depth_limit,
+        int num_walks,
+        const value_bytes_fn_t &value_bytes,
+        int64_t *population_out,
+        std::vector<key_distribution_bucket_t> *buckets_out) {
+    rassert(buckets_out->empty(), "Why is this output parameter not an empty vector\n");
+    *population_out = get_btree_population(superblock);
+
+    const block_id_t root_id = superblock->get_root_block_id();
+    if (root_id == NULL_BLOCK_ID) {
+        superblock->release();
+        return;
+    }
+    std::vector<frontier_node_t> frontier;
+    {
+        buf_lock_t root(superblock->expose_buf(), root_id, access_t::read);
+        superblock->release();
+        collect_buckets(&root, store_key_t::min(), 1, depth_limit, value_bytes,
+                        &frontier, buckets_out);
+    }
+    if (frontier.empty()) {
+        return;
     }
 
-    int depth_limit;
-    int64_t key_count;
-
-    //TODO this is inefficient since each one is maximum size
-    std::vector<store_key_t> *keys;
-};
-
-void get_btree_key_distribution(superblock_t *superblock, int depth_limit,
-                                int64_t *key_count_out,
-                                std::vector<store_key_t> *keys_out) {
-    get_distribution_traversal_helper_t helper(depth_limit, keys_out);
-    rassert(keys_out->empty(), "Why is this output parameter not an empty vector\n");
+    // The walks are shared out between the frontier nodes by their number of
+    // children.  If a node gets fewer walks than it has children, runs of
+    // neighbouring children share a walk.
+    size_t num_frontier_buckets = 0;
+    for (const auto &frontier_node : frontier) {
+        num_frontier_buckets += frontier_node.children.size();
+    }
+    std::vector<walk_task_t> tasks;
+    for (size_t i = 0; i < frontier.size(); ++i) {
+        const size_t num_children = frontier[i].children.size();
+        const int node_walks = std::max<int>(
+            1, static_cast<int64_t>(num_walks) * num_children / num_frontier_buckets);
+        if (static_cast<size_t>(node_walks) >= num_children) {
+            for (size_t c = 0; c < num_children; ++c) {
+                tasks.push_back(walk_task_t{
+                    i, c, 1, static_cast<int>(node_walks / num_children)});
+            }
+        } else {
+            const size_t stride = ceil_divide(num_children, node_walks);
+            for (size_t c = 0; c < num_children; c += stride) {
+                tasks.push_back(walk_task_t{
+                    i, c, std::min(stride, num_children - c), 1});
+            }
+        }
+    }
 
-    cond_t non_interruptor;
-    btree_parallel_traversal(superblock, &helper, &non_interruptor);
-    *key_count_out = helper.key_count;
+    throttled_pmap(tasks.size(), [&](int64_t task_index) {
+        const walk_task_t &task = tasks[task_index];
+        frontier_node_t *frontier_node = &frontier[task.frontier_index];
+        double key_count = 0, bytes = 0;
+        for (int w = 0; w < task.num_walks; ++w) {
+            const size_t child = task.first_child + randint(task.num_children);
+            double walk_key_count, walk_bytes;
+            random_walk(&frontier_node->lock, frontier_node->children[child],
+                        value_bytes, &walk_key_count, &walk_bytes);
+            key_count += walk_key_count;
+            bytes += walk_bytes;
+        }
+        // Each walk estimates the size of a random child of the run, which stands in
+        // for every child of the run.
+        key_count /= task.num_walks;
+        bytes /= task.num_walks;
+        for (size_t c = 0; c < task.num_children; ++c) {
+            key_distribution_bucket_t *bucket =
+                &(*buckets_out)[frontier_node->first_bucket + task.first_child + c];
+            bucket->key_count = key_count;
+            bucket->bytes = bytes;
+        }
+    }, DISTRIBUTION_WALK_CONCURRENCY);
 }
@@ -2,6 +2,7 @@
 #ifndef BTREE_GET_DISTRIBUTION_HPP_
 #define BTREE_GET_DISTRIBUTION_HPP_
 
+#include <functional>
 #include <vector>
 
 #include "btree/keys.hpp"
@@ -9,8 +10,32 @@
 
 class superblock_t;
 
-void get_btree_key_distribution(superblock_t *superblock, int depth_limit,
-                                int64_t *key_count_out,
-                                std::vector<store_key_t> *keys_out);
+/* The estimated number of keys in the key range that starts at `left_key` and ends
+at the `left_key` of the next bucket, and the estimated number of bytes that their
+keys and values take up. */
+struct key_distribution_bucket_t {
+    store_key_t left_key;
+    double key_count;
+    double bytes;
+};
+
+/* Splits the key space of the B-tree into buckets, one for each child of the nodes
+at `depth_limit` (where the root is at depth 1), or one for each key if the leaf
+nodes are no deeper than that.  The buckets below `depth_limit` are estimated by
+about `num_walks` random walks from there down to a leaf node: each walk multiplies
+the number of keys and bytes in the leaf node it ends at by the number of choices it
+had on the way down, which is correct on average no matter how unevenly the tree is
+filled.
+
+`value_bytes` returns the size of the data that a value stands for.
+`*population_out` is set to the population in the stat block, or to -1 if the
+B-tree doesn't have one. */
+void get_btree_key_distribution(
+    superblock_t *superblock,
+    int depth_limit,
+    int num_walks,
+    const std::function<int64_t(const void *)> &value_bytes,
+    int64_t *population_out,
+    std::vector<key_distribution_bucket_t> *buckets_out);
 
 #endif /* BTREE_GET_DISTRIBUTION_HPP_ */
@@ -81,6 +81,21 @@ bool remove(block_size_t block_size, internal_node_t *node, const btree_key_t *k
     return true;
 }
 
+void remove_children(block_size_t block_size, internal_node_t *node, int begin, int end) {
+    rassert(0 <= begin && begin < end && end <= node->npairs);
+    rassert(end - begin < node->npairs, "an internal node can't lose all of its children");
+    const bool removes_last = end == node->npairs;
+    for (int index = end - 1; index >= begin; --index) {
+        impl::delete_pair(node, node->pair_offsets[index]);
+        impl::delete_offset(node, index);
+    }
+    if (removes_last) {
+        impl::make_last_pair_special(node);
+    }
+
+    validate(block_size, node);
+}
+
 void split(block_size_t block_size, internal_node_t *node, internal_node_t *rnode, btree_key_t *median) {
     uint16_t total_pairs = block_size.value() - node->frontmost_offset;
     uint16_t first_pairs = 0;
@@ -291,6 +306,17 @@ bool is_full(const internal_node_t *node) {
     return sizeof(internal_node_t) + (node->npairs + 1) * sizeof(*node->pair_offsets) + impl::pair_size_with_key_size(MAX_KEY_SIZE) >=  node->frontmost_offset;
 }
 
+int free_pairs(const internal_node_t *node) {
+    // `is_full` stays false for `k` more inserts of the largest possible pairs as long
+    // as `(k + 1) * pair_size < available`.
+    const int available = static_cast<int>(node->frontmost_offset)
+        - static_cast<int>(sizeof(internal_node_t))
+        - node->npairs * static_cast<int>(sizeof(*node->pair_offsets));
+    const int pair_size = sizeof(*node->pair_offsets)
+        + impl::pair_size_with_key_size(MAX_KEY_SIZE);
+    return available <= 0 ? 0 : (available - 1) / pair_size;
+}
+
 bool change_unsafe(const internal_node_t *node) {
     return sizeof(internal_node_t) + node->npairs * sizeof(*node->pair_offsets) + MAX_KEY_SIZE >= node->frontmost_offset;
 }
@@ -318,6 +344,12 @@ bool is_underfull(block_size_t block_size, const internal_node_t *node) {
         INTERNAL_EPSILON * 2  < block_size.value() / 2;
 }
 
+bool is_filled(block_size_t block_size, const internal_node_t *node, double fraction) {
+    const size_t used = node->npairs * sizeof(*node->pair_offsets)
+        + (block_size.value() - node->frontmost_offset);
+    return used >= fraction * (block_size.value() - sizeof(internal_node_t));
+}
+
 bool is_mergable(block_size_t block_size, const internal_node_t *node, const internal_node_t *sibling, const internal_node_t *parent) {
     const btree_key_t *key_from_parent;
     if (nodecmp(node, sibling) < 0) {
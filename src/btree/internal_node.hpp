@@ -34,6 +34,9 @@ void init(block_size_t block_size, internal_node_t *node, const internal_node_t
 block_id_t lookup(const internal_node_t *node, const btree_key_t *key);
 bool insert(internal_node_t *node, const btree_key_t *key, block_id_t lnode, block_id_t rnode);
 bool remove(block_size_t block_size, internal_node_t *node, const btree_key_t *key);
+/* Removes the children with indexes `begin` to `end - 1`, whose keys then belong to
+the child after them (or the child before them, if they include the last child). */
+void remove_children(block_size_t block_size, internal_node_t *node, int begin, int end);
 void split(block_size_t block_size, internal_node_t *node, internal_node_t *rnode, btree_key_t *median);
 void merge(block_size_t block_size, const internal_node_t *node, internal_node_t *rnode, const internal_node_t *parent);
 bool level(block_size_t block_size, internal_node_t *node, internal_node_t *sibling,
@@ -43,7 +46,13 @@ int sibling(const internal_node_t *node, const btree_key_t *key, block_id_t *sib
 void update_key(internal_node_t *node, const btree_key_t *key_to_replace, const btree_key_t *replacement_key);
 int nodecmp(const internal_node_t *node1, const internal_node_t *node2);
 bool is_full(const internal_node_t *node);
+// How many more pairs (of any size) can be inserted into `node` one after another
+// with `is_full` still false before each of them.
+int free_pairs(const internal_node_t *node);
 bool is_underfull(block_size_t block_size, const internal_node_t *node);
+// Whether the pairs of `node` take up at least `fraction` of the space in an internal
+// node.
+bool is_filled(block_size_t block_size, const internal_node_t *node, double fraction);
 bool change_unsafe(const internal_node_t *node);
 bool is_mergable(block_size_t block_size, const internal_node_t *node, const internal_node_t *sibling, const internal_node_t *parent);
 bool is_doubleton(const internal_node_t *node);
@@ -568,6 +568,11 @@ bool is_underfull(value_sizer_t *sizer, const leaf_node_t *node) {
     return mandatory_cost(sizer, node, MANDATORY_TIMESTAMPS) < free_space(sizer) / 2 - leaf_epsilon(sizer);
 }
 
+bool is_filled(value_sizer_t *sizer, const leaf_node_t *node, double fraction) {
+    return mandatory_cost(sizer, node, MANDATORY_TIMESTAMPS)
+        >= fraction * free_space(sizer);
+}
+
 
 // Compares indices by looking at values in another array.
 class indirect_index_comparator_t {
@@ -131,6 +131,9 @@ bool is_full(value_sizer_t *sizer, const leaf_node_t *node, const btree_key_t *k
 
 bool is_underfull(value_sizer_t *sizer, const leaf_node_t *node);
 
+// Whether the entries of `node` take up at least `fraction` of the space in a leaf node.
+bool is_filled(value_sizer_t *sizer, const leaf_node_t *node, double fraction);
+
 void split(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *sibling,
            btree_key_t *median_out);
 
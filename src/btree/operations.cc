@@ -378,6 +378,10 @@ void find_keyvalue_location_for_write(
 
     buf_lock_t last_buf;
     buf_lock_t buf;
+    // Whether `buf` and `last_buf` are the last nodes on their level.  The root is,
+    // and so is any new root that a split of the root puts above it.
+    bool buf_is_rightmost = true;
+    bool last_buf_is_rightmost = true;
     {
         // KSI: We can't acquire the block for write here -- we could, but it would
         // worsen the performance of the program -- sometimes we only end up using
@@ -404,6 +408,15 @@ void find_keyvalue_location_for_write(
                 sizer, &buf, &last_buf, superblock, key, nullptr, balancing_detacher);
         }
 
+        // A split might have left `buf` with a right neighbor.  (A merge below can
+        // only take away its right neighbor, so we stay on the safe side.)
+        if (!last_buf.empty()) {
+            buf_read_t read(&last_buf);
+            auto node = static_cast<const internal_node_t *>(read.get_data_read());
+            buf_is_rightmost = last_buf_is_rightmost
+                && internal_node::get_offset_index(node, key) == node->npairs - 1;
+        }
+
         // Check if the node is underfull, and merge/level if it is.
         {
             PROFILE_STARTER_IF_ENABLED(
@@ -453,6 +466,7 @@ void find_keyvalue_location_for_write(
             last_buf = std::move(buf);
             buf = std::move(tmp);
         }
+        last_buf_is_rightmost = buf_is_rightmost;
     }
 
     {
@@ -470,9 +484,90 @@ void find_keyvalue_location_for_write(
     }
 
     keyvalue_location_out->last_buf.swap(last_buf);
+    keyvalue_location_out->last_buf_is_rightmost = last_buf_is_rightmost;
     keyvalue_location_out->buf.swap(buf);
 }
 
+bool move_keyvalue_location_for_write(
+        value_sizer_t *sizer,
+        const btree_key_t *key,
+        keyvalue_location_t *kv_loc) {
+    rassert(!kv_loc->buf.empty());
+
+    if (kv_loc->superblock != nullptr && !kv_loc->last_buf.empty()
+        && kv_loc->superblock->get_root_block_id() == kv_loc->buf.block_id()) {
+        // `check_and_handle_underfull` merged the only two children of the root and
+        // deleted the root, so `buf` is the root now.
+        kv_loc->last_buf.reset_buf_lock();
+    }
+
+    if (!kv_loc->last_buf.empty()) {
+        block_id_t node_id;
+        {
+            buf_read_t read(&kv_loc->last_buf);
+            auto node = static_cast<const internal_node_t *>(read.get_data_read());
+            // `find_keyvalue_location_for_write` only made sure that the parent has
+            // room for one more key, which a split of `buf` might have used up.
+            if (internal_node::is_full(node)) {
+                return false;
+            }
+            int index = internal_node::get_offset_index(node, key);
+            // We know that `key` isn't too small for the subtree of `last_buf`
+            // because no earlier key was.  Unless there is a key to the right of it
+            // in `last_buf`, it might be too large though.
+            if (index == node->npairs - 1 && !kv_loc->last_buf_is_rightmost) {
+                return false;
+            }
+            node_id = internal_node::get_pair_by_index(node, index)->lnode;
+        }
+        if (node_id != kv_loc->buf.block_id()) {
+            // `key` belongs in a sibling, for example the other half of a split.
+            kv_loc->buf.reset_buf_lock();
+            kv_loc->buf = buf_lock_t(&kv_loc->last_buf, node_id, access_t::write);
+        }
+    }
+
+    kv_loc->there_originally_was_value = false;
+    kv_loc->value.reset();
+    scoped_malloc_t<void> tmp(sizer->max_possible_size());
+    {
+        buf_read_t read(&kv_loc->buf);
+        auto node = static_cast<const leaf_node_t *>(read.get_data_read());
+        if (leaf::lookup(sizer, node, key, tmp.get())) {
+            kv_loc->there_originally_was_value = true;
+            kv_loc->value = std::move(tmp);
+        }
+    }
+    return true;
+}
+
+size_t count_keys_for_keyvalue_location(
+        keyvalue_location_t *kv_loc,
+        size_t num_keys,
+        const std::function<const btree_key_t *(size_t)> &key_at) {
+    rassert(kv_loc->superblock == nullptr);
+    rassert(!kv_loc->last_buf.empty());
+    rassert(num_keys > 0);
+
+    buf_read_t read(&kv_loc->last_buf);
+    auto node = static_cast<const internal_node_t *>(read.get_data_read());
+    const int index = internal_node::get_offset_index(node, key_at(0));
+    if (index == node->npairs - 1 && !kv_loc->last_buf_is_rightmost) {
+        // We don't know where the range of `buf` ends.
+        return 1;
+    }
+    // Every key can split the leaf it goes to once, and each split takes a pair in
+    // the parent, which `find_keyvalue_location_for_write` left room for at least one
+    // of.
+    const size_t max_keys = std::min<size_t>(
+        num_keys, std::max(1, internal_node::free_pairs(node)));
+    size_t n = 1;
+    while (n < max_keys && internal_node::get_offset_index(node, key_at(n)) == index) {
+        ++n;
+    }
+    return n;
+}
+
 void find_keyvalue_location_for_read(
         value_sizer_t *sizer,
         superblock_t *superblock, const btree_key_t *key,
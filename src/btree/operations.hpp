@@ -3,6 +3,7 @@
 #define BTREE_OPERATIONS_HPP_
 
 #include <algorithm>
+#include <functional>
 #include <utility>
 #include <vector>
 
@@ -63,11 +64,16 @@ public:
         : btree_collection(),
           pm_keys_read(secs_to_ticks(1)),
           pm_keys_set(secs_to_ticks(1)),
+          pm_rows_post_constructed(secs_to_ticks(1)),
           pm_keys_membership(&btree_collection,
               &pm_keys_read, "keys_read",
               &pm_total_keys_read, "total_keys_read",
               &pm_keys_set, "keys_set",
-              &pm_total_keys_set, "total_keys_set") {
+              &pm_total_keys_set, "total_keys_set",
+              &pm_total_value_bytes_read, "total_value_bytes_read",
+              &pm_total_value_bytes_skipped, "total_value_bytes_skipped",
+              &pm_rows_post_constructed, "rows_post_constructed",
+              &pm_total_rows_post_constructed, "total_rows_post_constructed") {
         if (parent != nullptr) {
             rename(parent, identifier);
         }
@@ -90,10 +96,18 @@ public:
     scoped_ptr_t<perfmon_membership_t> btree_collection_membership;
     perfmon_rate_monitor_t
         pm_keys_read,
-        pm_keys_set;
+        pm_keys_set,
+        // Rows of the primary index that secondary index post-construction has
+        // added to this (secondary index) B-tree.
+        pm_rows_post_constructed;
     perfmon_counter_t
         pm_total_keys_read,
-        pm_total_keys_set;
+        pm_total_keys_set,
+        // Bytes of stored values that range reads loaded, and that they didn't
+        // have to load because they only needed some of the fields.
+        pm_total_value_bytes_read,
+        pm_total_value_bytes_skipped,
+        pm_total_rows_post_constructed;
     perfmon_multi_membership_t pm_keys_membership;
 };
 
@@ -101,7 +115,8 @@ class keyvalue_location_t {
 public:
     keyvalue_location_t()
         : superblock(nullptr), pass_back_superblock(nullptr),
-          there_originally_was_value(false), stat_block(NULL_BLOCK_ID) { }
+          last_buf_is_rightmost(false), there_originally_was_value(false),
+          stat_block(NULL_BLOCK_ID) { }
 
     ~keyvalue_location_t() {
         if (superblock != nullptr) {
@@ -120,6 +135,10 @@ public:
     // The parent buf of buf, if buf is not the root node.  This is hacky.
     buf_lock_t last_buf;
 
+    // True if no key is too large to belong in the subtree of `last_buf`.  False
+    // if we don't know.
+    bool last_buf_is_rightmost;
+
     // The buf owning the leaf node which contains the value.
     buf_lock_t buf;
 
@@ -205,6 +224,29 @@ void find_keyvalue_location_for_write(
         profile::trace_t *trace,
         promise_t<superblock_t *> *pass_back_superblock = nullptr) THROWS_NOTHING;
 
+/* Points `kv_loc` (which `find_keyvalue_location_for_write` filled in, and which
+might have been used with `apply_keyvalue_change` since) at `key` without walking
+down the tree again, if `key` belongs in `kv_loc->buf` or in one of its siblings.
+`key` must not be less than any key `kv_loc` was used for before.  Returns false if
+that's not possible, in which case the caller has to release `kv_loc` and call
+`find_keyvalue_location_for_write` for `key`. */
+bool move_keyvalue_location_for_write(
+        value_sizer_t *sizer,
+        const btree_key_t *key,
+        keyvalue_location_t *kv_loc);
+
+/* Returns how many of the sorted keys `key_at(0)`, ..., `key_at(num_keys - 1)`,
+starting with the one that `find_keyvalue_location_for_write` just filled in `kv_loc`
+for, belong in `kv_loc->buf` with room in its parent for whatever splits
+`apply_keyvalue_change` does for them.  `move_keyvalue_location_for_write` can still
+fail for them if a change merges `kv_loc->buf` with a sibling, so the caller has to be
+ready to walk down the tree again.  `kv_loc` must have released the superblock
+already.  Always at least 1. */
+size_t count_keys_for_keyvalue_location(
+        keyvalue_location_t *kv_loc,
+        size_t num_keys,
+        const std::function<const btree_key_t *(size_t)> &key_at);
+
 void find_keyvalue_location_for_read(
         value_sizer_t *sizer,
         superblock_t *superblock,
@@ -12,6 +12,11 @@ class value_deleter_t {
 public:
     value_deleter_t() { }
     virtual void delete_value(buf_parent_t leaf_node, const void *value) const = 0;
+    // Deletes `value` after it has been replaced by `new_value`, which may share
+    // parts of it.
+    virtual void delete_replaced_value(buf_parent_t leaf_node,
+                                       const void *value,
+                                       const void *new_value) const = 0;
 
 protected:
     virtual ~value_deleter_t() { }
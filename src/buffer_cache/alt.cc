@@ -102,9 +102,10 @@ void alt_txn_throttler_t::inform_memory_limit_change(uint64_t memory_limit,
 
 cache_t::cache_t(serializer_t *serializer,
                  cache_balancer_t *balancer,
-                 perfmon_collection_t *perfmon_collection)
+                 perfmon_collection_t *perfmon_collection,
+                 int64_t soft_durability_flush_delay_ms)
     : throttler_(MINIMUM_SOFT_UNWRITTEN_CHANGES_LIMIT),
-      page_cache_(serializer, balancer, &throttler_),
+      page_cache_(serializer, balancer, &throttler_, soft_durability_flush_delay_ms),
       stats_(make_scoped<alt_cache_stats_t>(&page_cache_, perfmon_collection)) { }
 
 cache_t::~cache_t() {
@@ -240,6 +241,7 @@ txn_t::~txn_t() {
 
     if (durability_ == write_durability_t::SOFT) {
         cache_->page_cache_.flush_and_destroy_txn(std::move(page_txn_),
+                                                  durability_,
                                                   std::bind(&txn_t::inform_tracker,
                                                             cache_,
                                                             ph::_1));
@@ -247,6 +249,7 @@ txn_t::~txn_t() {
         cond_t cond;
         cache_->page_cache_.flush_and_destroy_txn(
                 std::move(page_txn_),
+                durability_,
                 std::bind(&txn_t::pulse_and_inform_tracker,
                           cache_, ph::_1, &cond));
         cond.wait();
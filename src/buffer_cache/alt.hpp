@@ -8,6 +8,7 @@
 
 #include "buffer_cache/page_cache.hpp"
 #include "buffer_cache/types.hpp"
+#include "config/args.hpp"
 #include "containers/two_level_array.hpp"
 #include "repli_timestamp.hpp"
 
@@ -41,9 +42,13 @@ private:
 
 class cache_t : public home_thread_mixin_t {
 public:
+    // `soft_durability_flush_delay_ms` is how long the flushes of soft durability
+    // txns may be delayed to combine them with later ones; zero disables that.
     explicit cache_t(serializer_t *serializer,
                      cache_balancer_t *balancer,
-                     perfmon_collection_t *perfmon_collection);
+                     perfmon_collection_t *perfmon_collection,
+                     int64_t soft_durability_flush_delay_ms
+                         = DEFAULT_SOFT_DURABILITY_FLUSH_DELAY_MS);
     ~cache_t();
 
     max_block_size_t max_block_size() const { return page_cache_.max_block_size(); }
@@ -2,7 +2,9 @@
 #include "buffer_cache/blob.hpp"
 
 #include <stdint.h>
+#include <string.h>
 
+#include <algorithm>
 #include <limits>
 
 #include "buffer_cache/alt.hpp"
@@ -291,6 +293,10 @@ int64_t blob_t::valuesize() const {
     return blob::value_size(ref_, maxreflen_);
 }
 
+bool blob_t::is_small() const {
+    return blob::is_small(ref_, maxreflen_);
+}
+
 void blob_t::detach_subtrees(buf_parent_t root) {
     if (blob::is_small(ref_, maxreflen_)) {
         return;
@@ -562,6 +568,196 @@ void blob_t::write_from_string(const std::string &val,
 
 namespace blob {
 
+block_id_t write_node_reusing_blocks(buf_parent_t parent, int levels,
+                                     block_id_t old_block_id, int64_t old_size,
+                                     const char *data, int64_t size);
+
+// Writes the subtrees for the `size` bytes of `data` to `block_ids_out`.  The
+// subtrees at the same level of the old blob, which held `old_size` bytes, are
+// `old_block_ids`.
+void write_ids_reusing_blocks(buf_parent_t parent, int levels,
+                              const block_id_t *old_block_ids, int64_t old_size,
+                              const char *data, int64_t size,
+                              block_id_t *block_ids_out) {
+    const max_block_size_t block_size = parent.cache()->max_block_size();
+    const int64_t step = stepsize(block_size, levels);
+    int lo, hi;
+    compute_acquisition_offsets(block_size, levels, 0, size, &lo, &hi);
+    throttled_pmap(hi, [&](int i) {
+        int64_t old_subsize, subsize;
+        shrink(block_size, levels, old_size, i, &old_subsize);
+        shrink(block_size, levels, size, i, &subsize);
+        block_ids_out[i] = write_node_reusing_blocks(
+            parent, levels,
+            old_subsize > 0 ? old_block_ids[i] : NULL_BLOCK_ID, old_subsize,
+            data + i * step, subsize);
+    }, choose_concurrency(levels));
+}
+
+// Returns `old_block_id` if the old subtree holds exactly the `size` bytes of
+// `data`, or else a new subtree for them.
+block_id_t write_node_reusing_blocks(buf_parent_t parent, int levels,
+                                     block_id_t old_block_id, int64_t old_size,
+                                     const char *data, int64_t size) {
+    rassert(size > 0);
+    const max_block_size_t block_size = parent.cache()->max_block_size();
+
+    if (levels == 1) {
+        if (old_block_id != NULL_BLOCK_ID && old_size == size) {
+            buf_lock_t old_lock(parent, old_block_id, access_t::read);
+            buf_read_t old_read(&old_lock);
+            uint32_t unused_block_size;
+            const char *old_data
+                = leaf_node_data(old_read.get_data_read(&unused_block_size));
+            if (memcmp(old_data, data, size) == 0) {
+                return old_block_id;
+            }
+        }
+
+        buf_lock_t lock(parent, alt_create_t::create, block_type_t::aux);
+        buf_write_t write(&lock);
+        void *b = write.get_data_write(LEAF_NODE_DATA_OFFSET + size);
+        *static_cast<block_magic_t *>(b) = leaf_node_magic;
+        memcpy(leaf_node_data(b), data, size);
+        return lock.block_id();
+    }
+
+    std::vector<block_id_t> old_block_ids;
+    if (old_block_id != NULL_BLOCK_ID) {
+        buf_lock_t old_lock(parent, old_block_id, access_t::read);
+        buf_read_t old_read(&old_lock);
+        const block_id_t *ids = internal_node_block_ids(old_read.get_data_read());
+        int lo, hi;
+        compute_acquisition_offsets(block_size, levels - 1, 0, old_size, &lo, &hi);
+        old_block_ids.assign(ids, ids + hi);
+    }
+
+    int lo, hi;
+    compute_acquisition_offsets(block_size, levels - 1, 0, size, &lo, &hi);
+    std::vector<block_id_t> block_ids(hi);
+    write_ids_reusing_blocks(parent, levels - 1, old_block_ids.data(), old_size,
+                             data, size, block_ids.data());
+    if (block_ids == old_block_ids) {
+        return old_block_id;
+    }
+
+    buf_lock_t lock(parent, alt_create_t::create, block_type_t::aux);
+    buf_write_t write(&lock);
+    void *b = write.get_data_write();
+    *static_cast<block_magic_t *>(b) = internal_node_magic;
+    std::copy(block_ids.begin(), block_ids.end(), internal_node_block_ids(b));
+    return lock.block_id();
+}
+
+void delete_unshared_node(buf_parent_t parent, int levels,
+                          block_id_t block_id, int64_t size,
+                          block_id_t new_block_id, int64_t new_size);
+
+// Deletes the subtrees `block_ids`, which hold `size` bytes, except for the ones
+// that are shared with `new_block_ids`, the subtrees at the same level of the new
+// blob.
+void delete_unshared_ids(buf_parent_t parent, int levels,
+                         const block_id_t *block_ids, int64_t size,
+                         const block_id_t *new_block_ids, int64_t new_size) {
+    const max_block_size_t block_size = parent.cache()->max_block_size();
+    int lo, hi, new_lo, new_hi;
+    compute_acquisition_offsets(block_size, levels, 0, size, &lo, &hi);
+    compute_acquisition_offsets(block_size, levels, 0, new_size, &new_lo, &new_hi);
+    throttled_pmap(hi, [&](int i) {
+        const block_id_t new_block_id = i < new_hi ? new_block_ids[i] : NULL_BLOCK_ID;
+        if (block_ids[i] != new_block_id) {
+            int64_t subsize, new_subsize;
+            shrink(block_size, levels, size, i, &subsize);
+            shrink(block_size, levels, new_size, i, &new_subsize);
+            delete_unshared_node(parent, levels, block_ids[i], subsize,
+                                 new_block_id, new_subsize);
+        }
+    }, choose_concurrency(levels));
+}
+
+void delete_unshared_node(buf_parent_t parent, int levels,
+                          block_id_t block_id, int64_t size,
+                          block_id_t new_block_id, int64_t new_size) {
+    const max_block_size_t block_size = parent.cache()->max_block_size();
+    buf_lock_t lock(parent, block_id, access_t::write);
+
+    if (levels > 1) {
+        std::vector<block_id_t> block_ids;
+        {
+            buf_read_t read(&lock);
+            const block_id_t *ids = internal_node_block_ids(read.get_data_read());
+            int lo, hi;
+            compute_acquisition_offsets(block_size, levels - 1, 0, size, &lo, &hi);
+            block_ids.assign(ids, ids + hi);
+        }
+        std::vector<block_id_t> new_block_ids;
+        if (new_block_id != NULL_BLOCK_ID) {
+            buf_lock_t new_lock(parent, new_block_id, access_t::read);
+            buf_read_t new_read(&new_lock);
+            const block_id_t *ids = internal_node_block_ids(new_read.get_data_read());
+            int lo, hi;
+            compute_acquisition_offsets(block_size, levels - 1, 0, new_size, &lo, &hi);
+            new_block_ids.assign(ids, ids + hi);
+        }
+        delete_unshared_ids(buf_parent_t(&lock), levels - 1,
+                            block_ids.data(), size, new_block_ids.data(), new_size);
+    }
+
+    // mark_deleted() requires that we have already got the write lock.
+    lock.write_acq_signal()->wait_lazily_unordered();
+    lock.mark_deleted();
+}
+
+}  // namespace blob
+
+void blob_t::write_reusing_blocks(buf_parent_t parent, const blob_t &old_blob,
+                                  const std::string &data) {
+    guarantee(valuesize() == 0);
+    guarantee(maxreflen_ == old_blob.maxreflen_);
+    const max_block_size_t block_size = parent.cache()->max_block_size();
+    const int64_t size = data.size();
+
+    int levels = 0;
+    if (!blob::size_would_be_small(size, maxreflen_)) {
+        levels = blob::big_ref_info(block_size, size, maxreflen_).levels;
+    }
+    if (levels == 0
+        || levels != blob::ref_info(block_size, old_blob.ref_, maxreflen_).levels) {
+        // The bytes at each offset would be in different places of the two trees.
+        append_region(parent, size);
+        write_from_string(data, parent, 0);
+        return;
+    }
+
+    blob::set_small_size_field(ref_, maxreflen_, maxreflen_);
+    blob::set_big_size(ref_, maxreflen_, size);
+    blob::write_ids_reusing_blocks(parent, levels,
+                                   blob::block_ids(old_blob.ref_, maxreflen_),
+                                   blob::big_size(old_blob.ref_, maxreflen_),
+                                   data.data(), size,
+                                   blob::block_ids(ref_, maxreflen_));
+}
+
+void blob_t::clear_unshared(buf_parent_t parent, const blob_t &new_blob) {
+    guarantee(maxreflen_ == new_blob.maxreflen_);
+    const max_block_size_t block_size = parent.cache()->max_block_size();
+    const int levels = blob::ref_info(block_size, ref_, maxreflen_).levels;
+    if (levels == 0
+        || levels != blob::ref_info(block_size, new_blob.ref_, maxreflen_).levels) {
+        clear(parent);
+        return;
+    }
+
+    blob::delete_unshared_ids(parent, levels,
+                              blob::block_ids(ref_, maxreflen_),
+                              blob::big_size(ref_, maxreflen_),
+                              blob::block_ids(new_blob.ref_, maxreflen_),
+                              blob::big_size(new_blob.ref_, maxreflen_));
+    blob::set_small_size(ref_, maxreflen_, 0);
+}
+
+namespace blob {
+
 struct traverse_helper_t {
     virtual buf_lock_t preprocess(buf_parent_t parent, int levels,
                                   block_id_t *block_id) = 0;
@@ -166,6 +166,9 @@ public:
     // than one gazillion.
     int64_t valuesize() const;
 
+    // Returns true if the value is stored in the ref itself, without any blocks.
+    bool is_small() const;
+
     // Detaches the blob's subtrees from the root node (see
     // buf_lock_t::detach_child).
     void detach_subtrees(buf_parent_t root);
@@ -202,6 +205,19 @@ public:
     void write_from_string(const std::string &val, buf_parent_t root,
                            int64_t offset);
 
+    // Fills the blob, which must be empty, with data, which is going to replace the
+    // value of old_blob.  Subtrees of old_blob that would hold the same bytes in the
+    // new blob are not copied, but shared by both blobs, so a small change of a
+    // large value only writes the blocks on the path to the changed bytes.  Since
+    // the bytes at each offset are in the same position of the tree, this works as
+    // long as the size of the value doesn't change by much.
+    void write_reusing_blocks(buf_parent_t root, const blob_t &old_blob,
+                              const std::string &data);
+
+    // Empties the blob like clear(), but leaves the blocks that it shares with
+    // new_blob (which was written with write_reusing_blocks from this blob).
+    void clear_unshared(buf_parent_t root, const blob_t &new_blob);
+
 private:
     bool traverse_to_dimensions(buf_parent_t parent, int levels,
                                 int64_t smaller_size, int64_t bigger_size,
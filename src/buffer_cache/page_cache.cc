@@ -8,6 +8,7 @@
 #include "arch/runtime/coroutines.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/runtime/runtime_utils.hpp"
+#include "arch/timing.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "buffer_cache/cache_balancer.hpp"
@@ -203,9 +204,12 @@ public:
 
 page_cache_t::page_cache_t(serializer_t *_serializer,
                            cache_balancer_t *balancer,
-                           alt_txn_throttler_t *throttler)
+                           alt_txn_throttler_t *throttler,
+                           int64_t soft_durability_flush_delay_ms)
     : max_block_size_(_serializer->max_block_size()),
       serializer_(_serializer),
+      soft_durability_flush_delay_ms_(soft_durability_flush_delay_ms),
+      delayed_flush_scheduled_(false),
       free_list_(_serializer),
       evicter_(),
       read_ahead_cb_(nullptr),
@@ -318,12 +322,13 @@ private:
 
 void page_cache_t::flush_and_destroy_txn(
         scoped_ptr_t<page_txn_t> txn,
+        write_durability_t durability,
         std::function<void(throttler_acq_t *)> on_flush_complete) {
     guarantee(txn->live_acqs_ == 0,
               "A current_page_acq_t lifespan exceeds its page_txn_t's.");
     guarantee(!txn->began_waiting_for_flush_);
 
-    txn->announce_waiting_for_flush();
+    txn->announce_waiting_for_flush(durability);
 
     page_txn_t *page_txn = txn.release();
     flush_and_destroy_txn_waiter_t *sub
@@ -1058,12 +1063,17 @@ void page_txn_t::remove_acquirer(current_page_acq_t *acq) {
     }
 }
 
-void page_txn_t::announce_waiting_for_flush() {
+void page_txn_t::announce_waiting_for_flush(write_durability_t durability) {
     rassert(live_acqs_ == 0);
     rassert(!began_waiting_for_flush_);
     rassert(!spawned_flush_);
     began_waiting_for_flush_ = true;
-    page_cache_->im_waiting_for_flush(this);
+    if (durability == write_durability_t::SOFT
+        && page_cache_->soft_durability_flush_delay_ms_ > 0) {
+        page_cache_->delay_flush(this);
+    } else {
+        page_cache_->im_waiting_for_flush(this);
+    }
 }
 
 std::map<block_id_t, page_cache_t::block_change_t>
@@ -1420,7 +1430,8 @@ void page_cache_t::do_flush_txn_set(page_cache_t *page_cache,
 std::vector<page_txn_t *> page_cache_t::maximal_flushable_txn_set(page_txn_t *base) {
     // Returns all transactions that can presently be flushed, given the newest
     // transaction that has had began_waiting_for_flush_ set.  (We assume all
-    // previous such sets of transactions had flushing begin on them.)
+    // previous such sets of transactions had flushing begin on them, or are in
+    // delayed_flush_txns_.)
     //
     // page_txn_t's `mark` fields can be in the following states:
     //  - not: the page has not yet been considered for processing
@@ -1540,21 +1551,70 @@ void page_cache_t::im_waiting_for_flush(page_txn_t *base) {
         for (auto it = flush_set.begin(); it != flush_set.end(); ++it) {
             rassert(!(*it)->spawned_flush_);
             (*it)->spawned_flush_ = true;
+            delayed_flush_txns_.erase(*it);
         }
+        spawn_flush_txn_set(flush_set);
+    }
+}
 
-        std::map<block_id_t, block_change_t> changes
-            = page_cache_t::compute_changes(flush_set);
+void page_cache_t::delay_flush(page_txn_t *txn) {
+    assert_thread();
+    rassert(txn->began_waiting_for_flush_);
+    rassert(!txn->spawned_flush_);
+    delayed_flush_txns_.insert(txn);
+    if (!delayed_flush_scheduled_) {
+        delayed_flush_scheduled_ = true;
+        coro_t::spawn_sometime(std::bind(&page_cache_t::flush_delayed_txns,
+                                         this,
+                                         drainer_->lock()));
+    }
+}
 
-        if (!changes.empty()) {
-            coro_t::spawn_now_dangerously(std::bind(&page_cache_t::do_flush_txn_set,
-                                                    this,
-                                                    &changes,
-                                                    flush_set));
-        } else {
-            // Flush complete.  do_flush_txn_set does this in the write case.
-            page_cache_t::remove_txn_set_from_graph(this, flush_set);
+void page_cache_t::flush_delayed_txns(auto_drainer_t::lock_t lock) {
+    try {
+        nap(soft_durability_flush_delay_ms_, lock.get_drain_signal());
+    } catch (const interrupted_exc_t &) {
+        // The page cache is being destroyed, so we flush right away.
+    }
+    assert_thread();
+    ASSERT_FINITE_CORO_WAITING;
+    delayed_flush_scheduled_ = false;
+
+    // All the delayed txns go into a single flush set, so that every block gets
+    // written at most once.  Txns that can't be flushed yet (because one of their
+    // preceders hasn't begun waiting for a flush) get flushed along with that
+    // preceder later, like in im_waiting_for_flush.
+    std::vector<page_txn_t *> flush_set;
+    while (!delayed_flush_txns_.empty()) {
+        page_txn_t *base = *delayed_flush_txns_.begin();
+        delayed_flush_txns_.erase(delayed_flush_txns_.begin());
+        std::vector<page_txn_t *> base_set
+            = page_cache_t::maximal_flushable_txn_set(base);
+        for (page_txn_t *txn : base_set) {
+            rassert(!txn->spawned_flush_);
+            txn->spawned_flush_ = true;
+            delayed_flush_txns_.erase(txn);
+            flush_set.push_back(txn);
         }
     }
+    if (!flush_set.empty()) {
+        spawn_flush_txn_set(flush_set);
+    }
+}
+
+void page_cache_t::spawn_flush_txn_set(const std::vector<page_txn_t *> &flush_set) {
+    std::map<block_id_t, block_change_t> changes
+        = page_cache_t::compute_changes(flush_set);
+
+    if (!changes.empty()) {
+        coro_t::spawn_now_dangerously(std::bind(&page_cache_t::do_flush_txn_set,
+                                                this,
+                                                &changes,
+                                                flush_set));
+    } else {
+        // Flush complete.  do_flush_txn_set does this in the write case.
+        page_cache_t::remove_txn_set_from_graph(this, flush_set);
+    }
 }
 
 
@@ -327,13 +327,19 @@ class page_cache_t : public home_thread_mixin_t {
 public:
     page_cache_t(serializer_t *serializer,
                  cache_balancer_t *balancer,
-                 alt_txn_throttler_t *throttler);
+                 alt_txn_throttler_t *throttler,
+                 int64_t soft_durability_flush_delay_ms);
     ~page_cache_t();
 
     // Takes a txn to be flushed.  Calls on_flush_complete() (which resets the
-    // throttler_acq parameter) when done.
+    // throttler_acq parameter) when done.  Soft durability txns are not flushed
+    // right away, but up to soft_durability_flush_delay_ms later, together with the
+    // other soft durability txns committed in the meantime.  That way a block that
+    // gets modified over and over again is written once per flush, and not once per
+    // txn.
     void flush_and_destroy_txn(
             scoped_ptr_t<page_txn_t> txn,
+            write_durability_t durability,
             std::function<void(throttler_acq_t *)> on_flush_complete);
 
     current_page_t *page_for_block_id(block_id_t block_id);
@@ -416,6 +422,9 @@ private:
     static std::vector<page_txn_t *> maximal_flushable_txn_set(page_txn_t *base);
 
     void im_waiting_for_flush(page_txn_t *txns);
+    void delay_flush(page_txn_t *txn);
+    void flush_delayed_txns(auto_drainer_t::lock_t lock);
+    void spawn_flush_txn_set(const std::vector<page_txn_t *> &flush_set);
 
     friend class current_page_acq_t;
     repli_timestamp_t recency_for_block_id(block_id_t id) {
@@ -466,6 +475,16 @@ private:
 
     std::unordered_map<block_id_t, current_page_t *> current_pages_;
 
+    // Soft durability txns that began waiting for a flush, but whose flush hasn't
+    // been spawned yet.  A txn is removed from here when its flush gets spawned,
+    // possibly early as part of the flush of some hard durability txn.
+    std::set<page_txn_t *> delayed_flush_txns_;
+    // How long soft durability txns are delayed.  If it's zero, they are flushed
+    // right away, like hard durability txns.
+    const int64_t soft_durability_flush_delay_ms_;
+    // True while a flush_delayed_txns coroutine is napping.
+    bool delayed_flush_scheduled_;
+
     free_list_t free_list_;
 
     evicter_t evicter_;
@@ -593,7 +612,7 @@ private:
     void add_acquirer(current_page_acq_t *acq);
     void remove_acquirer(current_page_acq_t *acq);
 
-    void announce_waiting_for_flush();
+    void announce_waiting_for_flush(write_durability_t durability);
 
     page_cache_t *page_cache_;
     // This can be NULL, if the txn is not part of some cache conn.
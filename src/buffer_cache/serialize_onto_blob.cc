@@ -1,5 +1,7 @@
 #include "buffer_cache/serialize_onto_blob.hpp"
 
+#include "containers/archive/string_stream.hpp"
+
 void write_onto_blob(buf_parent_t parent, blob_t *blob,
                      const write_message_t &wm) {
     blob->clear(parent);
@@ -18,3 +20,19 @@ void write_onto_blob(buf_parent_t parent, blob_t *blob,
               "Blob not filled by write_message_t (Was it made too big?)");
 }
 
+
+void write_onto_blob_reusing_blocks(buf_parent_t parent, blob_t *blob,
+                                    const blob_t &old_blob,
+                                    const write_message_t &wm) {
+    if (old_blob.is_small()) {
+        // There are no blocks to share, so we don't need the value in one piece.
+        write_onto_blob(parent, blob, wm);
+        return;
+    }
+
+    string_stream_t stream;
+    int res = send_write_message(&stream, &wm);
+    guarantee(res == 0);
+    blob->clear(parent);
+    blob->write_reusing_blocks(parent, old_blob, stream.str());
+}
@@ -11,6 +11,13 @@
 void write_onto_blob(buf_parent_t parent, blob_t *blob,
                      const write_message_t &wm);
 
+// Like write_onto_blob, for a blob whose value replaces the value of old_blob.  The
+// two blobs can share blocks (see blob_t::write_reusing_blocks), which means that
+// old_blob must be deleted with blob_t::clear_unshared.
+void write_onto_blob_reusing_blocks(buf_parent_t parent, blob_t *blob,
+                                    const blob_t &old_blob,
+                                    const write_message_t &wm);
+
 template <cluster_version_t W, class T>
 void serialize_onto_blob(buf_parent_t parent, blob_t *blob,
                          const T &value) {
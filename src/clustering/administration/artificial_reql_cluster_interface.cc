@@ -510,6 +510,19 @@ bool artificial_reql_cluster_interface_t::sindex_list(
         db, table, interruptor, error_out, configs_and_statuses_out);
 }
 
+bool artificial_reql_cluster_interface_t::sindex_configs(
+        counted_t<const ql::db_t> db,
+        const name_string_t &table,
+        signal_t *interruptor,
+        admin_err_t *error_out,
+        std::map<std::string, sindex_config_t> *configs_out) {
+    if (db->name == m_database) {
+        configs_out->clear();
+        return true;
+    }
+    return m_next->sindex_configs(db, table, interruptor, error_out, configs_out);
+}
+
 admin_artificial_tables_t::admin_artificial_tables_t(
         real_reql_cluster_interface_t *_next_reql_cluster_interface,
         boost::shared_ptr<semilattice_readwrite_view_t<auth_semilattice_metadata_t> >
@@ -1,6 +1,7 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/administration/persist/file.hpp"
 
+#include "arch/runtime/coroutines.hpp"
 #include "btree/depth_first_traversal.hpp"
 #include "btree/types.hpp"
 #include "buffer_cache/blob.hpp"
@@ -140,6 +141,11 @@ public:
             blob::btree_maxreflen);
         blob.clear(parent);
     }
+    void delete_replaced_value(buf_parent_t parent, const void *value,
+                               const void *) const {
+        // Metadata values are written from scratch, so they share no blocks.
+        delete_value(parent, value);
+    }
 };
 
 class metadata_value_detacher_t : public value_deleter_t {
@@ -153,6 +159,10 @@ public:
                     blob::btree_maxreflen);
         blob.detach_subtrees(parent);
     }
+    void delete_replaced_value(buf_parent_t parent, const void *value,
+                               const void *) const {
+        delete_value(parent, value);
+    }
 };
 
 metadata_file_t::read_txn_t::read_txn_t(
@@ -292,12 +302,48 @@ void metadata_file_t::write_txn_t::write_bin(
         &detacher, &null_cb, delete_mode_t::ERASE);
 }
 
+void metadata_file_t::write_grouped(
+        const std::function<void(write_txn_t *, signal_t *)> &fn) {
+    cond_t done;
+    grouped_writes.push_back(std::make_pair(&fn, &done));
+    if (!grouped_writes_running) {
+        /* `spawn_sometime()` doesn't start the coroutine until we block, so the calls
+        to `write_grouped()` that arrive in the meantime join the same transaction. */
+        grouped_writes_running = true;
+        coro_t::spawn_sometime(std::bind(
+            &metadata_file_t::perform_grouped_writes, this, drainer.lock()));
+    }
+    done.wait_lazily_unordered();
+}
+
+void metadata_file_t::perform_grouped_writes(auto_drainer_t::lock_t) {
+    /* The writes can't be interrupted; `write_grouped()` is only called by objects that
+    have to be destroyed before the metadata file. */
+    cond_t non_interruptor;
+    while (!grouped_writes.empty()) {
+        std::vector<std::pair<
+            const std::function<void(write_txn_t *, signal_t *)> *, cond_t *> > batch;
+        batch.swap(grouped_writes);
+        {
+            write_txn_t txn(this, &non_interruptor);
+            for (const auto &pair : batch) {
+                (*pair.first)(&txn, &non_interruptor);
+            }
+        }
+        for (const auto &pair : batch) {
+            pair.second->pulse();
+        }
+    }
+    grouped_writes_running = false;
+}
+
 metadata_file_t::metadata_file_t(
         io_backender_t *io_backender,
         const base_path_t &base_path,
         perfmon_collection_t *perfmon_parent,
         signal_t *interruptor) :
-    btree_stats(perfmon_parent, "metadata")
+    btree_stats(perfmon_parent, "metadata"),
+    grouped_writes_running(false)
 {
     filepath_file_opener_t file_opener(get_filename(base_path), io_backender);
     init_serializer(&file_opener, perfmon_parent);
@@ -358,7 +404,8 @@ metadata_file_t::metadata_file_t(
         perfmon_collection_t *perfmon_parent,
         const std::function<void(write_txn_t *, signal_t *)> &initializer,
         signal_t *interruptor) :
-    btree_stats(perfmon_parent, "metadata")
+    btree_stats(perfmon_parent, "metadata"),
+    grouped_writes_running(false)
 {
     filepath_file_opener_t file_opener(get_filename(base_path), io_backender);
     log_serializer_t::create(
@@ -396,7 +443,8 @@ void metadata_file_t::init_serializer(
     }
     serializer.init(new merger_serializer_t(
         std::move(standard_ser),
-        MERGER_SERIALIZER_MAX_ACTIVE_WRITES));
+        MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+        perfmon_parent));
 }
 
 serializer_filepath_t metadata_file_t::get_filename(const base_path_t &path) {
@@ -5,6 +5,7 @@
 #include "btree/operations.hpp"
 #include "buffer_cache/alt.hpp"
 #include "buffer_cache/types.hpp"
+#include "concurrency/auto_drainer.hpp"
 #include "concurrency/rwlock.hpp"
 #include "serializer/types.hpp"
 
@@ -139,6 +140,15 @@ public:
             signal_t *interruptor);
     };
 
+    /* `write_grouped()` runs `fn` in a write transaction that it shares with the other
+    calls to `write_grouped()` that arrive at about the same time, and returns once that
+    transaction is on disk. Many small writes from different coroutines, such as the Raft
+    log entries of many tables that are being reconfigured at once, then cost one
+    transaction and one flush instead of one each. `fn` must not block on anything but
+    the transaction, and a caller must not rely on the writes of another caller that is
+    still waiting. */
+    void write_grouped(const std::function<void(write_txn_t *, signal_t *)> &fn);
+
     // Used to open an existing metadata file
     metadata_file_t(
         io_backender_t *io_backender,
@@ -162,12 +172,22 @@ private:
 
     static serializer_filepath_t get_filename(const base_path_t &path);
 
+    void perform_grouped_writes(auto_drainer_t::lock_t keepalive);
+
     scoped_ptr_t<merger_serializer_t> serializer;
     scoped_ptr_t<cache_balancer_t> balancer;
     scoped_ptr_t<cache_t> cache;
     scoped_ptr_t<cache_conn_t> cache_conn;
     btree_stats_t btree_stats;
     rwlock_t rwlock;
+
+    /* The calls to `write_grouped()` that wait for the next transaction */
+    std::vector<std::pair<
+        const std::function<void(write_txn_t *, signal_t *)> *, cond_t *> >
+            grouped_writes;
+    bool grouped_writes_running;
+
+    auto_drainer_t drainer;
 };
 
 #endif /* CLUSTERING_ADMINISTRATION_PERSIST_FILE_HPP_ */
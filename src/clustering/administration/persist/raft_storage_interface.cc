@@ -136,45 +136,37 @@ table_raft_storage_interface_t::get() {
 void table_raft_storage_interface_t::write_current_term_and_voted_for(
         raft_term_t current_term,
         raft_member_id_t voted_for) {
-    cond_t non_interruptor;
-    metadata_file_t::write_txn_t txn(file, &non_interruptor);
     state.current_term = current_term;
     state.voted_for = voted_for;
-    txn.write(
-        mdprefix_table_raft_header().suffix(uuid_to_str(table_id)),
-        table_raft_stored_header_t::from_state(state),
-        &non_interruptor);
+    write_header();
 }
 
 void table_raft_storage_interface_t::write_commit_index(
         raft_log_index_t commit_index) {
-    cond_t non_interruptor;
-    metadata_file_t::write_txn_t txn(file, &non_interruptor);
     state.commit_index = commit_index;
-    txn.write(
-        mdprefix_table_raft_header().suffix(uuid_to_str(table_id)),
-        table_raft_stored_header_t::from_state(state),
-        &non_interruptor);
+    write_header();
 }
 
 void table_raft_storage_interface_t::write_log_replace_tail(
         const raft_log_t<table_raft_state_t> &source,
         raft_log_index_t first_replaced) {
-    cond_t non_interruptor;
-    metadata_file_t::write_txn_t txn(file, &non_interruptor);
     guarantee(first_replaced > state.log.prev_index);
     guarantee(first_replaced <= state.log.get_latest_index() + 1);
-    for (raft_log_index_t i = first_replaced;
-            i <= std::max(state.log.get_latest_index(), source.get_latest_index()); ++i) {
-        metadata_file_t::key_t<raft_log_entry_t<table_raft_state_t> > key =
-            mdprefix_table_raft_log().suffix(
-                uuid_to_str(table_id) + "/" + log_index_to_str(i));
-        if (i <= source.get_latest_index()) {
-            txn.write(key, source.get_entry_ref(i), &non_interruptor);
-        } else {
-            txn.erase(key, &non_interruptor);
+    file->write_grouped(
+    [&](metadata_file_t::write_txn_t *txn, signal_t *interruptor) {
+        for (raft_log_index_t i = first_replaced;
+                i <= std::max(state.log.get_latest_index(), source.get_latest_index());
+                ++i) {
+            metadata_file_t::key_t<raft_log_entry_t<table_raft_state_t> > key =
+                mdprefix_table_raft_log().suffix(
+                    uuid_to_str(table_id) + "/" + log_index_to_str(i));
+            if (i <= source.get_latest_index()) {
+                txn->write(key, source.get_entry_ref(i), interruptor);
+            } else {
+                txn->erase(key, interruptor);
+            }
         }
-    }
+    });
     if (first_replaced != state.log.get_latest_index() + 1) {
         state.log.delete_entries_from(first_replaced);
     }
@@ -185,14 +177,15 @@ void table_raft_storage_interface_t::write_log_replace_tail(
 
 void table_raft_storage_interface_t::write_log_append_one(
         const raft_log_entry_t<table_raft_state_t> &entry) {
-    cond_t non_interruptor;
-    metadata_file_t::write_txn_t txn(file, &non_interruptor);
     raft_log_index_t index = state.log.get_latest_index() + 1;
-    txn.write(
-        mdprefix_table_raft_log().suffix(
-            uuid_to_str(table_id) + "/" + log_index_to_str(index)),
-        entry,
-        &non_interruptor);
+    file->write_grouped(
+    [&](metadata_file_t::write_txn_t *txn, signal_t *interruptor) {
+        txn->write(
+            mdprefix_table_raft_log().suffix(
+                uuid_to_str(table_id) + "/" + log_index_to_str(index)),
+            entry,
+            interruptor);
+    });
     state.log.append(entry);
 }
 
@@ -203,29 +196,31 @@ void table_raft_storage_interface_t::write_snapshot(
         raft_log_index_t log_prev_index,
         raft_term_t log_prev_term,
         raft_log_index_t commit_index) {
-    cond_t non_interruptor;
-    metadata_file_t::write_txn_t txn(file, &non_interruptor);
     state.commit_index = commit_index;
-    txn.write(
-        mdprefix_table_raft_header().suffix(uuid_to_str(table_id)),
-        table_raft_stored_header_t::from_state(state),
-        &non_interruptor);
     table_raft_stored_snapshot_t snapshot;
     snapshot.snapshot_state = snapshot_state;
     snapshot.snapshot_config = snapshot_config;
     snapshot.log_prev_index = log_prev_index;
     snapshot.log_prev_term = log_prev_term;
-    txn.write(
-        mdprefix_table_raft_snapshot().suffix(uuid_to_str(table_id)),
-        snapshot,
-        &non_interruptor);
-    for (raft_log_index_t i = state.log.prev_index + 1;
-            i <= (clear_log ? state.log.get_latest_index() : log_prev_index); ++i) {
-        txn.erase(
-            mdprefix_table_raft_log().suffix(
-                uuid_to_str(table_id) + "/" + log_index_to_str(i)),
-            &non_interruptor);
-    }
+    file->write_grouped(
+    [&](metadata_file_t::write_txn_t *txn, signal_t *interruptor) {
+        txn->write(
+            mdprefix_table_raft_header().suffix(uuid_to_str(table_id)),
+            table_raft_stored_header_t::from_state(state),
+            interruptor);
+        txn->write(
+            mdprefix_table_raft_snapshot().suffix(uuid_to_str(table_id)),
+            snapshot,
+            interruptor);
+        for (raft_log_index_t i = state.log.prev_index + 1;
+                i <= (clear_log ? state.log.get_latest_index() : log_prev_index);
+                ++i) {
+            txn->erase(
+                mdprefix_table_raft_log().suffix(
+                    uuid_to_str(table_id) + "/" + log_index_to_str(i)),
+                interruptor);
+        }
+    });
     state.snapshot_state = std::move(snapshot.snapshot_state);
     state.snapshot_config = std::move(snapshot.snapshot_config);
     if (clear_log) {
@@ -237,3 +232,12 @@ void table_raft_storage_interface_t::write_snapshot(
     }
 }
 
+void table_raft_storage_interface_t::write_header() {
+    file->write_grouped(
+    [&](metadata_file_t::write_txn_t *txn, signal_t *interruptor) {
+        txn->write(
+            mdprefix_table_raft_header().suffix(uuid_to_str(table_id)),
+            table_raft_stored_header_t::from_state(state),
+            interruptor);
+    });
+}
@@ -81,6 +81,10 @@ public:
         raft_log_index_t commit_index);
 
 private:
+    /* The `write_*()` methods use `metadata_file_t::write_grouped()`, so that the Raft
+    writes of many tables share a transaction. */
+    void write_header();
+
     metadata_file_t *const file;
     namespace_id_t const table_id;
     raft_persistent_state_t<table_raft_state_t> state;
@@ -68,7 +68,8 @@ public:
             perfmon_collection_serializers));
         serializer.init(new merger_serializer_t(
             std::move(inner_serializer),
-            MERGER_SERIALIZER_MAX_ACTIVE_WRITES));
+            MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+            perfmon_collection_serializers));
 
         std::vector<serializer_t *> ptrs;
         ptrs.push_back(serializer.get());
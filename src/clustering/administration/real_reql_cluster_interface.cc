@@ -497,7 +497,7 @@ bool real_reql_cluster_interface_t::table_estimate_doc_counts(
 
         /* Perform a distribution query against the database */
         std::map<store_key_t, int64_t> counts;
-        fetch_distribution(table_id, this, &interruptor_on_home, &counts);
+        fetch_distribution(table_id, this, &interruptor_on_home, &counts, nullptr);
 
         /* Match the results of the distribution query against the table's shard
         boundaries */
@@ -946,13 +946,15 @@ void real_reql_cluster_interface_t::rebalance_internal(
         throw no_such_table_exc_t();
     }
 
-    std::map<store_key_t, int64_t> counts;
-    fetch_distribution(table_id, this, interruptor_on_home, &counts);
+    /* The shards are balanced by the size of their data, not by their number of
+    documents. */
+    std::map<store_key_t, int64_t> counts, bytes;
+    fetch_distribution(table_id, this, interruptor_on_home, &counts, &bytes);
 
     /* If there's not enough data to rebalance, return `rebalanced: 0` but don't report
     an error */
     bool actually_rebalanced = calculate_split_points_with_distribution(
-        counts, config.config.shards.size(), &config.shard_scheme);
+        bytes, config.config.shards.size(), &config.shard_scheme);
     if (actually_rebalanced) {
         table_config_and_shards_change_t table_config_and_shards_change(
             table_config_and_shards_change_t::set_table_config_and_shards_t{ config });
@@ -1228,6 +1230,7 @@ bool real_reql_cluster_interface_t::sindex_create(
             table_config_and_shards_change_t::sindex_create_t{name, config});
         m_table_meta_client->set_config(
             table_id, table_config_and_shards_change, &interruptor_on_home);
+        m_rdb_context->sindex_planning_cache.invalidate(table_id);
 
         return true;
     } catch (const config_change_exc_t &) {
@@ -1265,6 +1268,7 @@ bool real_reql_cluster_interface_t::sindex_drop(
             table_config_and_shards_change_t::sindex_drop_t{name});
         m_table_meta_client->set_config(
             table_id, table_config_and_shards_change, &interruptor_on_home);
+        m_rdb_context->sindex_planning_cache.invalidate(table_id);
 
         return true;
     } catch (const config_change_exc_t &) {
@@ -1305,6 +1309,7 @@ bool real_reql_cluster_interface_t::sindex_rename(
                 name, new_name, overwrite});
         m_table_meta_client->set_config(
             table_id, table_config_and_shards_change, &interruptor_on_home);
+        m_rdb_context->sindex_planning_cache.invalidate(table_id);
 
         return true;
     } catch (const config_change_exc_t &) {
@@ -1351,6 +1356,29 @@ bool real_reql_cluster_interface_t::sindex_list(
         "Failed to retrieve all secondary indexes.")
 }
 
+bool real_reql_cluster_interface_t::sindex_configs(
+        counted_t<const ql::db_t> db,
+        const name_string_t &table_name,
+        signal_t *interruptor_on_caller,
+        admin_err_t *error_out,
+        std::map<std::string, sindex_config_t> *configs_out) {
+    guarantee(db->name != name_string_t::guarantee_valid("rethinkdb"),
+        "real_reql_cluster_interface_t should never get queries for system tables");
+    cross_thread_signal_t interruptor_on_home(interruptor_on_caller, home_thread());
+    try {
+        on_thread_t thread_switcher(home_thread());
+        namespace_id_t table_id;
+        m_table_meta_client->find(db->id, table_name, &table_id);
+        table_config_and_shards_t config;
+        m_table_meta_client->get_config(table_id, &interruptor_on_home, &config);
+        *configs_out = std::move(config.config.sindexes);
+        return true;
+    } CATCH_NAME_ERRORS(db->name, table_name, error_out)
+      CATCH_OP_ERRORS(db->name, table_name, error_out,
+        "Failed to retrieve all secondary indexes.",
+        "Failed to retrieve all secondary indexes.")
+}
+
 void real_reql_cluster_interface_t::wait_for_cluster_metadata_to_propagate(
         const cluster_semilattice_metadata_t &metadata,
         signal_t *interruptor_on_caller) {
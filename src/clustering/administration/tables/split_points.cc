@@ -89,7 +89,8 @@ void fetch_distribution(
         const namespace_id_t &table_id,
         real_reql_cluster_interface_t *reql_cluster_interface,
         signal_t *interruptor,
-        std::map<store_key_t, int64_t> *counts_out)
+        std::map<store_key_t, int64_t> *counts_out,
+        std::map<store_key_t, int64_t> *bytes_out)
         THROWS_ONLY(interrupted_exc_t, failed_table_op_exc_t, no_such_table_exc_t) {
     namespace_interface_access_t ns_if_access =
         reql_cluster_interface->get_namespace_repo()->get_namespace_interface(
@@ -113,21 +114,25 @@ void fetch_distribution(
         /* If `get_name()` didn't throw, the table exists but is inaccessible */
         throw failed_table_op_exc_t();
     }
-    *counts_out = std::move(
-        boost::get<distribution_read_response_t>(resp.response).key_counts);
+    distribution_read_response_t *dist_resp =
+        boost::get<distribution_read_response_t>(&resp.response);
+    *counts_out = std::move(dist_resp->key_counts);
+    if (bytes_out != nullptr) {
+        *bytes_out = std::move(dist_resp->key_bytes);
+    }
 }
 
 bool calculate_split_points_with_distribution(
-        const std::map<store_key_t, int64_t> &counts,
+        const std::map<store_key_t, int64_t> &weights,
         size_t num_shards,
         table_shard_scheme_t *split_points_out) {
     std::vector<std::pair<int64_t, store_key_t> > pairs;
-    int64_t total_count = 0;
-    for (auto const &pair : counts) {
+    int64_t total_weight = 0;
+    for (auto const &pair : weights) {
         if (pair.second != 0) {
-            pairs.push_back(std::make_pair(total_count, pair.first));
+            pairs.push_back(std::make_pair(total_weight, pair.first));
         }
-        total_count += pair.second;
+        total_weight += pair.second;
     }
     if (pairs.size() < static_cast<size_t>(num_shards)) {
         return false;
@@ -136,19 +141,19 @@ bool calculate_split_points_with_distribution(
     split_points_out->split_points.clear();
     size_t left_pair = 0;
     for (size_t split_index = 1; split_index < num_shards; ++split_index) {
-        int64_t split_count = (split_index * total_count) / num_shards;
-        rassert(pairs[left_pair].first <= split_count);
+        int64_t split_weight = (split_index * total_weight) / num_shards;
+        rassert(pairs[left_pair].first <= split_weight);
         while (left_pair+1 < pairs.size() &&
-                pairs[left_pair+1].first <= split_count) {
+                pairs[left_pair+1].first <= split_weight) {
             ++left_pair;
         }
         std::pair<int64_t, store_key_t> left = pairs[left_pair];
         std::pair<int64_t, store_key_t> right =
             (left_pair == pairs.size() - 1)
-                ? std::make_pair(total_count, store_key_t::max())
+                ? std::make_pair(total_weight, store_key_t::max())
                 : pairs[left_pair+1];
         store_key_t split_key = interpolate_key(left.second, right.second,
-            (split_count - left.first) / static_cast<double>(right.first - left.first));
+            (split_weight - left.first) / static_cast<double>(right.first - left.first));
         split_points_out->split_points.push_back(split_key);
     }
     ensure_distinct(&split_points_out->split_points);
@@ -224,11 +229,12 @@ void calculate_split_points_intelligently(
         table_shard_scheme_t *split_points_out)
         THROWS_ONLY(interrupted_exc_t, failed_table_op_exc_t, no_such_table_exc_t) {
     if (num_shards > old_split_points.num_shards()) {
-        std::map<store_key_t, int64_t> counts;
-        fetch_distribution(table_id, reql_cluster_interface, interruptor, &counts);
+        std::map<store_key_t, int64_t> counts, bytes;
+        fetch_distribution(
+            table_id, reql_cluster_interface, interruptor, &counts, &bytes);
         if (!calculate_split_points_with_distribution(
-                counts, num_shards, split_points_out)) {
-            /* There aren't enough documents to calculate distribution. We'll just assume
+                bytes, num_shards, split_points_out)) {
+            /* There isn't enough data to calculate distribution. We'll just assume
             the user is going to use UUID primary keys. If we got it wrong, they will end
             up with horribly unbalanced data, but it's the best we can do. */
             calculate_split_points_for_uuids(num_shards, split_points_out);
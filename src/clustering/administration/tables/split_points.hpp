@@ -14,20 +14,25 @@ class real_reql_cluster_interface_t;
 class signal_t;
 class table_shard_scheme_t;
 
-/* `fetch_distribution` fetches the distribution information from the database. */
+/* `fetch_distribution` fetches the distribution information from the database: the
+estimated number of documents in each key range, and (unless `bytes_out` is null) the
+estimated number of bytes that they take up. */
 void fetch_distribution(
         const namespace_id_t &table_id,
         real_reql_cluster_interface_t *reql_cluster_interface,
         signal_t *interruptor,
-        std::map<store_key_t, int64_t> *counts_out)
+        std::map<store_key_t, int64_t> *counts_out,
+        std::map<store_key_t, int64_t> *bytes_out)
         THROWS_ONLY(interrupted_exc_t, failed_table_op_exc_t, no_such_table_exc_t);
 
-/* `calculate_split_points_with_distribution` generates a set of split points that are
-guaranteed to divide the data approximately evenly, using the results of
-`fetch_distribution()`. It returns `false` if there are too few documents in the
-database. */
+/* `calculate_split_points_with_distribution` generates a set of split points that
+divide `weights` approximately evenly. `weights` maps the left bound of each key range
+to its weight; it can be either of the maps that `fetch_distribution()` returns, and the
+split points then balance the number of documents or the number of bytes. Using the
+bytes makes the shards about equally large even if the documents vary in size. It
+returns `false` if fewer than `num_shards` key ranges have a non-zero weight. */
 bool calculate_split_points_with_distribution(
-        const std::map<store_key_t, int64_t> &counts,
+        const std::map<store_key_t, int64_t> &weights,
         size_t num_shards,
         table_shard_scheme_t *split_points_out);
 
@@ -47,9 +52,9 @@ void calculate_split_points_by_interpolation(
         table_shard_scheme_t *split_points_out);
 
 /* `calculate_split_points_intelligently` picks one of the above methods based on its
-input. If the number of shards is being increased, it takes a distribution; if the number
-is being decreased, it interpolates; and if the number stays the same, it uses the old
-split points. It fails if it can't read the distribution from the database. */
+input. If the number of shards is being increased, it takes a distribution by bytes; if
+the number is being decreased, it interpolates; and if the number stays the same, it uses
+the old split points. It fails if it can't read the distribution from the database. */
 void calculate_split_points_intelligently(
         namespace_id_t table_id,
         real_reql_cluster_interface_t *reql_cluster_interface,
@@ -743,9 +743,12 @@ private:
     static const int32_t election_timeout_min_ms = 1000,
                          election_timeout_max_ms = 2000;
 
-    /* When the number of committed entries in the log exceeds this number, we will take
-    a snapshot to compress them. */
-    static const size_t snapshot_threshold = 20;
+    /* When the committed entries in the log take up more space on disk than the
+    snapshot, we take a new snapshot to compress them. This way writing the snapshot
+    costs at most as much as writing the entries did, no matter if the state is small
+    and changes often or is large and changes rarely. We don't bother for logs of less
+    than `snapshot_min_log_size` bytes. */
+    static const size_t snapshot_min_log_size = 64 * 1024;
 
     /* Note: Methods prefixed with `follower_`, `candidate_`, or `leader_` are methods
     that are only used when in that state. This convention will hopefully make the code
@@ -800,6 +803,17 @@ private:
         raft_log_index_t first,
         raft_log_index_t last);
 
+    /* `serialized_size()` returns the number of bytes that a snapshot, or the entries
+    from `log` with indexes `first <= index <= last`, take up when they are serialized.
+    */
+    static size_t serialized_size(
+        const state_t &state,
+        const raft_complex_config_t &config);
+    static size_t serialized_size(
+        const raft_log_t<state_t> &log,
+        raft_log_index_t first,
+        raft_log_index_t last);
+
     /* `update_term()` sets the term to `new_term` and resets all per-term variables.
     Since we often want to set `ps().voted_for` to something immediately after starting a
     new term, it allows setting that to avoid an extra storage write operation. */
@@ -930,6 +944,12 @@ private:
     `latest_state` must be updated to keep in sync. */
     watchable_variable_t<state_and_config_t> latest_state;
 
+    /* `snapshot_size` is the serialized size of the snapshot, and `committed_log_size`
+    is the serialized size of the log entries that have been committed since then. They
+    tell `update_commit_index()` when to take a new snapshot. */
+    size_t snapshot_size;
+    size_t committed_log_size;
+
     /* Only `candidate_and_leader_coro()` should ever change `mode` */
     mode_t mode;
 
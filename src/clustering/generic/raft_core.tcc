@@ -110,6 +110,9 @@ raft_member_t<state_t>::raft_member_t(
             s, this->ps().log, s->log_index + 1, this->ps().commit_index);
         return true;
     });
+    snapshot_size = serialized_size(ps().snapshot_state, ps().snapshot_config);
+    committed_log_size = serialized_size(
+        ps().log, ps().log.prev_index + 1, ps().commit_index);
     DEBUG_ONLY_CODE(check_invariants(&mutex_acq));
 }
 
@@ -600,6 +603,10 @@ void raft_member_t<state_t>::on_install_snapshot_rpc(
             ps().log.prev_index, ps().snapshot_state, ps().snapshot_config));
     }
 
+    snapshot_size = serialized_size(ps().snapshot_state, ps().snapshot_config);
+    committed_log_size = serialized_size(ps().log, ps().log.prev_index + 1,
+        std::max(committed_state.get_ref().log_index, ps().log.prev_index));
+
     /* Raft paper, Figure 13: "Reset state machine using snapshot contents"
     This conditional doesn't appear in the Raft paper. It will always be true if we
     discarded the entire log, but it will sometimes be false if we only discarded part of
@@ -1097,6 +1104,28 @@ void raft_member_t<state_t>::apply_log_entries(
     guarantee(state_and_config->log_index == last);
 }
 
+template<class state_t>
+size_t raft_member_t<state_t>::serialized_size(
+        const state_t &state,
+        const raft_complex_config_t &config) {
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_DISK>(&wm, state);
+    serialize<cluster_version_t::LATEST_DISK>(&wm, config);
+    return wm.size();
+}
+
+template<class state_t>
+size_t raft_member_t<state_t>::serialized_size(
+        const raft_log_t<state_t> &log,
+        raft_log_index_t first,
+        raft_log_index_t last) {
+    write_message_t wm;
+    for (raft_log_index_t i = first; i <= last; ++i) {
+        serialize<cluster_version_t::LATEST_DISK>(&wm, log.get_entry_ref(i));
+    }
+    return wm.size();
+}
+
 template<class state_t>
 void raft_member_t<state_t>::update_term(
         raft_term_t new_term,
@@ -1134,6 +1163,8 @@ void raft_member_t<state_t>::update_commit_index(
     index to disk whenever it changes. This ensures that the state machine never appears
     to go backwards. */
     storage->write_commit_index(new_commit_index);
+    committed_log_size +=
+        serialized_size(ps().log, old_commit_index + 1, new_commit_index);
 
     /* Raft paper, Figure 2: "If commitIndex > lastApplied: increment lastApplied, apply
     log[lastApplied] to state machine"
@@ -1173,9 +1204,9 @@ void raft_member_t<state_t>::update_commit_index(
     so that the tests will exercise many different code paths. */
     bool should_take_snapshot = (randint(3) == 0);
 #else
-    /* In release mode, snapshot when the log grows beyond a certain margin. */
-    size_t num_committed_entries = new_commit_index - ps().log.prev_index;
-    bool should_take_snapshot = (num_committed_entries > snapshot_threshold);
+    /* In release mode, snapshot when the log grows larger than the snapshot. */
+    bool should_take_snapshot = (committed_log_size > snapshot_min_log_size
+        && committed_log_size > snapshot_size);
 #endif /* NDEBUG */
     if (should_take_snapshot) {
         /* Take a snapshot as described in Section 7.
@@ -1190,6 +1221,8 @@ void raft_member_t<state_t>::update_commit_index(
             new_commit_index,
             ps().log.get_entry_term(new_commit_index),
             new_commit_index);
+        snapshot_size = serialized_size(ps().snapshot_state, ps().snapshot_config);
+        committed_log_size = 0;
     }
 
     /* If we just committed the second step of a config change, then we might need to
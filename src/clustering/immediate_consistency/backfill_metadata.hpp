@@ -6,6 +6,7 @@
 #include "clustering/generic/registration_metadata.hpp"
 #include "clustering/immediate_consistency/backfill_item_seq.hpp"
 #include "clustering/immediate_consistency/history.hpp"
+#include "containers/archive/compression.hpp"
 #include "rdb_protocol/distribution_progress.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "rpc/mailbox/typed.hpp"
@@ -34,6 +35,21 @@ public:
     /* The maximum size, in bytes, of a chunk of pre-items sent over the network from the
     backfillee to the backfiller. */
     size_t pre_item_chunk_mem_size;
+
+    /* How hard the backfiller should try to compress the chunks of items it sends to the
+    backfillee. They aren't compressed if both are on the same server. */
+    compression_t item_compression;
+
+    /* How many range sessions the backfillee runs at once to copy the data before the
+    ordered session catches up (see below). Each range session can queue up
+    `item_queue_mem_size` bytes of items of its own. Setting this to 1 disables range
+    sessions. */
+    size_t num_range_sessions;
+
+    /* How often, in milliseconds, the backfillee makes sure that what it has committed
+    to the store so far is on disk. A restarted backfill only has to copy what came
+    after the last checkpoint. */
+    int checkpoint_interval_ms;
 };
 
 RDB_DECLARE_SERIALIZABLE(backfill_config_t);
@@ -103,6 +119,18 @@ which the backfiller responds with a message to the `ack_end_session_mailbox_t`,
 like in the other case. However, this doesn't mean that the backfill is over; the
 backfillee may still choose to start another session from earlier in the key-range.
 
+If the backfillee hasn't diverged from the backfiller (that is, the common version is
+the same as the backfillee's initial version everywhere), there are no pre items, and
+the backfillee may first copy the data in several range sessions at once. Each range
+session covers a disjoint range of the key-space and runs through the same steps as a
+session, but with the `*_range_session_mailbox_t`s, `range_items_mailbox_t` and
+`ack_range_items_mailbox_t`, which carry an ID that the backfillee picks for the range
+session. Each range session has its own traversal on the backfiller and its own flow
+control. The backfillee applies the items but doesn't report them to its caller, because
+the ranges don't reach the same timestamps in key order. Instead, a normal session
+follows, which only has to send whatever changed since the range sessions copied it.
+Range sessions and normal sessions don't exist at the same time.
+
 The pre-item traversal process is much simpler than the item traversal process. The
 backfillee sends a series of messages to the `pre_items_mailbox_t` on the backfiller;
 these messages form a contiguous series of `backfill_pre_item_t`s in lexicographical
@@ -143,6 +171,24 @@ public:
         size_t
         )> ack_items_mailbox_t;
 
+    typedef mailbox_t<void(
+        fifo_enforcer_write_token_t,
+        /* The ID of the range session */
+        uint64_t,
+        key_range_t
+        )> begin_range_session_mailbox_t;
+
+    typedef mailbox_t<void(
+        fifo_enforcer_write_token_t,
+        uint64_t
+        )> end_range_session_mailbox_t;
+
+    typedef mailbox_t<void(
+        fifo_enforcer_write_token_t,
+        uint64_t,
+        size_t
+        )> ack_range_items_mailbox_t;
+
     class intro_2_t {
     public:
         /* The backfillee uses this to determine where to send pre-items from. */
@@ -157,6 +203,9 @@ public:
         begin_session_mailbox_t::address_t begin_session_mailbox;
         end_session_mailbox_t::address_t end_session_mailbox;
         ack_items_mailbox_t::address_t ack_items_mailbox;
+        begin_range_session_mailbox_t::address_t begin_range_session_mailbox;
+        end_range_session_mailbox_t::address_t end_range_session_mailbox;
+        ack_range_items_mailbox_t::address_t ack_range_items_mailbox;
 
         /* This is used to determine the backfill priority. */
         uint64_t num_changes_estimate;
@@ -169,13 +218,25 @@ public:
         fifo_enforcer_write_token_t,
         /* The `region_map_t` and the `backfill_item_seq_t` have the same region. */
         region_map_t<version_t>,
-        backfill_item_seq_t<backfill_item_t>
+        compressed_t<backfill_item_seq_t<backfill_item_t> >
         )> items_mailbox_t;
 
     typedef mailbox_t<void(
         fifo_enforcer_write_token_t
         )> ack_end_session_mailbox_t;
 
+    typedef mailbox_t<void(
+        fifo_enforcer_write_token_t,
+        uint64_t,
+        region_map_t<version_t>,
+        compressed_t<backfill_item_seq_t<backfill_item_t> >
+        )> range_items_mailbox_t;
+
+    typedef mailbox_t<void(
+        fifo_enforcer_write_token_t,
+        uint64_t
+        )> ack_end_range_session_mailbox_t;
+
     typedef mailbox_t<void(
         fifo_enforcer_write_token_t,
         /* This `size_t` has the same meaning as the numbers returned by
@@ -192,6 +253,8 @@ public:
         items_mailbox_t::address_t items_mailbox;
         ack_end_session_mailbox_t::address_t ack_end_session_mailbox;
         ack_pre_items_mailbox_t::address_t ack_pre_items_mailbox;
+        range_items_mailbox_t::address_t range_items_mailbox;
+        ack_end_range_session_mailbox_t::address_t ack_end_range_session_mailbox;
     };
 
     /* This `region_t` describes the region that the backfiller applies to. Backfill
@@ -1,6 +1,8 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/backfillee.hpp"
 
+#include <algorithm>
+
 #include "arch/timing.hpp"
 #include "clustering/immediate_consistency/history.hpp"
 #include "concurrency/cross_thread_signal.hpp"
@@ -14,7 +16,10 @@ static const int ITEM_ACK_INTERVAL_MS = 100;
 /* `backfillee_t::session_t` contains all the bits and pieces for managing a single
 backfill session. It's impossible to have multiple sessions running at once, so in
 principle this could have been implemented as some member variables on `backfillee_t`;
-but collecting the variables into an object makes it easier to reason about.
+but collecting the variables into an object makes it easier to reason about. Range
+sessions are `session_t`s too, and several of them run at once; they only go up to the end
+of their range, and they report their progress to `on_copy_progress()` instead of
+`on_progress()`.
 
 Here's how `backfillee_t` and `session_t` interact: `backfillee_t` creates the
 `session_t`. The `session_t` is responsible for sending the begin-session, end-session,
@@ -32,6 +37,7 @@ public:
             callback_t *_callback) :
         parent(_parent),
         threshold(_threshold),
+        end(_parent->store->get_region().inner.right),
         callback(_callback),
         callback_returned_false(false),
         items(_parent->store->get_region().beg, _parent->store->get_region().end,
@@ -40,7 +46,33 @@ public:
         sent_end_session(false),
         metainfo(region_map_t<version_t>::empty()),
         metainfo_binary(region_map_t<binary_blob_t>::empty()),
-        pulse_when_items_arrive(nullptr)
+        pulse_when_items_arrive(nullptr),
+        pulse_to_ack(nullptr)
+    {
+        coro_t::spawn_sometime(std::bind(
+            &session_t::run, this, drainer.lock()));
+    }
+
+    session_t(
+            backfillee_t *_parent,
+            uint64_t _range_session_id,
+            const key_range_t &range,
+            callback_t *_callback) :
+        parent(_parent),
+        range_session_id(_range_session_id),
+        range_start(range.left),
+        threshold(range.left),
+        end(range.right),
+        callback(_callback),
+        callback_returned_false(false),
+        items(_parent->store->get_region().beg, _parent->store->get_region().end,
+            threshold),
+        items_mem_size_unacked(0),
+        sent_end_session(false),
+        metainfo(region_map_t<version_t>::empty()),
+        metainfo_binary(region_map_t<binary_blob_t>::empty()),
+        pulse_when_items_arrive(nullptr),
+        pulse_to_ack(nullptr)
     {
         coro_t::spawn_sometime(std::bind(
             &session_t::run, this, drainer.lock()));
@@ -50,7 +82,7 @@ public:
         guarantee(!done_cond.is_pulsed() || items_mem_size_unacked == 0,
             "we seem to have leaked some semaphore credits");
 
-        parent->progress_tracker->is_ready = true;
+        mark_ready();
     }
 
     /* `backfillee_t()` calls these callbacks when it receives messages from the
@@ -74,11 +106,36 @@ public:
 
     void wait_done(signal_t *interruptor) {
         wait_interruptible(&done_cond, interruptor);
-        guarantee(threshold == parent->store->get_region().inner.right
-            || callback_returned_false);
+        guarantee(threshold == end || callback_returned_false);
         guarantee(got_ack_end_session.is_pulsed());
     }
 
+    /* `stop()` ends a range session early. It still has to apply the items that the
+    backfiller already sent. */
+    void stop() {
+        guarantee(static_cast<bool>(range_session_id));
+        if (!callback_returned_false) {
+            callback_returned_false = true;
+            if (!sent_end_session) {
+                send_end_session_message();
+            }
+        }
+    }
+
+    /* Returns `true` if this range session reached the end of its range */
+    bool reached_end() const {
+        return threshold == end;
+    }
+
+    /* For range sessions, how far this range session has come, as estimated by the
+    backfiller's key distribution */
+    double estimate_progress_done() const {
+        return estimate_progress(threshold) - estimate_progress(range_start);
+    }
+    double estimate_progress_total() const {
+        return estimate_progress(end) - estimate_progress(range_start);
+    }
+
 private:
     /* `run()` runs in a separate coroutine for the duration of the session's existence.
     It does the main work of the session: draining backfill items from the `items` queue
@@ -86,11 +143,21 @@ private:
     void run(auto_drainer_t::lock_t keepalive) {
         with_priority_t p(CORO_PRIORITY_BACKFILL_RECEIVER);
         try {
-            send(parent->mailbox_manager, parent->intro.begin_session_mailbox,
-                parent->fifo_source.enter_write(), threshold);
+            if (static_cast<bool>(range_session_id)) {
+                key_range_t range;
+                range.left = threshold.key();
+                range.right = end;
+                send(parent->mailbox_manager, message_lane_t::CONTROL,
+                    parent->intro.begin_range_session_mailbox,
+                    parent->fifo_source.enter_write(), *range_session_id, range);
+            } else {
+                send(parent->mailbox_manager, message_lane_t::CONTROL,
+                    parent->intro.begin_session_mailbox,
+                    parent->fifo_source.enter_write(), threshold);
+            }
 
             /* Loop until we reach the end of the backfill range. */
-            while (threshold != parent->store->get_region().inner.right) {
+            while (threshold != end) {
                 /* Wait until we receive some items from the backfiller so we have
                 something to do, or the session is terminated. */
                 while (items.empty_domain()) {
@@ -110,7 +177,7 @@ private:
                         to the backfiller, and it replied; then we drained the `items`
                         queue. So this session is over. */
                         guarantee(callback_returned_false);
-                        parent->progress_tracker->is_ready = true;
+                        mark_ready();
                         done_cond.pulse();
                         return;
                     }
@@ -127,6 +194,7 @@ private:
                 backfilled */
                 region_t subregion = parent->store->get_region();
                 subregion.inner.left = threshold.key();
+                subregion.inner.right = end;
 
                 /* Copy items from `items` into the store until we finish the backfill
                 range or we run out of items */
@@ -147,6 +215,7 @@ private:
                             *is_item_out = true;
                             *item_out = parent->items.front();
                             parent->items.pop_front();
+                            parent->maybe_ack_items();
                             return continue_bool_t::CONTINUE;
                         } else if (!parent->items.empty_domain()) {
                             /* There aren't any more items left in the queue, but there's
@@ -170,6 +239,7 @@ private:
                     }
                     void on_commit(const key_range_t::right_bound_t &new_threshold)
                             THROWS_NOTHING {
+                        parent->parent->committed_since_checkpoint = true;
                         /* `on_commit()` might get called multiple times even after
                         `on_progress()` returns false, because calling
                         `send_end_session_message()` sets into motion a long chain of
@@ -177,6 +247,16 @@ private:
                         but might take a while. But we want to hide that complexity from
                         the callack, so we just skip calling `on_progress()` again if it
                         has returned `false` before. */
+                        if (static_cast<bool>(parent->range_session_id)) {
+                            parent->threshold = new_threshold;
+                            if (!parent->callback_returned_false) {
+                                parent->parent->update_range_session_progress();
+                                if (!parent->callback->on_copy_progress()) {
+                                    parent->parent->stop_range_sessions();
+                                }
+                            }
+                            return;
+                        }
                         if (!parent->callback_returned_false) {
                             region_t mask = parent->parent->store->get_region();
                             mask.inner.left = parent->threshold.key();
@@ -187,26 +267,33 @@ private:
                                 parent->send_end_session_message();
                             }
 
-                            if (!new_threshold.unbounded) {
-                                const distribution_progress_estimator_t &estimator =
-                                    parent->parent->intro.progress_estimator;
-                                parent->parent->progress_tracker->progress =
-                                    estimator.estimate_progress(new_threshold.key());
-                            } else {
-                                parent->parent->progress_tracker->progress = 1.0;
-                            }
+                            /* The range sessions may have taken `progress` further
+                            already. */
+                            double *progress =
+                                &parent->parent->progress_tracker->progress;
+                            *progress = std::max(
+                                *progress, parent->estimate_progress(new_threshold));
                         }
                         parent->threshold = new_threshold;
                     }
                 private:
                     /* `ack_periodically()` calls `session_t::send_ack_items()` every so
-                    often during the backfill, so that the backfiller will keep sending
-                    us items as they consume them and so ideally the `items` queue won't
-                    ever bottom out before we're done. */
+                    often during the backfill, and whenever `maybe_ack_items()` finds
+                    that we consumed a chunk's worth of items, so that the backfiller
+                    will keep sending us items as they consume them and so ideally the
+                    `items` queue won't ever bottom out before we're done. */
                     void ack_periodically(auto_drainer_t::lock_t keepalive2) {
                         try {
                             while (true) {
-                                nap(ITEM_ACK_INTERVAL_MS, keepalive2.get_drain_signal());
+                                {
+                                    signal_timer_t timer(ITEM_ACK_INTERVAL_MS);
+                                    cond_t cond;
+                                    assignment_sentry_t<cond_t *> sentry(
+                                        &parent->pulse_to_ack, &cond);
+                                    wait_any_t waiter(&timer, &cond);
+                                    wait_interruptible(
+                                        &waiter, keepalive2.get_drain_signal());
+                                }
                                 parent->send_ack_items();
                             }
                         } catch (const interrupted_exc_t &) {
@@ -241,16 +328,43 @@ private:
 
             wait_interruptible(&got_ack_end_session, keepalive.get_drain_signal());
             guarantee(items.empty_domain());
-            parent->progress_tracker->is_ready = true;
+            mark_ready();
             done_cond.pulse();
 
         } catch (const interrupted_exc_t &) {
             /* The backfillee was destroyed, if the session is restarted `is_ready` will
             be set to false again. */
+            mark_ready();
+        }
+    }
+
+    /* Range sessions don't change `is_ready`, because the backfill isn't done when they
+    are. */
+    void mark_ready() {
+        if (!static_cast<bool>(range_session_id)) {
             parent->progress_tracker->is_ready = true;
         }
     }
 
+    double estimate_progress(const key_range_t::right_bound_t &bound) const {
+        if (bound.unbounded) {
+            return 1.0;
+        } else {
+            return parent->intro.progress_estimator.estimate_progress(bound.key());
+        }
+    }
+
+    /* `maybe_ack_items()` wakes up `ack_periodically()` if we've consumed a chunk's
+    worth of items since the last acknowledgement. This way the backfiller gets its
+    credit back as soon as it can use it, instead of waiting for the timer. */
+    void maybe_ack_items() {
+        guarantee(items_mem_size_unacked >= items.get_mem_size());
+        if (pulse_to_ack != nullptr && items_mem_size_unacked - items.get_mem_size()
+                >= parent->backfill_config.item_chunk_mem_size) {
+            pulse_to_ack->pulse_if_not_already_pulsed();
+        }
+    }
+
     /* `send_ack_items()` lets the backfiller know the total mem size of the items we've
     consumed since the last call to `send_ack_items()`, so it knows when it's safe to
     send more items. */
@@ -259,23 +373,43 @@ private:
         size_t diff = items_mem_size_unacked - items.get_mem_size();
         if (diff != 0) {
             items_mem_size_unacked -= diff;
-            send(parent->mailbox_manager, parent->intro.ack_items_mailbox,
-                parent->fifo_source.enter_write(), diff);
+            if (static_cast<bool>(range_session_id)) {
+                send(parent->mailbox_manager, message_lane_t::CONTROL,
+                    parent->intro.ack_range_items_mailbox,
+                    parent->fifo_source.enter_write(), *range_session_id, diff);
+            } else {
+                send(parent->mailbox_manager, message_lane_t::CONTROL,
+                    parent->intro.ack_items_mailbox,
+                    parent->fifo_source.enter_write(), diff);
+            }
         }
     }
 
     void send_end_session_message() {
         guarantee(!sent_end_session);
         sent_end_session = true;
-        send(parent->mailbox_manager, parent->intro.end_session_mailbox,
-            parent->fifo_source.enter_write());
+        if (static_cast<bool>(range_session_id)) {
+            send(parent->mailbox_manager, message_lane_t::CONTROL,
+                parent->intro.end_range_session_mailbox,
+                parent->fifo_source.enter_write(), *range_session_id);
+        } else {
+            send(parent->mailbox_manager, message_lane_t::CONTROL,
+                parent->intro.end_session_mailbox,
+                parent->fifo_source.enter_write());
+        }
     }
 
     backfillee_t *const parent;
 
+    /* For range sessions, the ID of the range session and the start of its range */
+    boost::optional<uint64_t> range_session_id;
+    key_range_t::right_bound_t range_start;
+
     /* `threshold` describes the current location that this session has reached. It
-    starts at the threshold that was passed to `go()` and proceeds to the right. */
+    starts at the threshold that was passed to `go()` and proceeds to the right, until it
+    reaches `end`. */
     key_range_t::right_bound_t threshold;
+    key_range_t::right_bound_t const end;
 
     callback_t *const callback;
     bool callback_returned_false;
@@ -307,6 +441,10 @@ private:
     `items`. */
     cond_t *pulse_when_items_arrive;
 
+    /* `ack_periodically()` puts a `cond_t` here while it waits for its timer, and
+    `maybe_ack_items()` pulses it. */
+    cond_t *pulse_to_ack;
+
     /* `run()` pulses this when the session is completely over */
     cond_t done_cond;
 
@@ -331,12 +469,21 @@ backfillee_t::backfillee_t(
     pre_item_throttler_acq(&pre_item_throttler, 0),
     current_session(nullptr),
     session_interrupted(false),
+    range_sessions_allowed(false),
+    next_range_session_id(0),
+    committed_since_checkpoint(false),
     items_mailbox(mailbox_manager,
         std::bind(&backfillee_t::on_items, this, ph::_1, ph::_2, ph::_3, ph::_4)),
     ack_end_session_mailbox(mailbox_manager,
         std::bind(&backfillee_t::on_ack_end_session, this, ph::_1, ph::_2)),
     ack_pre_items_mailbox(mailbox_manager,
-        std::bind(&backfillee_t::on_ack_pre_items, this, ph::_1, ph::_2, ph::_3))
+        std::bind(&backfillee_t::on_ack_pre_items, this, ph::_1, ph::_2, ph::_3)),
+    range_items_mailbox(mailbox_manager,
+        std::bind(&backfillee_t::on_range_items, this,
+            ph::_1, ph::_2, ph::_3, ph::_4, ph::_5)),
+    ack_end_range_session_mailbox(mailbox_manager,
+        std::bind(&backfillee_t::on_ack_end_range_session, this,
+            ph::_1, ph::_2, ph::_3))
 {
     guarantee(region_is_superset(backfiller.region, store->get_region()));
     guarantee(store->get_region().beg == backfiller.region.beg);
@@ -347,6 +494,9 @@ backfillee_t::backfillee_t(
     our_intro.ack_pre_items_mailbox = ack_pre_items_mailbox.get_address();
     our_intro.items_mailbox = items_mailbox.get_address();
     our_intro.ack_end_session_mailbox = ack_end_session_mailbox.get_address();
+    our_intro.range_items_mailbox = range_items_mailbox.get_address();
+    our_intro.ack_end_range_session_mailbox =
+        ack_end_range_session_mailbox.get_address();
 
     /* Fetch the `initial_version` and `initial_version_history` fields for the
     `intro_1_t` that we'll send to the backfiller */
@@ -380,6 +530,19 @@ backfillee_t::backfillee_t(
         mailbox_manager, backfiller.registrar, our_intro));
     wait_interruptible(&got_intro, interruptor);
 
+    /* If our version is the common version everywhere, we haven't diverged from the
+    backfiller, so we may copy the data in range sessions. The backfiller checks the
+    same condition. */
+    range_sessions_allowed = backfill_config.num_range_sessions > 1;
+    our_intro.initial_version.visit(store->get_region(),
+    [&](const region_t &r, const version_t &v) {
+        intro.common_version.visit(r, [&](const region_t &, const state_timestamp_t &ts) {
+            if (ts != v.timestamp) {
+                range_sessions_allowed = false;
+            }
+        });
+    });
+
     /* Record the branch history we got from the backfiller */
     {
         on_thread_t thread_switcher(branch_history_manager->home_thread());
@@ -389,6 +552,9 @@ backfillee_t::backfillee_t(
     /* Spawn the coroutine that will stream pre-items to the backfiller. */
     coro_t::spawn_sometime(
         std::bind(&backfillee_t::send_pre_items, this, drainer.lock()));
+
+    coro_t::spawn_sometime(
+        std::bind(&backfillee_t::checkpoint_periodically, this, drainer.lock()));
 }
 
 backfillee_t::~backfillee_t() {
@@ -407,6 +573,7 @@ void backfillee_t::go(
         THROWS_ONLY(interrupted_exc_t) {
     guarantee(current_session == nullptr);
     guarantee(!session_interrupted);
+    range_sessions_allowed = false;
     session_t session(this, threshold, callback);
     current_session = &session;
     try {
@@ -423,14 +590,14 @@ void backfillee_t::on_items(
         signal_t *interruptor,
         const fifo_enforcer_write_token_t &fifo_token,
         region_map_t<version_t> &&version,
-        backfill_item_seq_t<backfill_item_t> &&chunk) {
+        compressed_t<backfill_item_seq_t<backfill_item_t> > &&chunk) {
     fifo_enforcer_sink_t::exit_write_t exit_write(&fifo_sink, fifo_token);
     wait_interruptible(&exit_write, interruptor);
     if (session_interrupted) {
         return;
     }
     guarantee(current_session != nullptr);
-    current_session->on_items(std::move(version), std::move(chunk));
+    current_session->on_items(std::move(version), std::move(chunk.value));
 }
 
 void backfillee_t::on_ack_end_session(
@@ -445,6 +612,142 @@ void backfillee_t::on_ack_end_session(
     current_session->on_ack_end_session();
 }
 
+void backfillee_t::on_range_items(
+        signal_t *interruptor,
+        const fifo_enforcer_write_token_t &fifo_token,
+        uint64_t session_id,
+        region_map_t<version_t> &&version,
+        compressed_t<backfill_item_seq_t<backfill_item_t> > &&chunk) {
+    fifo_enforcer_sink_t::exit_write_t exit_write(&fifo_sink, fifo_token);
+    wait_interruptible(&exit_write, interruptor);
+    if (session_interrupted) {
+        return;
+    }
+    auto it = range_sessions.find(session_id);
+    guarantee(it != range_sessions.end());
+    it->second->on_items(std::move(version), std::move(chunk.value));
+}
+
+void backfillee_t::on_ack_end_range_session(
+        signal_t *interruptor,
+        const fifo_enforcer_write_token_t &fifo_token,
+        uint64_t session_id) {
+    fifo_enforcer_sink_t::exit_write_t exit_write(&fifo_sink, fifo_token);
+    wait_interruptible(&exit_write, interruptor);
+    if (session_interrupted) {
+        return;
+    }
+    auto it = range_sessions.find(session_id);
+    guarantee(it != range_sessions.end());
+    it->second->on_ack_end_session();
+}
+
+bool backfillee_t::copy(
+        callback_t *callback,
+        const key_range_t::right_bound_t &start_point,
+        signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    guarantee(current_session == nullptr);
+    guarantee(range_sessions.empty());
+    guarantee(!session_interrupted);
+    if (!range_sessions_allowed || start_point == store->get_region().inner.right) {
+        return true;
+    }
+
+    /* Split the rest of the range into parts with about the same number of keys on the
+    backfiller. If the backfiller doesn't have enough keys to split it, the session will
+    do just as well. */
+    key_range_t range;
+    range.left = start_point.key();
+    range.right = store->get_region().inner.right;
+    std::vector<store_key_t> splits = intro.progress_estimator.split_range(
+        range, backfill_config.num_range_sessions);
+    if (splits.empty()) {
+        range_sessions_allowed = false;
+        return true;
+    }
+    std::vector<key_range_t> ranges;
+    for (const store_key_t &split : splits) {
+        ranges.push_back(key_range_t(
+            key_range_t::closed, range.left, key_range_t::open, split));
+        range.left = split;
+    }
+    ranges.push_back(range);
+
+    range_sessions_start = start_point;
+    progress_tracker->session_progress.assign(ranges.size(), 0.0);
+    std::vector<scoped_ptr_t<session_t> > sessions;
+    for (const key_range_t &r : ranges) {
+        uint64_t session_id = next_range_session_id++;
+        sessions.push_back(make_scoped<session_t>(this, session_id, r, callback));
+        range_sessions[session_id] = sessions.back().get();
+    }
+
+    bool reached_end = true;
+    try {
+        for (const auto &session : sessions) {
+            session->wait_done(interruptor);
+            reached_end = reached_end && session->reached_end();
+        }
+    } catch (const interrupted_exc_t &) {
+        range_sessions.clear();
+        session_interrupted = true;
+        throw;
+    }
+    range_sessions.clear();
+    progress_tracker->session_progress.clear();
+    if (reached_end) {
+        range_sessions_allowed = false;
+    }
+    return reached_end;
+}
+
+void backfillee_t::stop_range_sessions() {
+    for (const auto &pair : range_sessions) {
+        pair.second->stop();
+    }
+}
+
+void backfillee_t::update_range_session_progress() {
+    /* The range sessions are in key order, and together they cover everything from
+    `range_sessions_start` to the end of the store's region. */
+    double progress = range_sessions_start.unbounded ? 1.0
+        : intro.progress_estimator.estimate_progress(range_sessions_start.key());
+    size_t i = 0;
+    for (const auto &pair : range_sessions) {
+        double done = pair.second->estimate_progress_done();
+        double total = pair.second->estimate_progress_total();
+        progress += done;
+        progress_tracker->session_progress[i++] =
+            total > 0 ? std::min(1.0, done / total)
+                : (pair.second->reached_end() ? 1.0 : 0.0);
+    }
+    progress_tracker->progress = std::max(progress_tracker->progress, progress);
+}
+
+void backfillee_t::checkpoint_periodically(auto_drainer_t::lock_t keepalive) {
+    try {
+        while (true) {
+            nap(backfill_config.checkpoint_interval_ms, keepalive.get_drain_signal());
+            if (!committed_since_checkpoint) {
+                continue;
+            }
+            committed_since_checkpoint = false;
+            /* An empty update leaves the metainfo as it is, but the store can't flush
+            it before the transactions that the backfill committed before it. So once it
+            returns, the metainfo on disk records everything we've backfilled so far, and
+            a restarted backfill will pick up from there. */
+            write_token_t token;
+            store->new_write_token(&token);
+            store->set_metainfo(region_map_t<binary_blob_t>::empty(),
+                order_token_t::ignore, &token, write_durability_t::HARD,
+                keepalive.get_drain_signal());
+        }
+    } catch (const interrupted_exc_t &) {
+        /* ignore */
+    }
+}
+
 void backfillee_t::send_pre_items(auto_drainer_t::lock_t keepalive) {
     with_priority_t p(CORO_PRIORITY_BACKFILL_RECEIVER);
     try {
@@ -501,7 +804,7 @@ void backfillee_t::send_pre_items(auto_drainer_t::lock_t keepalive) {
             pre_item_throttler_acq.transfer_in(std::move(sem_acq));
 
             /* Send the chunk over the network */
-            send(mailbox_manager, intro.pre_items_mailbox,
+            send(mailbox_manager, message_lane_t::BULK, intro.pre_items_mailbox,
                 fifo_source.enter_write(), chunk);
 
             /* Update `progress` */
@@ -2,6 +2,8 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_BACKFILLEE_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_BACKFILLEE_HPP_
 
+#include <map>
+
 #include "clustering/generic/registrant.hpp"
 #include "clustering/immediate_consistency/history.hpp"
 #include "clustering/immediate_consistency/backfill_metadata.hpp"
@@ -39,7 +41,19 @@ completed. If the backfill is aborted early by returning `false`, the caller can
 `go()` again to resume the backfill. The effect of this is to reset the minimum state
 that the backfill is guaranteed to go to; any keys backfilled during the new call to
 `go()` are guaranteed to be at least as up-to-date as the other server's state when the
-new call to `go()` happens. */
+new call to `go()` happens.
+
+8. Before the first call to `go()`, the caller may call `copy()`. If the backfillee
+hasn't diverged from the backfiller, `copy()` copies the data in several range sessions
+at once (see `backfill_metadata.hpp`), so that the sessions of `go()` only have to send
+what changed since then. The copied data doesn't count as backfilled, and `copy()`
+doesn't call `on_progress()`, because the ranges aren't copied in order.
+
+9. Everything the backfill commits to the store comes with the backfiller's version in
+the metainfo, and every so often the backfillee waits until it's on disk. If the backfill
+is interrupted, even by a crash, a new `backfillee_t` for the same store starts from
+that metainfo; the backfiller checks it against its branch history and only sends what
+changed since then. */
 
 class backfillee_t : public home_thread_mixin_debug_only_t {
 private:
@@ -52,6 +66,11 @@ public:
     public:
         virtual bool on_progress(
             const region_map_t<version_t> &chunk) THROWS_NOTHING = 0;
+        /* `on_copy_progress()` is called while `copy()` copies data. Returning `false`
+        stops `copy()` early. */
+        virtual bool on_copy_progress() THROWS_NOTHING {
+            return true;
+        }
     protected:
         virtual ~callback_t() { }
     };
@@ -89,6 +108,19 @@ public:
         const key_range_t::right_bound_t &start_point,
         signal_t *interruptor) THROWS_ONLY(interrupted_exc_t);
 
+    /* Copies everything from `start_point` onward in range sessions, if the backfillee
+    hasn't diverged from the backfiller and `backfill_config.num_range_sessions` is more
+    than one. Returns `false` if `on_copy_progress()` returned `false`, in which case the
+    caller may call `copy()` again later; it will only copy what changed in the meantime.
+    Once a call to `copy()` has returned `true`, or after `go()` was called, `copy()`
+    returns `true` without doing anything.
+
+    Pulsing `interruptor` invalidates the `backfillee_t`. */
+    bool copy(
+        callback_t *callback,
+        const key_range_t::right_bound_t &start_point,
+        signal_t *interruptor) THROWS_ONLY(interrupted_exc_t);
+
 private:
     /* `on_items()`, `on_ack_end_session()`, and `on_ack_pre_items()` are mailbox
     callbacks. */
@@ -97,12 +129,38 @@ private:
         signal_t *interruptor,
         const fifo_enforcer_write_token_t &fifo_token,
         region_map_t<version_t> &&version,
-        backfill_item_seq_t<backfill_item_t> &&chunk);
+        compressed_t<backfill_item_seq_t<backfill_item_t> > &&chunk);
 
     void on_ack_end_session(
         signal_t *interruptor,
         const fifo_enforcer_write_token_t &fifo_token);
 
+    void on_range_items(
+        signal_t *interruptor,
+        const fifo_enforcer_write_token_t &fifo_token,
+        uint64_t session_id,
+        region_map_t<version_t> &&version,
+        compressed_t<backfill_item_seq_t<backfill_item_t> > &&chunk);
+
+    void on_ack_end_range_session(
+        signal_t *interruptor,
+        const fifo_enforcer_write_token_t &fifo_token,
+        uint64_t session_id);
+
+    /* Asks every range session to stop. */
+    void stop_range_sessions();
+
+    /* Updates `progress_tracker` from the range sessions' progress. */
+    void update_range_session_progress();
+
+    /* `checkpoint_periodically()` is spawned by the `backfillee_t` constructor in a
+    separate coroutine. Every `backfill_config.checkpoint_interval_ms`, it waits until
+    what the backfill committed to the store is on disk. The store commits backfill
+    changes with soft durability, so without checkpoints, a crash could undo much more
+    than the last few seconds of the backfill. */
+    void checkpoint_periodically(
+        auto_drainer_t::lock_t keepalive);
+
     /* `send_pre_items()` is spawned by the `backfillee_t` constructor in a separate
     coroutine. It's responsible for traversing the B-tree and sending pre items to the
     backfiller. */
@@ -124,7 +182,11 @@ private:
 
     /* `fifo_source` is used to attach order tokens to the messages we send to the
     backfiller. `fifo_sink` is used to interpret the order tokens on messages we receive
-    from the backfiller. */
+    from the backfiller. Pre-items and items go in the `BULK` lane, while the messages
+    that begin and end sessions and the acks go in the `CONTROL` lane so that they
+    don't wait behind large chunks. The lanes can overtake each other on the wire, so
+    every message must carry an order token and every handler must wait for its turn
+    in `fifo_sink` before it does anything. */
     fifo_enforcer_source_t fifo_source;
     fifo_enforcer_sink_t fifo_sink;
 
@@ -142,6 +204,19 @@ private:
     session_t *current_session;
     bool session_interrupted;
 
+    /* `range_sessions_allowed` is `true` if we haven't diverged from the backfiller and
+    `backfill_config.num_range_sessions` is more than one. It's set to `false` once the
+    range sessions have copied everything or `go()` was called. During `copy()`,
+    `range_sessions` contains the running range sessions by ID. */
+    bool range_sessions_allowed;
+    std::map<uint64_t, session_t *> range_sessions;
+    key_range_t::right_bound_t range_sessions_start;
+    uint64_t next_range_session_id;
+
+    /* `committed_since_checkpoint` is `true` if the sessions committed anything to the
+    store since `checkpoint_periodically()` last made sure that it's on disk. */
+    bool committed_since_checkpoint;
+
     /* Destructor order matters here; `drainer` and `*_mailbox` must be destroyed before
     the other members of `backfillee_t` because they can spawn coroutines that access the
     other members. It's not strictly necessary to destroy `registrant` before destroying
@@ -151,6 +226,8 @@ private:
     backfiller_bcard_t::items_mailbox_t items_mailbox;
     backfiller_bcard_t::ack_end_session_mailbox_t ack_end_session_mailbox;
     backfiller_bcard_t::ack_pre_items_mailbox_t ack_pre_items_mailbox;
+    backfiller_bcard_t::range_items_mailbox_t range_items_mailbox;
+    backfiller_bcard_t::ack_end_range_session_mailbox_t ack_end_range_session_mailbox;
     scoped_ptr_t<registrant_t<backfiller_bcard_t::intro_1_t> > registrant;
 };
 
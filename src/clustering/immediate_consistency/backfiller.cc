@@ -23,10 +23,14 @@ backfiller_t::client_t::client_t(
     parent(_parent),
     intro(_intro),
     full_region(intro.initial_version.get_domain()),
+    item_compression(
+        intro.items_mailbox.get_peer() == parent->mailbox_manager->get_me()
+            ? compression_t::NONE
+            : intro.config.item_compression),
     pre_items(full_region.beg, full_region.end,
         key_range_t::right_bound_t(full_region.inner.left)),
+    range_sessions_allowed(false),
     item_throttler(intro.config.item_queue_mem_size),
-    item_throttler_acq(&item_throttler, 0),
     pre_items_mailbox(parent->mailbox_manager,
         std::bind(&client_t::on_pre_items, this, ph::_1, ph::_2, ph::_3)),
     begin_session_mailbox(parent->mailbox_manager,
@@ -34,7 +38,15 @@ backfiller_t::client_t::client_t(
     end_session_mailbox(parent->mailbox_manager,
         std::bind(&client_t::on_end_session, this, ph::_1, ph::_2)),
     ack_items_mailbox(parent->mailbox_manager,
-        std::bind(&client_t::on_ack_items, this, ph::_1, ph::_2, ph::_3))
+        std::bind(&client_t::on_ack_items, this, ph::_1, ph::_2, ph::_3)),
+    begin_range_session_mailbox(parent->mailbox_manager,
+        std::bind(&client_t::on_begin_range_session, this,
+            ph::_1, ph::_2, ph::_3, ph::_4)),
+    end_range_session_mailbox(parent->mailbox_manager,
+        std::bind(&client_t::on_end_range_session, this, ph::_1, ph::_2, ph::_3)),
+    ack_range_items_mailbox(parent->mailbox_manager,
+        std::bind(&client_t::on_ack_range_items, this,
+            ph::_1, ph::_2, ph::_3, ph::_4))
 {
     /* Fetch our current state from the superblock metainfo */
     region_map_t<version_t> our_version;
@@ -86,6 +98,18 @@ backfiller_t::client_t::client_t(
             our_version, &our_version_history);
     }
 
+    /* If the backfillee's version is the common version everywhere, then it doesn't
+    have any changes that we don't have, so there won't be any pre items. */
+    range_sessions_allowed = true;
+    intro.initial_version.visit(full_region,
+    [&](const region_t &r, const version_t &v) {
+        common_version.visit(r, [&](const region_t &, const state_timestamp_t &ts) {
+            if (ts != v.timestamp) {
+                range_sessions_allowed = false;
+            }
+        });
+    });
+
     /* Fetch the key distribution from the store, this is used by the backfillee to
     calculate the progress of backfill jobs. */
     distribution_progress_estimator_t progress_estimator(parent->store, interruptor);
@@ -118,9 +142,15 @@ backfiller_t::client_t::client_t(
     our_intro.begin_session_mailbox = begin_session_mailbox.get_address();
     our_intro.end_session_mailbox = end_session_mailbox.get_address();
     our_intro.ack_items_mailbox = ack_items_mailbox.get_address();
+    our_intro.begin_range_session_mailbox = begin_range_session_mailbox.get_address();
+    our_intro.end_range_session_mailbox = end_range_session_mailbox.get_address();
+    our_intro.ack_range_items_mailbox = ack_range_items_mailbox.get_address();
     our_intro.num_changes_estimate = num_changes_estimate;
     our_intro.progress_estimator = std::move(progress_estimator);
-    send(parent->mailbox_manager, intro.intro_mailbox, our_intro);
+    /* This one has no order token, but the backfillee doesn't send us anything until it
+    has received it, so nothing can overtake it. */
+    send(parent->mailbox_manager, message_lane_t::CONTROL, intro.intro_mailbox,
+        our_intro);
 }
 
 /* `item_seq_pre_item_producer_t` is a `backfill_pre_item_producer_t` that reads from a
@@ -215,11 +245,17 @@ private:
 `session_t`. The `session_t` is responsible for sending items to the backfillee. When the
 session is over, the backfillee will send an end-session message to the `client_t`, which
 will destroy the `session_t` and then send an ack-end-session message back to the
-backfillee. */
+backfillee.
+
+A range session is a `session_t` too. It only goes up to the end of its range, it has its
+own `item_throttler_t`, and it sends items to the range session's mailboxes instead. */
 class backfiller_t::client_t::session_t {
 public:
     session_t(client_t *_parent, const key_range_t::right_bound_t &_threshold) :
-        parent(_parent), threshold(_threshold), pulse_when_pre_items_arrive(nullptr)
+        parent(_parent), threshold(_threshold),
+        end(_parent->full_region.inner.right),
+        throttler(&_parent->item_throttler),
+        pulse_when_pre_items_arrive(nullptr)
     {
         guarantee(parent->pre_items.empty_of_items() ||
             key_range_t::right_bound_t(parent->pre_items.front().range.left)
@@ -229,6 +265,18 @@ public:
         coro_t::spawn_sometime(std::bind(&session_t::run, this, drainer.lock()));
     }
 
+    session_t(
+            client_t *_parent,
+            uint64_t _range_session_id,
+            const key_range_t &range,
+            item_throttler_t *_throttler) :
+        parent(_parent), range_session_id(_range_session_id),
+        threshold(range.left), end(range.right), throttler(_throttler),
+        pulse_when_pre_items_arrive(nullptr)
+    {
+        coro_t::spawn_sometime(std::bind(&session_t::run, this, drainer.lock()));
+    }
+
     /* Every time the `client_t` receives more pre-items from the backfillee, it calls
     `on_pre_items()` to notify us. */
     void on_pre_items() {
@@ -241,20 +289,27 @@ private:
     void run(auto_drainer_t::lock_t keepalive) {
         with_priority_t p(CORO_PRIORITY_BACKFILL_SENDER);
         try {
-            while (threshold != parent->full_region.inner.right) {
+            while (threshold != end) {
                 /* Wait until there's room in the semaphore for the chunk we're about to
                 process.
                 We acquire the maximum size that we want to put in this chunk first,
                 and then adjust the semaphore acquisition to the actual size of the
                 chunk later. */
                 new_semaphore_in_line_t sem_acq(
-                    &parent->item_throttler, parent->intro.config.item_chunk_mem_size);
+                    &throttler->semaphore, parent->intro.config.item_chunk_mem_size);
                 wait_interruptible(
                     sem_acq.acquisition_signal(), keepalive.get_drain_signal());
 
                 /* Wait until we have some pre items, or else we won't be able to make
-                any progress on the backfill */
-                while (parent->pre_items.get_right_key() == threshold) {
+                any progress on the backfill. A range session doesn't need any, because
+                the backfillee hasn't diverged from us; it uses `no_pre_items`. */
+                backfill_item_seq_t<backfill_pre_item_t> no_pre_items(
+                    parent->full_region.beg, parent->full_region.end, threshold);
+                if (static_cast<bool>(range_session_id)) {
+                    no_pre_items.push_back_nothing(end);
+                }
+                while (!static_cast<bool>(range_session_id)
+                        && parent->pre_items.get_right_key() == threshold) {
                     cond_t cond;
                     assignment_sentry_t<cond_t *> sentry(
                         &pulse_when_pre_items_arrive, &cond);
@@ -265,6 +320,7 @@ private:
                 backfilled */
                 region_t subregion = parent->full_region;
                 subregion.inner.left = threshold.key();
+                subregion.inner.right = end;
 
                 /* Copy items from the store into `chunk` until the total size hits
                 `item_chunk_mem_size`; we finish the backfill range; or we run out of
@@ -283,11 +339,13 @@ private:
                     corresponding to all of the pre-items it consumed, so those pre-items
                     might be needed again in a later call to `send_backfill()`. It's a
                     little sketchy that `producer` modifies `pre_items` like this, but
-                    it's safe because only one `session_t` can exist at once and because
-                    `client_t::on_pre_items` only touches the right-hand end of
-                    `parent->pre_items`. */
+                    it's safe because only one `session_t` can exist at once (range
+                    sessions use `no_pre_items`) and because `client_t::on_pre_items`
+                    only touches the right-hand end of `parent->pre_items`. */
                     item_seq_pre_item_producer_t producer(
-                        &parent->pre_items, threshold);
+                        static_cast<bool>(range_session_id)
+                            ? &no_pre_items : &parent->pre_items,
+                        threshold);
 
                     /* `consumer_t` is responsible for receiving backfill items and
                     the corresponding metainfo from `send_backfill()` and storing them in
@@ -362,7 +420,7 @@ private:
                     equal to `item_chunk_mem_size`, and then transfer the semaphore
                     ownership. */
                     sem_acq.change_count(chunk.get_mem_size());
-                    parent->item_throttler_acq.transfer_in(std::move(sem_acq));
+                    throttler->acq.transfer_in(std::move(sem_acq));
 
                     /* Update `threshold` */
                     guarantee(chunk.get_left_key() == threshold);
@@ -376,9 +434,19 @@ private:
                     we've sent. */
                     try {
                         /* Send the chunk over the network */
-                        send(parent->parent->mailbox_manager,
-                            parent->intro.items_mailbox,
-                            parent->fifo_source.enter_write(), metainfo, chunk);
+                        compressed_t<backfill_item_seq_t<backfill_item_t> > compressed(
+                            parent->item_compression, std::move(chunk));
+                        if (static_cast<bool>(range_session_id)) {
+                            send(parent->parent->mailbox_manager, message_lane_t::BULK,
+                                parent->intro.range_items_mailbox,
+                                parent->fifo_source.enter_write(), *range_session_id,
+                                metainfo, compressed);
+                        } else {
+                            send(parent->parent->mailbox_manager, message_lane_t::BULK,
+                                parent->intro.items_mailbox,
+                                parent->fifo_source.enter_write(), metainfo,
+                                compressed);
+                        }
 
                         /* Update `common_version` to reflect the changes that will
                         happen on the backfillee in response to the chunk */
@@ -386,6 +454,12 @@ private:
                             metainfo.map(metainfo.get_domain(),
                                 [](const version_t &v) { return v.timestamp; }));
 
+                        if (static_cast<bool>(range_session_id)) {
+                            /* There are no pre items in a range session's range, so
+                            there's nothing to discard. */
+                            continue;
+                        }
+
                         /* Discard pre-items we don't need anymore. This has two
                         purposes: it saves memory, and it keeps `pre_items` consistent
                         with `common_version`. However, we note that the domain of the
@@ -413,6 +487,7 @@ private:
                         chunk. */
                         if (old_size != new_size) {
                             send(parent->parent->mailbox_manager,
+                                message_lane_t::CONTROL,
                                 parent->intro.ack_pre_items_mailbox,
                                 parent->fifo_source.enter_write(), old_size - new_size);
                         }
@@ -431,10 +506,16 @@ private:
 
     client_t *const parent;
 
+    /* The ID of the range session, or empty if this isn't a range session */
+    boost::optional<uint64_t> range_session_id;
+
     /* This is the current location we've backfilled up to. Initially it's set to the
     point that the backfillee sent us with the begin-session message, and it moves right
-    from there. */
+    from there until it reaches `end`. */
     key_range_t::right_bound_t threshold;
+    key_range_t::right_bound_t const end;
+
+    item_throttler_t *const throttler;
 
     /* This exists if we're waiting for more pre items. `on_pre_items()` pulses it if it
     exists. */
@@ -454,6 +535,7 @@ void backfiller_t::client_t::on_begin_session(
     wait_interruptible(&exit_write, interruptor);
 
     guarantee(!current_session.has());
+    guarantee(range_sessions.empty());
     current_session.init(new session_t(this, threshold));
 }
 
@@ -467,10 +549,11 @@ void backfiller_t::client_t::on_end_session(
     current_session.reset();
 
     /* `session_t`'s destructor won't return until it's done sending items over the
-    network, so we can be sure that the ack-end-session message comes after all of the
-    items that were part of the session. */
-    send(parent->mailbox_manager, intro.ack_end_session_mailbox,
-        fifo_source.enter_write());
+    network, so the ack-end-session message gets a later order token than all of the
+    items that were part of the session. It may overtake them on the wire, but the
+    backfillee won't process it until it has processed them. */
+    send(parent->mailbox_manager, message_lane_t::CONTROL,
+        intro.ack_end_session_mailbox, fifo_source.enter_write());
 }
 
 void backfiller_t::client_t::on_ack_items(
@@ -480,8 +563,8 @@ void backfiller_t::client_t::on_ack_items(
     fifo_enforcer_sink_t::exit_write_t exit_write(&fifo_sink, write_token);
     wait_interruptible(&exit_write, interruptor);
 
-    guarantee(static_cast<int64_t>(mem_size) <= item_throttler_acq.count());
-    item_throttler_acq.change_count(item_throttler_acq.count() - mem_size);
+    guarantee(static_cast<int64_t>(mem_size) <= item_throttler.acq.count());
+    item_throttler.acq.change_count(item_throttler.acq.count() - mem_size);
 }
 
 void backfiller_t::client_t::on_pre_items(
@@ -497,3 +580,53 @@ void backfiller_t::client_t::on_pre_items(
     }
 }
 
+void backfiller_t::client_t::on_begin_range_session(
+        signal_t *interruptor,
+        const fifo_enforcer_write_token_t &write_token,
+        uint64_t session_id,
+        const key_range_t &range) {
+    fifo_enforcer_sink_t::exit_write_t exit_write(&fifo_sink, write_token);
+    wait_interruptible(&exit_write, interruptor);
+
+    guarantee(range_sessions_allowed);
+    guarantee(!current_session.has());
+    guarantee(region_is_superset(full_region,
+        region_t(full_region.beg, full_region.end, range)));
+    guarantee(range_item_throttlers.count(session_id) == 0);
+    item_throttler_t *throttler = new item_throttler_t(intro.config.item_queue_mem_size);
+    range_item_throttlers[session_id].init(throttler);
+    range_sessions[session_id].init(
+        new session_t(this, session_id, range, throttler));
+}
+
+void backfiller_t::client_t::on_end_range_session(
+        signal_t *interruptor,
+        const fifo_enforcer_write_token_t &write_token,
+        uint64_t session_id) {
+    fifo_enforcer_sink_t::exit_write_t exit_write(&fifo_sink, write_token);
+    wait_interruptible(&exit_write, interruptor);
+
+    auto it = range_sessions.find(session_id);
+    guarantee(it != range_sessions.end());
+    range_sessions.erase(it);
+
+    /* Just like in `on_end_session()`, the range session is done sending items once its
+    destructor returns. */
+    send(parent->mailbox_manager, message_lane_t::CONTROL,
+        intro.ack_end_range_session_mailbox, fifo_source.enter_write(), session_id);
+}
+
+void backfiller_t::client_t::on_ack_range_items(
+        signal_t *interruptor,
+        const fifo_enforcer_write_token_t &write_token,
+        uint64_t session_id,
+        size_t mem_size) {
+    fifo_enforcer_sink_t::exit_write_t exit_write(&fifo_sink, write_token);
+    wait_interruptible(&exit_write, interruptor);
+
+    auto it = range_item_throttlers.find(session_id);
+    guarantee(it != range_item_throttlers.end());
+    new_semaphore_in_line_t *acq = &it->second->acq;
+    guarantee(static_cast<int64_t>(mem_size) <= acq->count());
+    acq->change_count(acq->count() - mem_size);
+}
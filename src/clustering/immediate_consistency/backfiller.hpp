@@ -60,6 +60,32 @@ private:
             signal_t *interruptor,
             const fifo_enforcer_write_token_t &write_token,
             backfill_item_seq_t<backfill_pre_item_t> &&chunk);
+        void on_begin_range_session(
+            signal_t *interruptor,
+            const fifo_enforcer_write_token_t &write_token,
+            uint64_t session_id,
+            const key_range_t &range);
+        void on_end_range_session(
+            signal_t *interruptor,
+            const fifo_enforcer_write_token_t &write_token,
+            uint64_t session_id);
+        void on_ack_range_items(
+            signal_t *interruptor,
+            const fifo_enforcer_write_token_t &write_token,
+            uint64_t session_id,
+            size_t mem_size);
+
+        /* `item_throttler_t` limits the total mem size of the backfill items that a
+        session is allowed to queue up on the backfillee. `acq` always holds `semaphore`,
+        but its `count` changes to reflect the total mem size that's currently in the
+        queue. */
+        class item_throttler_t {
+        public:
+            explicit item_throttler_t(size_t queue_mem_size) :
+                semaphore(queue_mem_size), acq(&semaphore, 0) { }
+            new_semaphore_t semaphore;
+            new_semaphore_in_line_t acq;
+        };
 
         backfiller_t *const parent;
 
@@ -70,9 +96,14 @@ private:
         same as `intro.initial_version.get_domain()`. */
         region_t const full_region;
 
+        /* `intro.config.item_compression`, unless the backfillee is on this server. */
+        compression_t const item_compression;
+
         /* `fifo_source` is used to attach order tokens to the messages we send to the
         backfillee. `fifo_sink` is used to interpret the order tokens on messages we
-        receive from the backfillee. */
+        receive from the backfillee. The messages are sent in two lanes that can
+        overtake each other (see `backfillee_t::fifo_source`), so the order tokens are
+        what keeps them in order. */
         fifo_enforcer_source_t fifo_source;
         fifo_enforcer_sink_t fifo_sink;
 
@@ -93,19 +124,27 @@ private:
         region_map_t<state_timestamp_t> common_version;
         backfill_item_seq_t<backfill_pre_item_t> pre_items;
 
-        /* `item_throttler` limits the total mem size of the backfill items that are
-        allowed to queue up on the backfillee. `item_throttler_acq` always holds
-        `item_throttler`, but its `count` changes to reflect the total mem size that's
-        currently in the queue. */
-        new_semaphore_t item_throttler;
-        new_semaphore_in_line_t item_throttler_acq;
+        /* `range_sessions_allowed` is `true` if the backfillee hasn't diverged from us,
+        so there aren't any pre items and it may copy the data in range sessions. */
+        bool range_sessions_allowed;
+
+        /* `item_throttler` is for the items of the sessions. The range sessions each
+        have their own throttler in `range_item_throttlers`, which outlives the range
+        session because the backfillee may acknowledge items after the range session is
+        over. */
+        item_throttler_t item_throttler;
+        std::map<uint64_t, scoped_ptr_t<item_throttler_t> > range_item_throttlers;
 
         scoped_ptr_t<session_t> current_session;
+        std::map<uint64_t, scoped_ptr_t<session_t> > range_sessions;
 
         backfiller_bcard_t::pre_items_mailbox_t pre_items_mailbox;
         backfiller_bcard_t::begin_session_mailbox_t begin_session_mailbox;
         backfiller_bcard_t::end_session_mailbox_t end_session_mailbox;
         backfiller_bcard_t::ack_items_mailbox_t ack_items_mailbox;
+        backfiller_bcard_t::begin_range_session_mailbox_t begin_range_session_mailbox;
+        backfiller_bcard_t::end_range_session_mailbox_t end_range_session_mailbox;
+        backfiller_bcard_t::ack_range_items_mailbox_t ack_range_items_mailbox;
     };
 
     mailbox_manager_t *const mailbox_manager;
@@ -155,6 +155,11 @@ public:
         return branch_bc;
     }
 
+    /* Returns the timestamp of the latest write that `spawn_write()` has started. */
+    state_timestamp_t get_latest_timestamp() {
+        return current_timestamp;
+    }
+
     /* `read()` performs the given read, blocking until the read is complete. */
     void read(
         const read_t &r,
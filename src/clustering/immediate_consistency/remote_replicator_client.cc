@@ -3,7 +3,9 @@
 
 #include "clustering/immediate_consistency/backfill_throttler.hpp"
 #include "clustering/immediate_consistency/backfillee.hpp"
+#include "clustering/immediate_consistency/replication_lag_tracker.hpp"
 #include "clustering/table_manager/backfill_progress_tracker.hpp"
+#include "concurrency/pmap.hpp"
 #include "stl_utils.hpp"
 #include "store_view.hpp"
 
@@ -151,6 +153,7 @@ remote_replicator_client_t::remote_replicator_client_t(
 
         store_view_t *store,
         branch_history_manager_t *branch_history_manager,
+        replication_lag_tracker_t *lag_tracker,
 
         signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) :
 
@@ -162,12 +165,11 @@ remote_replicator_client_t::remote_replicator_client_t(
 
     next_write_waiter_(nullptr),
 
-    write_async_mailbox_(mailbox_manager,
-        std::bind(&remote_replicator_client_t::on_write_async, this,
-            ph::_1, ph::_2, ph::_3, ph::_4, ph::_5)),
-    write_sync_mailbox_(mailbox_manager,
-        std::bind(&remote_replicator_client_t::on_write_sync, this,
-            ph::_1, ph::_2, ph::_3, ph::_4, ph::_5, ph::_6)),
+    write_watermark_(state_timestamp_t::zero()),
+    lag_tracker_(lag_tracker),
+    write_batch_mailbox_(mailbox_manager,
+        std::bind(&remote_replicator_client_t::on_write_batch, this,
+            ph::_1, ph::_2, ph::_3, ph::_4)),
     dummy_write_mailbox_(mailbox_manager,
         std::bind(&remote_replicator_client_t::on_dummy_write, this,
             ph::_1, ph::_2)),
@@ -203,13 +205,13 @@ remote_replicator_client_t::remote_replicator_client_t(
                     intro.streaming_begin_timestamp));
                 tracker_.init(new timestamp_range_tracker_t(
                     region_, intro.streaming_begin_timestamp));
+                write_watermark_ = intro.streaming_begin_timestamp;
                 got_intro.pulse();
             });
         remote_replicator_client_bcard_t our_bcard {
             server_id,
             intro_mailbox.get_address(),
-            write_async_mailbox_.get_address(),
-            write_sync_mailbox_.get_address(),
+            write_batch_mailbox_.get_address(),
             dummy_write_mailbox_.get_address(),
             read_mailbox_.get_address() };
         registrant_.init(new registrant_t<remote_replicator_client_bcard_t>(
@@ -239,6 +241,31 @@ remote_replicator_client_t::remote_replicator_client_t(
         backfill_throttler_t::lock_t backfill_throttler_lock(
             backfill_throttler, priority, interruptor);
 
+        /* If the backfillee can, it first copies the data in range sessions. We stay in
+        `PAUSED` mode meanwhile, so the streaming writes are discarded for the copied
+        data too. That's OK because the copied data doesn't count as backfilled until
+        `backfillee.go()` below goes over it again. */
+        {
+            class copy_callback_t : public backfillee_t::callback_t {
+            public:
+                copy_callback_t(store_view_t *s, signal_t *ps) :
+                    store(s), preempt_signal(ps) { }
+                bool on_progress(const region_map_t<version_t> &) THROWS_NOTHING {
+                    unreachable();
+                }
+                bool on_copy_progress() THROWS_NOTHING {
+                    return store->check_ok_to_receive_backfill()
+                        && !preempt_signal->is_pulsed();
+                }
+                store_view_t *store;
+                signal_t *preempt_signal;
+            } copy_callback(store_, backfill_throttler_lock.get_preempt_signal());
+            if (!backfillee.copy(&copy_callback, tracker_->get_backfill_threshold(),
+                    interruptor)) {
+                continue;
+            }
+        }
+
         state_timestamp_t backfill_start_timestamp;
         {
             mutex_assertion_t::acq_t mutex_assertion_acq(&mutex_assertion_);
@@ -364,14 +391,83 @@ remote_replicator_client_t::remote_replicator_client_t(
 remote_replicator_client_t::~remote_replicator_client_t() {
     /* The destructor is declared here instead of the header file so that we can see the
     destructor for `timestamp_range_tracker_t` */
+    if (lag_tracker_ != nullptr) {
+        lag_tracker_->forget();
+    }
+}
+
+void remote_replicator_client_t::on_write_batch(
+        signal_t *interruptor,
+        std::vector<remote_replicator_write_t> &&writes,
+        state_timestamp_t latest_timestamp,
+        const remote_replicator_client_bcard_t::write_ack_mailbox_t::address_t &ack_addr)
+        THROWS_ONLY(interrupted_exc_t) {
+    /* Before we're streaming, the watermark doesn't mean that the writes are in the
+    store, so the lag is unknown. */
+    if (lag_tracker_ != nullptr && mode_ == backfill_mode_t::STREAMING) {
+        lagging_batches_.push_back(std::make_pair(latest_timestamp, get_ticks()));
+        update_lag_tracker();
+    }
+    if (writes.empty()) {
+        /* It's a heartbeat; there's nothing to ack. */
+        return;
+    }
+
+    std::vector<std::pair<state_timestamp_t, write_response_t> > responses;
+    std::vector<size_t> response_index(writes.size());
+    for (size_t i = 0; i < writes.size(); ++i) {
+        if (writes[i].is_sync) {
+            response_index[i] = responses.size();
+            responses.push_back(std::make_pair(writes[i].timestamp, write_response_t()));
+        }
+    }
+
+    /* The writes wait for their predecessors in `timestamp_enforcer_` or `replica_`, so
+    we can start them all at once and let the store work on them in parallel, as if
+    they had arrived in separate messages. */
+    bool interrupted = false;
+    pmap(writes.size(), [&](int64_t i) {
+        remote_replicator_write_t *w = &writes[i];
+        try {
+            if (w->is_sync) {
+                do_write_sync(interruptor, w->write, w->timestamp, w->order_token,
+                    w->durability, &responses[response_index[i]].second);
+            } else {
+                do_write_async(interruptor, std::move(w->write), w->timestamp,
+                    w->order_token);
+            }
+        } catch (const interrupted_exc_t &) {
+            interrupted = true;
+            return;
+        }
+        writes_done_.insert(w->timestamp);
+        while (!writes_done_.empty()
+                && *writes_done_.begin() == write_watermark_.next()) {
+            write_watermark_ = write_watermark_.next();
+            writes_done_.erase(writes_done_.begin());
+        }
+        update_lag_tracker();
+    });
+    if (interrupted) {
+        throw interrupted_exc_t();
+    }
+
+    send(mailbox_manager_, ack_addr, write_watermark_, responses);
 }
 
-void remote_replicator_client_t::on_write_async(
+void remote_replicator_client_t::update_lag_tracker() {
+    while (!lagging_batches_.empty()
+            && lagging_batches_.front().first <= write_watermark_) {
+        lag_tracker_->note_up_to_date_as_of(lagging_batches_.front().second);
+        lagging_batches_.pop_front();
+    }
+}
+
+void remote_replicator_client_t::do_write_async(
         signal_t *interruptor,
         write_t &&write,
         state_timestamp_t timestamp,
-        order_token_t order_token,
-        const mailbox_t<void()>::address_t &ack_addr)
+        order_token_t order_token)
         THROWS_ONLY(interrupted_exc_t) {
     wait_interruptible(&registered_, interruptor);
 
@@ -442,28 +538,24 @@ void remote_replicator_client_t::on_write_async(
             }
         }
     }
-
-    send(mailbox_manager_, ack_addr);
 }
 
-void remote_replicator_client_t::on_write_sync(
+void remote_replicator_client_t::do_write_sync(
         signal_t *interruptor,
         const write_t &write,
         state_timestamp_t timestamp,
         order_token_t order_token,
         write_durability_t durability,
-        const mailbox_t<void(write_response_t)>::address_t &ack_addr)
+        write_response_t *response_out)
         THROWS_ONLY(interrupted_exc_t) {
     /* The current implementation of the dispatcher will never send us an async write
     once it's started sending sync writes, but we don't want to rely on that detail, so
     we pass sync writes through the timestamp enforcer too. */
     timestamp_enforcer_->complete(timestamp);
 
-    write_response_t response;
     replica_->do_write(
         write, timestamp, order_token, durability,
-        interruptor, &response);
-    send(mailbox_manager_, ack_addr, response);
+        interruptor, response_out);
 }
 
 void remote_replicator_client_t::on_dummy_write(
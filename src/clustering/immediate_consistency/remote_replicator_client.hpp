@@ -2,7 +2,11 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_CLIENT_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_CLIENT_HPP_
 
+#include <deque>
 #include <queue>
+#include <set>
+#include <utility>
+#include <vector>
 
 #include "clustering/generic/registrant.hpp"
 #include "clustering/immediate_consistency/backfill_throttler.hpp"
@@ -13,6 +17,7 @@
 #include "concurrency/semaphore.hpp"
 
 class backfill_progress_tracker_t;
+class replication_lag_tracker_t;
 
 /* `remote_replicator_client_t` contacts a `remote_replicator_server_t` on another server
 to sign up for writes to a given shard, and then applies them to a `store_t` on the same
@@ -53,7 +58,10 @@ public:
 
     The `remote_replicator_client_t` constructor blocks until this entire process is
     complete. The backfilled data will be safely flushed to disk by the time it returns.
-    */
+
+    From then on, if `lag_tracker` isn't `nullptr`, we keep it up to date with how far
+    the store lags behind the primary, until the `remote_replicator_client_t` is
+    destroyed. */
 
     remote_replicator_client_t(
         backfill_throttler_t *backfill_throttler,
@@ -70,6 +78,7 @@ public:
 
         store_view_t *store,
         branch_history_manager_t *branch_history_manager,
+        replication_lag_tracker_t *lag_tracker,
 
         signal_t *interruptor) THROWS_ONLY(interrupted_exc_t);
 
@@ -78,24 +87,35 @@ public:
 private:
     class timestamp_range_tracker_t;
 
-    /* `on_write_async()`, `on_write_sync()`, `on_dummy_write()`, and `on_read()`
-    are mailbox callbacks for `write_async_mailbox_`, `write_sync_mailbox_`,
-    `dummy_write_mailbox_` and `read_mailbox_`. */
-    void on_write_async(
+    /* `on_write_batch()`, `on_dummy_write()`, and `on_read()` are mailbox callbacks
+    for `write_batch_mailbox_`, `dummy_write_mailbox_` and `read_mailbox_`.
+    `on_write_batch()` performs the writes in the batch with `do_write_async()` or
+    `do_write_sync()`. */
+    void on_write_batch(
+            signal_t *interruptor,
+            std::vector<remote_replicator_write_t> &&writes,
+            state_timestamp_t latest_timestamp,
+            const remote_replicator_client_bcard_t::write_ack_mailbox_t::address_t
+                &ack_addr)
+        THROWS_ONLY(interrupted_exc_t);
+
+    /* `update_lag_tracker()` is called whenever `write_watermark_` advances. */
+    void update_lag_tracker();
+
+    void do_write_async(
             signal_t *interruptor,
             write_t &&write,
             state_timestamp_t timestamp,
-            order_token_t order_token,
-            const mailbox_t<void()>::address_t &ack_addr)
+            order_token_t order_token)
         THROWS_ONLY(interrupted_exc_t);
 
-    void on_write_sync(
+    void do_write_sync(
             signal_t *interruptor,
             const write_t &write,
             state_timestamp_t timestamp,
             order_token_t order_token,
             write_durability_t durability,
-            const mailbox_t<void(write_response_t)>::address_t &ack_addr)
+            write_response_t *response_out)
         THROWS_ONLY(interrupted_exc_t);
 
     void on_dummy_write(
@@ -162,7 +182,7 @@ private:
     mutex_assertion_t mutex_assertion_;
 
     /* `registered_` is pulsed once `timestamp_enforcer_` is set up. So
-    `on_write_async()` has to wait for it before proceeding. */
+    `do_write_async()` has to wait for it before proceeding. */
     cond_t registered_;
 
     /* `cleanup_rwlock_` is used to temporarily lock out writes when doing the very last
@@ -170,8 +190,20 @@ private:
     acquires it in write mode. */
     rwlock_t cleanup_rwlock_;
 
-    remote_replicator_client_bcard_t::write_async_mailbox_t write_async_mailbox_;
-    remote_replicator_client_bcard_t::write_sync_mailbox_t write_sync_mailbox_;
+    /* `write_watermark_` is the timestamp up to which every write has been performed.
+    `writes_done_` holds the timestamps of the writes after `write_watermark_` that have
+    been performed. */
+    state_timestamp_t write_watermark_;
+    std::set<state_timestamp_t> writes_done_;
+
+    /* `lag_tracker_` may be `nullptr`. `lagging_batches_` holds the latest timestamps of
+    the batches that arrived while `write_watermark_` was still behind them, along with
+    the time at which they arrived. Once the watermark catches up with a batch, the
+    store is as up to date as the primary was when it sent the batch. */
+    replication_lag_tracker_t *const lag_tracker_;
+    std::deque<std::pair<state_timestamp_t, ticks_t> > lagging_batches_;
+
+    remote_replicator_client_bcard_t::write_batch_mailbox_t write_batch_mailbox_;
     remote_replicator_client_bcard_t::dummy_write_mailbox_t dummy_write_mailbox_;
     remote_replicator_client_bcard_t::read_mailbox_t read_mailbox_;
 
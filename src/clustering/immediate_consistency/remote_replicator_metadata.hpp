@@ -2,6 +2,9 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_METADATA_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_METADATA_HPP_
 
+#include <utility>
+#include <vector>
+
 #include "clustering/generic/registration_metadata.hpp"
 #include "clustering/immediate_consistency/history.hpp"
 #include "rdb_protocol/protocol.hpp"
@@ -16,19 +19,41 @@ public:
 
 RDB_DECLARE_SERIALIZABLE(remote_replicator_client_intro_t);
 
+/* `remote_replicator_write_t` is one of the writes in a batch that the
+`remote_replicator_server_t` sends to a `remote_replicator_client_t`. Sync writes get a
+`write_response_t` back; async writes only count towards the ack watermark. */
+class remote_replicator_write_t {
+public:
+    write_t write;
+    state_timestamp_t timestamp;
+    order_token_t order_token;
+    bool is_sync;
+    /* `durability` is only meaningful if `is_sync` is `true`. */
+    write_durability_t durability;
+};
+
+RDB_DECLARE_SERIALIZABLE(remote_replicator_write_t);
+
 class remote_replicator_client_bcard_t {
 public:
     typedef mailbox_t<void(
         remote_replicator_client_intro_t
         )> intro_mailbox_t;
+    /* The writes in a batch are in timestamp order. Once the client has performed
+    them, it replies with the responses to the sync writes in the batch, and with a
+    watermark timestamp: every write at or before the watermark has been performed.
+    Each batch also carries the latest timestamp that the primary had assigned when it
+    sent the batch. The server sends empty batches as heartbeats while there are no
+    writes, so that the client can tell how far behind the primary it is. */
     typedef mailbox_t<void(
-        write_t, state_timestamp_t, order_token_t,
-        mailbox_t<void()>::address_t
-        )> write_async_mailbox_t;
+        state_timestamp_t,
+        std::vector<std::pair<state_timestamp_t, write_response_t> >
+        )> write_ack_mailbox_t;
     typedef mailbox_t<void(
-        write_t, state_timestamp_t, order_token_t, write_durability_t,
-        mailbox_t<void(write_response_t)>::address_t
-        )> write_sync_mailbox_t;
+        std::vector<remote_replicator_write_t>,
+        state_timestamp_t,
+        write_ack_mailbox_t::address_t
+        )> write_batch_mailbox_t;
     typedef mailbox_t<void(
         mailbox_t<void(write_response_t)>::address_t
         )> dummy_write_mailbox_t;
@@ -39,8 +64,7 @@ public:
 
     server_id_t server_id;
     intro_mailbox_t::address_t intro_mailbox;
-    write_async_mailbox_t::address_t write_async_mailbox;
-    write_sync_mailbox_t::address_t write_sync_mailbox;
+    write_batch_mailbox_t::address_t write_batch_mailbox;
     dummy_write_mailbox_t::address_t dummy_write_mailbox;
     read_mailbox_t::address_t read_mailbox;
 };
@@ -1,6 +1,18 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/remote_replicator_server.hpp"
 
+#include <algorithm>
+
+#include "arch/timing.hpp"
+#include "containers/map_sentries.hpp"
+
+/* The server sends an empty write batch to a client that hasn't gotten any writes for
+`HEARTBEAT_INTERVAL_MS`, so that the client can tell how far behind the primary it is.
+Every further heartbeat without writes in between doubles the interval, up to
+`MAX_HEARTBEAT_INTERVAL_MS`, so that idle tables don't keep the network busy. */
+static const int64_t HEARTBEAT_INTERVAL_MS = 200;
+static const int64_t MAX_HEARTBEAT_INTERVAL_MS = 5 * 1000;
+
 remote_replicator_server_t::remote_replicator_server_t(
         mailbox_manager_t *_mailbox_manager,
         primary_dispatcher_t *_primary) :
@@ -14,9 +26,13 @@ remote_replicator_server_t::proxy_replica_t::proxy_replica_t(
         const remote_replicator_client_bcard_t &_client_bcard,
         UNUSED signal_t *interruptor) :
     client_bcard(_client_bcard), parent(_parent), is_ready(false),
+    write_batch_send_pending(false), sent_since_heartbeat(false),
     ready_mailbox(
         parent->mailbox_manager,
-        std::bind(&proxy_replica_t::on_ready, this, ph::_1))
+        std::bind(&proxy_replica_t::on_ready, this, ph::_1)),
+    write_ack_mailbox(
+        parent->mailbox_manager,
+        std::bind(&proxy_replica_t::on_write_ack, this, ph::_1, ph::_2, ph::_3))
 {
     state_timestamp_t first_timestamp;
     registration = make_scoped<primary_dispatcher_t::dispatchee_registration_t>(
@@ -25,6 +41,8 @@ remote_replicator_server_t::proxy_replica_t::proxy_replica_t(
         remote_replicator_client_intro_t {
             first_timestamp,
             ready_mailbox.get_address() });
+    coro_t::spawn_sometime(std::bind(
+        &proxy_replica_t::send_heartbeats, this, drainer.lock()));
 }
 
 void remote_replicator_server_t::proxy_replica_t::do_read(
@@ -53,16 +71,8 @@ void remote_replicator_server_t::proxy_replica_t::do_write_sync(
         signal_t *interruptor,
         write_response_t *response_out) {
     guarantee(is_ready);
-    cond_t got_response;
-    mailbox_t<void(write_response_t)> response_mailbox(
-        parent->mailbox_manager,
-        [&](signal_t *, const write_response_t &response) {
-            *response_out = response;
-            got_response.pulse();
-        });
-    send(parent->mailbox_manager, client_bcard.write_sync_mailbox,
-        write, timestamp, order_token, durability, response_mailbox.get_address());
-    wait_interruptible(&got_response, interruptor);
+    do_write(write, timestamp, order_token, true, durability, interruptor,
+        response_out);
 }
 
 void remote_replicator_server_t::proxy_replica_t::do_dummy_write(
@@ -86,13 +96,102 @@ void remote_replicator_server_t::proxy_replica_t::do_write_async(
         state_timestamp_t timestamp,
         order_token_t order_token,
         signal_t *interruptor) {
-    cond_t got_ack;
-    mailbox_t<void()> ack_mailbox(
-        parent->mailbox_manager,
-        [&](signal_t *) { got_ack.pulse(); });
-    send(parent->mailbox_manager, client_bcard.write_async_mailbox,
-        write, timestamp, order_token, ack_mailbox.get_address());
-    wait_interruptible(&got_ack, interruptor);
+    do_write(write, timestamp, order_token, false, write_durability_t::SOFT,
+        interruptor, nullptr);
+}
+
+void remote_replicator_server_t::proxy_replica_t::do_write(
+        const write_t &write,
+        state_timestamp_t timestamp,
+        order_token_t order_token,
+        bool is_sync,
+        write_durability_t durability,
+        signal_t *interruptor,
+        write_response_t *response_out) {
+    write_waiter_t waiter;
+    waiter.response_out = response_out;
+    map_insertion_sentry_t<state_timestamp_t, write_waiter_t *> waiter_sentry(
+        is_sync ? &sync_write_waiters : &async_write_waiters, timestamp, &waiter);
+
+    write_batch.push_back(remote_replicator_write_t {
+        write, timestamp, order_token, is_sync, durability });
+    if (!write_batch_send_pending) {
+        /* The writes that the dispatcher hands us before `send_write_batch()` runs will
+        go into the same batch. */
+        write_batch_send_pending = true;
+        coro_t::spawn_sometime(std::bind(
+            &proxy_replica_t::send_write_batch, this, drainer.lock()));
+    }
+
+    wait_interruptible(&waiter.acked, interruptor);
+}
+
+void remote_replicator_server_t::proxy_replica_t::send_write_batch(
+        UNUSED auto_drainer_t::lock_t keepalive) {
+    guarantee(write_batch_send_pending);
+    write_batch_send_pending = false;
+    std::vector<remote_replicator_write_t> batch;
+    batch.swap(write_batch);
+    /* The dispatcher's workers may hand us the writes out of order. */
+    std::sort(batch.begin(), batch.end(),
+        [](const remote_replicator_write_t &a, const remote_replicator_write_t &b) {
+            return a.timestamp < b.timestamp;
+        });
+    send(parent->mailbox_manager, client_bcard.write_batch_mailbox,
+        batch, parent->primary->get_latest_timestamp(),
+        write_ack_mailbox.get_address());
+    sent_since_heartbeat = true;
+}
+
+void remote_replicator_server_t::proxy_replica_t::send_heartbeats(
+        auto_drainer_t::lock_t keepalive) {
+    try {
+        int64_t interval_ms = HEARTBEAT_INTERVAL_MS;
+        int64_t idle_ms = 0;
+        for (;;) {
+            nap(HEARTBEAT_INTERVAL_MS, keepalive.get_drain_signal());
+            if (sent_since_heartbeat || write_batch_send_pending) {
+                interval_ms = HEARTBEAT_INTERVAL_MS;
+                idle_ms = 0;
+            } else {
+                idle_ms += HEARTBEAT_INTERVAL_MS;
+            }
+            sent_since_heartbeat = false;
+            if (idle_ms < interval_ms) {
+                continue;
+            }
+            /* The client ignores the batches until it's ready. */
+            if (is_ready) {
+                send(parent->mailbox_manager, client_bcard.write_batch_mailbox,
+                    std::vector<remote_replicator_write_t>(),
+                    parent->primary->get_latest_timestamp(),
+                    write_ack_mailbox.get_address());
+            }
+            interval_ms = std::min(interval_ms * 2, MAX_HEARTBEAT_INTERVAL_MS);
+            idle_ms = 0;
+        }
+    } catch (const interrupted_exc_t &) {
+        /* We're being destroyed. */
+    }
+}
+
+void remote_replicator_server_t::proxy_replica_t::on_write_ack(
+        UNUSED signal_t *interruptor,
+        state_timestamp_t watermark,
+        std::vector<std::pair<state_timestamp_t, write_response_t> > &&responses) {
+    ASSERT_FINITE_CORO_WAITING;
+    for (auto &pair : responses) {
+        auto it = sync_write_waiters.find(pair.first);
+        if (it != sync_write_waiters.end()) {
+            *it->second->response_out = std::move(pair.second);
+            it->second->acked.pulse_if_not_already_pulsed();
+        }
+    }
+    for (auto it = async_write_waiters.begin();
+            it != async_write_waiters.end() && it->first <= watermark;
+            ++it) {
+        it->second->acked.pulse_if_not_already_pulsed();
+    }
 }
 
 void remote_replicator_server_t::proxy_replica_t::on_ready(signal_t *) {
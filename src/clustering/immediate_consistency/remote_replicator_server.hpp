@@ -2,6 +2,9 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_SERVER_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_SERVER_HPP_
 
+#include <map>
+#include <vector>
+
 #include "clustering/generic/registrar.hpp"
 #include "clustering/immediate_consistency/primary_dispatcher.hpp"
 #include "clustering/immediate_consistency/remote_replicator_metadata.hpp"
@@ -64,16 +67,55 @@ private:
             write_response_t *response_out);
 
     private:
+        /* `do_write_sync()` and `do_write_async()` put the write into `write_batch`
+        and wait for the client to ack it. Writes that arrive before
+        `send_write_batch()` gets to run go out to the client in the same message. */
+        void do_write(
+            const write_t &write,
+            state_timestamp_t timestamp,
+            order_token_t order_token,
+            bool is_sync,
+            write_durability_t durability,
+            signal_t *interruptor,
+            write_response_t *response_out);
+        void send_write_batch(auto_drainer_t::lock_t keepalive);
+
+        /* `send_heartbeats()` sends an empty batch whenever no batch has gone out for a
+        while, and less and less often as long as no writes come in. The client uses
+        the batches to keep track of its replication lag. */
+        void send_heartbeats(auto_drainer_t::lock_t keepalive);
+
+        void on_write_ack(
+            signal_t *interruptor,
+            state_timestamp_t watermark,
+            std::vector<std::pair<state_timestamp_t, write_response_t> > &&responses);
+
         void on_ready(signal_t *interruptor);
 
         remote_replicator_client_bcard_t client_bcard;
         remote_replicator_server_t *parent;
         bool is_ready;
 
+        std::vector<remote_replicator_write_t> write_batch;
+        bool write_batch_send_pending;
+        bool sent_since_heartbeat;
+
+        /* The writes that are waiting for an ack, by timestamp. Async writes are acked
+        by the watermark; sync writes wait for their responses. */
+        class write_waiter_t {
+        public:
+            write_response_t *response_out;
+            cond_t acked;
+        };
+        std::map<state_timestamp_t, write_waiter_t *> async_write_waiters;
+        std::map<state_timestamp_t, write_waiter_t *> sync_write_waiters;
+
         // The destruction order matters: The `ready_mailbox` callback assumes
         // that `registration` is still valid.
         scoped_ptr_t<primary_dispatcher_t::dispatchee_registration_t> registration;
         remote_replicator_client_intro_t::ready_mailbox_t ready_mailbox;
+        remote_replicator_client_bcard_t::write_ack_mailbox_t write_ack_mailbox;
+        auto_drainer_t drainer;
     };
 
     mailbox_manager_t *mailbox_manager;
@@ -0,0 +1,56 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_REPLICATION_LAG_TRACKER_HPP_
+#define CLUSTERING_IMMEDIATE_CONSISTENCY_REPLICATION_LAG_TRACKER_HPP_
+
+#include "errors.hpp"
+#include <boost/optional.hpp>
+
+#include "threading.hpp"
+#include "time.hpp"
+
+/* `replication_lag_tracker_t` keeps track of how far the data in a secondary replica's
+store might lag behind the primary replica. The `remote_replicator_client_t` updates it
+as it applies the writes and heartbeats that the `remote_replicator_server_t` sends, and
+the `direct_query_server_t` checks it before serving a read with a `max_staleness`
+bound.
+
+The lag is measured on the secondary's own clock, from the moment a message from the
+primary arrived, so it doesn't depend on the clocks of the two servers agreeing. It
+doesn't include the time that the message spent on the network. */
+
+class replication_lag_tracker_t : public home_thread_mixin_debug_only_t {
+public:
+    replication_lag_tracker_t() : up_to_date_as_of(boost::none) { }
+
+    /* Records that, as of the local time `ticks`, the store had every write that the
+    primary replica had performed. */
+    void note_up_to_date_as_of(ticks_t ticks) {
+        assert_thread();
+        if (!static_cast<bool>(up_to_date_as_of) || *up_to_date_as_of < ticks) {
+            up_to_date_as_of = ticks;
+        }
+    }
+
+    /* Records that we can't tell anymore how far behind the store is, for example
+    because we stopped streaming writes from the primary. */
+    void forget() {
+        assert_thread();
+        up_to_date_as_of = boost::none;
+    }
+
+    /* Returns the lag in milliseconds, or `boost::none` if it isn't known. */
+    boost::optional<uint64_t> get_lag_ms() const {
+        assert_thread();
+        if (!static_cast<bool>(up_to_date_as_of)) {
+            return boost::none;
+        }
+        return (get_ticks() - *up_to_date_as_of) / 1000000;
+    }
+
+private:
+    boost::optional<ticks_t> up_to_date_as_of;
+
+    DISABLE_COPYING(replication_lag_tracker_t);
+};
+
+#endif /* CLUSTERING_IMMEDIATE_CONSISTENCY_REPLICATION_LAG_TRACKER_HPP_ */
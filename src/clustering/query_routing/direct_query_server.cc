@@ -1,14 +1,23 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/query_routing/direct_query_server.hpp"
 
+#include "clustering/immediate_consistency/replication_lag_tracker.hpp"
 #include "protocol_api.hpp"
 #include "store_view.hpp"
+#include "time.hpp"
+
+/* How much weight the latest read gets in the moving average of the service time. */
+static const double SERVICE_TIME_EWMA_WEIGHT = 0.2;
 
 direct_query_server_t::direct_query_server_t(
         mailbox_manager_t *mm,
-        store_view_t *svs_) :
+        store_view_t *svs_,
+        replication_lag_tracker_t *_lag_tracker) :
     mailbox_manager(mm),
     svs(svs_),
+    lag_tracker(_lag_tracker),
+    reads_in_progress(0),
+    service_time_us(0),
     read_mailbox(mm, std::bind(&direct_query_server_t::on_read, this,
                                ph::_1, ph::_2, ph::_3))
     { }
@@ -17,10 +26,27 @@ direct_query_bcard_t direct_query_server_t::get_bcard() {
     return direct_query_bcard_t(read_mailbox.get_address());
 }
 
+direct_query_load_t direct_query_server_t::get_load() const {
+    return direct_query_load_t(reads_in_progress, service_time_us);
+}
+
 void direct_query_server_t::on_read(
         signal_t *interruptor,
         const read_t &read,
-        const mailbox_addr_t<void(read_response_t)> &cont) {
+        const mailbox_addr_t<void(
+            boost::variant<read_response_t, cannot_perform_query_exc_t>,
+            direct_query_load_t)> &cont) {
+    typedef boost::variant<read_response_t, cannot_perform_query_exc_t> reply_t;
+
+    if (static_cast<bool>(read.max_staleness_ms) && lag_tracker != nullptr) {
+        boost::optional<uint64_t> lag_ms = lag_tracker->get_lag_ms();
+        if (!static_cast<bool>(lag_ms) || *lag_ms > *read.max_staleness_ms) {
+            send(mailbox_manager, cont, reply_t(cannot_perform_query_exc_t(
+                "replica is not within the `max_staleness` bound",
+                query_state_t::FAILED)), get_load());
+            return;
+        }
+    }
 
     // Shortcut: Dummy reads for checking table status are fulfilled
     // without hitting the store.
@@ -28,7 +54,7 @@ void direct_query_server_t::on_read(
         read_response_t response;
         response.response = dummy_read_response_t();
         response.n_shards = 1;
-        send(mailbox_manager, cont, response);
+        send(mailbox_manager, cont, reply_t(response), get_load());
         return;
     }
 
@@ -42,12 +68,22 @@ void direct_query_server_t::on_read(
 #endif
 
         read_response_t response;
-        svs->read(DEBUG_ONLY(metainfo_checker, )
-                  read,
-                  &response,
-                  &token,
-                  interruptor);
-        send(mailbox_manager, cont, response);
+        const ticks_t start_ticks = get_ticks();
+        ++reads_in_progress;
+        try {
+            svs->read(DEBUG_ONLY(metainfo_checker, )
+                      read,
+                      &response,
+                      &token,
+                      interruptor);
+        } catch (const interrupted_exc_t &) {
+            --reads_in_progress;
+            throw;
+        }
+        --reads_in_progress;
+        const double read_us = (get_ticks() - start_ticks) / 1000.0;
+        service_time_us += SERVICE_TIME_EWMA_WEIGHT * (read_us - service_time_us);
+        send(mailbox_manager, cont, reply_t(response), get_load());
     } catch (const interrupted_exc_t &) {
         /* ignore */
     }
@@ -5,19 +5,25 @@
 #include "clustering/query_routing/metadata.hpp"
 #include "concurrency/fifo_checker.hpp"
 
+class replication_lag_tracker_t;
 class store_view_t;
 
 /* For each primary or secondary replica of each shard, there is a
 `direct_query_server_t`. The `direct_query_server_t` allows the `table_query_server_t` to
 bypass the `broadcaster_t` and read directly from the B-tree itself. This reduces network
 traffic and is possible even when the primary replica is unavailable, but the data it
-returns might be out of date. */
+returns might be out of date.
+
+`lag_tracker` tells how far the store lags behind the primary, for reads with a
+`max_staleness` bound. It's `nullptr` if the store belongs to the primary replica, which
+never lags. */
 
 class direct_query_server_t {
 public:
     direct_query_server_t(
             mailbox_manager_t *mm,
-            store_view_t *svs);
+            store_view_t *svs,
+            replication_lag_tracker_t *lag_tracker);
 
     direct_query_bcard_t get_bcard();
 
@@ -25,10 +31,20 @@ private:
     void on_read(
             signal_t *interruptor,
             const read_t &,
-            const mailbox_addr_t<void(read_response_t)> &);
+            const mailbox_addr_t<void(
+                boost::variant<read_response_t, cannot_perform_query_exc_t>,
+                direct_query_load_t)> &);
+
+    direct_query_load_t get_load() const;
 
     mailbox_manager_t *mailbox_manager;
     store_view_t *svs;
+    replication_lag_tracker_t *lag_tracker;
+
+    /* The load that we report back with each reply. `service_time_us` is a moving
+    average over the reads that went to the store. */
+    int64_t reads_in_progress;
+    double service_time_us;
 
     order_source_t order_source;  // TODO: order_token_t::ignore
 
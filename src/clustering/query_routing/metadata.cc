@@ -16,6 +16,9 @@ RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(primary_query_bcard_t, region, multi_client)
 
 RDB_IMPL_EQUALITY_COMPARABLE_2(primary_query_bcard_t, region, multi_client);
 
+RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(
+        direct_query_load_t, reads_in_progress, service_time_us);
+
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(direct_query_bcard_t, read_mailbox);
 RDB_IMPL_EQUALITY_COMPARABLE_1(direct_query_bcard_t, read_mailbox);
 
@@ -71,14 +71,38 @@ RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(primary_query_bcard_t::write_request_t);
 RDB_DECLARE_SERIALIZABLE(primary_query_bcard_t);
 RDB_DECLARE_EQUALITY_COMPARABLE(primary_query_bcard_t);
 
+/* `direct_query_load_t` is the load feedback that a `direct_query_server_t` sends back
+with the reply to each read, so that `table_query_client_t` can route reads away from
+busy replicas. */
+
+class direct_query_load_t {
+public:
+    direct_query_load_t() : reads_in_progress(0), service_time_us(0) { }
+    direct_query_load_t(int64_t rip, double st) :
+        reads_in_progress(rip), service_time_us(st) { }
+
+    /* The number of other reads that the replica was performing when it replied. */
+    int64_t reads_in_progress;
+
+    /* An exponentially weighted moving average of how many microseconds the replica's
+    store took to perform a read. */
+    double service_time_us;
+};
+
+RDB_DECLARE_SERIALIZABLE(direct_query_load_t);
+
 /* Each replica exposes a `direct_query_bcard_t` for each shard that it is a primary or
-secondary replica for. */
+secondary replica for. A read with a `max_staleness` bound fails with a
+`cannot_perform_query_exc_t` if the replica might lag further behind the primary than
+that. */
 
 class direct_query_bcard_t {
 public:
     typedef mailbox_t< void(
             read_t,
-            mailbox_addr_t< void(read_response_t)>
+            mailbox_addr_t< void(
+                boost::variant<read_response_t, cannot_perform_query_exc_t>,
+                direct_query_load_t)>
             )> read_mailbox_t;
 
     direct_query_bcard_t() { }
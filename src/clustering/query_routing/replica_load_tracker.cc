@@ -0,0 +1,70 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "clustering/query_routing/replica_load_tracker.hpp"
+
+#include <algorithm>
+
+#include "config/args.hpp"
+#include "random.hpp"
+
+/* How much weight the latest read gets in the moving average of the latency. */
+static const double LATENCY_EWMA_WEIGHT = 0.2;
+
+/* How long we wait before we give an idle replica another chance. */
+static const ticks_t REPLICA_LOAD_EXPIRY_MS = 1000;
+
+replica_load_tracker_t::replica_load_tracker_t() :
+    reads_in_flight(0), has_reply(false), last_reply_ticks(0), latency_us(0) { }
+
+void replica_load_tracker_t::on_send() {
+    ++reads_in_flight;
+}
+
+void replica_load_tracker_t::on_reply(
+        ticks_t latency, const direct_query_load_t &load) {
+    guarantee(reads_in_flight > 0);
+    --reads_in_flight;
+    const double reply_latency_us = latency / 1000.0;
+    if (has_reply) {
+        latency_us += LATENCY_EWMA_WEIGHT * (reply_latency_us - latency_us);
+    } else {
+        latency_us = reply_latency_us;
+        has_reply = true;
+    }
+    last_reply_ticks = get_ticks();
+    last_load = load;
+}
+
+void replica_load_tracker_t::on_no_reply() {
+    guarantee(reads_in_flight > 0);
+    --reads_in_flight;
+}
+
+double replica_load_tracker_t::get_expected_latency_us(ticks_t now) const {
+    if (!has_reply || (reads_in_flight == 0
+            && now > last_reply_ticks + REPLICA_LOAD_EXPIRY_MS * MILLION)) {
+        return 0;
+    }
+    /* `last_load.reads_in_progress` includes other clients' reads, but it's out of
+    date; `reads_in_flight` only counts our own, but it's current. */
+    const int64_t queued = std::max(reads_in_flight, last_load.reads_in_progress);
+    return latency_us + queued * last_load.service_time_us;
+}
+
+size_t replica_load_tracker_t::choose(
+        const std::vector<const replica_load_tracker_t *> &candidates,
+        boost::optional<size_t> local) {
+    guarantee(!candidates.empty());
+    guarantee(!local || *local < candidates.size());
+    if (candidates.size() == 1) {
+        return 0;
+    }
+    const size_t first = local ? *local : randsize(candidates.size());
+    size_t second = randsize(candidates.size() - 1);
+    if (second >= first) {
+        ++second;
+    }
+    const ticks_t now = get_ticks();
+    return candidates[second]->get_expected_latency_us(now)
+            < candidates[first]->get_expected_latency_us(now)
+        ? second : first;
+}
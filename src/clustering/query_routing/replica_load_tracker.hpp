@@ -0,0 +1,55 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_QUERY_ROUTING_REPLICA_LOAD_TRACKER_HPP_
+#define CLUSTERING_QUERY_ROUTING_REPLICA_LOAD_TRACKER_HPP_
+
+#include <vector>
+
+#include "errors.hpp"
+#include <boost/optional.hpp>
+
+#include "clustering/query_routing/metadata.hpp"
+#include "time.hpp"
+
+/* `replica_load_tracker_t` estimates how long a read sent to a given replica will take,
+from the latencies that `table_query_client_t` has seen for the replica and from the
+`direct_query_load_t` that the replica sent back with its replies. The estimate is the
+moving average of the latency plus one service time for each read that is queued up on
+the replica.
+
+If we haven't heard back from a replica for a while and nothing is in flight to it, the
+estimate is zero so that the replica gets another chance. Otherwise a replica that was
+slow once would never get any reads again, and we'd never notice that it recovered. */
+
+class replica_load_tracker_t {
+public:
+    replica_load_tracker_t();
+
+    /* Call `on_send()` when sending a read to the replica, and then either `on_reply()`
+    with the latency of the read and the load that the replica reported, or
+    `on_no_reply()` if the read failed or was interrupted. */
+    void on_send();
+    void on_reply(ticks_t latency, const direct_query_load_t &load);
+    void on_no_reply();
+
+    double get_expected_latency_us(ticks_t now) const;
+
+    /* Picks two different candidates at random and returns the index of the one that is
+    expected to reply sooner ("power of two choices"). Comparing only two random
+    candidates, instead of always taking the least loaded one, keeps the clients from
+    all piling onto the same replica between two updates of its load.
+
+    If `local` is set, that candidate is always one of the two, and only the other one
+    is random. A local replica has no network round trip, so it should only lose to a
+    replica that is actually expected to be faster. */
+    static size_t choose(const std::vector<const replica_load_tracker_t *> &candidates,
+                         boost::optional<size_t> local = boost::none);
+
+private:
+    int64_t reads_in_flight;
+    bool has_reply;
+    ticks_t last_reply_ticks;
+    double latency_us;
+    direct_query_load_t last_load;
+};
+
+#endif /* CLUSTERING_QUERY_ROUTING_REPLICA_LOAD_TRACKER_HPP_ */
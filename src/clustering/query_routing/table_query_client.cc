@@ -11,6 +11,10 @@
 #include "concurrency/watchable.hpp"
 #include "rdb_protocol/env.hpp"
 
+/* How long we keep a replica that turned down a read with a `max_staleness` bound from
+getting more of them. */
+static const ticks_t LAGGING_REPLICA_RETRY_MS = 500;
+
 table_query_client_t::table_query_client_t(
         const namespace_id_t &_table_id,
         mailbox_manager_t *mm,
@@ -341,38 +345,69 @@ void table_query_client_t::dispatch_outdated_read(
 
     std::vector<scoped_ptr_t<outdated_read_info_t> > replicas_to_contact;
 
+    /* With a `max_staleness` bound, we skip the replicas that recently turned down a
+    read for lagging too far behind, and fall back to the primary replica if there's no
+    other replica left. */
+    const bool is_bounded = static_cast<bool>(op.max_staleness_ms);
+    const ticks_t now = get_ticks();
+
     scoped_ptr_t<outdated_read_info_t> new_op_info(new outdated_read_info_t());
     relationships.visit(region_t::universe(),
     [&](const region_t &region, const std::set<relationship_t *> &rels) {
         if (op.shard(region, &new_op_info->sharded_op)) {
             std::vector<relationship_t *> potential_relationships;
             relationship_t *chosen_relationship = nullptr;
+            relationship_t *primary_relationship = nullptr;
             for (auto jt = rels.begin(); jt != rels.end(); ++jt) {
                 // See the comment in `dispatch_immediate_op` about why we need to
                 // check that `region` and the relationship's region are the same.
-                if ((*jt)->direct_bcard != nullptr && (*jt)->region == region) {
-                    if ((*jt)->is_local) {
-                        chosen_relationship = *jt;
-                        break;
-                    } else {
-                        potential_relationships.push_back(*jt);
-                    }
+                if ((*jt)->region != region) {
+                    continue;
+                }
+                if (is_bounded && (*jt)->primary_client != nullptr) {
+                    primary_relationship = *jt;
+                }
+                if ((*jt)->direct_bcard != nullptr
+                        && (!is_bounded || (*jt)->lagging_until <= now)) {
+                    potential_relationships.push_back(*jt);
                 }
             }
-            if (!chosen_relationship && !potential_relationships.empty()) {
-                chosen_relationship
-                    = potential_relationships[randint(potential_relationships.size())];
+            if (!potential_relationships.empty()) {
+                /* The local replica, if any, is always one of the two choices, so it
+                only loses to a replica that is expected to be faster. */
+                std::vector<const replica_load_tracker_t *> loads;
+                boost::optional<size_t> local;
+                for (relationship_t *rel : potential_relationships) {
+                    if (rel->is_local) {
+                        local = loads.size();
+                    }
+                    loads.push_back(&rel->load);
+                }
+                chosen_relationship = potential_relationships[
+                    replica_load_tracker_t::choose(loads, local)];
             }
-            if (!chosen_relationship) {
+            if (!chosen_relationship && !primary_relationship) {
                 /* Don't bother looking for masters; if there are no direct
                    readers, there won't be any masters either. */
                 throw cannot_perform_query_exc_t(
                     "no replica is available",
                     query_state_t::FAILED);
             }
-            new_op_info->direct_bcard = chosen_relationship->direct_bcard;
-            new_op_info->keepalive = auto_drainer_t::lock_t(
-                &chosen_relationship->drainer);
+            new_op_info->relationship = chosen_relationship;
+            if (chosen_relationship != nullptr) {
+                new_op_info->direct_bcard = chosen_relationship->direct_bcard;
+                new_op_info->keepalive = auto_drainer_t::lock_t(
+                    &chosen_relationship->drainer);
+            } else {
+                new_op_info->direct_bcard = nullptr;
+            }
+            if (primary_relationship != nullptr) {
+                new_op_info->primary_client = primary_relationship->primary_client;
+                new_op_info->primary_keepalive = auto_drainer_t::lock_t(
+                    &primary_relationship->drainer);
+            } else {
+                new_op_info->primary_client = nullptr;
+            }
             replicas_to_contact.push_back(std::move(new_op_info));
             new_op_info.init(new outdated_read_info_t());
         }
@@ -405,23 +440,82 @@ void table_query_client_t::perform_outdated_read(
     outdated_read_info_t *replica_to_contact = (*replicas_to_contact)[i].get();
 
     try {
-        cond_t done;
-        mailbox_t<void(read_response_t)> cont(mailbox_manager,
-            [&](signal_t *, const read_response_t &res) {
-                results->at(i) = res;
-                done.pulse();
-            });
+        if (replica_to_contact->direct_bcard != nullptr) {
+            replica_load_tracker_t *load = &replica_to_contact->relationship->load;
+            const ticks_t start_ticks = get_ticks();
+            cond_t done;
+            boost::optional<cannot_perform_query_exc_t> rejection;
+            mailbox_t<void(boost::variant<read_response_t, cannot_perform_query_exc_t>,
+                           direct_query_load_t)>
+                cont(mailbox_manager,
+                    [&](signal_t *,
+                            const boost::variant<
+                                read_response_t, cannot_perform_query_exc_t> &res,
+                            const direct_query_load_t &replica_load) {
+                        if (const read_response_t *response =
+                                boost::get<read_response_t>(&res)) {
+                            results->at(i) = *response;
+                        } else {
+                            rejection = boost::get<cannot_perform_query_exc_t>(res);
+                        }
+                        load->on_reply(get_ticks() - start_ticks, replica_load);
+                        done.pulse();
+                    });
+
+            load->on_send();
+            send(mailbox_manager,
+                replica_to_contact->direct_bcard->read_mailbox,
+                replica_to_contact->sharded_op,
+                cont.get_address());
+            wait_any_t waiter(replica_to_contact->keepalive.get_drain_signal(), &done);
+            try {
+                wait_interruptible(&waiter, interruptor);
+            } catch (const interrupted_exc_t &) {
+                if (!done.is_pulsed()) {
+                    load->on_no_reply();
+                }
+                throw;
+            }
+            if (!done.is_pulsed()) {
+                load->on_no_reply();
+                /* `wait_interruptible()` returned because
+                `replica_to_contact->keepalive.get_drain_signal()` was pulsed */
+                failures->at(i).assign("lost contact with replica");
+                return;
+            }
+            if (!static_cast<bool>(rejection)) {
+                return;
+            }
+            if (replica_to_contact->primary_client == nullptr) {
+                failures->at(i).assign(rejection->what());
+                return;
+            }
+            /* The replica lags too far behind the primary. Leave it alone for a while
+            and ask the primary instead. */
+            replica_to_contact->relationship->lagging_until =
+                get_ticks() + LAGGING_REPLICA_RETRY_MS * MILLION;
+        }
 
-        send(mailbox_manager,
-            replica_to_contact->direct_bcard->read_mailbox,
-            replica_to_contact->sharded_op,
-            cont.get_address());
-        wait_any_t waiter(replica_to_contact->keepalive.get_drain_signal(), &done);
-        wait_interruptible(&waiter, interruptor);
-        if (!done.is_pulsed()) {
-            /* `wait_interruptible()` returned because
-            `replica_to_contact->keepalive.get_drain_signal()` was pulsed */
-            failures->at(i).assign("lost contact with replica");
+        /* The primary replica only performs up-to-date reads. */
+        read_t primary_read = replica_to_contact->sharded_op;
+        primary_read.read_mode = read_mode_t::SINGLE;
+        try {
+            fifo_enforcer_sink_t::exit_read_t token;
+            replica_to_contact->primary_client->new_read_token(&token);
+            wait_any_t waiter(
+                replica_to_contact->primary_keepalive.get_drain_signal(), interruptor);
+            replica_to_contact->primary_client->read(
+                primary_read,
+                &results->at(i),
+                order_token_t::ignore.with_read_mode(),
+                &token,
+                &waiter);
+        } catch (const cannot_perform_query_exc_t &e) {
+            failures->at(i).assign(e.what());
+        } catch (const interrupted_exc_t &) {
+            if (!interruptor->is_pulsed()) {
+                failures->at(i).assign("lost contact with primary replica");
+            }
         }
     } catch (const interrupted_exc_t &) {
         /* Return immediately. `dispatch_immediate_op()` will notice that the
@@ -538,6 +632,7 @@ void table_query_client_t::relationship_coroutine(
         relationship_record.is_local =
             (key.first == mailbox_manager->get_connectivity_cluster()->get_me());
         relationship_record.region = bcard.region;
+        relationship_record.lagging_until = 0;
 
         scoped_ptr_t<primary_query_client_t> primary_client;
         if (static_cast<bool>(bcard.primary)) {
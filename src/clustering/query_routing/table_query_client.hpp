@@ -11,11 +11,13 @@
 
 #include "clustering/administration/auth/permission_error.hpp"
 #include "clustering/query_routing/metadata.hpp"
+#include "clustering/query_routing/replica_load_tracker.hpp"
 #include "containers/clone_ptr.hpp"
 #include "concurrency/fifo_enforcer.hpp"
 #include "concurrency/watchable_map.hpp"
 #include "protocol_api.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "time.hpp"
 
 class multi_table_manager_t;
 class primary_query_client_t;
@@ -74,6 +76,11 @@ private:
         region_t region;
         primary_query_client_t *primary_client;
         const direct_query_bcard_t *direct_bcard;
+        /* If the replica turned down a read because it lagged too far behind the
+        primary, we don't send it reads with a `max_staleness` bound until then. */
+        ticks_t lagging_until;
+        /* Used to pick the replica that's likely to answer an outdated read soonest. */
+        replica_load_tracker_t load;
         auto_drainer_t drainer;
     };
 
@@ -90,11 +97,17 @@ private:
         auto_drainer_t::lock_t keepalive;
     };
 
+    /* For a read with a `max_staleness` bound, `direct_bcard` is `nullptr` if no
+    replica is known to be recent enough, and `primary_client` is the primary replica
+    that we fall back to. */
     class outdated_read_info_t {
     public:
         read_t sharded_op;
+        relationship_t *relationship;
         const direct_query_bcard_t *direct_bcard;
         auto_drainer_t::lock_t keepalive;
+        primary_query_client_t *primary_client;
+        auto_drainer_t::lock_t primary_keepalive;
     };
 
     template <class op_type, class fifo_enforcer_token_type, class op_response_type>
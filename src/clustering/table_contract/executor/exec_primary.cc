@@ -129,7 +129,8 @@ void primary_execution_t::run(auto_drainer_t::lock_t keepalive) {
 
         direct_query_server_t direct_query_server(
             context->mailbox_manager,
-            store);
+            store,
+            nullptr);
 
         on_thread_t thread_switcher_2(home_thread());
 
@@ -4,6 +4,7 @@
 #include <utility>
 
 #include "clustering/immediate_consistency/remote_replicator_client.hpp"
+#include "clustering/immediate_consistency/replication_lag_tracker.hpp"
 #include "clustering/query_routing/direct_query_server.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 
@@ -82,7 +83,11 @@ void secondary_execution_t::run(auto_drainer_t::lock_t keepalive) {
                     order_source.check_in("secondary_execution_t").with_read_mode(),
                     &token, region, &interruptor_on_store_thread)));
 
-            direct_query_server_t direct_query_server(context->mailbox_manager, store);
+            /* `lag_tracker` is updated by `remote_replicator_client` below, once it's
+            streaming writes from the primary. */
+            replication_lag_tracker_t lag_tracker;
+            direct_query_server_t direct_query_server(
+                context->mailbox_manager, store, &lag_tracker);
 
             /* Switch back to the home thread so we can send the initial ack */
             on_thread_t thread_switcher_2(home_thread());
@@ -184,6 +189,7 @@ void secondary_execution_t::run(auto_drainer_t::lock_t keepalive) {
                 primary,
                 store,
                 context->branch_history_manager,
+                &lag_tracker,
                 &stop_signal_on_store_thread);
 
             on_thread_t thread_switcher_4(home_thread());
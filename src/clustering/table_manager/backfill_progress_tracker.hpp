@@ -3,6 +3,7 @@
 #define CLUSTERING_TABLE_MANAGER_BACKFILL_PROGRESS_TRACKER_HPP_
 
 #include <map>
+#include <vector>
 
 #include "concurrency/one_per_thread.hpp"
 #include "containers/uuid.hpp"
@@ -18,6 +19,9 @@ public:
         microtime_t start_time;
         server_id_t source_server_id;
         double progress;
+        /* The progress of each range session while the backfill copies the data in
+        range sessions, between 0.0 and 1.0, in key order. Empty otherwise. */
+        std::vector<double> session_progress;
     };
 
     progress_tracker_t * insert_progress_tracker(const region_t &region);
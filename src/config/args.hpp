@@ -44,6 +44,10 @@
 // useful.
 #define DEFAULT_IO_BATCH_FACTOR                   1
 
+// How long the cache may delay the flush of a soft durability txn, so that it can
+// be combined with the flushes of later txns. Zero flushes every txn right away.
+#define DEFAULT_SOFT_DURABILITY_FLUSH_DELAY_MS    10
+
 // I/O priority of index writes in the log serializer
 #define INDEX_WRITE_IO_PRIORITY                   128
 
@@ -14,6 +14,7 @@
 #include "containers/archive/versioned.hpp"
 #include "containers/uuid.hpp"
 #include "rpc/serialize_macros.hpp"
+#include "thread_local.hpp"
 
 const char *archive_result_as_str(archive_result_t archive_result) {
     switch (archive_result) {
@@ -58,17 +59,59 @@ int64_t force_read(read_stream_t *s, void *p, int64_t n) {
     return written_so_far;
 }
 
+/* A message is usually serialized on one thread and destroyed on another; since each
+pool keeps at most `MAX_UNUSED_WRITE_BUFFERS` buffers, this can't pile up memory on the
+destroying thread. */
+#define MAX_UNUSED_WRITE_BUFFERS 256
+
+TLS_with_init(write_buffer_pool_t *, write_buffer_pool, nullptr);
+
+write_buffer_pool_t::write_buffer_pool_t() {
+    rassert(TLS_get_write_buffer_pool() == nullptr,
+            "write buffer pool initialized twice on this thread");
+    TLS_set_write_buffer_pool(this);
+}
+
+write_buffer_pool_t::~write_buffer_pool_t() {
+    rassert(TLS_get_write_buffer_pool() == this);
+    TLS_set_write_buffer_pool(nullptr);
+    while (write_buffer_t *buffer = unused_.head()) {
+        unused_.remove(buffer);
+        delete buffer;
+    }
+}
+
+write_buffer_t *write_buffer_pool_t::get() {
+    write_buffer_pool_t *pool = TLS_get_write_buffer_pool();
+    if (pool == nullptr || pool->unused_.empty()) {
+        return new write_buffer_t;
+    }
+    write_buffer_t *buffer = pool->unused_.head();
+    pool->unused_.remove(buffer);
+    buffer->size = 0;
+    return buffer;
+}
+
+void write_buffer_pool_t::release(write_buffer_t *buffer) {
+    write_buffer_pool_t *pool = TLS_get_write_buffer_pool();
+    if (pool != nullptr && pool->unused_.size() < MAX_UNUSED_WRITE_BUFFERS) {
+        pool->unused_.push_front(buffer);
+    } else {
+        delete buffer;
+    }
+}
+
 write_message_t::~write_message_t() {
     while (write_buffer_t *buffer = buffers_.head()) {
         buffers_.remove(buffer);
-        delete buffer;
+        write_buffer_pool_t::release(buffer);
     }
 }
 
 void write_message_t::append(const void *p, int64_t n) {
     while (n > 0) {
         if (buffers_.empty() || buffers_.tail()->size == write_buffer_t::DATA_SIZE) {
-            buffers_.push_back(new write_buffer_t);
+            buffers_.push_back(write_buffer_pool_t::get());
         }
 
         write_buffer_t *b = buffers_.tail();
@@ -81,6 +124,10 @@ void write_message_t::append(const void *p, int64_t n) {
     }
 }
 
+void write_message_t::append(write_message_t *other) {
+    buffers_.append_and_clear(&other->buffers_);
+}
+
 size_t write_message_t::size() const {
     size_t ret = 0;
     for (write_buffer_t *h = buffers_.head(); h != nullptr; h = buffers_.next(h)) {
@@ -103,6 +103,26 @@ private:
     DISABLE_COPYING(write_buffer_t);
 };
 
+/* While a `write_buffer_pool_t` exists on a thread, the buffers of the
+`write_message_t`s destroyed on that thread are kept for the next messages instead of
+being freed, so that serializing a message usually doesn't allocate. A message is
+destroyed once it has been sent, so its buffers are reused only after the send is
+done. Each `linux_thread_t` owns one; construct at most one per thread. Threads without
+a pool allocate and free buffers directly. */
+class write_buffer_pool_t {
+public:
+    write_buffer_pool_t();
+    ~write_buffer_pool_t();
+
+    static write_buffer_t *get();
+    static void release(write_buffer_t *buffer);
+
+private:
+    intrusive_list_t<write_buffer_t> unused_;
+
+    DISABLE_COPYING(write_buffer_pool_t);
+};
+
 // A set of buffers in which an atomic message to be sent on a stream
 // gets built up.  (This way we don't flush after the first four bytes
 // sent to a stream, or buffer things and then forget to manually
@@ -117,6 +137,9 @@ public:
 
     void append(const void *p, int64_t n);
 
+    // Moves the buffers of `other` to the end of this message without copying them.
+    void append(write_message_t *other);
+
     size_t size() const;
 
     intrusive_list_t<write_buffer_t> *unsafe_expose_buffers() { return &buffers_; }
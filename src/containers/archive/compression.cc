@@ -0,0 +1,94 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "containers/archive/compression.hpp"
+
+#include <string.h>
+#include <zlib.h>
+
+#include <limits>
+
+#include "containers/archive/varint.hpp"
+#include "perfmon/perfmon.hpp"
+
+/* zlib can't compress data by more than a factor of about 1032. A message that claims
+to be larger than that when it's decompressed is invalid. */
+static const uint64_t MAX_COMPRESSION_RATIO = 1100;
+
+/* The ratio of `pm_compression_bytes_out` to `pm_compression_bytes_in` is the
+compression ratio. */
+static perfmon_collection_t pm_compression_collection;
+static perfmon_rate_monitor_t pm_compression_bytes_in(secs_to_ticks(1)),
+    pm_compression_bytes_out(secs_to_ticks(1)),
+    pm_compression_bytes_decompressed(secs_to_ticks(1));
+static perfmon_multi_membership_t pm_compression_memberships(&pm_compression_collection,
+    &pm_compression_bytes_in, "bytes_in_per_sec",
+    &pm_compression_bytes_out, "bytes_out_per_sec",
+    &pm_compression_bytes_decompressed, "bytes_decompressed_per_sec");
+static perfmon_membership_t pm_compression_collection_membership(
+    &get_global_perfmon_collection(), &pm_compression_collection, "compression");
+
+void serialize_compressed(write_message_t *wm,
+                          compression_t compression,
+                          write_message_t *uncompressed) {
+    guarantee(compression != compression_t::NONE);
+
+    // zlib wants the input in one piece.
+    const size_t uncompressed_size = uncompressed->size();
+    std::vector<char> input(uncompressed_size);
+    size_t offset = 0;
+    intrusive_list_t<write_buffer_t> *buffers = uncompressed->unsafe_expose_buffers();
+    for (write_buffer_t *b = buffers->head(); b != nullptr; b = buffers->next(b)) {
+        memcpy(input.data() + offset, b->data, b->size);
+        offset += b->size;
+    }
+
+    uLongf compressed_size = compressBound(uncompressed_size);
+    std::vector<char> output(compressed_size);
+    int zres = compress2(
+        reinterpret_cast<Bytef *>(output.data()), &compressed_size,
+        reinterpret_cast<const Bytef *>(input.data()), uncompressed_size,
+        compression == compression_t::FAST ? Z_BEST_SPEED : Z_DEFAULT_COMPRESSION);
+    guarantee(zres == Z_OK, "zlib failed to compress a message (error %d)", zres);
+
+    serialize_varint_uint64(wm, uncompressed_size);
+    serialize_varint_uint64(wm, compressed_size);
+    wm->append(output.data(), compressed_size);
+
+    pm_compression_bytes_in.record(uncompressed_size);
+    pm_compression_bytes_out.record(compressed_size);
+}
+
+archive_result_t deserialize_compressed(read_stream_t *s,
+                                        std::vector<char> *uncompressed_out) {
+    uint64_t uncompressed_size;
+    archive_result_t res = deserialize_varint_uint64(s, &uncompressed_size);
+    if (bad(res)) { return res; }
+    uint64_t compressed_size;
+    res = deserialize_varint_uint64(s, &compressed_size);
+    if (bad(res)) { return res; }
+    if (compressed_size > std::numeric_limits<uLong>::max()
+        || uncompressed_size > std::numeric_limits<uLong>::max()
+        || uncompressed_size / MAX_COMPRESSION_RATIO > compressed_size) {
+        return archive_result_t::RANGE_ERROR;
+    }
+
+    std::vector<char> input(compressed_size);
+    int64_t num_read = force_read(s, input.data(), compressed_size);
+    if (num_read == -1) {
+        return archive_result_t::SOCK_ERROR;
+    }
+    if (static_cast<uint64_t>(num_read) < compressed_size) {
+        return archive_result_t::SOCK_EOF;
+    }
+
+    uncompressed_out->resize(uncompressed_size);
+    uLongf output_size = uncompressed_size;
+    int zres = uncompress(
+        reinterpret_cast<Bytef *>(uncompressed_out->data()), &output_size,
+        reinterpret_cast<const Bytef *>(input.data()), compressed_size);
+    if (zres != Z_OK || output_size != uncompressed_size) {
+        return archive_result_t::RANGE_ERROR;
+    }
+
+    pm_compression_bytes_decompressed.record(uncompressed_size);
+    return archive_result_t::SUCCESS;
+}
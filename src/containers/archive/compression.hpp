@@ -0,0 +1,78 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_ARCHIVE_COMPRESSION_HPP_
+#define CONTAINERS_ARCHIVE_COMPRESSION_HPP_
+
+#include <utility>
+#include <vector>
+
+#include "containers/archive/archive.hpp"
+#include "containers/archive/buffer_stream.hpp"
+#include "containers/archive/versioned.hpp"
+
+/* How much CPU time to spend on making data that's sent over the network smaller.
+`FAST` compresses about as fast as a single core can serialize, and `SMALL` takes a few
+times longer for somewhat better compression. */
+enum class compression_t { NONE, FAST, SMALL };
+
+ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(compression_t,
+                                      int8_t,
+                                      compression_t::NONE,
+                                      compression_t::SMALL);
+
+/* Compresses `*uncompressed` with zlib and writes the result to `wm`, along with the
+sizes that `deserialize_compressed()` needs to decompress it. `compression` must not be
+`NONE`. Both functions record how many bytes go in and out of them in the "compression"
+perfmon collection. */
+void serialize_compressed(write_message_t *wm,
+                          compression_t compression,
+                          write_message_t *uncompressed);
+MUST_USE archive_result_t deserialize_compressed(read_stream_t *s,
+                                                 std::vector<char> *uncompressed_out);
+
+/* `compressed_t<T>` is a `T` that gets compressed when it's serialized, unless
+`compression` is `NONE`. It's meant for the large messages that take up most of the
+bandwidth between servers, like the items of a backfill. Messages that are delivered
+without being serialized aren't compressed either. */
+template <class T>
+class compressed_t {
+public:
+    compressed_t() : compression(compression_t::NONE) { }
+    compressed_t(compression_t _compression, T &&_value) :
+        compression(_compression), value(std::move(_value)) { }
+
+    compression_t compression;
+    T value;
+};
+
+template <cluster_version_t W, class T>
+void serialize(write_message_t *wm, const compressed_t<T> &c) {
+    serialize<W>(wm, c.compression);
+    if (c.compression == compression_t::NONE) {
+        serialize<W>(wm, c.value);
+    } else {
+        write_message_t uncompressed;
+        serialize<W>(&uncompressed, c.value);
+        serialize_compressed(wm, c.compression, &uncompressed);
+    }
+}
+
+template <cluster_version_t W, class T>
+MUST_USE archive_result_t deserialize(read_stream_t *s, compressed_t<T> *c) {
+    archive_result_t res = deserialize<W>(s, &c->compression);
+    if (bad(res)) { return res; }
+    if (c->compression == compression_t::NONE) {
+        return deserialize<W>(s, &c->value);
+    }
+    std::vector<char> uncompressed;
+    res = deserialize_compressed(s, &uncompressed);
+    if (bad(res)) { return res; }
+    buffer_read_stream_t stream(uncompressed.data(), uncompressed.size());
+    res = deserialize<W>(&stream, &c->value);
+    if (bad(res)) { return res; }
+    if (stream.tell() != static_cast<int64_t>(uncompressed.size())) {
+        return archive_result_t::RANGE_ERROR;
+    }
+    return archive_result_t::SUCCESS;
+}
+
+#endif  // CONTAINERS_ARCHIVE_COMPRESSION_HPP_
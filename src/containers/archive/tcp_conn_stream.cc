@@ -56,6 +56,17 @@ int64_t tcp_conn_stream_t::write_buffered(const void *p, int64_t n) {
     }
 }
 
+int64_t tcp_conn_stream_t::write_buffered(write_message_t *msg) {
+    try {
+        cond_t non_closer;
+        const int64_t n = msg->size();
+        conn_->write_buffered(msg, &non_closer);
+        return n;
+    } catch (const tcp_conn_write_closed_exc_t &) {
+        return -1;
+    }
+}
+
 bool tcp_conn_stream_t::flush_buffer() {
     try {
         cond_t non_closer;
@@ -145,6 +156,14 @@ int64_t keepalive_tcp_conn_stream_t::write_buffered(const void *p, int64_t n) {
     return tcp_conn_stream_t::write_buffered(p, n);
 }
 
+int64_t keepalive_tcp_conn_stream_t::write_buffered(write_message_t *msg) {
+    if (keepalive_callback != nullptr) {
+        keepalive_callback->keepalive_write();
+    }
+
+    return tcp_conn_stream_t::write_buffered(msg);
+}
+
 bool keepalive_tcp_conn_stream_t::flush_buffer() {
     if (keepalive_callback != nullptr) {
         keepalive_callback->keepalive_write();
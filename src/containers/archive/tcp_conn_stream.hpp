@@ -24,6 +24,8 @@ public:
     virtual MUST_USE int64_t read(void *p, int64_t n);
     virtual MUST_USE int64_t write(const void *p, int64_t n);
     virtual MUST_USE int64_t write_buffered(const void *p, int64_t n);
+    // Sends the buffers of `msg`, mostly without copying them, and leaves it empty.
+    virtual MUST_USE int64_t write_buffered(write_message_t *msg);
     virtual bool flush_buffer();
 
     void rethread(threadnum_t new_thread);
@@ -76,6 +78,7 @@ public:
     virtual MUST_USE int64_t read(void *p, int64_t n);
     virtual MUST_USE int64_t write(const void *p, int64_t n);
     virtual MUST_USE int64_t write_buffered(const void *p, int64_t n);
+    virtual MUST_USE int64_t write_buffered(write_message_t *msg);
     virtual bool flush_buffer();
 
 private:
@@ -140,6 +140,13 @@ ql::datum_t artificial_table_t::read_nearest(
         error_message_index_not_found(sindex, table_name).c_str());
 }
 
+std::map<store_key_t, int64_t> artificial_table_t::read_sindex_distribution(
+        UNUSED ql::env_t *env,
+        UNUSED const std::string &sindex) {
+    /* Artificial tables don't have secondary indexes. */
+    return std::map<store_key_t, int64_t>();
+}
+
 ql::datum_t artificial_table_t::write_batched_replace(
         ql::env_t *env,
         const std::vector<ql::datum_t> &keys,
@@ -58,6 +58,9 @@ public:
         const ellipsoid_spec_t &geo_system,
         dist_unit_t dist_unit,
         const ql::configured_limits_t &limits);
+    std::map<store_key_t, int64_t> read_sindex_distribution(
+        ql::env_t *env,
+        const std::string &sindex);
 
     ql::datum_t write_batched_replace(
         ql::env_t *env,
@@ -2,8 +2,11 @@
 #include "rdb_protocol/btree.hpp"
 
 #include <algorithm>
+#include <deque>
 #include <functional>
 #include <iterator>
+#include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -11,7 +14,9 @@
 #include "errors.hpp"
 #include <boost/optional.hpp>
 
+#include "btree/bulk_load.hpp"
 #include "btree/concurrent_traversal.hpp"
+#include "btree/count_keys.hpp"
 #include "btree/get_distribution.hpp"
 #include "btree/operations.hpp"
 #include "btree/reql_specific.hpp"
@@ -27,6 +32,7 @@
 #include "rdb_protocol/geo/exceptions.hpp"
 #include "rdb_protocol/geo/indexing.hpp"
 #include "rdb_protocol/blob_wrapper.hpp"
+#include "rdb_protocol/filter_pushdown.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/geo_traversal.hpp"
 #include "rdb_protocol/lazy_btree_val.hpp"
@@ -151,9 +157,19 @@ kv_location_set(keyvalue_location_t *kv_location,
     const max_block_size_t block_size = kv_location->buf.cache()->max_block_size();
     {
         blob_t blob(block_size, new_value->value_ref(), blob::btree_maxreflen);
-        ql::serialization_result_t res
-            = datum_serialize_onto_blob(buf_parent_t(&kv_location->buf),
-                                        &blob, data);
+        ql::serialization_result_t res;
+        if (kv_location->value.has()) {
+            // The new value shares the blocks that didn't change with the old one.
+            // That's why the old value must be deleted with `delete_replaced_value`.
+            blob_t old_blob(block_size,
+                            kv_location->value_as<rdb_value_t>()->value_ref(),
+                            blob::btree_maxreflen);
+            res = datum_serialize_onto_blob_reusing_blocks(
+                buf_parent_t(&kv_location->buf), &blob, old_blob, data);
+        } else {
+            res = datum_serialize_onto_blob(buf_parent_t(&kv_location->buf),
+                                            &blob, data);
+        }
         if (bad(res)) return res;
     }
 
@@ -164,8 +180,9 @@ kv_location_set(keyvalue_location_t *kv_location,
     }
 
     if (kv_location->value.has()) {
-        deletion_context->in_tree_deleter()->delete_value(
-                buf_parent_t(&kv_location->buf), kv_location->value.get());
+        deletion_context->in_tree_deleter()->delete_replaced_value(
+                buf_parent_t(&kv_location->buf), kv_location->value.get(),
+                new_value.get());
         if (mod_info_out != NULL) {
             guarantee(mod_info_out->deleted.second.empty());
             mod_info_out->deleted.second.assign(
@@ -212,38 +229,43 @@ kv_location_set(keyvalue_location_t *kv_location,
     return ql::serialization_result_t::SUCCESS;
 }
 
-batched_replace_response_t rdb_replace_and_return_superblock(
-    const btree_loc_info_t &info,
+// Reports the serialization errors in `res` that are caused by the contents of
+// `data`, such as a too large array.
+void rcheck_serialization_result(ql::serialization_result_t res,
+                                 const ql::datum_t &data) {
+    if (res & ql::serialization_result_t::ARRAY_TOO_BIG) {
+        rfail_typed_target(&data, "Array too large for disk writes "
+                           "(limit 100,000 elements).");
+    } else if (res & ql::serialization_result_t::EXTREMA_PRESENT) {
+        rfail_typed_target(&data, "`r.minval` and `r.maxval` cannot be "
+                           "written to disk.");
+    }
+    r_sanity_check(!ql::bad(res));
+}
+
+// Replaces the row at `key`, which `kv_location` must point at.
+batched_replace_response_t rdb_replace_at_location(
+    const btree_info_t &info,
+    const store_key_t &key,
+    keyvalue_location_t *kv_location,
     const btree_point_replacer_t *replacer,
     const deletion_context_t *deletion_context,
-    promise_t<superblock_t *> *superblock_promise,
-    rdb_modification_info_t *mod_info_out,
-    profile::trace_t *trace) {
+    rdb_modification_info_t *mod_info_out) {
     const return_changes_t return_changes = replacer->should_return_changes();
-    const datum_string_t &primary_key = info.btree->primary_key;
-    const store_key_t &key = *info.key;
+    const datum_string_t &primary_key = info.primary_key;
 
     try {
-        keyvalue_location_t kv_location;
-        rdb_value_sizer_t sizer(info.superblock->cache()->max_block_size());
-        find_keyvalue_location_for_write(&sizer, info.superblock,
-                                         info.key->btree_key(),
-                                         info.btree->timestamp,
-                                         deletion_context->balancing_detacher(),
-                                         &kv_location,
-                                         trace,
-                                         superblock_promise);
-        info.btree->slice->stats.pm_keys_set.record();
-        info.btree->slice->stats.pm_total_keys_set += 1;
+        info.slice->stats.pm_keys_set.record();
+        info.slice->stats.pm_total_keys_set += 1;
 
         ql::datum_t old_val;
-        if (!kv_location.value.has()) {
+        if (!kv_location->value.has()) {
             // If there's no entry with this key, pass NULL to the function.
             old_val = ql::datum_t::null();
         } else {
             // Otherwise pass the entry with this key to the function.
-            old_val = get_data(kv_location.value_as<rdb_value_t>(),
-                               buf_parent_t(&kv_location.buf));
+            old_val = get_data(kv_location->value_as<rdb_value_t>(),
+                               buf_parent_t(&kv_location->buf));
             guarantee(old_val.get_field(primary_key, ql::NOTHROW).has());
         }
         guarantee(old_val.has());
@@ -267,23 +289,16 @@ batched_replace_response_t rdb_replace_and_return_superblock(
 
             /* Now that the change has passed validation, write it to disk */
             if (new_val.get_type() == ql::datum_t::R_NULL) {
-                kv_location_delete(&kv_location, *info.key, info.btree->timestamp,
+                kv_location_delete(kv_location, key, info.timestamp,
                                    deletion_context, delete_mode_t::REGULAR_QUERY,
                                    mod_info_out);
             } else {
                 r_sanity_check(new_val.get_field(primary_key, ql::NOTHROW).has());
                 ql::serialization_result_t res =
-                    kv_location_set(&kv_location, *info.key, new_val,
-                                    info.btree->timestamp, deletion_context,
+                    kv_location_set(kv_location, key, new_val,
+                                    info.timestamp, deletion_context,
                                     mod_info_out);
-                if (res & ql::serialization_result_t::ARRAY_TOO_BIG) {
-                    rfail_typed_target(&new_val, "Array too large for disk writes "
-                                       "(limit 100,000 elements).");
-                } else if (res & ql::serialization_result_t::EXTREMA_PRESENT) {
-                    rfail_typed_target(&new_val, "`r.minval` and `r.maxval` cannot be "
-                                       "written to disk.");
-                }
-                r_sanity_check(!ql::bad(res));
+                rcheck_serialization_result(res, new_val);
             }
 
             /* Report the changes for sindex and change-feed purposes */
@@ -335,41 +350,223 @@ private:
     const size_t index;
 };
 
-void do_a_replace_from_batched_replace(
+// Does the replaces of `keys[order[begin]]`, `keys[order[begin + 1]]` and so on, as
+// long as the keys belong in the leaf node of the first one or in one of its
+// siblings, and pulses `num_keys_promise` with the number of keys it takes.  The keys
+// in a leaf are modified under a single write acquisition of the leaf, instead of
+// each of them walking down the tree on its own.  Keys that it takes but can't get
+// to without walking down the tree again are added to `leftover_out` instead.
+void do_a_leaf_of_replaces_from_batched_replace(
     auto_drainer_t::lock_t,
     fifo_enforcer_sink_t *batched_replaces_fifo_sink,
     const fifo_enforcer_write_token_t &batched_replaces_fifo_token,
-    const btree_loc_info_t &info,
-    const one_replace_t one_replace,
+    const btree_info_t *info,
+    real_superblock_t *superblock,
+    const std::vector<store_key_t> *keys,
+    const std::vector<size_t> *order,
+    size_t begin,
+    const btree_batched_replacer_t *replacer,
     const ql::configured_limits_t &limits,
     promise_t<superblock_t *> *superblock_promise,
+    promise_t<size_t> *num_keys_promise,
     rdb_modification_report_cb_t *mod_cb,
     bool update_pkey_cfeeds,
     batched_replace_response_t *stats_out,
     profile::trace_t *trace,
-    std::set<std::string> *conditions) {
+    std::set<std::string> *conditions,
+    std::vector<size_t> *leftover_out) {
 
     fifo_enforcer_sink_t::exit_write_t exiter(
         batched_replaces_fifo_sink, batched_replaces_fifo_token);
     // We need to get in line for this while still holding the superblock so
     // that stamp read operations can't queue-skip.
-    info.superblock->get()->write_acq_signal()->wait_lazily_unordered();
-    rwlock_in_line_t stamp_spot = mod_cb->get_in_line_for_cfeed_stamp();
+    superblock->get()->write_acq_signal()->wait_lazily_unordered();
+    std::deque<rwlock_in_line_t> stamp_spots;
+    stamp_spots.push_back(mod_cb->get_in_line_for_cfeed_stamp());
 
     rdb_live_deletion_context_t deletion_context;
-    rdb_modification_report_t mod_report(*info.key);
-    ql::datum_t res = rdb_replace_and_return_superblock(
-        info, &one_replace, &deletion_context, superblock_promise, &mod_report.info,
-        trace);
-    *stats_out = (*stats_out).merge(res, ql::stats_merge, limits, conditions);
+    std::vector<rdb_modification_report_t> mod_reports;
+    {
+        keyvalue_location_t kv_location;
+        rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+        find_keyvalue_location_for_write(&sizer, superblock,
+                                         (*keys)[(*order)[begin]].btree_key(),
+                                         info->timestamp,
+                                         deletion_context.balancing_detacher(),
+                                         &kv_location,
+                                         trace,
+                                         superblock_promise);
+        auto do_replace = [&](size_t i) {
+            const size_t index = (*order)[i];
+            const one_replace_t one_replace(replacer, index);
+            mod_reports.push_back(rdb_modification_report_t((*keys)[index]));
+            ql::datum_t res = rdb_replace_at_location(
+                *info, (*keys)[index], &kv_location, &one_replace,
+                &deletion_context, &mod_reports.back().info);
+            *stats_out = (*stats_out).merge(res, ql::stats_merge, limits, conditions);
+        };
+        if (kv_location.superblock == nullptr) {
+            // The rest of the batch can go ahead as soon as it knows which keys are
+            // ours, so we work that out before computing any of the replacements.
+            size_t end = begin + count_keys_for_keyvalue_location(
+                &kv_location, order->size() - begin,
+                [&](size_t i) { return (*keys)[(*order)[begin + i]].btree_key(); });
+            // Writes to the same key have to stay in order, so they must not end up
+            // split between us and the next leaf if we leave some keys over.
+            while (end < order->size()
+                   && (*keys)[(*order)[end]] == (*keys)[(*order)[end - 1]]) {
+                ++end;
+            }
+            for (size_t i = begin + 1; i < end; ++i) {
+                stamp_spots.push_back(mod_cb->get_in_line_for_cfeed_stamp());
+            }
+            num_keys_promise->pulse(end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                if (i != begin
+                    && !move_keyvalue_location_for_write(
+                        &sizer, (*keys)[(*order)[i]].btree_key(), &kv_location)) {
+                    // A merge of underfull leaves can change the parent so that it
+                    // no longer tells us where the key goes.  We gave the superblock
+                    // away already, so the caller walks down the tree for the rest.
+                    for (; i < end; ++i) {
+                        leftover_out->push_back((*order)[i]);
+                    }
+                    break;
+                }
+                do_replace(i);
+            }
+        } else {
+            // We still hold the superblock, so the rest of the batch has to wait for
+            // us anyway and we can take keys for as long as they fit.
+            size_t end = begin;
+            do {
+                if (end != begin) {
+                    // The rest of the batch waits for `num_keys_promise`, so we're
+                    // still ahead of any stamp read operations.
+                    stamp_spots.push_back(mod_cb->get_in_line_for_cfeed_stamp());
+                }
+                do_replace(end);
+                ++end;
+            } while (end < order->size()
+                     && move_keyvalue_location_for_write(
+                         &sizer, (*keys)[(*order)[end]].btree_key(), &kv_location));
+            num_keys_promise->pulse(end - begin);
+        }
+    }
 
     // We wait to make sure we acquire `acq` in the same order we were
     // originally called.
     exiter.wait();
-    new_mutex_in_line_t sindex_spot = mod_cb->get_in_line_for_sindex();
+    for (size_t i = 0; i < mod_reports.size(); ++i) {
+        new_mutex_in_line_t sindex_spot = mod_cb->get_in_line_for_sindex();
+        mod_cb->on_mod_report(
+            mod_reports[i], update_pkey_cfeeds, &sindex_spot, &stamp_spots[i]);
+    }
+}
+
+// How full `rdb_bulk_load_batched_replace` makes the nodes, which leaves some room
+// for later writes before they have to be split.
+const double BULK_LOAD_FILL_FACTOR = 0.9;
+
+// Does a batched replace into an empty B-tree (where the old value of every row is
+// `null`) by building the tree bottom-up with a `btree_bulk_loader_t`, instead of
+// walking down the tree for every key.  `order` must sort `keys`, which must be
+// distinct.
+batched_replace_response_t rdb_bulk_load_batched_replace(
+    const btree_info_t &info,
+    scoped_ptr_t<real_superblock_t> *superblock,
+    const std::vector<store_key_t> &keys,
+    const std::vector<size_t> &order,
+    const btree_batched_replacer_t *replacer,
+    rdb_modification_report_cb_t *sindex_cb,
+    ql::configured_limits_t limits,
+    profile::sampler_t *sampler,
+    profile::trace_t *trace) {
+    const return_changes_t return_changes = replacer->should_return_changes();
+    const datum_string_t &primary_key = info.primary_key;
+
+    ql::datum_t stats = ql::datum_t::empty_object();
+    std::set<std::string> conditions;
+
+    sampler->new_sample();
+    PROFILE_STARTER_IF_ENABLED(
+        trace != nullptr,
+        "Bulk load into an empty B-tree.",
+        trace);
+
+    scoped_ptr_t<real_superblock_t> current_superblock(superblock->release());
+    const bool update_pkey_cfeeds = sindex_cb->has_pkey_cfeeds(keys);
+    // We need to get in line for these while still holding the superblock so
+    // that stamp read operations can't queue-skip.
+    current_superblock->get()->write_acq_signal()->wait_lazily_unordered();
+    std::deque<rwlock_in_line_t> stamp_spots;
+    std::vector<rdb_modification_report_t> mod_reports;
+    {
+        const max_block_size_t block_size =
+            current_superblock->cache()->max_block_size();
+        rdb_value_sizer_t sizer(block_size);
+        btree_bulk_loader_t loader(&sizer, current_superblock.get(), info.timestamp,
+                                   BULK_LOAD_FILL_FACTOR);
+        for (size_t index : order) {
+            const store_key_t &key = keys[index];
+            stamp_spots.push_back(sindex_cb->get_in_line_for_cfeed_stamp());
+            mod_reports.push_back(rdb_modification_report_t(key));
+            rdb_modification_info_t *mod_info = &mod_reports.back().info;
+            info.slice->stats.pm_keys_set.record();
+            info.slice->stats.pm_total_keys_set += 1;
+
+            const ql::datum_t old_val = ql::datum_t::null();
+            ql::datum_t new_val;
+            ql::datum_t res;
+            try {
+                new_val = replacer->replace(old_val, index);
+                rcheck_row_replacement(primary_key, key, old_val, new_val);
+                bool was_changed;
+                res = make_row_replacement_stats(
+                    primary_key, key, old_val, new_val, return_changes, &was_changed);
+                if (was_changed) {
+                    r_sanity_check(new_val.get_field(primary_key, ql::NOTHROW).has());
+                    write_message_t wm;
+                    ql::serialization_result_t ser_res = ql::datum_serialize(
+                        &wm, new_val, ql::check_datum_serialization_errors_t::YES);
+                    rcheck_serialization_result(ser_res, new_val);
+
+                    loader.add(key.btree_key(), [&](buf_parent_t leaf, void *out) {
+                        rdb_value_t *value = static_cast<rdb_value_t *>(out);
+                        memset(value, 0, blob::btree_maxreflen);
+                        blob_t blob(block_size, value->value_ref(),
+                                    blob::btree_maxreflen);
+                        write_onto_blob(leaf, &blob, wm);
+                        mod_info->added.second.assign(
+                            value->value_ref(),
+                            value->value_ref() + value->inline_size(block_size));
+                    });
+                    mod_info->added.first = new_val;
+                }
+            } catch (const ql::base_exc_t &e) {
+                res = make_row_replacement_error_stats(
+                    old_val, new_val, return_changes, e.what());
+            }
+            stats = stats.merge(res, ql::stats_merge, limits, &conditions);
+        }
+        loader.finish();
+    }
+    if (!update_pkey_cfeeds) {
+        current_superblock.reset();
+    }
 
-    mod_cb->on_mod_report(
-        mod_report, update_pkey_cfeeds, &sindex_spot, &stamp_spot);
+    for (size_t i = 0; i < mod_reports.size(); ++i) {
+        new_mutex_in_line_t sindex_spot = sindex_cb->get_in_line_for_sindex();
+        sindex_cb->on_mod_report(
+            mod_reports[i], update_pkey_cfeeds, &sindex_spot, &stamp_spots[i]);
+    }
+    if (update_pkey_cfeeds) {
+        sindex_cb->finish(info.slice, current_superblock.get());
+    }
+
+    ql::datum_object_builder_t out(stats);
+    out.add_warnings(conditions, limits);
+    return std::move(out).to_datum();
 }
 
 batched_replace_response_t rdb_batched_replace(
@@ -389,6 +586,38 @@ batched_replace_response_t rdb_batched_replace(
 
     std::set<std::string> conditions;
 
+    // We do the replaces in key order, so that the ones that go to the same leaf
+    // node can share a single walk down the tree.  As a result `first_error` in the
+    // response is the error of the first failing key in key order, rather than in
+    // the order the rows were given in.
+    std::vector<size_t> order(keys.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return keys[a] < keys[b];
+    });
+
+    // A batch that goes to an empty B-tree, like the first one of an import into a
+    // new table, builds the tree bottom-up.  That holds the superblock until the
+    // whole tree is built, so we only do it if the new rows are given up front
+    // instead of being computed by a function.
+    if ((*superblock)->get_root_block_id() == NULL_BLOCK_ID
+        && replacer->replaces_missing_rows_with_given_values()) {
+        bool keys_are_distinct = true;
+        for (size_t i = 1; i < order.size(); ++i) {
+            if (keys[order[i - 1]] == keys[order[i]]) {
+                keys_are_distinct = false;
+                break;
+            }
+        }
+        if (keys_are_distinct) {
+            return rdb_bulk_load_batched_replace(
+                info, superblock, keys, order, replacer, sindex_cb, limits, sampler,
+                trace);
+        }
+    }
+
     // We have to drain write operations before destructing everything above us,
     // because the coroutines being drained use them.
     {
@@ -415,32 +644,55 @@ batched_replace_response_t rdb_batched_replace(
         // write operations depending on the presence of limit changefeeds.
         scoped_ptr_t<real_superblock_t> current_superblock(superblock->release());
         bool update_pkey_cfeeds = sindex_cb->has_pkey_cfeeds(keys);
-        {
-            auto_drainer_t drainer;
-            for (size_t i = 0; i < keys.size(); ++i) {
-                promise_t<superblock_t *> superblock_promise;
-                coro_queue.push(
-                    std::bind(
-                        &do_a_replace_from_batched_replace,
-                        auto_drainer_t::lock_t(&drainer),
-                        &sink,
-                        source.enter_write(),
-                        btree_loc_info_t(&info, current_superblock.release(), &keys[i]),
-                        one_replace_t(replacer, i),
-                        limits,
-                        &superblock_promise,
-                        sindex_cb,
-                        update_pkey_cfeeds,
-                        &stats,
-                        trace,
-                        &conditions));
-                current_superblock.init(
-                    static_cast<real_superblock_t *>(superblock_promise.wait()));
-            }
-            if (!update_pkey_cfeeds) {
-                current_superblock.reset(); // Release the superblock early if
-                                            // we don't need to finish.
+        // A leaf's coroutine may leave some of the keys it took to a later round,
+        // which walks down the tree for them again.  That's rare, but it means we
+        // can only release the superblock once every coroutine is done.
+        std::vector<size_t> round_order = std::move(order);
+        while (!round_order.empty()) {
+            std::vector<size_t> leftover;
+            {
+                auto_drainer_t drainer;
+                size_t begin = 0;
+                while (begin < round_order.size()) {
+                    promise_t<superblock_t *> superblock_promise;
+                    promise_t<size_t> num_keys_promise;
+                    coro_queue.push(
+                        std::bind(
+                            &do_a_leaf_of_replaces_from_batched_replace,
+                            auto_drainer_t::lock_t(&drainer),
+                            &sink,
+                            source.enter_write(),
+                            &info,
+                            current_superblock.release(),
+                            &keys,
+                            &round_order,
+                            begin,
+                            replacer,
+                            limits,
+                            &superblock_promise,
+                            &num_keys_promise,
+                            sindex_cb,
+                            update_pkey_cfeeds,
+                            &stats,
+                            trace,
+                            &conditions,
+                            &leftover));
+                    current_superblock.init(
+                        static_cast<real_superblock_t *>(superblock_promise.wait()));
+                    begin += num_keys_promise.wait();
+                }
             }
+            // The coroutines finish in any order.  A coroutine that leaves keys
+            // over never shares a key with the next one, so sorting by index as
+            // well keeps writes to the same key in the order they were given in.
+            std::sort(leftover.begin(), leftover.end(), [&](size_t a, size_t b) {
+                return keys[a] < keys[b] || (keys[a] == keys[b] && a < b);
+            });
+            round_order = std::move(leftover);
+        }
+        if (!update_pkey_cfeeds) {
+            current_superblock.reset(); // Release the superblock early if
+                                        // we don't need to finish.
         }
         // This needs to happen after draining.
         if (update_pkey_cfeeds) {
@@ -486,14 +738,7 @@ void rdb_set(const store_key_t &key,
         ql::serialization_result_t res =
             kv_location_set(&kv_location, key, data, timestamp, deletion_context,
                             mod_info);
-        if (res & ql::serialization_result_t::ARRAY_TOO_BIG) {
-            rfail_typed_target(&data, "Array too large for disk writes "
-                               "(limit 100,000 elements).");
-        } else if (res & ql::serialization_result_t::EXTREMA_PRESENT) {
-            rfail_typed_target(&data, "`r.minval` and `r.maxval` cannot be "
-                               "written to disk.");
-        }
-        r_sanity_check(!ql::bad(res));
+        rcheck_serialization_result(res, data);
         guarantee(mod_info->deleted.second.empty() == !had_value &&
                   !mod_info->added.second.empty());
     }
@@ -538,10 +783,34 @@ void rdb_value_deleter_t::delete_value(buf_parent_t parent, const void *value) c
     actually_delete_rdb_value(parent, value_copy.get());
 }
 
+void rdb_value_deleter_t::delete_replaced_value(buf_parent_t parent,
+                                                const void *value,
+                                                const void *new_value) const {
+    rdb_value_sizer_t sizer(parent.cache()->max_block_size());
+    scoped_malloc_t<rdb_value_t> value_copy(sizer.max_possible_size());
+    memcpy(value_copy.get(), value, sizer.size(value));
+    blob_t blob(parent.cache()->max_block_size(),
+                value_copy->value_ref(),
+                blob::btree_maxreflen);
+    // `new_blob` is only read, so it doesn't need a copy.
+    blob_t new_blob(parent.cache()->max_block_size(),
+                    const_cast<rdb_value_t *>(
+                        static_cast<const rdb_value_t *>(new_value))->value_ref(),
+                    blob::btree_maxreflen);
+    blob.clear_unshared(parent, new_blob);
+}
+
 void rdb_value_detacher_t::delete_value(buf_parent_t parent, const void *value) const {
     detach_rdb_value(parent, value);
 }
 
+void rdb_value_detacher_t::delete_replaced_value(buf_parent_t parent,
+                                                 const void *value,
+                                                 const void *) const {
+    // Shared blocks never change, so they can be detached like the other ones.
+    detach_rdb_value(parent, value);
+}
+
 typedef ql::transform_variant_t transform_variant_t;
 typedef ql::terminal_variant_t terminal_variant_t;
 
@@ -588,7 +857,8 @@ public:
                region_t region,
                store_key_t last_key,
                sorting_t _sorting,
-               require_sindexes_t require_sindex_val)
+               require_sindexes_t require_sindex_val,
+               boost::optional<std::vector<datum_string_t> > _fields = boost::none)
         : env(_env),
           batcher(make_scoped<ql::batcher_t>(batchspec.to_batcher())),
           sorting(_sorting),
@@ -598,7 +868,10 @@ public:
                                         std::move(last_key),
                                         sorting,
                                         batcher.get(),
-                                        require_sindex_val)) {
+                                        require_sindex_val)),
+          reads_whole_range(_terminal
+                            && boost::get<ql::limit_read_t>(&*_terminal) == nullptr),
+          fields(std::move(_fields)) {
         for (size_t i = 0; i < _transforms.size(); ++i) {
             transformers.push_back(ql::make_op(_transforms[i]));
         }
@@ -616,6 +889,11 @@ private:
     std::vector<scoped_ptr_t<ql::op_t> > transformers;
     sorting_t sorting;
     scoped_ptr_t<ql::accumulator_t> accumulator;
+    // True if `accumulator` is a terminal like `count` or `reduce` that never stops
+    // the traversal early, so every row of the range gets transformed anyway.
+    const bool reads_whole_range;
+    // If set, the transformations only read these top-level fields of each row.
+    boost::optional<std::vector<datum_string_t> > fields;
 };
 
 class rget_io_data_t {
@@ -628,6 +906,10 @@ private:
     btree_slice_t *const slice;
 };
 
+// The most rows (and bytes of values) that `rget_cb_t` collects before it applies
+// the transformations to them.
+const size_t RGET_TRANSFORM_BATCH_ROWS = 64;
+const size_t RGET_TRANSFORM_BATCH_BYTES = 1024 * 1024;
 
 class rget_cb_t {
 public:
@@ -643,12 +925,34 @@ public:
         THROWS_ONLY(interrupted_exc_t);
     void finish(continue_bool_t last_cb) THROWS_ONLY(interrupted_exc_t);
 private:
+    // Applies the transformations to `data` and hands the result to the accumulator.
+    continue_bool_t transform_and_accumulate(
+        ql::groups_t *data,
+        const store_key_t &key,
+        const std::function<ql::datum_t()> &lazy_sindex_val);
+    // Applies the transformations to the rows in `batch`.
+    continue_bool_t flush_batch();
+
     const rget_io_data_t io; // How do get data in/out.
     job_data_t job; // What to do next (stateful).
     const boost::optional<rget_sindex_data_t> sindex; // Optional sindex information.
 
     scoped_ptr_t<ql::env_t> sindex_env;
 
+    // Unordered reads of the primary index that end in a terminal that reads the
+    // whole range collect rows in `batch` and apply the transformations to a whole
+    // batch at a time, so that `filter` and `map` can evaluate their functions on
+    // many rows at once.  Since every row gets transformed either way, this neither
+    // reads rows the query wouldn't have read nor raises errors it wouldn't have
+    // raised.  Reads that return a stream stop as soon as the batcher or a limit is
+    // satisfied, so they transform one row at a time.  All rows of a batch are
+    // accumulated with the key of its last row, which is fine because the keys of
+    // unordered rows are only used to remember the last considered key.
+    bool batch_rows;
+    ql::datums_t batch;
+    size_t batch_bytes;
+    store_key_t batch_last_key;
+
     // State for internal bookkeeping.
     bool bad_init;
     boost::optional<std::string> last_truncated_secondary_for_abort;
@@ -687,6 +991,11 @@ rget_cb_t::rget_cb_t(rget_io_data_t &&_io,
     : io(std::move(_io)),
       job(std::move(_job)),
       sindex(std::move(_sindex)),
+      batch_rows(!sindex
+                 && job.sorting == sorting_t::UNORDERED
+                 && job.reads_whole_range
+                 && !job.transformers.empty()),
+      batch_bytes(0),
       bad_init(false) {
 
     if (sindex) {
@@ -707,9 +1016,48 @@ rget_cb_t::rget_cb_t(rget_io_data_t &&_io,
 }
 
 void rget_cb_t::finish(continue_bool_t last_cb) THROWS_ONLY(interrupted_exc_t) {
+    // If the traversal didn't abort, the rows of the last batch still have to be
+    // processed.  Since they are the last rows of the range, `last_cb` stays
+    // `CONTINUE` even if the accumulator would want to stop after them.
+    if (last_cb == continue_bool_t::CONTINUE
+        && !batch.empty()
+        && boost::get<ql::exc_t>(&io.response->result) == NULL) {
+        try {
+            flush_batch();
+        } catch (const ql::exc_t &e) {
+            io.response->result = e;
+        } catch (const ql::datum_exc_t &e) {
+#ifndef NDEBUG
+            unreachable();
+#else
+            io.response->result = ql::exc_t(e, ql::backtrace_id_t::empty());
+#endif // NDEBUG
+        }
+    }
     job.accumulator->finish(last_cb, &io.response->result);
 }
 
+continue_bool_t rget_cb_t::transform_and_accumulate(
+        ql::groups_t *data,
+        const store_key_t &key,
+        const std::function<ql::datum_t()> &lazy_sindex_val) {
+    for (auto it = job.transformers.begin(); it != job.transformers.end(); ++it) {
+        (**it)(job.env, data, lazy_sindex_val);
+    }
+    // We need lots of extra data for the accumulation because we might be
+    // accumulating `rget_item_t`s for a batch.
+    return (*job.accumulator)(job.env, data, key, lazy_sindex_val);
+}
+
+continue_bool_t rget_cb_t::flush_batch() {
+    ql::groups_t data = {{ql::datum_t(), std::move(batch)}};
+    batch.clear();
+    batch_bytes = 0;
+    // Batches are only used without a secondary index.
+    return transform_and_accumulate(
+        &data, batch_last_key, []() { return ql::datum_t(); });
+}
+
 // Handle a keyvalue pair.  Returns whether or not we're done early.
 continue_bool_t rget_cb_t::handle_pair(
     scoped_key_value_t &&keyvalue,
@@ -731,14 +1079,19 @@ continue_bool_t rget_cb_t::handle_pair(
         return continue_bool_t::CONTINUE;
     }
     lazy_btree_val_t row(static_cast<const rdb_value_t *>(keyvalue.value()),
-                         keyvalue.expose_buf());
+                         keyvalue.expose_buf(),
+                         job.fields ? &*job.fields : nullptr);
     ql::datum_t val;
+    size_t val_bytes = 0;
     // Count stats whether or not we deserialize the value
     io.slice->stats.pm_keys_read.record();
     io.slice->stats.pm_total_keys_read += 1;
     // We only load the value if we actually use it (`count` does not).
     if (job.accumulator->uses_val() || job.transformers.size() != 0 || sindex) {
         val = row.get();
+        val_bytes = row.bytes_read();
+        io.slice->stats.pm_total_value_bytes_read += row.bytes_read();
+        io.slice->stats.pm_total_value_bytes_skipped += row.bytes_skipped();
     } else {
         row.reset();
     }
@@ -923,14 +1276,19 @@ continue_bool_t rget_cb_t::handle_pair(
             }
         }
 
-        ql::groups_t data = {{ql::datum_t(), ql::datums_t(copies, val)}};
-
-        for (auto it = job.transformers.begin(); it != job.transformers.end(); ++it) {
-            (**it)(job.env, &data, lazy_sindex_val);
+        if (batch_rows) {
+            batch.insert(batch.end(), copies, val);
+            batch_bytes += val_bytes;
+            batch_last_key = key;
+            if (batch.size() < RGET_TRANSFORM_BATCH_ROWS
+                && batch_bytes < RGET_TRANSFORM_BATCH_BYTES) {
+                return continue_bool_t::CONTINUE;
+            }
+            return flush_batch();
         }
-        // We need lots of extra data for the accumulation because we might be
-        // accumulating `rget_item_t`s for a batch.
-        continue_bool_t cont = (*job.accumulator)(job.env, &data, key, lazy_sindex_val);
+
+        ql::groups_t data = {{ql::datum_t(), ql::datums_t(copies, val)}};
+        continue_bool_t cont = transform_and_accumulate(&data, key, lazy_sindex_val);
         if (remember_key_for_sindex_batching) {
             if (cont == continue_bool_t::ABORT) {
                 last_truncated_secondary_for_abort =
@@ -953,6 +1311,39 @@ continue_bool_t rget_cb_t::handle_pair(
     }
 }
 
+// If the first transformation only reads some top-level fields of each row (as in
+// `table.pluck(...)`), returns them so that only those have to be loaded.
+boost::optional<std::vector<datum_string_t> > fields_read_by_transforms(
+        const std::vector<transform_variant_t> &transforms) {
+    if (transforms.empty()) {
+        return boost::none;
+    }
+    const ql::map_wire_func_t *map = boost::get<ql::map_wire_func_t>(&transforms[0]);
+    if (map == nullptr) {
+        return boost::none;
+    }
+    return ql::fields_read_by(map->compile_wire_func());
+}
+
+// Whether a range read just counts the rows in its range.  Those reads don't have to
+// go through `rget_cb_t`, because they only depend on the keys.
+bool is_plain_count(const std::vector<transform_variant_t> &transforms,
+                    const boost::optional<terminal_variant_t> &terminal) {
+    return transforms.empty()
+        && static_cast<bool>(terminal)
+        && boost::get<ql::count_wire_func_t>(&*terminal) != nullptr;
+}
+
+// The result that the `count` terminal would have produced for `count` rows.
+ql::grouped_t<uint64_t> make_count_result(uint64_t count) {
+    ql::grouped_t<uint64_t> res;
+    // `count_terminal_t` only starts a group once it has seen a row.
+    if (count != 0) {
+        res[ql::datum_t()] = count;
+    }
+    return res;
+}
+
 // TODO: Having two functions which are 99% the same sucks.
 void rdb_rget_slice(
         btree_slice_t *slice,
@@ -973,6 +1364,19 @@ void rdb_rget_slice(
         "Do range scan on primary index.",
         ql_env->trace);
 
+    if (!primary_keys && is_plain_count(transforms, terminal)) {
+        // The population in the stat block would be cheaper for the whole B-tree,
+        // but it's updated at the end of each write instead of in the snapshot we
+        // read, so it could be off by the writes that are still in progress.
+        const uint64_t count = btree_count_keys(
+            superblock, range, std::function<bool(const btree_key_t *)>(),
+            release_superblock, ql_env->interruptor);
+        slice->stats.pm_keys_read.record(count);
+        slice->stats.pm_total_keys_read += count;
+        response->result = make_count_result(count);
+        return;
+    }
+
     rget_cb_t callback(
         rget_io_data_t(response, slice),
         job_data_t(ql_env,
@@ -984,7 +1388,8 @@ void rdb_rget_slice(
                        ? range.left
                        : range.right.key_or_max(),
                    sorting,
-                   require_sindexes_t::NO),
+                   require_sindexes_t::NO,
+                   fields_read_by_transforms(transforms)),
         boost::none);
 
     direction_t direction = reversed(sorting) ? BACKWARD : FORWARD;
@@ -1026,6 +1431,71 @@ void rdb_rget_slice(
     callback.finish(cont);
 }
 
+/* Counts the secondary index entries of the rows in `pk_range` whose index value is in
+`datumspec`, if that can be done by looking only at the keys.  That is the case if
+`datumspec` is a single range whose bounds weren't truncated, because the index
+values of the keys at its boundaries can then be compared with it exactly (see
+`rget_cb_t::handle_pair()`).  Returns `boost::none` otherwise. */
+boost::optional<uint64_t> count_secondary_range(
+        btree_slice_t *slice,
+        const ql::datumspec_t &datumspec,
+        const key_range_t &sindex_region_range,
+        sindex_superblock_t *superblock,
+        ql::env_t *ql_env,
+        const key_range_t &pk_range,
+        reql_version_t sindex_func_reql_version,
+        release_superblock_t release_superblock) {
+    const ql::datum_range_t *range = nullptr;
+    datumspec.visit<void>(
+        [&](const ql::datum_range_t &r) { range = &r; },
+        [](const std::map<ql::datum_t, uint64_t> &) { });
+    if (range == nullptr) {
+        return boost::none;
+    }
+    const size_t max_trunc_size = ql::datum_t::max_trunc_size();
+    const std::string lbound_trunc_key =
+        range->get_left_bound_trunc_key(sindex_func_reql_version);
+    const std::string rbound_trunc_key =
+        range->get_right_bound_trunc_key(sindex_func_reql_version);
+    if (lbound_trunc_key.size() >= max_trunc_size
+        || rbound_trunc_key.size() >= max_trunc_size) {
+        return boost::none;
+    }
+
+    const bool check_pkey = !(pk_range == key_range_t::universe());
+    const bool left_open = range->left_bound_type == key_range_t::open;
+    const bool right_open = range->right_bound_type == key_range_t::open;
+    std::function<bool(const btree_key_t *)> key_filter;
+    if (check_pkey || left_open || right_open) {
+        key_filter = [&](const btree_key_t *key) {
+            const store_key_t store_key(key->size, key->contents);
+            if (check_pkey
+                && !pk_range.contains_key(ql::datum_t::extract_primary(store_key))) {
+                return false;
+            }
+            if (left_open || right_open) {
+                // Since the bounds weren't truncated, a key at an open bound has
+                // exactly the bound as its (untruncated) index value.
+                const std::string skey = ql::datum_t::extract_truncated_secondary(
+                    key_to_unescaped_str(store_key));
+                if ((left_open && skey == lbound_trunc_key)
+                    || (right_open && skey == rbound_trunc_key)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+    }
+
+    const key_range_t active_range = sindex_region_range.intersection(
+        range->to_sindex_keyrange(sindex_func_reql_version));
+    const uint64_t count = btree_count_keys(superblock, active_range, key_filter,
+                                            release_superblock, ql_env->interruptor);
+    slice->stats.pm_keys_read.record(count);
+    slice->stats.pm_total_keys_read += count;
+    return count;
+}
+
 void rdb_rget_secondary_slice(
         btree_slice_t *slice,
         const region_t &shard,
@@ -1052,6 +1522,16 @@ void rdb_rget_secondary_slice(
     const reql_version_t sindex_func_reql_version =
         sindex_info.mapping_version_info.latest_compatible_reql_version;
 
+    if (is_plain_count(transforms, terminal)) {
+        boost::optional<uint64_t> count = count_secondary_range(
+            slice, datumspec, sindex_region_range, superblock, ql_env, pk_range,
+            sindex_func_reql_version, release_superblock);
+        if (count) {
+            response->result = make_count_result(*count);
+            return;
+        }
+    }
+
     key_range_t active_region_range = sindex_region_range;
     rget_cb_t callback(
         rget_io_data_t(response, slice),
@@ -1200,27 +1680,42 @@ void rdb_get_nearest_slice(
     } while (state.proceed_to_next_batch() == continue_bool_t::CONTINUE);
 }
 
+// How many random walks estimate the size of the buckets below `max_depth`.  Each one
+// reads one node per level below it.
+const int DISTRIBUTION_RANDOM_WALKS = 128;
+
 void rdb_distribution_get(int max_depth,
                           const store_key_t &left_key,
-                          real_superblock_t *superblock,
+                          superblock_t *superblock,
                           distribution_read_response_t *response) {
-    int64_t key_count_out;
-    std::vector<store_key_t> key_splits;
-    get_btree_key_distribution(superblock, max_depth,
-                               &key_count_out, &key_splits);
-
-    int64_t keys_per_bucket;
-    if (key_splits.size() == 0) {
-        keys_per_bucket = key_count_out;
-    } else  {
-        keys_per_bucket = std::max<int64_t>(key_count_out / key_splits.size(), 1);
+    int64_t population;
+    std::vector<key_distribution_bucket_t> buckets;
+    get_btree_key_distribution(
+        superblock, max_depth, DISTRIBUTION_RANDOM_WALKS,
+        [](const void *value) {
+            return static_cast<const rdb_value_t *>(value)->value_size();
+        },
+        &population, &buckets);
+    if (buckets.empty()) {
+        response->key_counts[left_key] = 0;
+        response->key_bytes[left_key] = 0;
+        return;
     }
-    response->key_counts[left_key] = keys_per_bucket;
+    buckets[0].left_key = left_key;
 
-    for (std::vector<store_key_t>::iterator it  = key_splits.begin();
-                                            it != key_splits.end();
-                                            ++it) {
-        response->key_counts[*it] = keys_per_bucket;
+    // The walks only estimate the key counts, so if the stat block knows better we
+    // scale them to add up to the population.
+    double estimated_population = 0;
+    for (const auto &bucket : buckets) {
+        estimated_population += bucket.key_count;
+    }
+    const double count_scale = population >= 0 && estimated_population > 0
+        ? population / estimated_population
+        : 1;
+    for (const auto &bucket : buckets) {
+        response->key_counts[bucket.left_key] +=
+            llround(bucket.key_count * count_scale);
+        response->key_bytes[bucket.left_key] += llround(bucket.bytes);
     }
 }
 
@@ -1696,12 +2191,8 @@ void rdb_update_single_sindex(
     guarantee(cfeed_old_keys_out == nullptr || cfeed_old_keys_out->size() == 0);
     guarantee(cfeed_new_keys_out == nullptr || cfeed_new_keys_out->size() == 0);
 
-    sindex_disk_info_t sindex_info;
-    try {
-        deserialize_sindex_info_or_crash(sindex->sindex.opaque_definition, &sindex_info);
-    } catch (const archive_exc_t &e) {
-        crash("%s", e.what());
-    }
+    const std::shared_ptr<const sindex_disk_info_t> sindex_info =
+        store->get_sindex_info(sindex->sindex);
     // TODO(2015-01): Actually get real profiling information for
     // secondary index updates.
     profile::trace_t *const trace = nullptr;
@@ -1710,62 +2201,19 @@ void rdb_update_single_sindex(
 
     auto cserver = store->changefeed_server(modification->primary_key);
 
+    // We compute both the old and the new keys of the row before we modify the index,
+    // so that entries whose key doesn't change can be overwritten in place instead of
+    // being deleted first.
+    std::vector<std::pair<store_key_t, ql::datum_t> > old_keys;
     if (modification->info.deleted.first.has()) {
         guarantee(!modification->info.deleted.second.empty());
         try {
-            ql::datum_t deleted = modification->info.deleted.first;
-
-            std::vector<std::pair<store_key_t, ql::datum_t> > keys;
             compute_keys(
-                modification->primary_key, deleted, sindex_info,
-                &keys, cfeed_old_keys_out);
-            if (cserver.first != nullptr) {
-                cserver.first->foreach_limit(
-                    sindex->name.name,
-                    &modification->primary_key,
-                    [&](rwlock_in_line_t *clients_spot,
-                        rwlock_in_line_t *limit_clients_spot,
-                        rwlock_in_line_t *lm_spot,
-                        ql::changefeed::limit_manager_t *lm) {
-                        guarantee(clients_spot->read_signal()->is_pulsed());
-                        guarantee(limit_clients_spot->read_signal()->is_pulsed());
-                        for (const auto &pair : keys) {
-                            lm->del(lm_spot, pair.first, is_primary_t::NO);
-                        }
-                    }, cserver.second);
-            }
-            for (auto it = keys.begin(); it != keys.end(); ++it) {
-                promise_t<superblock_t *> return_superblock_local;
-                {
-                    keyvalue_location_t kv_location;
-                    rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
-
-                    find_keyvalue_location_for_write(
-                        &sizer,
-                        superblock,
-                        it->first.btree_key(),
-                        repli_timestamp_t::distant_past,
-                        deletion_context->balancing_detacher(),
-                        &kv_location,
-                        trace,
-                        &return_superblock_local);
-
-                    if (kv_location.value.has()) {
-                        kv_location_delete(
-                            &kv_location,
-                            it->first,
-                            repli_timestamp_t::distant_past,
-                            deletion_context,
-                            delete_mode_t::REGULAR_QUERY,
-                            nullptr);
-                    }
-                    // The keyvalue location gets destroyed here.
-                }
-                superblock =
-                    static_cast<sindex_superblock_t *>(return_superblock_local.wait());
-            }
+                modification->primary_key, modification->info.deleted.first,
+                *sindex_info, &old_keys, cfeed_old_keys_out);
         } catch (const ql::base_exc_t &) {
             // Do nothing (it wasn't actually in the index).
+            old_keys.clear();
 
             // See comment in `catch` below.
             guarantee(cfeed_old_keys_out == nullptr || cfeed_old_keys_out->size() == 0);
@@ -1777,91 +2225,133 @@ void rdb_update_single_sindex(
     // This is so we don't race against any sindex erase about who is faster
     // (we with inserting new entries, or the erase with removing them).
     const bool sindex_is_being_deleted = sindex->sindex.being_deleted;
+    std::vector<std::pair<store_key_t, ql::datum_t> > new_keys;
     if (!sindex_is_being_deleted && modification->info.added.first.has()) {
-        bool decremented_updates_left = false;
         try {
-            ql::datum_t added = modification->info.added.first;
+            compute_keys(
+                modification->primary_key, modification->info.added.first,
+                *sindex_info, &new_keys, cfeed_new_keys_out);
+        } catch (const ql::base_exc_t &) {
+            // Do nothing (we just drop the row from the index).
+            new_keys.clear();
 
-            std::vector<std::pair<store_key_t, ql::datum_t> > keys;
+            // If `compute_keys` had produced some keys for the changefeed before
+            // throwing, we might send a change with new values for this key even
+            // though we're actually dropping the row.  I *believe* that it always
+            // throws before producing any keys, so this guarantee should never trip.
+            guarantee(cfeed_new_keys_out == nullptr || cfeed_new_keys_out->size() == 0);
+        }
+    }
 
-            compute_keys(
-                modification->primary_key, added, sindex_info,
-                &keys, cfeed_new_keys_out);
-            if (keys_available_cond != nullptr) {
-                guarantee(*updates_left > 0);
-                decremented_updates_left = true;
-                if (--*updates_left == 0) {
-                    keys_available_cond->pulse();
-                }
-            }
-            if (cserver.first != nullptr) {
-                cserver.first->foreach_limit(
-                    sindex->name.name,
-                    &modification->primary_key,
-                    [&](rwlock_in_line_t *clients_spot,
-                        rwlock_in_line_t *limit_clients_spot,
-                        rwlock_in_line_t *lm_spot,
-                        ql::changefeed::limit_manager_t *lm) {
-                        guarantee(clients_spot->read_signal()->is_pulsed());
-                        guarantee(limit_clients_spot->read_signal()->is_pulsed());
-                        for (const auto &pair :keys) {
-                            lm->add(lm_spot, pair.first, is_primary_t::NO,
-                                    pair.second, added);
-                        }
-                    }, cserver.second);
+    if (keys_available_cond != nullptr) {
+        guarantee(*updates_left > 0);
+        if (--*updates_left == 0) {
+            keys_available_cond->pulse();
+        }
+    }
+
+    if (!old_keys.empty()) {
+        if (cserver.first != nullptr) {
+            cserver.first->foreach_limit(
+                sindex->name.name,
+                &modification->primary_key,
+                [&](rwlock_in_line_t *clients_spot,
+                    rwlock_in_line_t *limit_clients_spot,
+                    rwlock_in_line_t *lm_spot,
+                    ql::changefeed::limit_manager_t *lm) {
+                    guarantee(clients_spot->read_signal()->is_pulsed());
+                    guarantee(limit_clients_spot->read_signal()->is_pulsed());
+                    for (const auto &pair : old_keys) {
+                        lm->del(lm_spot, pair.first, is_primary_t::NO);
+                    }
+                }, cserver.second);
+        }
+
+        std::set<store_key_t> new_key_set;
+        for (const auto &pair : new_keys) {
+            new_key_set.insert(pair.first);
+        }
+        for (auto it = old_keys.begin(); it != old_keys.end(); ++it) {
+            if (new_key_set.count(it->first) != 0) {
+                // The entry gets overwritten with the new value below.
+                continue;
             }
-            for (auto it = keys.begin(); it != keys.end(); ++it) {
-                promise_t<superblock_t *> return_superblock_local;
-                {
-                    keyvalue_location_t kv_location;
-
-                    rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
-                    find_keyvalue_location_for_write(
-                        &sizer,
-                        superblock,
-                        it->first.btree_key(),
-                        repli_timestamp_t::distant_past,
-                        deletion_context->balancing_detacher(),
+            promise_t<superblock_t *> return_superblock_local;
+            {
+                keyvalue_location_t kv_location;
+                rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+
+                find_keyvalue_location_for_write(
+                    &sizer,
+                    superblock,
+                    it->first.btree_key(),
+                    repli_timestamp_t::distant_past,
+                    deletion_context->balancing_detacher(),
+                    &kv_location,
+                    trace,
+                    &return_superblock_local);
+
+                if (kv_location.value.has()) {
+                    kv_location_delete(
                         &kv_location,
-                        trace,
-                        &return_superblock_local);
-
-                    ql::serialization_result_t res =
-                        kv_location_set(&kv_location, it->first,
-                                        modification->info.added.second,
-                                        repli_timestamp_t::distant_past,
-                                        deletion_context);
-                    // this particular context cannot fail AT THE MOMENT.
-                    guarantee(!bad(res));
-                    // The keyvalue location gets destroyed here.
+                        it->first,
+                        repli_timestamp_t::distant_past,
+                        deletion_context,
+                        delete_mode_t::REGULAR_QUERY,
+                        nullptr);
                 }
-                superblock = static_cast<sindex_superblock_t *>(
-                    return_superblock_local.wait());
+                // The keyvalue location gets destroyed here.
             }
-        } catch (const ql::base_exc_t &) {
-            // Do nothing (we just drop the row from the index).
+            superblock =
+                static_cast<sindex_superblock_t *>(return_superblock_local.wait());
+        }
+    }
 
-            // If we've decremented `updates_left` already, that means we might
-            // have sent a change with new values for this key even though we're
-            // actually dropping the row.  I *believe* that this catch statement
-            // can only be triggered by an exception thrown from `compute_keys`
-            // (which begs the question of why so many other statements are
-            // inside of it), so this guarantee should never trip.
-            if (keys_available_cond != nullptr) {
-                guarantee(!decremented_updates_left);
-                guarantee(cfeed_new_keys_out->size() == 0);
-                guarantee(*updates_left > 0);
-                if (--*updates_left == 0) {
-                    keys_available_cond->pulse();
-                }
-            }
+    if (!new_keys.empty()) {
+        const ql::datum_t added = modification->info.added.first;
+        if (cserver.first != nullptr) {
+            cserver.first->foreach_limit(
+                sindex->name.name,
+                &modification->primary_key,
+                [&](rwlock_in_line_t *clients_spot,
+                    rwlock_in_line_t *limit_clients_spot,
+                    rwlock_in_line_t *lm_spot,
+                    ql::changefeed::limit_manager_t *lm) {
+                    guarantee(clients_spot->read_signal()->is_pulsed());
+                    guarantee(limit_clients_spot->read_signal()->is_pulsed());
+                    for (const auto &pair : new_keys) {
+                        lm->add(lm_spot, pair.first, is_primary_t::NO,
+                                pair.second, added);
+                    }
+                }, cserver.second);
         }
-    } else {
-        if (keys_available_cond != nullptr) {
-            guarantee(*updates_left > 0);
-            if (--*updates_left == 0) {
-                keys_available_cond->pulse();
+        for (auto it = new_keys.begin(); it != new_keys.end(); ++it) {
+            promise_t<superblock_t *> return_superblock_local;
+            {
+                keyvalue_location_t kv_location;
+
+                rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+                find_keyvalue_location_for_write(
+                    &sizer,
+                    superblock,
+                    it->first.btree_key(),
+                    repli_timestamp_t::distant_past,
+                    deletion_context->balancing_detacher(),
+                    &kv_location,
+                    trace,
+                    &return_superblock_local);
+
+                ql::serialization_result_t res =
+                    kv_location_set(&kv_location, it->first,
+                                    modification->info.added.second,
+                                    repli_timestamp_t::distant_past,
+                                    deletion_context);
+                // this particular context cannot fail AT THE MOMENT.
+                guarantee(!bad(res));
+                // The keyvalue location gets destroyed here.
             }
+            superblock = static_cast<sindex_superblock_t *>(
+                return_superblock_local.wait());
         }
     }
 
@@ -1876,7 +2366,7 @@ void rdb_update_single_sindex(
                 guarantee(clients_spot->read_signal()->is_pulsed());
                 guarantee(limit_clients_spot->read_signal()->is_pulsed());
                 lm->commit(lm_spot, ql::changefeed::sindex_ref_t{
-                        sindex->btree, superblock, &sindex_info});
+                        sindex->btree, superblock, sindex_info.get()});
             }, cserver.second);
     }
 }
@@ -1943,8 +2433,16 @@ void rdb_update_sindexes(
     /* All of the sindex have been updated now it's time to actually clear the
      * deleted blob if it exists. */
     if (modification->info.deleted.first.has()) {
-        deletion_context->post_deleter()->delete_value(buf_parent_t(txn),
-                modification->info.deleted.second.data());
+        if (modification->info.added.first.has()) {
+            // The new value can share blocks with the deleted one.
+            deletion_context->post_deleter()->delete_replaced_value(
+                buf_parent_t(txn),
+                modification->info.deleted.second.data(),
+                modification->info.added.second.data());
+        } else {
+            deletion_context->post_deleter()->delete_value(buf_parent_t(txn),
+                    modification->info.deleted.second.data());
+        }
     }
 }
 
@@ -1968,6 +2466,12 @@ public:
         // (this acquisition should never block)
         new_mutex_acq_t wtxn_acq(&wtxn_lock_);
         start_write_transaction(&wtxn_acq);
+
+        // The definitions of the indexes don't change while we construct them, so we
+        // only have to look them up once.
+        for (const auto &access : sindexes_) {
+            sindex_infos_[access->sindex.id] = store_->get_sindex_info(access->sindex);
+        }
     }
 
     continue_bool_t handle_pair(
@@ -1983,58 +2487,55 @@ public:
         store_->btree->stats.pm_keys_read.record();
         store_->btree->stats.pm_total_keys_read += 1;
 
-        // Grab the key and value and construct a modification report for the key/value
-        // pair.
+        // Grab the key and value, and compute the keys of the row in the secondary
+        // indexes.  We don't need `wtxn_lock_` for this, so the index functions get
+        // evaluated for the other rows of the traversal while one coroutine is
+        // writing to the indexes.
         const store_key_t primary_key(keyvalue.key());
         const rdb_value_t *rdb_value =
             static_cast<const rdb_value_t *>(keyvalue.value());
-        rdb_modification_report_t mod_report(primary_key);
         const max_block_size_t block_size =
             keyvalue.expose_buf().cache()->max_block_size();
-        mod_report.info.added
-            = std::make_pair(
-                get_data(rdb_value, buf_parent_t(keyvalue.expose_buf())),
-                std::vector<char>(rdb_value->value_ref(),
-                    rdb_value->value_ref() + rdb_value->inline_size(block_size)));
-
-        // Store the value into the secondary indexes
-        {
-            // We need this mutex because we don't want `wtxn` to be destructed,
-            // but also because only one coroutine can be traversing the indexes
-            // through `rdb_update_sindexes` at a time (or else the btree will get
-            // corrupted!).
-            new_mutex_acq_t wtxn_acq(&wtxn_lock_, interruptor_);
-            guarantee(wtxn_.has());
-            const rdb_post_construction_deletion_context_t deletion_context;
-            rdb_update_sindexes(store_,
-                                sindexes_,
-                                &mod_report,
-                                wtxn_.get(),
-                                &deletion_context,
-                                NULL,
-                                NULL,
-                                NULL);
+        const ql::datum_t doc =
+            get_data(rdb_value, buf_parent_t(keyvalue.expose_buf()));
+        std::vector<char> value_ref(
+            rdb_value->value_ref(),
+            rdb_value->value_ref() + rdb_value->inline_size(block_size));
+        std::vector<std::pair<uuid_u, store_key_t> > row_entries;
+        for (const auto &info : sindex_infos_) {
+            std::vector<std::pair<store_key_t, ql::datum_t> > keys;
+            try {
+                compute_keys(primary_key, doc, *info.second, &keys, nullptr);
+            } catch (const ql::base_exc_t &) {
+                // Do nothing (we just drop the row from the index, like
+                // `rdb_update_single_sindex` does).
+                continue;
+            }
+            for (auto &&pair : keys) {
+                row_entries.push_back(std::make_pair(info.first, std::move(pair.first)));
+            }
         }
 
-        // Account for the sindex writes in the stats
-        store_->btree->stats.pm_keys_set.record(sindexes_.size());
-        store_->btree->stats.pm_total_keys_set += sindexes_.size();
-
         // Update the traversed range boundary (everything below here will happen in
         // key order).
-        // This can't be interrupted, because we have already called rdb_update_sindexes,
-        // so now we /must/ update traversed_right_bound.
         waiter.wait();
         traversed_right_bound_ = primary_key;
 
-        // Release the write transaction and secondary index locks once we've reached the
-        // designated chunk size. Then acquire a new transaction once the previous one
-        // has been flushed.
+        // Add the entries to the current chunk. Once we've reached the designated
+        // chunk size, we write the chunk to the secondary indexes and release the
+        // write transaction and secondary index locks. Then acquire a new transaction
+        // once the previous one has been flushed.
         {
             new_mutex_acq_t wtxn_acq(&wtxn_lock_, interruptor_);
+            chunk_value_refs_.push_back(std::move(value_ref));
+            for (auto &&entry : row_entries) {
+                chunk_entries_[entry.first].push_back(
+                    std::make_pair(std::move(entry.second),
+                                   chunk_value_refs_.size() - 1));
+            }
             ++current_chunk_size_;
             if (current_chunk_size_ >= MAX_CHUNK_SIZE) {
-                current_chunk_size_ = 0;
+                write_chunk(&wtxn_acq);
                 sindexes_.clear();
                 wtxn_.reset();
                 start_write_transaction(&wtxn_acq);
@@ -2050,6 +2551,13 @@ public:
         }
     }
 
+    // Writes the entries of the last chunk to the secondary indexes. Must be called
+    // once the traversal is done, before `get_traversed_right_bound()` is used.
+    void finish() THROWS_ONLY(interrupted_exc_t) {
+        new_mutex_acq_t wtxn_acq(&wtxn_lock_, interruptor_);
+        write_chunk(&wtxn_acq);
+    }
+
     store_key_t get_traversed_right_bound() const {
         return traversed_right_bound_;
     }
@@ -2110,12 +2618,79 @@ private:
             // All indexes have been deleted. Interrupt the traversal.
             on_indexes_deleted_->pulse_if_not_already_pulsed();
         }
+    }
 
-        // We pretend that the indexes have been fully constructed, so that when we call
-        // `rdb_update_sindexes` above, it actually updates the range we're currently
-        // constructing. This is a bit hacky, but works.
-        for (auto &&access : sindexes_) {
-            access->sindex.needs_post_construction_range = key_range_t::empty();
+    // Inserts the entries of the current chunk into the secondary indexes. The
+    // entries of each index are sorted first, so that consecutive entries that go to
+    // the same leaf node can be inserted without walking down the tree again.
+    void write_chunk(new_mutex_acq_t *wtxn_acq) {
+        wtxn_acq->guarantee_is_holding(&wtxn_lock_);
+        guarantee(wtxn_.has());
+
+        const rdb_post_construction_deletion_context_t deletion_context;
+        for (const auto &access : sindexes_) {
+            auto entries_it = chunk_entries_.find(access->sindex.id);
+            if (entries_it != chunk_entries_.end()) {
+                std::vector<std::pair<store_key_t, size_t> > *entries =
+                    &entries_it->second;
+                std::sort(entries->begin(), entries->end(),
+                    [](const std::pair<store_key_t, size_t> &a,
+                       const std::pair<store_key_t, size_t> &b) {
+                        return a.first < b.first;
+                    });
+                insert_sorted_entries(access->superblock.get(), *entries,
+                                      &deletion_context);
+
+                // Account for the sindex writes in the stats
+                store_->btree->stats.pm_keys_set.record(entries->size());
+                store_->btree->stats.pm_total_keys_set += entries->size();
+            }
+            access->btree->stats.pm_rows_post_constructed.record(
+                chunk_value_refs_.size());
+            access->btree->stats.pm_total_rows_post_constructed +=
+                chunk_value_refs_.size();
+        }
+
+        chunk_entries_.clear();
+        chunk_value_refs_.clear();
+        current_chunk_size_ = 0;
+    }
+
+    void insert_sorted_entries(
+            sindex_superblock_t *superblock,
+            const std::vector<std::pair<store_key_t, size_t> > &entries,
+            const deletion_context_t *deletion_context) {
+        rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+        size_t i = 0;
+        while (i < entries.size()) {
+            promise_t<superblock_t *> return_superblock_local;
+            {
+                keyvalue_location_t kv_location;
+                find_keyvalue_location_for_write(
+                    &sizer,
+                    superblock,
+                    entries[i].first.btree_key(),
+                    repli_timestamp_t::distant_past,
+                    deletion_context->balancing_detacher(),
+                    &kv_location,
+                    nullptr,
+                    &return_superblock_local);
+                do {
+                    ql::serialization_result_t res =
+                        kv_location_set(&kv_location, entries[i].first,
+                                        chunk_value_refs_[entries[i].second],
+                                        repli_timestamp_t::distant_past,
+                                        deletion_context);
+                    // this particular context cannot fail AT THE MOMENT.
+                    guarantee(!bad(res));
+                    ++i;
+                } while (i < entries.size()
+                         && move_keyvalue_location_for_write(
+                             &sizer, entries[i].first.btree_key(), &kv_location));
+                // The keyvalue location gets destroyed here.
+            }
+            superblock = static_cast<sindex_superblock_t *>(
+                return_superblock_local.wait());
         }
     }
 
@@ -2131,6 +2706,8 @@ private:
     store_key_t traversed_right_bound_;
     bool stopped_before_completion_;
 
+    std::map<uuid_u, std::shared_ptr<const sindex_disk_info_t> > sindex_infos_;
+
     // We re-use a single write transaction and secondary index acquisition for a chunk
     // of writes to get better efficiency when flushing the index writes to disk.
     // We reset the transaction  after each chunk because large write transactions can
@@ -2142,7 +2719,11 @@ private:
     scoped_ptr_t<txn_t> wtxn_;
     store_t::sindex_access_vector_t sindexes_;
     int current_chunk_size_;
-    // Controls access to `sindexes_` and `wtxn_`.
+    // The value references of the rows of the current chunk, and for each index the
+    // keys of the current chunk with the index of their row in `chunk_value_refs_`.
+    std::vector<std::vector<char> > chunk_value_refs_;
+    std::map<uuid_u, std::vector<std::pair<store_key_t, size_t> > > chunk_entries_;
+    // Controls access to `sindexes_`, `wtxn_` and the current chunk.
     new_mutex_t wtxn_lock_;
 };
 
@@ -2201,6 +2782,7 @@ void post_construct_secondary_index_range(
         && (interruptor->is_pulsed() || on_index_deleted_interruptor.is_pulsed())) {
         throw interrupted_exc_t();
     }
+    traversal_cb.finish();
 
     // Update the left bound of the construction range
     if (!traversal_cb.stopped_before_completion()) {
@@ -2217,3 +2799,6 @@ void post_construct_secondary_index_range(
 }
 
 void noop_value_deleter_t::delete_value(buf_parent_t, const void *) const { }
+
+void noop_value_deleter_t::delete_replaced_value(
+        buf_parent_t, const void *, const void *) const { }
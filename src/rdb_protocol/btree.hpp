@@ -76,25 +76,14 @@ struct btree_info_t {
     const datum_string_t primary_key;
 };
 
-struct btree_loc_info_t {
-    btree_loc_info_t(const btree_info_t *_btree,
-                     real_superblock_t *_superblock,
-                     const store_key_t *_key)
-        : btree(_btree), superblock(_superblock), key(_key) {
-        guarantee(btree != NULL);
-        guarantee(superblock != NULL);
-        guarantee(key != NULL);
-    }
-    const btree_info_t *const btree;
-    real_superblock_t *const superblock;
-    const store_key_t *const key;
-};
-
 struct btree_batched_replacer_t {
     virtual ~btree_batched_replacer_t() { }
     virtual ql::datum_t replace(
         const ql::datum_t &d, size_t index) const = 0;
     virtual return_changes_t should_return_changes() const = 0;
+    // Whether `replace()` of a row that doesn't exist yet just returns a value that
+    // was given up front, without evaluating any ReQL.
+    virtual bool replaces_missing_rows_with_given_values() const { return false; }
 };
 struct btree_point_replacer_t {
     virtual ~btree_point_replacer_t() { }
@@ -103,6 +92,8 @@ struct btree_point_replacer_t {
     virtual return_changes_t should_return_changes() const = 0;
 };
 
+// The replaces are done in key order, so if several of them fail, `first_error` in
+// the response is the error of the smallest failing key.
 batched_replace_response_t rdb_batched_replace(
     const btree_info_t &info,
     scoped_ptr_t<real_superblock_t> *superblock,
@@ -190,9 +181,14 @@ void rdb_get_nearest_slice(
     const sindex_disk_info_t &sindex_info,
     nearest_geo_read_response_t *response);
 
+/* Estimates the number of keys and the number of bytes of each bucket; see
+`get_btree_key_distribution()`.  `superblock` may be either a primary or a sindex
+superblock.  For the primary B-tree, the key counts are scaled to add up to the
+population in its stat block.  Sindex B-trees don't maintain a population count, so
+theirs are left as estimated. */
 void rdb_distribution_get(int max_depth,
                           const store_key_t &left_key,
-                          real_superblock_t *superblock,
+                          superblock_t *superblock,
                           distribution_read_response_t *response);
 
 /* Secondary Indexes */
@@ -341,6 +337,8 @@ void post_construct_secondary_index_range(
 class rdb_value_deleter_t : public value_deleter_t {
 public:
     void delete_value(buf_parent_t parent, const void *_value) const;
+    void delete_replaced_value(buf_parent_t parent, const void *_value,
+                               const void *new_value) const;
 };
 
 /* A deleter that doesn't actually delete the values. Needed for secondary
@@ -348,6 +346,8 @@ public:
 class rdb_value_detacher_t : public value_deleter_t {
 public:
     void delete_value(buf_parent_t parent, const void *value) const;
+    void delete_replaced_value(buf_parent_t parent, const void *value,
+                               const void *new_value) const;
 };
 
 /* Used for operations on the live storage.
@@ -369,6 +369,7 @@ class noop_value_deleter_t : public value_deleter_t {
 public:
     noop_value_deleter_t() { }
     void delete_value(buf_parent_t, const void *) const;
+    void delete_replaced_value(buf_parent_t, const void *, const void *) const;
 };
 
 /* Used for operations on secondary indexes that aren't yet post-constructed.
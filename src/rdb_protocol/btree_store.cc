@@ -5,6 +5,7 @@
 
 #include "arch/runtime/coroutines.hpp"
 #include "btree/depth_first_traversal.hpp"
+#include "btree/detach_leaves.hpp"
 #include "btree/node.hpp"
 #include "btree/operations.hpp"
 #include "btree/reql_specific.hpp"
@@ -232,11 +233,15 @@ void store_t::reset_data(
     assert_thread();
     with_priority_t p(CORO_PRIORITY_RESET_DATA);
 
-    // Erase the data in small chunks
+    /* Erase the data in small chunks.  Each pass takes up to `max_leaves_per_pass`
+    whole leaf nodes out of the B-tree at the left end of what's left to erase, or, if
+    the leaf node there also holds keys outside of `subregion`, erases up to
+    `max_erased_per_pass` keys one by one.  Either way the erased part of the range
+    starts at `subregion.inner.left`, so the metainfo can be updated the same way. */
     always_true_key_tester_t key_tester;
     const uint64_t max_erased_per_pass = 100;
-    for (continue_bool_t done_erasing = continue_bool_t::CONTINUE;
-         done_erasing == continue_bool_t::CONTINUE;) {
+    key_range_t remaining = subregion.inner;
+    while (!remaining.is_empty()) {
         scoped_ptr_t<txn_t> txn;
         scoped_ptr_t<real_superblock_t> superblock;
 
@@ -254,31 +259,62 @@ void store_t::reset_data(
                                 superblock->get_sindex_block_id(),
                                 access_t::write);
 
+        /* If there are secondary indexes, we have to read every document in the
+        detached leaf nodes to erase it from them, so we detach fewer of them at a
+        time. */
+        std::map<sindex_name_t, secondary_index_t> secondary_indexes;
+        get_secondary_indexes(&sindex_block, &secondary_indexes);
+        const bool has_sindexes = !secondary_indexes.empty();
+        const size_t max_leaves_per_pass = has_sindexes ? 2 : 128;
+
         /* Note we don't allow interruption during this step; it's too easy to end up in
         an inconsistent state. */
         cond_t non_interruptor;
 
         rdb_live_deletion_context_t deletion_context;
         std::vector<rdb_modification_report_t> mod_reports;
+        std::vector<buf_lock_t> detached_leaves;
         key_range_t deleted_range;
-        done_erasing = rdb_erase_small_range(btree.get(),
-                                             &key_tester,
-                                             subregion.inner,
-                                             superblock.get(),
-                                             &deletion_context,
-                                             &non_interruptor,
-                                             max_erased_per_pass,
-                                             &mod_reports,
-                                             &deleted_range);
-
-        region_t deleted_region(subregion.beg, subregion.end, deleted_range);
+        rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+        const bool detached = btree_detach_leaves(&sizer,
+                                                  superblock.get(),
+                                                  remaining,
+                                                  max_leaves_per_pass,
+                                                  deletion_context.balancing_detacher(),
+                                                  &detached_leaves,
+                                                  &deleted_range);
+        if (!detached) {
+            rdb_erase_small_range(btree.get(),
+                                  &key_tester,
+                                  remaining,
+                                  superblock.get(),
+                                  &deletion_context,
+                                  &non_interruptor,
+                                  max_erased_per_pass,
+                                  &mod_reports,
+                                  &deleted_range);
+        }
+
+        key_range_t erased_so_far = subregion.inner;
+        erased_so_far.right = deleted_range.right;
+        region_t deleted_region(subregion.beg, subregion.end, erased_so_far);
         metainfo->update(superblock.get(),
                          region_map_t<binary_blob_t>(deleted_region, zero_metainfo));
 
+        const block_id_t stat_block_id = superblock->get_stat_block_id();
         superblock.reset();
+        rdb_erase_detached_leaves(&detached_leaves,
+                                  stat_block_id,
+                                  &deletion_context,
+                                  has_sindexes ? &mod_reports : nullptr);
         if (!mod_reports.empty()) {
             update_sindexes(txn.get(), &sindex_block, mod_reports, true);
         }
+
+        if (deleted_range.right.unbounded) {
+            break;
+        }
+        remaining.left = deleted_range.right.key();
     }
 }
 
@@ -584,6 +620,25 @@ double store_t::get_sindex_progress(uuid_u const &id) {
     }
 }
 
+std::shared_ptr<const sindex_disk_info_t> store_t::get_sindex_info(
+        const secondary_index_t &sindex) {
+    assert_thread();
+    auto it = sindex_info_cache.find(sindex.id);
+    if (it != sindex_info_cache.end()
+        && it->second.first == sindex.opaque_definition) {
+        return it->second.second;
+    }
+    auto info = std::make_shared<sindex_disk_info_t>();
+    try {
+        deserialize_sindex_info_or_crash(sindex.opaque_definition, info.get());
+    } catch (const archive_exc_t &e) {
+        crash("%s", e.what());
+    }
+    sindex_info_cache[sindex.id] = std::make_pair(
+        sindex.opaque_definition, std::shared_ptr<const sindex_disk_info_t>(info));
+    return info;
+}
+
 microtime_t store_t::get_sindex_start_time(uuid_u const &id) {
     auto iterator = sindex_context.find(id);
     if (iterator == sindex_context.end()) {
@@ -873,6 +928,7 @@ void store_t::drop_sindex(uuid_u sindex_id) THROWS_NOTHING {
     ::delete_secondary_index(&sindex_block, compute_sindex_deletion_name(sindex.id));
     size_t num_erased = secondary_index_slices.erase(sindex.id);
     guarantee(num_erased == 1);
+    sindex_info_cache.erase(sindex.id);
 }
 
 bool secondary_indexes_are_equivalent(const std::vector<char> &left,
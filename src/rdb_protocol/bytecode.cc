@@ -0,0 +1,470 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "rdb_protocol/bytecode.hpp"
+
+#include <algorithm>
+
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/error.hpp"
+#include "rdb_protocol/ql2.pb.h"
+#include "rdb_protocol/term_storage.hpp"
+#include "rdb_protocol/var_types.hpp"
+#include "utils.hpp"
+
+namespace ql {
+
+class bytecode_compiler_t {
+public:
+    typedef bytecode_program_t::operand_t operand_t;
+    typedef bytecode_program_t::opcode_t opcode_t;
+
+    bytecode_compiler_t(const std::vector<sym_t> &_arg_names,
+                        const term_t *_body,
+                        bytecode_program_t *_program)
+        : arg_names(_arg_names), body(_body), program(_program),
+          next_reg(_arg_names.size()), num_regs(_arg_names.size()) { }
+
+    // Appends code that computes the value of `term` and sets `*out` to the operand
+    // that holds it. That is a constant, an argument, or the first register that was
+    // free before, which stays in use until the caller frees it. Returns false if
+    // `term` can't be compiled.
+    bool compile(const raw_term_t &term, operand_t *out) {
+        switch (static_cast<int>(term.type())) {
+        case Term::DATUM:
+            *out = add_constant(term.datum());
+            return true;
+        case Term::VAR:
+            return compile_var(term, out);
+        case Term::IMPLICIT_VAR:
+            if (!function_emits_implicit_variable(arg_names)) {
+                return false;
+            }
+            *out = 0;
+            return true;
+        case Term::GET_FIELD: // fallthru
+        case Term::BRACKET:
+            return compile_get_field(term, out);
+        case Term::ADD: // fallthru
+        case Term::SUB: // fallthru
+        case Term::MUL: // fallthru
+        case Term::DIV:
+            return compile_op(term, opcode_t::ARITH, 1, out);
+        case Term::EQ: // fallthru
+        case Term::NE: // fallthru
+        case Term::LT: // fallthru
+        case Term::LE: // fallthru
+        case Term::GT: // fallthru
+        case Term::GE:
+            return compile_op(term, opcode_t::COMPARE, 2, out);
+        case Term::MERGE:
+            return compile_op(term, opcode_t::MERGE, 1, out);
+        case Term::NOT:
+            return compile_not(term, out);
+        case Term::AND:
+            return compile_and_or(term, opcode_t::JUMP_IF_FALSE, true, out);
+        case Term::OR:
+            return compile_and_or(term, opcode_t::JUMP_IF_TRUE, false, out);
+        case Term::DEFAULT:
+            return compile_default(term, out);
+        case Term::PLUCK:
+            return compile_pluck(term, out);
+        default:
+            return false;
+        }
+    }
+
+    size_t get_num_regs() const { return num_regs; }
+
+private:
+    bool compile_var(const raw_term_t &term, operand_t *out) {
+        if (term.num_args() != 1 || term.arg(0).type() != Term::DATUM) {
+            return false;
+        }
+        datum_t d = term.arg(0).datum();
+        if (d.get_type() != datum_t::R_NUM) {
+            return false;
+        }
+        sym_t var(d.as_int());
+        auto same_var = [&](sym_t other) { return other.value == var.value; };
+        size_t count = std::count_if(arg_names.begin(), arg_names.end(), same_var);
+        if (count > 1) {
+            return false;
+        } else if (count == 1) {
+            *out = std::find_if(arg_names.begin(), arg_names.end(), same_var)
+                - arg_names.begin();
+        } else {
+            *out = result_register(next_reg);
+            emit(opcode_t::LOAD_CAPTURED, *out, program->captured_vars.size());
+            program->captured_vars.push_back(var);
+        }
+        return true;
+    }
+
+    bool compile_get_field(const raw_term_t &term, operand_t *out) {
+        if (term.num_args() != 2 || term.num_optargs() != 0) {
+            return false;
+        }
+        raw_term_t field = term.arg(1);
+        if (field.type() != Term::DATUM) {
+            return false;
+        }
+        datum_t field_datum = field.datum();
+        const size_t base = next_reg;
+        operand_t object;
+        if (field_datum.get_type() != datum_t::R_STR
+            || !compile(term.arg(0), &object)) {
+            return false;
+        }
+        *out = result_register(base);
+        emit(opcode_t::GET_FIELD, *out, object, add_constant(field_datum));
+        return true;
+    }
+
+    bool compile_op(const raw_term_t &term,
+                    opcode_t op,
+                    size_t min_args,
+                    operand_t *out) {
+        size_t n = term.num_args();
+        if (n < min_args || term.num_optargs() != 0) {
+            return false;
+        }
+        const size_t base = next_reg;
+        std::vector<operand_t> args(n);
+        for (size_t i = 0; i < n; ++i) {
+            if (!compile(term.arg(i), &args[i])) {
+                return false;
+            }
+        }
+        const size_t first = program->operands.size();
+        program->operands.insert(program->operands.end(), args.begin(), args.end());
+        *out = result_register(base);
+        emit(op, *out, first, n, static_cast<int32_t>(term.type()));
+        return true;
+    }
+
+    bool compile_not(const raw_term_t &term, operand_t *out) {
+        const size_t base = next_reg;
+        operand_t arg;
+        if (term.num_args() != 1 || term.num_optargs() != 0
+            || !compile(term.arg(0), &arg)) {
+            return false;
+        }
+        *out = result_register(base);
+        emit(opcode_t::NOT, *out, arg);
+        return true;
+    }
+
+    // Compiles `term` so that its value ends up in the register `dst`, which must
+    // be the first free one.
+    bool compile_into(const raw_term_t &term, operand_t dst) {
+        operand_t arg;
+        if (!compile(term, &arg)) {
+            return false;
+        }
+        next_reg = dst + 1;
+        if (arg != dst) {
+            emit(opcode_t::MOVE, dst, arg);
+        }
+        return true;
+    }
+
+    bool compile_and_or(const raw_term_t &term,
+                        opcode_t jump,
+                        bool empty_value,
+                        operand_t *out) {
+        size_t n = term.num_args();
+        if (term.num_optargs() != 0) {
+            return false;
+        }
+        if (n == 0) {
+            *out = add_constant(datum_t::boolean(empty_value));
+            return true;
+        }
+        // Each argument overwrites the value of the previous one once the jump has
+        // decided to go on.
+        *out = next_reg;
+        std::vector<size_t> jumps;
+        for (size_t i = 0; i < n; ++i) {
+            next_reg = *out;
+            if (!compile_into(term.arg(i), *out)) {
+                return false;
+            }
+            if (i + 1 < n) {
+                jumps.push_back(program->code.size());
+                emit(jump, 0, *out);
+            }
+        }
+        for (size_t j : jumps) {
+            program->code[j].b = program->code.size();
+        }
+        return true;
+    }
+
+    bool compile_default(const raw_term_t &term, operand_t *out) {
+        if (term.num_args() != 2 || term.num_optargs() != 0) {
+            return false;
+        }
+        // A function as the default value is called with the error message, which
+        // the program doesn't keep.
+        *out = next_reg;
+        if (term.arg(1).type() == Term::FUNC || !compile_into(term.arg(0), *out)) {
+            return false;
+        }
+        size_t jump = program->code.size();
+        emit(opcode_t::JUMP_IF_DEFINED, 0, *out);
+        next_reg = *out;
+        if (!compile_into(term.arg(1), *out)) {
+            return false;
+        }
+        program->code[jump].b = program->code.size();
+        return true;
+    }
+
+    bool compile_pluck(const raw_term_t &term, operand_t *out) {
+        if (term.num_args() < 1 || term.num_optargs() != 0) {
+            return false;
+        }
+        std::vector<datum_t> paths;
+        for (size_t i = 1; i < term.num_args(); ++i) {
+            if (term.arg(i).type() != Term::DATUM) {
+                return false;
+            }
+            paths.push_back(term.arg(i).datum());
+        }
+        // Invalid paths are reported by the term tree.
+        try {
+            program->pathspecs.push_back(pathspec_t(
+                datum_t(std::move(paths), configured_limits_t::unlimited), body));
+        } catch (const base_exc_t &) {
+            return false;
+        }
+        const size_t base = next_reg;
+        operand_t object;
+        if (!compile(term.arg(0), &object)) {
+            return false;
+        }
+        *out = result_register(base);
+        emit(opcode_t::PLUCK, *out, object, program->pathspecs.size() - 1);
+        return true;
+    }
+
+    operand_t add_constant(datum_t d) {
+        program->constants.push_back(std::move(d));
+        return -static_cast<operand_t>(program->constants.size());
+    }
+
+    // Frees the registers from `base` on, which the operands of the instruction
+    // that is about to be emitted are in, and returns `base` for its result.
+    // Instructions read all of their operands before they write their result.
+    operand_t result_register(size_t base) {
+        next_reg = base + 1;
+        return base;
+    }
+
+    void emit(opcode_t op, int32_t dst, int32_t a, int32_t b = 0, int32_t c = 0) {
+        program->code.push_back(bytecode_program_t::instruction_t{op, dst, a, b, c});
+        num_regs = std::max(num_regs, next_reg);
+    }
+
+    const std::vector<sym_t> &arg_names;
+    const term_t *body;
+    bytecode_program_t *program;
+    size_t next_reg;
+    size_t num_regs;
+};
+
+counted_t<const bytecode_program_t> bytecode_program_t::compile(
+        const std::vector<sym_t> &arg_names,
+        const raw_term_t &src,
+        const term_t *body) {
+    counted_t<bytecode_program_t> program(new bytecode_program_t());
+    program->num_args = arg_names.size();
+    bytecode_compiler_t compiler(arg_names, body, program.get());
+    if (!compiler.compile(src, &program->result)
+        || compiler.get_num_regs() > max_registers) {
+        return counted_t<const bytecode_program_t>();
+    }
+    return program;
+}
+
+bool compare_datums(Term::TermType op, const datum_t &lhs, const datum_t &rhs) {
+    if (op == Term::EQ) {
+        return lhs == rhs;
+    } else if (op == Term::NE) {
+        return !(lhs == rhs);
+    } else if (op == Term::LT) {
+        return lhs.cmp(rhs) < 0;
+    } else if (op == Term::LE) {
+        return lhs.cmp(rhs) <= 0;
+    } else if (op == Term::GT) {
+        return lhs.cmp(rhs) > 0;
+    } else {
+        guarantee(op == Term::GE);
+        return lhs.cmp(rhs) >= 0;
+    }
+}
+
+bool is_plain_object(const datum_t &d) {
+    return d.get_type() == datum_t::R_OBJECT && !d.is_ptype();
+}
+
+namespace {
+
+// Returns an empty datum if the term tree has to handle this.
+datum_t arith(Term::TermType type, const datum_t &lhs, const datum_t &rhs) {
+    if (lhs.get_type() == datum_t::R_NUM && rhs.get_type() == datum_t::R_NUM) {
+        double res;
+        if (type == Term::ADD) {
+            res = lhs.as_num() + rhs.as_num();
+        } else if (type == Term::SUB) {
+            res = lhs.as_num() - rhs.as_num();
+        } else if (type == Term::MUL) {
+            res = lhs.as_num() * rhs.as_num();
+        } else {
+            guarantee(type == Term::DIV);
+            if (rhs.as_num() == 0) {
+                return datum_t();
+            }
+            res = lhs.as_num() / rhs.as_num();
+        }
+        return risfinite(res) ? datum_t(res) : datum_t();
+    } else if (type == Term::ADD
+               && lhs.get_type() == datum_t::R_STR
+               && rhs.get_type() == datum_t::R_STR) {
+        return datum_t(concat(lhs.as_str(), rhs.as_str()));
+    }
+    return datum_t();
+}
+
+}  // namespace
+
+/* An empty datum in a register stands for a `NON_EXISTENCE` error that the term tree
+would have thrown at that point, like a missing field. Each instruction propagates it
+exactly where the term tree would have propagated the error, so `default` can catch
+it. Everything else that could go wrong returns an empty datum from `run()`. */
+datum_t bytecode_program_t::run(env_t *env,
+                                const var_scope_t &captured_scope,
+                                const std::vector<datum_t> &args) const {
+    if (args.size() < num_args) {
+        return datum_t();
+    }
+    datum_t regs[max_registers];
+    std::copy(args.begin(), args.begin() + num_args, regs);
+    auto operand = [&](operand_t o) -> const datum_t & {
+        return o >= 0 ? regs[o] : constants[-1 - o];
+    };
+    try {
+        for (size_t pc = 0; pc < code.size(); ++pc) {
+            const instruction_t &ins = code[pc];
+            switch (ins.op) {
+            case opcode_t::MOVE:
+                regs[ins.dst] = operand(ins.a);
+                break;
+            case opcode_t::LOAD_CAPTURED:
+                regs[ins.dst] = captured_scope.lookup_var(captured_vars[ins.a]);
+                break;
+            case opcode_t::GET_FIELD: {
+                const datum_t &object = operand(ins.a);
+                if (!object.has()) {
+                    regs[ins.dst].reset();
+                } else if (!is_plain_object(object)) {
+                    return datum_t();
+                } else {
+                    regs[ins.dst] = object.get_field(operand(ins.b).as_str(), NOTHROW);
+                }
+            } break;
+            case opcode_t::ARITH: {
+                const operand_t *ops = &operands[ins.a];
+                Term::TermType type = static_cast<Term::TermType>(ins.c);
+                datum_t acc = operand(ops[0]);
+                for (int32_t i = 1; i < ins.b && acc.has(); ++i) {
+                    const datum_t &d = operand(ops[i]);
+                    if (!d.has()) {
+                        acc.reset();
+                        break;
+                    }
+                    acc = arith(type, acc, d);
+                    if (!acc.has()) {
+                        return datum_t();
+                    }
+                }
+                regs[ins.dst] = std::move(acc);
+            } break;
+            case opcode_t::COMPARE: {
+                const operand_t *ops = &operands[ins.a];
+                Term::TermType type = static_cast<Term::TermType>(ins.c);
+                datum_t res = operand(ops[0]).has()
+                    ? datum_t::boolean(type != Term::NE)
+                    : datum_t();
+                for (int32_t i = 1; i < ins.b && res.has(); ++i) {
+                    const datum_t &d = operand(ops[i]);
+                    if (!d.has()) {
+                        res.reset();
+                    } else if (!compare_datums(type == Term::NE ? Term::EQ : type,
+                                               operand(ops[i - 1]), d)) {
+                        res = datum_t::boolean(type == Term::NE);
+                        break;
+                    }
+                }
+                regs[ins.dst] = std::move(res);
+            } break;
+            case opcode_t::MERGE: {
+                const operand_t *ops = &operands[ins.a];
+                datum_t acc = operand(ops[0]);
+                if (acc.has() && !is_plain_object(acc)) {
+                    return datum_t();
+                }
+                for (int32_t i = 1; i < ins.b && acc.has(); ++i) {
+                    const datum_t &d = operand(ops[i]);
+                    if (!d.has()) {
+                        acc.reset();
+                    } else if (d.get_type() == datum_t::R_OBJECT && d.is_ptype()) {
+                        return datum_t();
+                    } else {
+                        acc = acc.merge(d);
+                    }
+                }
+                regs[ins.dst] = std::move(acc);
+            } break;
+            case opcode_t::PLUCK: {
+                const datum_t &object = operand(ins.a);
+                if (!object.has()) {
+                    regs[ins.dst].reset();
+                } else if (!is_plain_object(object)) {
+                    return datum_t();
+                } else {
+                    regs[ins.dst] = project(object, pathspecs[ins.b], DONT_RECURSE,
+                                            env->limits());
+                }
+            } break;
+            case opcode_t::NOT: {
+                const datum_t &d = operand(ins.a);
+                if (!d.has()) {
+                    regs[ins.dst].reset();
+                } else {
+                    regs[ins.dst] = datum_t::boolean(!d.as_bool());
+                }
+            } break;
+            case opcode_t::JUMP_IF_FALSE: // fallthru
+            case opcode_t::JUMP_IF_TRUE: {
+                const datum_t &d = operand(ins.a);
+                bool jump_if = ins.op == opcode_t::JUMP_IF_TRUE;
+                if (!d.has() || d.as_bool() == jump_if) {
+                    pc = ins.b - 1;
+                }
+            } break;
+            case opcode_t::JUMP_IF_DEFINED: {
+                const datum_t &d = operand(ins.a);
+                if (d.has() && d.get_type() != datum_t::R_NULL) {
+                    pc = ins.b - 1;
+                }
+            } break;
+            default: unreachable();
+            }
+        }
+    } catch (const base_exc_t &) {
+        return datum_t();
+    }
+    return operand(result);
+}
+
+}  // namespace ql
@@ -0,0 +1,123 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_BYTECODE_HPP_
+#define RDB_PROTOCOL_BYTECODE_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "containers/counted.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/pathspec.hpp"
+#include "rdb_protocol/ql2.pb.h"
+#include "rdb_protocol/sym.hpp"
+
+namespace ql {
+
+class env_t;
+class raw_term_t;
+class term_t;
+class var_scope_t;
+
+/* A `reql_func_t` body flattened into a small register machine program, so that
+calling the function doesn't have to walk the term tree, allocate a `val_t` per term
+and go through `args_t` for every argument.
+
+Only a pure, deterministic subset of ReQL is compiled: datum literals, variables, field
+access, arithmetic on numbers (and string concatenation), comparisons, `and`, `or`,
+`not`, `merge` and `pluck` on objects and `default`. `compile()` returns an empty
+pointer for anything else.
+
+Instructions read their operands straight from the arguments, the literals of the
+function and the registers that hold intermediate results, and write their result to
+a register. A predicate like `row('age') > 30` is just two instructions that don't
+copy the row or the literal anywhere.
+
+A program never reports errors itself. Whenever the tree evaluator would fail (or
+just on anything out of the ordinary, like a type that the program doesn't handle),
+`run()` returns an empty datum and the caller evaluates the term tree instead, which
+produces exactly the same result or error as before. */
+class bytecode_program_t : public slow_atomic_countable_t<bytecode_program_t> {
+public:
+    // `body` is the compiled term of the raw term `src`; it is only used as the
+    // creator of path specs and must outlive the program.
+    static counted_t<const bytecode_program_t> compile(
+        const std::vector<sym_t> &arg_names,
+        const raw_term_t &src,
+        const term_t *body);
+
+    // Returns an empty datum if the term tree has to be evaluated instead.
+    datum_t run(env_t *env,
+                const var_scope_t &captured_scope,
+                const std::vector<datum_t> &args) const;
+
+    size_t size() const { return code.size(); }
+
+private:
+    friend class bytecode_compiler_t;
+
+    // A non-negative operand is a register, a negative one is the constant
+    // `constants[-1 - operand]`. The arguments are in the first registers.
+    typedef int32_t operand_t;
+
+    enum class opcode_t : uint8_t {
+        // Sets `dst` to `a`.
+        MOVE,
+        // Sets `dst` to the captured variable `captured_vars[a]`.
+        LOAD_CAPTURED,
+        // Sets `dst` to the field `b` of the object `a`, or to an empty datum if there
+        // is no such field. Only `default` accepts empty datums.
+        GET_FIELD,
+        // Sets `dst` to the result of the `Term::TermType` `c` on the `b` operands
+        // starting at `operands[a]`.
+        ARITH,
+        COMPARE,
+        // Sets `dst` to the first of the `b` operands starting at `operands[a]`
+        // merged with the others.
+        MERGE,
+        // Sets `dst` to the projection of the object `a` on `pathspecs[b]`.
+        PLUCK,
+        NOT,
+        // Jump to `b` if `a` is falsy (`and`) or truthy (`or`).
+        JUMP_IF_FALSE,
+        JUMP_IF_TRUE,
+        // Jump to `b` if `a` is neither empty nor `null` (`default`).
+        JUMP_IF_DEFINED
+    };
+
+    struct instruction_t {
+        opcode_t op;
+        int32_t dst;
+        int32_t a;
+        int32_t b;
+        int32_t c;
+    };
+
+    // A program never uses more registers than this, arguments included.
+    static const size_t max_registers = 32;
+
+    bytecode_program_t() { }
+
+    std::vector<instruction_t> code;
+    std::vector<operand_t> operands;
+    std::vector<datum_t> constants;
+    std::vector<sym_t> captured_vars;
+    std::vector<pathspec_t> pathspecs;
+    size_t num_args;
+    // The operand that holds the value of the function after the last instruction.
+    operand_t result;
+
+    DISABLE_COPYING(bytecode_program_t);
+};
+
+// Whether `lhs op rhs` holds, where `op` is one of `EQ`, `NE`, `LT`, `LE`, `GT` and
+// `GE`.
+bool compare_datums(Term::TermType op, const datum_t &lhs, const datum_t &rhs);
+
+// Whether `d` is an object that isn't a pseudo-type. Field access on anything else
+// fails (or acts on the pseudo-type).
+bool is_plain_object(const datum_t &d);
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_BYTECODE_HPP_
@@ -40,6 +40,74 @@ void sindex_status_t::accum(const sindex_status_t &other) {
 RDB_IMPL_SERIALIZABLE_5_FOR_CLUSTER(sindex_status_t,
     progress_numerator, progress_denominator, ready, outdated, start_time);
 
+#define SINDEX_PLANNING_CACHE_EXPIRATION_MS (5 * 1000)
+
+sindex_planning_cache_t::entry_t *sindex_planning_cache_t::get_fresh_entry(
+        const namespace_id_t &table_id) {
+    std::map<namespace_id_t, entry_t> *thread_entries = entries.get();
+    auto it = thread_entries->find(table_id);
+    if (it == thread_entries->end()) {
+        return nullptr;
+    }
+    if (it->second.expiration_time <= current_microtime()) {
+        thread_entries->erase(it);
+        return nullptr;
+    }
+    return &it->second;
+}
+
+bool sindex_planning_cache_t::get_sindexes(
+        const namespace_id_t &table_id, sindexes_t *sindexes_out) {
+    entry_t *entry = get_fresh_entry(table_id);
+    if (entry == nullptr) {
+        return false;
+    }
+    *sindexes_out = entry->sindexes;
+    return true;
+}
+
+bool sindex_planning_cache_t::get_distribution(
+        const namespace_id_t &table_id,
+        const std::string &sindex,
+        std::map<store_key_t, int64_t> *distribution_out) {
+    entry_t *entry = get_fresh_entry(table_id);
+    if (entry == nullptr) {
+        return false;
+    }
+    auto it = entry->distributions.find(sindex);
+    if (it == entry->distributions.end()) {
+        return false;
+    }
+    *distribution_out = it->second;
+    return true;
+}
+
+void sindex_planning_cache_t::set_sindexes(
+        const namespace_id_t &table_id, const sindexes_t &sindexes) {
+    entry_t *entry = &(*entries.get())[table_id];
+    entry->expiration_time =
+        current_microtime() + SINDEX_PLANNING_CACHE_EXPIRATION_MS * 1000;
+    entry->sindexes = sindexes;
+    entry->distributions.clear();
+}
+
+void sindex_planning_cache_t::set_distribution(
+        const namespace_id_t &table_id,
+        const std::string &sindex,
+        const std::map<store_key_t, int64_t> &distribution) {
+    entry_t *entry = get_fresh_entry(table_id);
+    if (entry != nullptr) {
+        entry->distributions[sindex] = distribution;
+    }
+}
+
+void sindex_planning_cache_t::invalidate(const namespace_id_t &table_id) {
+    pmap(get_num_threads(), [&](int thread) {
+        on_thread_t thread_switcher((threadnum_t(thread)));
+        entries.get()->erase(table_id);
+    });
+}
+
 const char *rql_perfmon_name = "query_engine";
 
 rdb_context_t::stats_t::stats_t(perfmon_collection_t *global_stats)
@@ -101,6 +101,44 @@ public:
 };
 RDB_DECLARE_SERIALIZABLE(sindex_status_t);
 
+/* `sindex_planning_cache_t` remembers the secondary indexes of tables, and samples of
+their key distributions, for `SINDEX_PLANNING_CACHE_EXPIRATION_MS`. Query planning
+(see `ql::push_down_filter()`) uses it so that it doesn't have to contact the other
+servers for every query. Changes made through this server are seen right away. Indexes
+changed through another server are caught by comparing the cached definitions with the
+table's config before they are used, and an index that isn't ready yet makes the read
+fall back to the whole table. Every thread has its own entries. */
+class sindex_planning_cache_t {
+public:
+    typedef std::map<std::string, std::pair<sindex_config_t, sindex_status_t> >
+        sindexes_t;
+
+    /* These return false if there is no fresh entry. */
+    bool get_sindexes(const namespace_id_t &table_id, sindexes_t *sindexes_out);
+    bool get_distribution(const namespace_id_t &table_id,
+                          const std::string &sindex,
+                          std::map<store_key_t, int64_t> *distribution_out);
+
+    void set_sindexes(const namespace_id_t &table_id, const sindexes_t &sindexes);
+    /* Only has an effect if there is a fresh entry for the table's indexes. */
+    void set_distribution(const namespace_id_t &table_id,
+                          const std::string &sindex,
+                          const std::map<store_key_t, int64_t> &distribution);
+
+    /* Forgets the table on every thread. */
+    void invalidate(const namespace_id_t &table_id);
+
+private:
+    struct entry_t {
+        microtime_t expiration_time;
+        sindexes_t sindexes;
+        std::map<std::string, std::map<store_key_t, int64_t> > distributions;
+    };
+    entry_t *get_fresh_entry(const namespace_id_t &table_id);
+
+    one_per_thread_t<std::map<namespace_id_t, entry_t> > entries;
+};
+
 namespace ql {
 class configured_limits_t;
 class env_t;
@@ -155,6 +193,10 @@ public:
         r_sanity_fail();
     }
 
+    /* Limits how far behind the primary replica the replicas that serve this table's
+    `read_mode_t::OUTDATED` reads may lag. Tables that don't have replicas ignore it. */
+    virtual void set_max_staleness_ms(uint64_t) { }
+
     virtual ql::datum_t read_row(ql::env_t *env,
         ql::datum_t pval, read_mode_t read_mode) = 0;
     virtual counted_t<ql::datum_stream_t> read_all(
@@ -188,6 +230,14 @@ public:
         dist_unit_t dist_unit,
         const ql::configured_limits_t &limits) = 0;
 
+    /* Returns a sample of the key distribution of the secondary index `sindex`, in
+    the format of `distribution_read_response_t::key_counts`. This is used for
+    choosing between indexes during query planning, so it's fine for it to return an
+    empty map if no estimate is available. */
+    virtual std::map<store_key_t, int64_t> read_sindex_distribution(
+        ql::env_t *env,
+        const std::string &sindex) = 0;
+
     virtual ql::datum_t write_batched_replace(
         ql::env_t *env,
         const std::vector<ql::datum_t> &keys,
@@ -410,6 +460,14 @@ public:
             admin_err_t *error_out,
             std::map<std::string, std::pair<sindex_config_t, sindex_status_t> >
                 *configs_and_statuses_out) = 0;
+    /* `sindex_configs()` only returns the definitions of the table's secondary
+    indexes. Unlike `sindex_list()`, it doesn't have to ask every server. */
+    virtual bool sindex_configs(
+            counted_t<const ql::db_t> db,
+            const name_string_t &table,
+            signal_t *interruptor,
+            admin_err_t *error_out,
+            std::map<std::string, sindex_config_t> *configs_out) = 0;
 
 protected:
     virtual ~reql_cluster_interface_t() { }   // silence compiler warnings
@@ -468,6 +526,8 @@ public:
 
     clone_ptr_t<watchable_t<auth_semilattice_metadata_t>> get_auth_watchable() const;
 
+    sindex_planning_cache_t sindex_planning_cache;
+
 private:
     void init_auth_watchables(
         boost::shared_ptr<semilattice_read_view_t<auth_semilattice_metadata_t>>
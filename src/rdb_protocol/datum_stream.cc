@@ -1537,6 +1537,119 @@ bool lazy_datum_stream_t::is_infinite() const {
     return false;
 }
 
+// INDEX_FALLBACK_DATUM_STREAM_T
+
+/* Passes everything on to `inner` and remembers whether it got anything, so that we
+know if it's too late to switch to another stream. */
+class produce_tracking_acc_t : public eager_acc_t {
+public:
+    explicit produce_tracking_acc_t(eager_acc_t *_inner)
+        : inner(_inner), produced(false) { }
+    void operator()(env_t *env, groups_t *groups) {
+        produced = true;
+        (*inner)(env, groups);
+    }
+    void add_res(env_t *env, result_t *res, sorting_t sorting) {
+        produced = true;
+        inner->add_res(env, res, sorting);
+    }
+    scoped_ptr_t<val_t> finish_eager(
+        backtrace_id_t bt, bool is_grouped, const ql::configured_limits_t &limits) {
+        return inner->finish_eager(bt, is_grouped, limits);
+    }
+    bool has_produced() const { return produced; }
+private:
+    eager_acc_t *inner;
+    bool produced;
+};
+
+index_fallback_datum_stream_t::index_fallback_datum_stream_t(
+        counted_t<datum_stream_t> _indexed,
+        counted_t<datum_stream_t> _fallback,
+        backtrace_id_t _bt)
+    : datum_stream_t(_bt),
+      indexed(std::move(_indexed)),
+      fallback(std::move(_fallback)),
+      indexed_produced(false),
+      using_fallback(false) { }
+
+bool index_fallback_datum_stream_t::fall_back(
+        const base_exc_t &e, bool produced) {
+    // The shards report a missing or unfinished index as `OP_FAILED`. Any other
+    // error would have happened on the whole table too.
+    if (produced || e.get_type() != base_exc_t::OP_FAILED) {
+        return false;
+    }
+    using_fallback = true;
+    return true;
+}
+
+void index_fallback_datum_stream_t::add_transformation(transform_variant_t &&tv,
+                                                       backtrace_id_t _bt) {
+    indexed->add_transformation(transform_variant_t(tv), _bt);
+    fallback->add_transformation(std::move(tv), _bt);
+    update_bt(_bt);
+}
+
+void index_fallback_datum_stream_t::accumulate(
+    env_t *env, eager_acc_t *acc, const terminal_variant_t &tv) {
+    if (!using_fallback) {
+        produce_tracking_acc_t tracking_acc(acc);
+        try {
+            indexed->accumulate(env, &tracking_acc, tv);
+            return;
+        } catch (const base_exc_t &e) {
+            if (!fall_back(e, indexed_produced || tracking_acc.has_produced())) {
+                throw;
+            }
+        }
+    }
+    fallback->accumulate(env, acc, tv);
+}
+
+void index_fallback_datum_stream_t::accumulate_all(env_t *env, eager_acc_t *acc) {
+    if (!using_fallback) {
+        produce_tracking_acc_t tracking_acc(acc);
+        try {
+            indexed->accumulate_all(env, &tracking_acc);
+            return;
+        } catch (const base_exc_t &e) {
+            if (!fall_back(e, indexed_produced || tracking_acc.has_produced())) {
+                throw;
+            }
+        }
+    }
+    fallback->accumulate_all(env, acc);
+}
+
+std::vector<datum_t>
+index_fallback_datum_stream_t::next_batch_impl(
+        env_t *env, const batchspec_t &batchspec) {
+    if (!using_fallback) {
+        try {
+            std::vector<datum_t> batch = indexed->next_batch(env, batchspec);
+            indexed_produced = true;
+            return batch;
+        } catch (const base_exc_t &e) {
+            if (!fall_back(e, indexed_produced)) {
+                throw;
+            }
+        }
+    }
+    return fallback->next_batch(env, batchspec);
+}
+
+bool index_fallback_datum_stream_t::is_exhausted() const {
+    return (using_fallback ? fallback : indexed)->is_exhausted()
+        && batch_cache_exhausted();
+}
+feed_type_t index_fallback_datum_stream_t::cfeed_type() const {
+    return feed_type_t::not_feed;
+}
+bool index_fallback_datum_stream_t::is_infinite() const {
+    return false;
+}
+
 array_datum_stream_t::array_datum_stream_t(datum_t _arr,
                                            backtrace_id_t _bt)
     : eager_datum_stream_t(_bt), index(0), arr(_arr) { }
@@ -983,6 +983,48 @@ private:
     scoped_ptr_t<reader_t> reader;
 };
 
+/* Reads from `indexed`, a read of a secondary index range that `push_down_filter()`
+picked instead of a read of the whole table, and switches to `fallback` if `indexed`
+fails before it returned anything. That happens if the index was dropped or isn't
+ready yet by the time the read reaches the shards. Transformations are added to both
+streams. */
+class index_fallback_datum_stream_t : public datum_stream_t {
+public:
+    index_fallback_datum_stream_t(counted_t<datum_stream_t> _indexed,
+                                  counted_t<datum_stream_t> _fallback,
+                                  backtrace_id_t bt);
+
+    virtual bool is_array() const { return false; }
+    virtual datum_t as_array(UNUSED env_t *env) {
+        return datum_t();  // Cannot be converted implicitly.
+    }
+
+    bool is_exhausted() const;
+    virtual feed_type_t cfeed_type() const;
+    virtual bool is_infinite() const;
+
+private:
+    // Changefeeds are always on `fallback`, since they can't use a range of an index.
+    virtual std::vector<changespec_t> get_changespecs() {
+        return fallback->get_changespecs();
+    }
+
+    std::vector<datum_t>
+    next_batch_impl(env_t *env, const batchspec_t &batchspec);
+
+    virtual void add_transformation(transform_variant_t &&tv,
+                                    backtrace_id_t bt);
+    virtual void accumulate(env_t *env, eager_acc_t *acc, const terminal_variant_t &tv);
+    virtual void accumulate_all(env_t *env, eager_acc_t *acc);
+
+    /* Decides what to do with an error from `indexed`. Returns true if we switched to
+    `fallback`, false if the error has to be passed on. */
+    bool fall_back(const base_exc_t &e, bool indexed_produced);
+
+    counted_t<datum_stream_t> indexed, fallback;
+    bool indexed_produced, using_fallback;
+};
+
 class vector_datum_stream_t : public eager_datum_stream_t {
 public:
     vector_datum_stream_t(
@@ -0,0 +1,172 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "rdb_protocol/distinct.hpp"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "arch/runtime/coroutines.hpp"
+#include "rdb_protocol/pseudo_geometry.hpp"
+#include "rdb_protocol/pseudo_time.hpp"
+
+namespace ql {
+
+namespace {
+
+// The minimum amount of stack space we require before recursing into a datum.
+const size_t MIN_DATUM_HASH_STACK_SPACE = 16 * KILOBYTE;
+
+// The finalizer of SplitMix64, so that all bits of the result depend on all bits of
+// the input.  `hyperloglog_t` relies on that.
+uint64_t mix(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+uint64_t combine(uint64_t seed, uint64_t h) {
+    return mix(seed ^ (h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+uint64_t hash_bytes(const char *data, size_t size) {
+    // FNV-1a
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= static_cast<uint8_t>(data[i]);
+        h *= 0x100000001b3ULL;
+    }
+    return mix(h);
+}
+
+uint64_t hash_num(double d) {
+    // `0.0` and `-0.0` compare equal.
+    if (d == 0.0) {
+        d = 0.0;
+    }
+    uint64_t bits;
+    static_assert(sizeof(bits) == sizeof(d), "unexpected size of double");
+    memcpy(&bits, &d, sizeof(d));
+    return mix(bits);
+}
+
+uint64_t datum_hash_unchecked_stack(const datum_t &d) {
+    // Keep in sync with `datum_t::cmp`.
+    const uint64_t type_hash = mix(static_cast<uint64_t>(d.get_type()) + 1);
+    if (d.is_ptype() && !d.is_ptype(pseudo::geometry_string)) {
+        if (d.get_type() == datum_t::R_BINARY) {
+            const datum_string_t &data = d.as_binary();
+            return combine(type_hash, hash_bytes(data.data(), data.size()));
+        }
+        const std::string reql_type = d.get_reql_type();
+        uint64_t h = combine(type_hash, hash_bytes(reql_type.data(), reql_type.size()));
+        if (reql_type == pseudo::time_string) {
+            // Times compare by the instant they denote, not by their time zone.
+            h = combine(h, hash_num(pseudo::time_to_epoch_time(d)));
+        }
+        return h;
+    }
+
+    switch (d.get_type()) {
+    case datum_t::R_NULL: // fallthru
+    case datum_t::MINVAL: // fallthru
+    case datum_t::MAXVAL:
+        return type_hash;
+    case datum_t::R_BOOL:
+        return combine(type_hash, d.as_bool() ? 1 : 0);
+    case datum_t::R_NUM:
+        return combine(type_hash, hash_num(d.as_num()));
+    case datum_t::R_STR: {
+        const datum_string_t &str = d.as_str();
+        return combine(type_hash, hash_bytes(str.data(), str.size()));
+    }
+    case datum_t::R_ARRAY: {
+        uint64_t h = type_hash;
+        const size_t sz = d.arr_size();
+        for (size_t i = 0; i < sz; ++i) {
+            const datum_t el = d.get(i);
+            h = combine(h, call_with_enough_stack<uint64_t>([&]() {
+                return datum_hash_unchecked_stack(el);
+            }, MIN_DATUM_HASH_STACK_SPACE));
+        }
+        return h;
+    }
+    case datum_t::R_OBJECT: {
+        // Both representations of objects keep the pairs sorted by key.
+        uint64_t h = type_hash;
+        const size_t sz = d.obj_size();
+        for (size_t i = 0; i < sz; ++i) {
+            auto pair = d.get_pair(i);
+            h = combine(h, hash_bytes(pair.first.data(), pair.first.size()));
+            h = combine(h, call_with_enough_stack<uint64_t>([&]() {
+                return datum_hash_unchecked_stack(pair.second);
+            }, MIN_DATUM_HASH_STACK_SPACE));
+        }
+        return h;
+    }
+    case datum_t::R_BINARY: // handled above
+    case datum_t::UNINITIALIZED: // fallthru
+    default:
+        unreachable();
+    }
+}
+
+}  // namespace
+
+uint64_t datum_hash(const datum_t &d) {
+    return call_with_enough_stack<uint64_t>([&]() {
+        return datum_hash_unchecked_stack(d);
+    }, MIN_DATUM_HASH_STACK_SPACE);
+}
+
+bool datum_hash_set_t::insert(const datum_t &d) {
+    const uint64_t h = datum_hash(d);
+    auto range = set.equal_range(h);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == d) {
+            return false;
+        }
+    }
+    set.insert(std::make_pair(h, d));
+    return true;
+}
+
+const int hyperloglog_t::precision;
+const size_t hyperloglog_t::num_registers;
+
+hyperloglog_t::hyperloglog_t() : registers(num_registers, 0) { }
+
+void hyperloglog_t::add(const datum_t &d) {
+    const uint64_t h = datum_hash(d);
+    const size_t index = h >> (64 - precision);
+    // Make sure the rank is at most `64 - precision + 1` even if all remaining bits
+    // are zero.
+    const uint64_t rest = (h << precision) | (uint64_t(1) << (precision - 1));
+    const uint8_t rank = __builtin_clzll(rest) + 1;
+    registers[index] = std::max(registers[index], rank);
+}
+
+double hyperloglog_t::estimate() const {
+    const double m = static_cast<double>(num_registers);
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t r : registers) {
+        sum += ldexp(1.0, -static_cast<int>(r));
+        if (r == 0) {
+            ++zeros;
+        }
+    }
+    const double alpha = 0.7213 / (1 + 1.079 / m);
+    const double raw = alpha * m * m / sum;
+    if (raw <= 2.5 * m && zeros != 0) {
+        // Linear counting is more accurate for small cardinalities.
+        return m * log(m / static_cast<double>(zeros));
+    }
+    // With 64-bit hashes there is no need for a large range correction.
+    return raw;
+}
+
+}  // namespace ql
@@ -0,0 +1,58 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_DISTINCT_HPP_
+#define RDB_PROTOCOL_DISTINCT_HPP_
+
+#include <stdint.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "rdb_protocol/datum.hpp"
+
+namespace ql {
+
+// A hash of `d` that is the same for all datums that compare equal to it (so e.g.
+// times in different time zones that denote the same instant have the same hash).
+uint64_t datum_hash(const datum_t &d);
+
+/* The set of distinct datums seen so far.  Lookups go by `datum_hash` and are then
+verified with an exact comparison, so unlike a `std::set` this doesn't need any
+comparisons of elements with different hashes. */
+class datum_hash_set_t {
+public:
+    datum_hash_set_t() { }
+
+    // Returns true if `d` wasn't in the set yet.
+    bool insert(const datum_t &d);
+
+    size_t size() const { return set.size(); }
+
+private:
+    std::unordered_multimap<uint64_t, datum_t> set;
+
+    DISABLE_COPYING(datum_hash_set_t);
+};
+
+/* Estimates the number of distinct datums added to it in a fixed 16 KB of memory,
+with a standard error of about 0.8%.  See "HyperLogLog: the analysis of a
+near-optimal cardinality estimation algorithm" by Flajolet et al. */
+class hyperloglog_t {
+public:
+    hyperloglog_t();
+
+    void add(const datum_t &d);
+    double estimate() const;
+
+private:
+    // The first `precision` bits of a hash select one of the registers.
+    static const int precision = 14;
+    static const size_t num_registers = size_t(1) << precision;
+
+    // The maximum number of leading zeros (plus one) that the remaining bits of the
+    // hashes that selected each register had.
+    std::vector<uint8_t> registers;
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_DISTINCT_HPP_
@@ -50,6 +50,29 @@ double distribution_progress_estimator_t::estimate_progress(
     }
 }
 
+std::vector<store_key_t> distribution_progress_estimator_t::split_range(
+        const key_range_t &range, size_t num_parts) const {
+    std::vector<store_key_t> splits;
+    double begin = estimate_progress(range.left);
+    double end = range.right.unbounded ? 1.0 : estimate_progress(range.right.key());
+    if (num_parts <= 1 || end <= begin) {
+        return splits;
+    }
+    /* The keys in `distribution_counts` are the boundaries of the buckets, so those are
+    the split points we can tell apart. */
+    for (auto it = distribution_counts.upper_bound(range.left);
+            it != distribution_counts.end() && range.contains_key(it->first)
+                && splits.size() + 1 < num_parts;
+            ++it) {
+        double progress = estimate_progress(it->first);
+        double target = begin + (end - begin) * (splits.size() + 1) / num_parts;
+        if (progress >= target) {
+            splits.push_back(it->first);
+        }
+    }
+    return splits;
+}
+
 RDB_IMPL_SERIALIZABLE_2(distribution_progress_estimator_t,
     distribution_counts, distribution_counts_sum);
 INSTANTIATE_SERIALIZABLE_FOR_CLUSTER(distribution_progress_estimator_t);
@@ -3,6 +3,7 @@
 #define RDB_PROTOCOL_DISTRIBUTION_PROGRESS_HPP_
 
 #include <map>
+#include <vector>
 
 #include "btree/keys.hpp"
 #include "rpc/serialize_macros.hpp"
@@ -27,6 +28,10 @@ public:
     // Returns a value between 0.0 and 1.0
     double estimate_progress(const store_key_t &bound) const;
 
+    // Returns up to `num_parts - 1` keys inside of `range` that split it into parts
+    // with about the same number of keys, in increasing order.
+    std::vector<store_key_t> split_range(const key_range_t &range, size_t num_parts) const;
+
     RDB_DECLARE_ME_SERIALIZABLE(distribution_progress_estimator_t);
 
 private:
@@ -180,3 +180,54 @@ continue_bool_t rdb_erase_small_range(
         ? continue_bool_t::CONTINUE : continue_bool_t::ABORT;
 }
 
+
+void rdb_erase_detached_leaves(
+        std::vector<buf_lock_t> *leaves,
+        block_id_t stat_block_id,
+        const deletion_context_t *deletion_context,
+        std::vector<rdb_modification_report_t> *mod_reports_out) {
+    if (leaves->empty()) {
+        return;
+    }
+    const max_block_size_t max_block_size = leaves->front().cache()->max_block_size();
+    int64_t num_erased = 0;
+    for (buf_lock_t &leaf : *leaves) {
+        {
+            buf_read_t read(&leaf);
+            auto node = static_cast<const leaf_node_t *>(read.get_data_read());
+            for (auto it = leaf::begin(*node); it != leaf::end(*node); ++it) {
+                const rdb_value_t *rdb_value =
+                    static_cast<const rdb_value_t *>((*it).second);
+                if (mod_reports_out != nullptr) {
+                    rdb_modification_report_t mod_report(store_key_t((*it).first));
+                    mod_report.info.deleted.first =
+                        get_data(rdb_value, buf_parent_t(&leaf));
+                    mod_report.info.deleted.second.assign(
+                        rdb_value->value_ref(),
+                        rdb_value->value_ref() + rdb_value->inline_size(max_block_size));
+                    mod_reports_out->push_back(std::move(mod_report));
+                    deletion_context->in_tree_deleter()->delete_value(
+                        buf_parent_t(&leaf), rdb_value);
+                } else {
+                    deletion_context->post_deleter()->delete_value(
+                        buf_parent_t(&leaf), rdb_value);
+                }
+                ++num_erased;
+            }
+        }
+        leaf.write_acq_signal()->wait_lazily_unordered();
+        leaf.mark_deleted();
+        leaf.reset_buf_lock();
+    }
+
+    // Like other writes, we update the stat block as a child of the transaction.
+    if (stat_block_id != NULL_BLOCK_ID) {
+        buf_lock_t stat_block(buf_parent_t(leaves->front().txn()),
+                              stat_block_id, access_t::write);
+        buf_write_t stat_block_write(&stat_block);
+        auto stat_block_buf = static_cast<btree_statblock_t *>(
+            stat_block_write.get_data_write(BTREE_STATBLOCK_SIZE));
+        stat_block_buf->population -= num_erased;
+    }
+    leaves->clear();
+}
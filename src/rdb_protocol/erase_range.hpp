@@ -10,6 +10,7 @@
 #include "buffer_cache/types.hpp"
 
 class btree_slice_t;
+class buf_lock_t;
 struct btree_key_t;
 class deletion_context_t;
 struct rdb_modification_report_t;
@@ -55,4 +56,18 @@ continue_bool_t rdb_erase_small_range(
     std::vector<rdb_modification_report_t> *mod_reports_out,
     key_range_t *deleted_out);
 
+/* `rdb_erase_detached_leaves` takes care of the values in the leaf nodes that
+`btree_detach_leaves()` took out of a primary B-tree, marks the leaf nodes deleted and
+subtracts their keys from the population in the stat block.  Its complexity is O(m)
+for the m documents in the leaf nodes, without any lookups from the root.
+
+If `mod_reports_out` is not null, it gets a modification report for every document,
+and the values are only detached, like `rdb_erase_small_range` does.  Otherwise the
+values are deleted right away, which avoids reading the documents. */
+void rdb_erase_detached_leaves(
+    std::vector<buf_lock_t> *leaves,
+    block_id_t stat_block_id,
+    const deletion_context_t *deletion_context,
+    std::vector<rdb_modification_report_t> *mod_reports_out);
+
 #endif  // RDB_PROTOCOL_ERASE_RANGE_HPP_
@@ -0,0 +1,423 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "rdb_protocol/filter_pushdown.hpp"
+
+#include <set>
+
+#include "clustering/administration/admin_op_exc.hpp"
+#include "containers/name_string.hpp"
+#include "rdb_protocol/context.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/profile.hpp"
+#include "rdb_protocol/val.hpp"
+
+namespace ql {
+
+boost::optional<std::string> field_of_row(const raw_term_t &term, sym_t arg) {
+    if (term.type() != Term::BRACKET && term.type() != Term::GET_FIELD) {
+        return boost::none;
+    }
+    if (term.num_args() != 2 || term.num_optargs() != 0) {
+        return boost::none;
+    }
+    raw_term_t obj = term.arg(0);
+    if (obj.type() == Term::VAR) {
+        if (obj.num_args() != 1 || obj.arg(0).type() != Term::DATUM) {
+            return boost::none;
+        }
+        datum_t var = obj.arg(0).datum();
+        if (var.get_type() != datum_t::R_NUM || var.as_num() != arg.value) {
+            return boost::none;
+        }
+    } else if (obj.type() != Term::IMPLICIT_VAR) {
+        return boost::none;
+    }
+    raw_term_t field = term.arg(1);
+    if (field.type() != Term::DATUM) {
+        return boost::none;
+    }
+    datum_t field_datum = field.datum();
+    if (field_datum.get_type() != datum_t::R_STR) {
+        return boost::none;
+    }
+    return field_datum.as_str().to_std();
+}
+
+boost::optional<field_comparison_t> field_comparison_of(const raw_term_t &term,
+                                                        sym_t arg) {
+    Term::TermType op = term.type();
+    if (op != Term::EQ && op != Term::NE && op != Term::LT && op != Term::LE
+        && op != Term::GT && op != Term::GE) {
+        return boost::none;
+    }
+    if (term.num_args() != 2 || term.num_optargs() != 0) {
+        return boost::none;
+    }
+
+    raw_term_t value_term = term.arg(1);
+    boost::optional<std::string> field = field_of_row(term.arg(0), arg);
+    if (!field) {
+        // `c < row(field)` is the same as `row(field) > c`.
+        field = field_of_row(term.arg(1), arg);
+        value_term = term.arg(0);
+        switch (static_cast<int>(op)) {
+        case Term::LT: op = Term::GT; break;
+        case Term::LE: op = Term::GE; break;
+        case Term::GT: op = Term::LT; break;
+        case Term::GE: op = Term::LE; break;
+        default: break;
+        }
+    }
+    if (!field || value_term.type() != Term::DATUM) {
+        return boost::none;
+    }
+    return field_comparison_t{*field, op, value_term.datum()};
+}
+
+class single_arg_reql_func_visitor_t : public func_visitor_t {
+public:
+    single_arg_reql_func_visitor_t() : body(nullptr) { }
+    void on_reql_func(const reql_func_t *reql_func) {
+        if (reql_func->get_arg_names().size() == 1) {
+            arg = reql_func->get_arg_names()[0];
+            body = reql_func->get_body().get();
+        }
+    }
+    void on_js_func(const js_func_t *) { }
+
+    sym_t arg;
+    const term_t *body;
+};
+
+/* The bounds a field is restricted to. An unset bound is unbounded. */
+struct field_bounds_t {
+    void restrict_left(const datum_t &d, key_range_t::bound_t type) {
+        if (!left.has() || d > left
+            || (d == left && type == key_range_t::open)) {
+            left = d;
+            left_type = type;
+        }
+    }
+    void restrict_right(const datum_t &d, key_range_t::bound_t type) {
+        if (!right.has() || d < right
+            || (d == right && type == key_range_t::open)) {
+            right = d;
+            right_type = type;
+        }
+    }
+
+    // Non-indexable values sort between `ARRAY`/`BOOL` and `NUMBER` (`null`) and
+    // between `NUMBER` and `STRING` (objects), while nothing sorts after strings. So
+    // a range stays clear of them if both bounds have the same type, or if it only
+    // contains strings.
+    bool is_safe() const {
+        if (!left.has()) {
+            return false;
+        } else if (!right.has()) {
+            return left.get_type() == datum_t::R_STR;
+        } else {
+            return left.get_type() == right.get_type();
+        }
+    }
+
+    datum_range_t to_range() const {
+        return datum_range_t(
+            left, left_type,
+            right.has() ? right : datum_t::maxval(),
+            right.has() ? right_type : key_range_t::open);
+    }
+
+    datum_t left, right;
+    key_range_t::bound_t left_type, right_type;
+};
+
+void collect_field_bounds(const raw_term_t &term,
+                          sym_t arg,
+                          std::map<std::string, field_bounds_t> *bounds_out) {
+    if (term.type() == Term::AND) {
+        for (size_t i = 0; i < term.num_args(); ++i) {
+            collect_field_bounds(term.arg(i), arg, bounds_out);
+        }
+        return;
+    }
+    boost::optional<field_comparison_t> comparison = field_comparison_of(term, arg);
+    if (!comparison || comparison->op == Term::NE) {
+        return;
+    }
+    const Term::TermType type = comparison->op;
+    const datum_t &value = comparison->value;
+    if (value.get_type() != datum_t::R_NUM && value.get_type() != datum_t::R_STR) {
+        return;
+    }
+
+    field_bounds_t *bounds = &(*bounds_out)[comparison->field];
+    switch (static_cast<int>(type)) {
+    case Term::EQ:
+        bounds->restrict_left(value, key_range_t::closed);
+        bounds->restrict_right(value, key_range_t::closed);
+        break;
+    case Term::LT: bounds->restrict_right(value, key_range_t::open); break;
+    case Term::LE: bounds->restrict_right(value, key_range_t::closed); break;
+    case Term::GT: bounds->restrict_left(value, key_range_t::open); break;
+    case Term::GE: bounds->restrict_left(value, key_range_t::closed); break;
+    default: unreachable();
+    }
+}
+
+boost::optional<raw_term_t> single_arg_body(const counted_t<const func_t> &func,
+                                            sym_t *arg_out) {
+    single_arg_reql_func_visitor_t visitor;
+    func->visit(&visitor);
+    if (visitor.body == nullptr) {
+        return boost::none;
+    }
+    *arg_out = visitor.arg;
+    return visitor.body->get_src();
+}
+
+// Adds the top-level fields of a `pluck` path specification to `fields_out`.
+bool add_pathspec_fields(const datum_t &pathspec, std::set<datum_string_t> *fields_out) {
+    switch (pathspec.get_type()) {
+    case datum_t::R_STR:
+        fields_out->insert(pathspec.as_str());
+        return true;
+    case datum_t::R_ARRAY:
+        for (size_t i = 0; i < pathspec.arr_size(); ++i) {
+            if (!add_pathspec_fields(pathspec.get(i), fields_out)) {
+                return false;
+            }
+        }
+        return true;
+    case datum_t::R_OBJECT:
+        if (pathspec.is_ptype()) {
+            return false;
+        }
+        for (size_t i = 0; i < pathspec.obj_size(); ++i) {
+            fields_out->insert(pathspec.get_pair(i).first);
+        }
+        return true;
+    case datum_t::UNINITIALIZED: // fallthru
+    case datum_t::MINVAL: // fallthru
+    case datum_t::R_BINARY: // fallthru
+    case datum_t::R_BOOL: // fallthru
+    case datum_t::R_NULL: // fallthru
+    case datum_t::R_NUM: // fallthru
+    case datum_t::MAXVAL: // fallthru
+    default:
+        return false;
+    }
+}
+
+boost::optional<std::vector<datum_string_t> > fields_read_by(
+        const counted_t<const func_t> &func) {
+    sym_t arg;
+    boost::optional<raw_term_t> body = single_arg_body(func, &arg);
+    if (!body) {
+        return boost::none;
+    }
+    if (boost::optional<std::string> field = field_of_row(*body, arg)) {
+        return std::vector<datum_string_t>{datum_string_t(*field)};
+    }
+    if (body->type() != Term::PLUCK || body->num_args() < 2) {
+        return boost::none;
+    }
+    raw_term_t obj = body->arg(0);
+    if (obj.type() != Term::VAR
+        || obj.num_args() != 1
+        || obj.arg(0).type() != Term::DATUM) {
+        return boost::none;
+    }
+    datum_t var = obj.arg(0).datum();
+    if (var.get_type() != datum_t::R_NUM || var.as_num() != arg.value) {
+        return boost::none;
+    }
+    std::set<datum_string_t> fields;
+    for (size_t i = 1; i < body->num_args(); ++i) {
+        raw_term_t path = body->arg(i);
+        if (path.type() != Term::DATUM || !add_pathspec_fields(path.datum(), &fields)) {
+            return boost::none;
+        }
+    }
+    return std::vector<datum_string_t>(fields.begin(), fields.end());
+}
+
+std::vector<field_range_t> extract_field_ranges(
+        const counted_t<const func_t> &predicate) {
+    sym_t arg;
+    boost::optional<raw_term_t> body = single_arg_body(predicate, &arg);
+    if (!body) {
+        return std::vector<field_range_t>();
+    }
+
+    std::map<std::string, field_bounds_t> bounds;
+    collect_field_bounds(*body, arg, &bounds);
+
+    std::vector<field_range_t> res;
+    for (const auto &pair : bounds) {
+        if (pair.second.is_safe()) {
+            res.push_back(field_range_t{pair.first, pair.second.to_range()});
+        }
+    }
+    return res;
+}
+
+boost::optional<std::string> simple_sindex_field(const sindex_config_t &config) {
+    if (config.multi != sindex_multi_bool_t::SINGLE
+        || config.geo != sindex_geo_bool_t::REGULAR
+        || config.func_version != reql_version_t::LATEST) {
+        return boost::none;
+    }
+    sym_t arg;
+    boost::optional<raw_term_t> body =
+        single_arg_body(config.func.compile_wire_func(), &arg);
+    if (!body) {
+        return boost::none;
+    }
+    return field_of_row(*body, arg);
+}
+
+boost::optional<double> estimate_range_fraction(
+        const std::map<store_key_t, int64_t> &distribution,
+        const key_range_t &range) {
+    int64_t total = 0;
+    int64_t in_range = 0;
+    for (auto it = distribution.begin(); it != distribution.end(); ++it) {
+        total += it->second;
+        // The bucket starting at `it->first` ends where the next one starts.
+        auto next = it;
+        ++next;
+        bool starts_before_right =
+            range.right.unbounded || it->first < range.right.key();
+        bool ends_after_left =
+            next == distribution.end() || range.left < next->first;
+        if (starts_before_right && ends_after_left) {
+            in_range += it->second;
+        }
+    }
+    if (total <= 0) {
+        return boost::none;
+    }
+    return static_cast<double>(in_range) / static_cast<double>(total);
+}
+
+bool sindex_configs_match(
+        const sindex_planning_cache_t::sindexes_t &configs_and_statuses,
+        const std::map<std::string, sindex_config_t> &configs) {
+    if (configs_and_statuses.size() != configs.size()) {
+        return false;
+    }
+    for (const auto &pair : configs_and_statuses) {
+        auto it = configs.find(pair.first);
+        if (it == configs.end() || it->second != pair.second.first) {
+            return false;
+        }
+    }
+    return true;
+}
+
+counted_t<table_slice_t> push_down_filter(
+        env_t *env,
+        const counted_t<table_slice_t> &slice,
+        const counted_t<const func_t> &predicate) {
+    const counted_t<table_t> &table = slice->get_tbl();
+    if ((slice->get_idx() && *slice->get_idx() != table->get_pkey())
+        || slice->get_sorting() != sorting_t::UNORDERED
+        || !slice->get_bounds().is_universe()) {
+        return counted_t<table_slice_t>();
+    }
+
+    std::vector<field_range_t> ranges = extract_field_ranges(predicate);
+    if (ranges.empty()) {
+        return counted_t<table_slice_t>();
+    }
+
+    // This runs for every `filter`, so we only ask every server for the status of
+    // the table's indexes when the cache doesn't know them. A cached entry is still
+    // checked against the table's current index definitions, because an index may
+    // have been dropped or redefined through another server.
+    sindex_planning_cache_t *cache = &env->get_rdb_ctx()->sindex_planning_cache;
+    const namespace_id_t table_id = table->tbl->get_id();
+    const name_string_t table_name = name_string_t::guarantee_valid(table->name.c_str());
+    admin_err_t error;
+    sindex_planning_cache_t::sindexes_t configs_and_statuses;
+    bool cache_hit = cache->get_sindexes(table_id, &configs_and_statuses);
+    if (cache_hit) {
+        std::map<std::string, sindex_config_t> configs;
+        if (!env->reql_cluster_interface()->sindex_configs(
+                table->db, table_name, env->interruptor, &error, &configs)) {
+            // We just don't optimize the query; the read itself will report the
+            // problem.
+            return counted_t<table_slice_t>();
+        }
+        cache_hit = sindex_configs_match(configs_and_statuses, configs);
+    }
+    if (!cache_hit) {
+        configs_and_statuses.clear();
+        if (!env->reql_cluster_interface()->sindex_list(
+                table->db, table_name, env->interruptor, &error,
+                &configs_and_statuses)) {
+            return counted_t<table_slice_t>();
+        }
+        cache->set_sindexes(table_id, configs_and_statuses);
+    }
+
+    std::vector<std::pair<std::string, const field_range_t *> > candidates;
+    for (const auto &pair : configs_and_statuses) {
+        if (!pair.second.second.ready) {
+            continue;
+        }
+        boost::optional<std::string> field = simple_sindex_field(pair.second.first);
+        if (!field) {
+            continue;
+        }
+        for (const field_range_t &range : ranges) {
+            if (range.field == *field) {
+                candidates.push_back(std::make_pair(pair.first, &range));
+            }
+        }
+    }
+    if (candidates.empty()) {
+        return counted_t<table_slice_t>();
+    }
+
+    // Without a usable estimate we stick with the first candidate in index order.
+    size_t best = 0;
+    boost::optional<double> best_fraction;
+    if (candidates.size() > 1) {
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            std::map<store_key_t, int64_t> distribution;
+            if (!cache->get_distribution(
+                    table_id, candidates[i].first, &distribution)) {
+                distribution =
+                    table->tbl->read_sindex_distribution(env, candidates[i].first);
+                cache->set_distribution(
+                    table_id, candidates[i].first, distribution);
+            }
+            boost::optional<double> fraction = estimate_range_fraction(
+                distribution,
+                candidates[i].second->range.to_sindex_keyrange(
+                    reql_version_t::LATEST));
+            if (fraction && (!best_fraction || *fraction < *best_fraction)) {
+                best = i;
+                best_fraction = fraction;
+            }
+        }
+    }
+
+    PROFILE_STARTER_IF_ENABLED(
+        env->profile() == profile_bool_t::PROFILE,
+        strprintf("Push filter down into index `%s` over %s (%zu candidate "
+                  "index(es), estimated fraction %s).",
+                  candidates[best].first.c_str(),
+                  candidates[best].second->range.print().c_str(),
+                  candidates.size(),
+                  best_fraction ? strprintf("%.4f", *best_fraction).c_str()
+                                : "unknown"),
+        env->trace);
+
+    return make_counted<table_slice_t>(
+        table, candidates[best].first, sorting_t::UNORDERED,
+        candidates[best].second->range);
+}
+
+}  // namespace ql
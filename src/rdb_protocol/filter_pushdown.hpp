@@ -0,0 +1,104 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_FILTER_PUSHDOWN_HPP_
+#define RDB_PROTOCOL_FILTER_PUSHDOWN_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "errors.hpp"
+#include <boost/optional.hpp>
+
+#include "btree/keys.hpp"
+#include "containers/counted.hpp"
+#include "rdb_protocol/context.hpp"
+#include "rdb_protocol/datumspec.hpp"
+#include "rdb_protocol/sym.hpp"
+#include "rdb_protocol/term_storage.hpp"
+
+namespace ql {
+
+class env_t;
+class func_t;
+class table_slice_t;
+
+/* Returns the raw term of the body of `func` and sets `*arg_out` to its argument if
+`func` is a ReQL function of one argument. */
+boost::optional<raw_term_t> single_arg_body(const counted_t<const func_t> &func,
+                                            sym_t *arg_out);
+
+/* If `term` is `var(arg)(field)` or `r.row(field)` for the only argument of a
+function, returns `field`. */
+boost::optional<std::string> field_of_row(const raw_term_t &term, sym_t arg);
+
+/* A comparison `row(field) op value` of a top-level field of the only argument of a
+function with a datum literal, where `op` is one of `eq`, `ne`, `lt`, `le`, `gt` and
+`ge`. */
+struct field_comparison_t {
+    std::string field;
+    Term::TermType op;
+    datum_t value;
+};
+
+/* Returns the comparison if `term` is `row(field) OP c` or `c OP row(field)`.  The
+latter is turned around, so `c < row(field)` becomes `row(field) > c`. */
+boost::optional<field_comparison_t> field_comparison_of(const raw_term_t &term,
+                                                        sym_t arg);
+
+/* If the body of the one-argument function `func` is `row(field)` or a `pluck` of
+literal paths from `row` (which is what `table.pluck(...)` turns into), returns the
+top-level fields of `row` that it reads, sorted.  If `row` is a plain object with all
+of those fields, applying `func` to an object with just those fields of `row` gives
+the same result as applying it to `row`. */
+boost::optional<std::vector<datum_string_t> > fields_read_by(
+    const counted_t<const func_t> &func);
+
+/* The range that the value of a top-level field has to lie in for a `filter`
+predicate to be true. */
+struct field_range_t {
+    std::string field;
+    datum_range_t range;
+};
+
+/* Looks at a predicate of the form `row(f1) OP c1 && row(f2) OP c2 && ...`, where
+`OP` is one of `eq`, `lt`, `le`, `gt` and `ge` and the `c`s are number or string
+literals, and returns the range each field is restricted to. Parts of the predicate
+that don't have this shape are ignored.
+
+A range is only returned if it can't contain `null` or object values. Those can't be
+stored in a secondary index, so restricting a read to any of the returned ranges on an
+index over the field never loses a row that matches the predicate. */
+std::vector<field_range_t> extract_field_ranges(
+    const counted_t<const func_t> &predicate);
+
+/* Returns the field name if `config` is a regular, non-multi index whose function is
+just `row(field)` and whose ordering matches the current ReQL version. */
+boost::optional<std::string> simple_sindex_field(const sindex_config_t &config);
+
+/* Returns the fraction of the keys sampled in `distribution` (in the format of
+`distribution_read_response_t::key_counts`) that fall into `range`, or `boost::none`
+if the distribution is empty. */
+boost::optional<double> estimate_range_fraction(
+    const std::map<store_key_t, int64_t> &distribution,
+    const key_range_t &range);
+
+/* Returns true if the indexes in `configs_and_statuses`, which came from the query
+planning cache, have the same names and definitions as `configs`. */
+bool sindex_configs_match(
+    const sindex_planning_cache_t::sindexes_t &configs_and_statuses,
+    const std::map<std::string, sindex_config_t> &configs);
+
+/* Tries to turn `filter(predicate)` on `slice` into a read of a range of a secondary
+index. This only happens if `slice` is neither ordered nor bounded yet. If several
+indexes apply, the one with the smallest estimated range is used. The caller must
+still apply the full predicate to the result, and should fall back to reading
+`slice` if the index read fails (see `index_fallback_datum_stream_t`). Returns an empty
+pointer if no index applies. */
+counted_t<table_slice_t> push_down_filter(
+    env_t *env,
+    const counted_t<table_slice_t> &slice,
+    const counted_t<const func_t> &predicate);
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_FILTER_PUSHDOWN_HPP_
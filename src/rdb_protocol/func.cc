@@ -3,6 +3,7 @@
 
 #include "pprint/js_pprint.hpp"
 #include "pprint/pprint.hpp"
+#include "rdb_protocol/bytecode.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/minidriver.hpp"
 #include "rdb_protocol/pseudo_literal.hpp"
@@ -45,7 +46,18 @@ reql_func_t::reql_func_t(const var_scope_t &_captured_scope,
     : func_t(_body->backtrace()),
       captured_scope(_captured_scope),
       arg_names(std::move(_arg_names)),
-      body(std::move(_body)) { }
+      body(std::move(_body)),
+      program(bytecode_program_t::compile(arg_names, body->get_src(), body.get())) { }
+
+reql_func_t::reql_func_t(const var_scope_t &_captured_scope,
+                         std::vector<sym_t> _arg_names,
+                         counted_t<const term_t> _body,
+                         counted_t<const bytecode_program_t> _program)
+    : func_t(_body->backtrace()),
+      captured_scope(_captured_scope),
+      arg_names(std::move(_arg_names)),
+      body(std::move(_body)),
+      program(std::move(_program)) { }
 
 reql_func_t::reql_func_t(scoped_ptr_t<term_storage_t> &&_storage,
                          const var_scope_t &_captured_scope,
@@ -55,7 +67,8 @@ reql_func_t::reql_func_t(scoped_ptr_t<term_storage_t> &&_storage,
       captured_scope(_captured_scope),
       arg_names(std::move(_arg_names)),
       term_storage(std::move(_storage)),
-      body(std::move(_body)) { }
+      body(std::move(_body)),
+      program(bytecode_program_t::compile(arg_names, body->get_src(), body.get())) { }
 
 reql_func_t::~reql_func_t() { }
 
@@ -75,6 +88,20 @@ scoped_ptr_t<val_t> reql_func_t::call(env_t *env,
                          arg_names.size(),
                          (arg_names.size() == 1 ? "" : "s")));
 
+        // The program doesn't show up in profiles, so we only use it if nobody is
+        // looking.
+        if (program.has() && env->profile() == profile_bool_t::DONT_PROFILE) {
+            env->do_eval_callback();
+            if (env->interruptor->is_pulsed()) {
+                throw interrupted_exc_t();
+            }
+            env->maybe_yield();
+            datum_t res = program->run(env, captured_scope, args);
+            if (res.has()) {
+                return make_scoped<val_t>(std::move(res), backtrace());
+            }
+        }
+
         var_scope_t new_scope = arg_names.size() == 0
             ? captured_scope
             : captured_scope.with_func_arg_list(arg_names, args);
@@ -212,6 +239,7 @@ func_term_t::func_term_t(compile_env_t *env, const raw_term_t &t)
 
     arg_names = std::move(args);
     body = std::move(compiled_body);
+    program = bytecode_program_t::compile(arg_names, raw_body, body.get());
     external_captures = std::move(captures);
 }
 
@@ -228,7 +256,7 @@ scoped_ptr_t<val_t> func_term_t::term_eval(scope_env_t *env,
 
 counted_t<const func_t> func_term_t::eval_to_func(const var_scope_t &env_scope) const {
     return make_counted<reql_func_t>(env_scope.filtered_by_captures(external_captures),
-                                     arg_names, body);
+                                     arg_names, body, program);
 }
 
 deterministic_t func_term_t::is_deterministic() const {
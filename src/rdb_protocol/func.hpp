@@ -25,6 +25,7 @@ class js_runner_t;
 
 namespace ql {
 
+class bytecode_program_t;
 class func_visitor_t;
 
 class func_t : public slow_atomic_countable_t<func_t>, public bt_rcheckable_t {
@@ -86,6 +87,13 @@ public:
                 std::vector<sym_t> arg_names,
                 counted_t<const term_t> body);
 
+    // Like the above, but with a program that `func_term_t` compiled once for all
+    // the functions it creates.
+    reql_func_t(const var_scope_t &captured_scope,
+                std::vector<sym_t> arg_names,
+                counted_t<const term_t> body,
+                counted_t<const bytecode_program_t> program);
+
     // Used when constructing from a function read off the wire
     reql_func_t(scoped_ptr_t<term_storage_t> &&_storage,
                 const var_scope_t &captured_scope,
@@ -110,6 +118,10 @@ public:
 
     bool is_simple_selector() const final;
 
+    // Used by the query optimizer to look at the structure of the function.
+    const std::vector<sym_t> &get_arg_names() const { return arg_names; }
+    const counted_t<const term_t> &get_body() const { return body; }
+
 private:
     template <cluster_version_t> friend class wire_func_serialization_visitor_t;
     bool filter_helper(env_t *env, datum_t arg) const;
@@ -127,6 +139,10 @@ private:
     // The body of the function, which gets ->eval(...) called when call(...) is called.
     counted_t<const term_t> body;
 
+    // `body` compiled to bytecode, which `call` runs instead if it can. Empty if the
+    // body uses terms that aren't compiled.
+    counted_t<const bytecode_program_t> program;
+
     DISABLE_COPYING(reql_func_t);
 };
 
@@ -222,6 +238,7 @@ private:
 
     std::vector<sym_t> arg_names;
     counted_t<const term_t> body;
+    counted_t<const bytecode_program_t> program;
 
     var_captures_t external_captures;
 };
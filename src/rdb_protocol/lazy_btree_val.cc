@@ -1,6 +1,8 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/lazy_btree_val.hpp"
 
+#include <algorithm>
+
 #include "containers/archive/buffer_group_stream.hpp"
 #include "containers/archive/versioned.hpp"
 #include "rdb_protocol/blob_wrapper.hpp"
@@ -24,16 +26,71 @@ ql::datum_t get_data(const rdb_value_t *value, buf_parent_t parent) {
     return data;
 }
 
+ql::datum_t get_data_fields(const rdb_value_t *value,
+                            buf_parent_t parent,
+                            const std::vector<datum_string_t> &fields,
+                            int64_t *bytes_read_out) {
+    rdb_blob_wrapper_t blob(parent.cache()->max_block_size(),
+                            const_cast<rdb_value_t *>(value)->value_ref(),
+                            blob::btree_maxreflen);
+    const int64_t value_size = blob.valuesize();
+    // Stored objects are only parsed lazily anyway, so reading them in parts only
+    // pays off if that saves loading (and copying) some of the blob's blocks.
+    if (value_size <= parent.cache()->max_block_size().value()) {
+        *bytes_read_out = value_size;
+        return get_data(value, parent);
+    }
+
+    size_t bytes_read;
+    ql::datum_t data = ql::datum_deserialize_fields(
+        static_cast<size_t>(value_size),
+        [&](size_t offset, size_t size, char *out) {
+            blob_acq_t acq_group;
+            buffer_group_t buffer_group;
+            blob.expose_region(parent, access_t::read, offset, size,
+                               &buffer_group, &acq_group);
+            buffer_group_read_stream_t read_stream(const_view(&buffer_group));
+            int64_t res = force_read(&read_stream, out, size);
+            guarantee(res == static_cast<int64_t>(size));
+        },
+        fields,
+        &bytes_read);
+    *bytes_read_out = static_cast<int64_t>(bytes_read);
+    if (!data.has()) {
+        *bytes_read_out += value_size;
+        return get_data(value, parent);
+    }
+    return data;
+}
+
 const ql::datum_t &lazy_btree_val_t::get() const {
     guarantee(pointee.has());
     if (!pointee->ptr.has()) {
-        pointee->ptr = get_data(pointee->rdb_value, pointee->parent);
+        const int64_t value_size = pointee->rdb_value->value_size();
+        if (pointee->fields != NULL) {
+            pointee->ptr = get_data_fields(pointee->rdb_value, pointee->parent,
+                                           *pointee->fields, &pointee->bytes_read);
+        } else {
+            pointee->ptr = get_data(pointee->rdb_value, pointee->parent);
+            pointee->bytes_read = value_size;
+        }
+        pointee->bytes_skipped = std::max<int64_t>(0, value_size - pointee->bytes_read);
         pointee->rdb_value = NULL;
         pointee->parent = buf_parent_t();
     }
     return pointee->ptr;
 }
 
+int64_t lazy_btree_val_t::bytes_read() const {
+    guarantee(pointee.has());
+    return pointee->bytes_read;
+}
+
+int64_t lazy_btree_val_t::bytes_skipped() const {
+    guarantee(pointee.has());
+    return pointee->bytes_skipped;
+}
+
 bool lazy_btree_val_t::references_parent() const {
     return pointee.has() && !pointee->parent.empty();
 }
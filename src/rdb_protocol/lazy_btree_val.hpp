@@ -2,6 +2,8 @@
 #ifndef RDB_PROTOCOL_LAZY_BTREE_VAL_HPP_
 #define RDB_PROTOCOL_LAZY_BTREE_VAL_HPP_
 
+#include <vector>
+
 #include "buffer_cache/alt.hpp"
 #include "buffer_cache/blob.hpp"
 #include "rdb_protocol/datum.hpp"
@@ -30,15 +32,28 @@ public:
 ql::datum_t get_data(const rdb_value_t *value,
                      buf_parent_t parent);
 
+// Like `get_data`, but if the value is an object that spans more than one block,
+// returns an object with just the top-level `fields` (which must be sorted) and only
+// reads the parts of the blob that hold them.  Falls back to `get_data` if the value
+// lacks one of the fields.  Sets `*bytes_read_out` to the number of bytes of the
+// value that were read.
+ql::datum_t get_data_fields(const rdb_value_t *value,
+                            buf_parent_t parent,
+                            const std::vector<datum_string_t> &fields,
+                            int64_t *bytes_read_out);
+
 class lazy_btree_val_pointee_t
         : public single_threaded_countable_t<lazy_btree_val_pointee_t> {
-    lazy_btree_val_pointee_t(const rdb_value_t *_rdb_value, buf_parent_t _parent)
-        : rdb_value(_rdb_value), parent(_parent) {
+    lazy_btree_val_pointee_t(const rdb_value_t *_rdb_value, buf_parent_t _parent,
+                             const std::vector<datum_string_t> *_fields)
+        : rdb_value(_rdb_value), parent(_parent), fields(_fields),
+          bytes_read(0), bytes_skipped(0) {
         guarantee(rdb_value != NULL);
     }
 
     explicit lazy_btree_val_pointee_t(const ql::datum_t &_ptr)
-        : ptr(_ptr), rdb_value(NULL), parent() {
+        : ptr(_ptr), rdb_value(NULL), parent(), fields(NULL),
+          bytes_read(0), bytes_skipped(0) {
         guarantee(ptr.has());
     }
 
@@ -52,6 +67,13 @@ class lazy_btree_val_pointee_t
     const rdb_value_t *rdb_value;
     buf_parent_t parent;
 
+    // If non-NULL, only these top-level fields of the value are loaded.
+    const std::vector<datum_string_t> *fields;
+
+    // How many bytes of the value were read and not read when loading it.
+    int64_t bytes_read;
+    int64_t bytes_skipped;
+
     DISABLE_COPYING(lazy_btree_val_pointee_t);
 };
 
@@ -61,9 +83,18 @@ public:
         : pointee(new lazy_btree_val_pointee_t(ptr)) { }
 
     lazy_btree_val_t(const rdb_value_t *rdb_value, buf_parent_t parent)
-        : pointee(new lazy_btree_val_pointee_t(rdb_value, parent)) { }
+        : pointee(new lazy_btree_val_pointee_t(rdb_value, parent, NULL)) { }
+
+    // `get()` may return an object with only the top-level `fields` (see
+    // `get_data_fields`).  `fields` must outlive this object.
+    lazy_btree_val_t(const rdb_value_t *rdb_value, buf_parent_t parent,
+                     const std::vector<datum_string_t> *fields)
+        : pointee(new lazy_btree_val_pointee_t(rdb_value, parent, fields)) { }
 
     const ql::datum_t &get() const;
+    // The number of bytes of the stored value that `get()` did and didn't read.
+    int64_t bytes_read() const;
+    int64_t bytes_skipped() const;
     bool references_parent() const;
     void reset();
 
@@ -69,6 +69,7 @@ static const std::set<std::string> acceptable_optargs({
     "include_states",
     "include_types",
     "index",
+    "index_pushdown",
     "interleave",
     "ordered",
     "left_bound",
@@ -77,6 +78,7 @@ static const std::set<std::string> acceptable_optargs({
     "max_batch_seconds",
     "max_dist",
     "max_results",
+    "max_staleness",
     "method",
     "min_batch_rows",
     "multi",
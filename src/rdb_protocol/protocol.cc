@@ -247,8 +247,7 @@ void post_construct_and_drain_queue(
             // Pretend that the indexes in `sindexes` have been post-constructed up to
             // the new range. This is important to make the call to
             // `rdb_update_sindexes()` below actually update the indexes.
-            // We use the same trick in the `post_construct_traversal_helper_t`.
-            // TODO: Avoid this hackery (here and in `post_construct_traversal_helper_t`)
+            // TODO: Avoid this hackery
             for (auto &&access : sindexes) {
                 access->sindex.needs_post_construction_range = *construction_range_inout;
             }
@@ -630,6 +629,7 @@ bool read_t::shard(const hash_region_t<key_range_t> &region,
     read_t::variant_t payload;
     bool result = boost::apply_visitor(rdb_r_shard_visitor_t(&region, &payload), read);
     *read_out = read_t(payload, profile, read_mode);
+    read_out->max_staleness_ms = max_staleness_ms;
     return result;
 }
 
@@ -649,14 +649,22 @@ public:
 
 // Scale the distribution down by combining ranges to fit it within the limit of
 // the query
-void scale_down_distribution(size_t result_limit, std::map<store_key_t, int64_t> *key_counts) {
+void scale_down_distribution(size_t result_limit,
+                             distribution_read_response_t *distribution) {
     guarantee(result_limit > 0);
+    std::map<store_key_t, int64_t> *key_counts = &distribution->key_counts;
+    std::map<store_key_t, int64_t> *key_bytes = &distribution->key_bytes;
     const size_t combine = (key_counts->size() / result_limit); // Combine this many other ranges into the previous range
     for (std::map<store_key_t, int64_t>::iterator it = key_counts->begin(); it != key_counts->end(); ) {
         std::map<store_key_t, int64_t>::iterator next = it;
         ++next;
         for (size_t i = 0; i < combine && next != key_counts->end(); ++i) {
             it->second += next->second;
+            auto bytes_it = key_bytes->find(next->first);
+            if (bytes_it != key_bytes->end()) {
+                (*key_bytes)[it->first] += bytes_it->second;
+                key_bytes->erase(bytes_it);
+            }
             std::map<store_key_t, int64_t>::iterator tmp = next;
             ++next;
             key_counts->erase(tmp);
@@ -936,6 +944,29 @@ void rdb_r_unshard_visitor_t::unshard_range_batch(const query_t &q, sorting_t so
 }
 
 void rdb_r_unshard_visitor_t::operator()(const distribution_read_t &dg) {
+    if (static_cast<bool>(dg.sindex_id)) {
+        // Every shard has its own secondary index covering the whole sindex key
+        // space, so the samples overlap and we simply add them up.
+        distribution_read_response_t res;
+        res.region = dg.region;
+        for (size_t i = 0; i < count; ++i) {
+            auto result =
+                boost::get<distribution_read_response_t>(&responses[i].response);
+            guarantee(result != NULL, "Bad boost::get\n");
+            for (const auto &pair : result->key_counts) {
+                res.key_counts[pair.first] += pair.second;
+            }
+            for (const auto &pair : result->key_bytes) {
+                res.key_bytes[pair.first] += pair.second;
+            }
+        }
+        if (dg.result_limit > 0 && res.key_counts.size() > dg.result_limit) {
+            scale_down_distribution(dg.result_limit, &res);
+        }
+        response_out->response = res;
+        return;
+    }
+
     // TODO: do this without copying so much and/or without dynamic memory
     // Sort results by region
     std::vector<distribution_read_response_t> results(count);
@@ -957,6 +988,8 @@ void rdb_r_unshard_visitor_t::operator()(const distribution_read_t &dg) {
         size_t largest_index = i;
         size_t largest_size = 0;
         size_t total_range_keys = 0;
+        int64_t largest_bytes = 0;
+        int64_t total_range_bytes = 0;
 
         while (i < results.size() && results[i].region.inner == range) {
             size_t tmp_total_keys = 0;
@@ -965,13 +998,19 @@ void rdb_r_unshard_visitor_t::operator()(const distribution_read_t &dg) {
                  ++mit) {
                 tmp_total_keys += mit->second;
             }
+            int64_t tmp_total_bytes = 0;
+            for (const auto &pair : results[i].key_bytes) {
+                tmp_total_bytes += pair.second;
+            }
 
             if (tmp_total_keys > largest_size) {
                 largest_size = tmp_total_keys;
                 largest_index = i;
+                largest_bytes = tmp_total_bytes;
             }
 
             total_range_keys += tmp_total_keys;
+            total_range_bytes += tmp_total_bytes;
             ++i;
         }
 
@@ -989,16 +1028,30 @@ void rdb_r_unshard_visitor_t::operator()(const distribution_read_t &dg) {
                 mit->second = static_cast<int64_t>(mit->second * scale_factor);
             }
 
+            // The documents of the hash shards may differ in size, so the bytes are
+            // scaled by their own factor.
+            if (largest_bytes > 0) {
+                double bytes_scale_factor =
+                    static_cast<double>(total_range_bytes)
+                    / static_cast<double>(largest_bytes);
+                for (auto &pair : results[largest_index].key_bytes) {
+                    pair.second = static_cast<int64_t>(pair.second * bytes_scale_factor);
+                }
+            }
+
             // TODO: move semantics.
             res.key_counts.insert(
                 results[largest_index].key_counts.begin(),
                 results[largest_index].key_counts.end());
+            res.key_bytes.insert(
+                results[largest_index].key_bytes.begin(),
+                results[largest_index].key_bytes.end());
         }
     }
 
     // If the result is larger than the requested limit, scale it down
     if (dg.result_limit > 0 && res.key_counts.size() > dg.result_limit) {
-        scale_down_distribution(dg.result_limit, &res.key_counts);
+        scale_down_distribution(dg.result_limit, &res);
     }
 
     response_out->response = res;
@@ -1436,7 +1489,8 @@ ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
 RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
     rget_read_response_t, stamp_response, result, reql_version);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(nearest_geo_read_response_t, results_or_error);
-RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(distribution_read_response_t, region, key_counts);
+RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
+    distribution_read_response_t, region, key_counts, key_bytes);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(
     changefeed_subscribe_response_t, server_uuids, addrs);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(
@@ -1503,8 +1557,8 @@ RDB_IMPL_SERIALIZABLE_9_FOR_CLUSTER(
     table_name,
     sindex_id);
 
-RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
-        distribution_read_t, max_depth, result_limit, region);
+RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(
+        distribution_read_t, max_depth, result_limit, region, sindex_id);
 
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(changefeed_subscribe_t, addr, shard_region);
 RDB_IMPL_SERIALIZABLE_8_FOR_CLUSTER(
@@ -1520,7 +1574,8 @@ RDB_IMPL_SERIALIZABLE_8_FOR_CLUSTER(
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(changefeed_stamp_t, addr, region);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(changefeed_point_stamp_t, addr, key);
 
-RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(read_t, read, profile, read_mode);
+RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(
+    read_t, read, profile, read_mode, max_staleness_ms);
 
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(point_write_response_t, result);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(point_delete_response_t, result);
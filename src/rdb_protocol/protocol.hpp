@@ -151,8 +151,6 @@ struct nearest_geo_read_response_t {
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(nearest_geo_read_response_t);
 
-void scale_down_distribution(size_t result_limit, std::map<store_key_t, int64_t> *key_counts);
-
 struct distribution_read_response_t {
     // Supposing the map has keys:
     // k1, k2 ... kn
@@ -162,9 +160,15 @@ struct distribution_read_response_t {
     // key_counts[kn] = the number of keys in [kn, right_key)
     region_t region;
     std::map<store_key_t, int64_t> key_counts;
+    // The same ranges as `key_counts`, with the number of bytes that the keys and
+    // their documents in each range take up.
+    std::map<store_key_t, int64_t> key_bytes;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(distribution_read_response_t);
 
+void scale_down_distribution(size_t result_limit,
+                             distribution_read_response_t *distribution);
+
 struct changefeed_subscribe_response_t {
     changefeed_subscribe_response_t() { }
     std::set<uuid_u> server_uuids;
@@ -426,10 +430,20 @@ public:
         : max_depth(_max_depth), result_limit(_result_limit),
           region(region_t::universe())
     { }
+    distribution_read_t(int _max_depth, size_t _result_limit,
+                        const std::string &_sindex_id)
+        : max_depth(_max_depth), result_limit(_result_limit),
+          region(region_t::universe()), sindex_id(_sindex_id)
+    { }
 
     int max_depth;
     size_t result_limit;
     region_t region;
+
+    /* If set, the distribution is computed over the keys of this secondary index
+    instead of over the primary keys. `region` still determines which shards are
+    asked, and the per-shard results are summed up rather than concatenated. */
+    boost::optional<std::string> sindex_id;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(distribution_read_t);
 
@@ -492,6 +506,9 @@ struct read_t {
     variant_t read;
     profile_bool_t profile;
     read_mode_t read_mode;
+    /* If set, an `OUTDATED` read may only be served by a replica that lags at most this
+    many milliseconds behind the primary replica. */
+    boost::optional<uint64_t> max_staleness_ms;
 
     region_t get_region() const THROWS_NOTHING;
     // Returns true if the read has any operation for this region.  Returns
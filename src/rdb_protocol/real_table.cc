@@ -74,6 +74,10 @@ const std::string &real_table_t::get_pkey() const {
     return pkey;
 }
 
+void real_table_t::set_max_staleness_ms(uint64_t ms) {
+    max_staleness_ms = ms;
+}
+
 ql::datum_t real_table_t::read_row(
     ql::env_t *env, ql::datum_t pval, read_mode_t read_mode) {
     read_t read(point_read_t(store_key_t(pval.print_primary())),
@@ -235,6 +239,30 @@ ql::datum_t real_table_t::read_nearest(
     return std::move(formatted_result).to_datum();
 }
 
+std::map<store_key_t, int64_t> real_table_t::read_sindex_distribution(
+        ql::env_t *env,
+        const std::string &sindex) {
+    /* The same parameters as `fetch_distribution()` uses for the primary index. */
+    static const int max_depth = 2;
+    static const size_t result_limit = 128;
+    distribution_read_t dist_read(max_depth, result_limit, sindex);
+    read_t read(dist_read, profile_bool_t::DONT_PROFILE, read_mode_t::OUTDATED);
+    read_response_t res;
+    try {
+        namespace_access.get()->read(
+            env->get_user_context(), read, &res, order_token_t::ignore, env->interruptor);
+    } catch (const cannot_perform_query_exc_t &) {
+        /* The estimate is optional, so we don't fail the query over it. */
+        return std::map<store_key_t, int64_t>();
+    } catch (auth::permission_error_t const &error) {
+        rfail_datum(ql::base_exc_t::PERMISSION_ERROR, "%s", error.what());
+    }
+    distribution_read_response_t *d_res =
+        boost::get<distribution_read_response_t>(&res.response);
+    r_sanity_check(d_res);
+    return std::move(d_res->key_counts);
+}
+
 const size_t split_size = 128;
 template<class T>
 std::vector<std::vector<T> > split(std::vector<T> &&v) {
@@ -374,11 +402,20 @@ void real_table_t::read_with_profile(ql::env_t *env, const read_t &read,
     /* propagate whether or not we're doing profiles */
     r_sanity_check(read.profile == env->profile());
 
+    /* Bound the staleness of outdated reads, if the query asked us to. */
+    read_t bounded_read;
+    const read_t *read_to_send = &read;
+    if (read.read_mode == read_mode_t::OUTDATED && static_cast<bool>(max_staleness_ms)) {
+        bounded_read = read;
+        bounded_read.max_staleness_ms = max_staleness_ms;
+        read_to_send = &bounded_read;
+    }
+
     /* Do the actual read. */
     try {
         namespace_access.get()->read(
             env->get_user_context(),
-            read,
+            *read_to_send,
             response,
             order_token_t::ignore,
             env->interruptor);
@@ -72,6 +72,8 @@ public:
     namespace_id_t get_id() const;
     const std::string &get_pkey() const;
 
+    void set_max_staleness_ms(uint64_t ms);
+
     ql::datum_t read_row(ql::env_t *env, ql::datum_t pval, read_mode_t read_mode);
     counted_t<ql::datum_stream_t> read_all(
         ql::env_t *env,
@@ -103,6 +105,9 @@ public:
         const ellipsoid_spec_t &geo_system,
         dist_unit_t dist_unit,
         const ql::configured_limits_t &limits);
+    std::map<store_key_t, int64_t> read_sindex_distribution(
+        ql::env_t *env,
+        const std::string &sindex);
 
     ql::datum_t write_batched_replace(
         ql::env_t *env,
@@ -148,6 +153,8 @@ private:
     std::string pkey;
     ql::changefeed::client_t *changefeed_client;
     table_meta_client_t *m_table_meta_client;
+    /* `read_with_profile()` adds this to the outdated reads. */
+    boost::optional<uint64_t> max_staleness_ms;
 };
 
 #endif /* RDB_PROTOCOL_REAL_TABLE_HPP_ */
@@ -966,6 +966,175 @@ size_t datum_get_element_offset(const shared_buf_ref_t<char> &array, size_t inde
     }
 }
 
+size_t offset_serialized_size(datum_offset_size_t offset_size) {
+    switch (offset_size) {
+    case datum_offset_size_t::U8BIT:
+        return serialize_universal_size_t<uint8_t>::value;
+    case datum_offset_size_t::U16BIT:
+        return serialize_universal_size_t<uint16_t>::value;
+    case datum_offset_size_t::U32BIT:
+        return serialize_universal_size_t<uint32_t>::value;
+    case datum_offset_size_t::U64BIT:
+        return serialize_universal_size_t<uint64_t>::value;
+    default:
+        unreachable();
+    }
+}
+
+template <class T>
+uint64_t deserialize_offset(read_stream_t *s) {
+    T off;
+    guarantee_deserialization(deserialize_universal(s, &off), "datum decode offset");
+    return off;
+}
+
+/* The format of a serialized object is:
+     datum_serialized_type_t type (BUF_R_OBJECT)
+     varint ser_size
+     varint num_elements
+     uint*_t offsets[num_elements - 1] // counted from `data`, first pair omitted
+     (datum_string_t, datum_t) data[num_elements] // sorted by key */
+datum_t datum_deserialize_fields(size_t serialized_size,
+                                 const datum_region_reader_t &read_region,
+                                 const std::vector<datum_string_t> &fields,
+                                 size_t *bytes_read_out) {
+    *bytes_read_out = 0;
+    auto read = [&](size_t offset, size_t size, std::vector<char> *out) {
+        guarantee(offset <= serialized_size && size <= serialized_size - offset,
+                  "Corrupted datum: region out of bounds.");
+        out->resize(size);
+        if (size > 0) {
+            read_region(offset, size, out->data());
+        }
+        *bytes_read_out += size;
+    };
+
+    // The type and the two varints.
+    const size_t max_varint_size = 10;
+    std::vector<char> header;
+    read(0, std::min(serialized_size, 1 + 2 * max_varint_size), &header);
+    buffer_read_stream_t header_stream(header.data(), header.size());
+    datum_serialized_type_t type = datum_serialized_type_t::R_NULL;
+    guarantee_deserialization(datum_deserialize(&header_stream, &type), "datum type");
+    if (type != datum_serialized_type_t::BUF_R_OBJECT) {
+        return datum_t();
+    }
+    uint64_t ser_size = 0;
+    guarantee_deserialization(deserialize_varint_uint64(&header_stream, &ser_size),
+                              "datum decode object");
+    const size_t inner_offset = static_cast<size_t>(header_stream.tell());
+    guarantee(ser_size <= serialized_size - inner_offset,
+              "Corrupted datum: object larger than its buffer.");
+    const size_t inner_end = inner_offset + static_cast<size_t>(ser_size);
+    uint64_t num_elements = 0;
+    guarantee_deserialization(deserialize_varint_uint64(&header_stream, &num_elements),
+                              "datum decode object");
+    if (num_elements == 0) {
+        return datum_t();
+    }
+    const size_t table_offset = static_cast<size_t>(header_stream.tell());
+    guarantee(table_offset <= inner_end, "Corrupted datum: truncated object.");
+    const size_t offset_size = offset_serialized_size(
+        get_offset_size_from_inner_size(ser_size));
+    guarantee(num_elements - 1 <= (inner_end - table_offset) / offset_size,
+              "Corrupted datum: offset table larger than the object.");
+    const size_t n = static_cast<size_t>(num_elements);
+    const size_t data_offset = table_offset + (n - 1) * offset_size;
+
+    std::vector<char> table;
+    read(table_offset, (n - 1) * offset_size, &table);
+    buffer_read_stream_t table_stream(table.data(), table.size());
+    std::vector<size_t> pair_offsets(n + 1);
+    pair_offsets[0] = data_offset;
+    for (size_t i = 1; i < n; ++i) {
+        uint64_t off;
+        switch (get_offset_size_from_inner_size(ser_size)) {
+        case datum_offset_size_t::U8BIT:
+            off = deserialize_offset<uint8_t>(&table_stream); break;
+        case datum_offset_size_t::U16BIT:
+            off = deserialize_offset<uint16_t>(&table_stream); break;
+        case datum_offset_size_t::U32BIT:
+            off = deserialize_offset<uint32_t>(&table_stream); break;
+        case datum_offset_size_t::U64BIT:
+            off = deserialize_offset<uint64_t>(&table_stream); break;
+        default:
+            unreachable();
+        }
+        guarantee(off <= inner_end - data_offset,
+                  "Corrupted datum: offset out of bounds.");
+        pair_offsets[i] = data_offset + static_cast<size_t>(off);
+        guarantee(pair_offsets[i - 1] <= pair_offsets[i],
+                  "Corrupted datum: offsets out of order.");
+    }
+    pair_offsets[n] = inner_end;
+
+    // Binary search for `key`, reading just enough of each probed key to compare it.
+    // Returns the index of the pair and sets `*key_size_out` to the serialized size of
+    // its key, or returns `n` if there is no such key.
+    std::vector<char> probe;
+    auto find_pair = [&](const datum_string_t &key, size_t *key_size_out) -> size_t {
+        size_t range_beg = 0;
+        size_t range_end = n;
+        while (range_beg < range_end) {
+            const size_t center = range_beg + ((range_end - range_beg) / 2);
+            const size_t pair_size = pair_offsets[center + 1] - pair_offsets[center];
+            read(pair_offsets[center],
+                 std::min(pair_size, max_varint_size + key.size() + 1),
+                 &probe);
+            buffer_read_stream_t probe_stream(probe.data(), probe.size());
+            uint64_t center_key_size = 0;
+            guarantee_deserialization(
+                deserialize_varint_uint64(&probe_stream, &center_key_size),
+                "datum decode object key");
+            const size_t key_data_offset = static_cast<size_t>(probe_stream.tell());
+            guarantee(center_key_size <= pair_size - key_data_offset,
+                      "Corrupted datum: key larger than its pair.");
+            // We have read at least `min(key.size() + 1, center_key_size)` bytes of
+            // the key, which is enough to compare it with `key`.
+            const size_t common_size =
+                std::min<size_t>(key.size(), static_cast<size_t>(center_key_size));
+            int cmp_res = memcmp(key.data(), probe.data() + key_data_offset,
+                                 common_size);
+            if (cmp_res == 0) {
+                cmp_res = key.size() < center_key_size ? -1
+                    : (key.size() > center_key_size ? 1 : 0);
+            }
+            if (cmp_res == 0) {
+                *key_size_out = key_data_offset + static_cast<size_t>(center_key_size);
+                return center;
+            } else if (cmp_res < 0) {
+                range_end = center;
+            } else {
+                range_beg = center + 1;
+            }
+        }
+        return n;
+    };
+
+    size_t key_size;
+    if (find_pair(datum_t::reql_type_string, &key_size) != n) {
+        return datum_t();
+    }
+    datum_object_builder_t builder;
+    for (const datum_string_t &field : fields) {
+        const size_t index = find_pair(field, &key_size);
+        if (index == n) {
+            return datum_t();
+        }
+        const size_t value_offset = pair_offsets[index] + key_size;
+        const size_t value_size = pair_offsets[index + 1] - value_offset;
+        guarantee(value_size > 0, "Corrupted datum: empty value.");
+        // The value keeps its buffer representation, so nested objects and arrays
+        // are again only parsed when they are accessed.
+        counted_t<shared_buf_t> buf = shared_buf_t::create(value_size);
+        read_region(value_offset, value_size, buf->data());
+        *bytes_read_out += value_size;
+        builder.overwrite(field, datum_deserialize_from_buf(
+            shared_buf_ref_t<char>(std::move(buf), 0), 0));
+    }
+    return std::move(builder).to_datum();
+}
+
 size_t datum_serialized_size(const datum_string_t &s) {
     const size_t s_size = s.size();
     return varint_uint64_serialized_size(s_size) + s_size;
@@ -1,7 +1,9 @@
 #ifndef RDB_PROTOCOL_SERIALIZE_DATUM_HPP_
 #define RDB_PROTOCOL_SERIALIZE_DATUM_HPP_
 
+#include <functional>
 #include <utility>
+#include <vector>
 
 #include "containers/archive/archive.hpp"
 #include "containers/archive/buffer_group_stream.hpp"
@@ -58,6 +60,20 @@ size_t datum_get_element_offset(const shared_buf_ref_t<char> &array, size_t inde
 // Reads the number of elements in the array stored in the buffer
 size_t datum_get_array_size(const shared_buf_ref_t<char> &array);
 
+// Deserializes only the top-level fields `fields` (which must be sorted) of an object
+// that `datum_serialize` wrote into `serialized_size` bytes, using the offset table to
+// find them.  The bytes are read through `read_region(offset, size, out)`, so the rest
+// of the object is never copied or parsed.  Returns an object with just those fields,
+// or an empty datum if the serialized datum is not an object in the buffer format,
+// lacks one of the fields or is a pseudotype.  `*bytes_read_out` is set to the number
+// of bytes that were read either way.
+typedef std::function<void(size_t offset, size_t size, char *out)>
+    datum_region_reader_t;
+datum_t datum_deserialize_fields(size_t serialized_size,
+                                 const datum_region_reader_t &read_region,
+                                 const std::vector<datum_string_t> &fields,
+                                 size_t *bytes_read_out);
+
 size_t datum_serialized_size(const datum_string_t &s);
 serialization_result_t datum_serialize(write_message_t *wm, const datum_string_t &s);
 
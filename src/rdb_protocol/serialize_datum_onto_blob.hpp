@@ -22,6 +22,20 @@ datum_serialize_onto_blob(buf_parent_t parent, blob_t *blob,
     return res;
 }
 
+// Like datum_serialize_onto_blob, for a value that replaces the value of old_blob.
+inline ql::serialization_result_t
+datum_serialize_onto_blob_reusing_blocks(buf_parent_t parent, blob_t *blob,
+                                         const blob_t &old_blob,
+                                         const ql::datum_t &value) {
+    write_message_t wm;
+    ql::serialization_result_t res =
+        datum_serialize(&wm, value,
+                        ql::check_datum_serialization_errors_t::YES);
+    if (bad(res)) return res;
+    write_onto_blob_reusing_blocks(parent, blob, old_blob, wm);
+    return res;
+}
+
 inline void datum_deserialize_from_group(const const_buffer_group_t *group,
                                          ql::datum_t *value_out) {
     buffer_group_read_stream_t stream(group);
@@ -11,6 +11,7 @@
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/profile.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/vectorized_func.hpp"
 
 bool reversed(sorting_t sorting) { return sorting == sorting_t::DESCENDING; }
 
@@ -981,14 +982,30 @@ private:
     backtrace_id_t bt;
 };
 
+// Whether to evaluate a transform on the whole batch with a `vectorized_func_t`.
+// For a single row (e.g. from an ordered scan on a shard) this would only add
+// overhead, and the term tree has to run for the profile to show up.
+bool use_vectorized(const scoped_ptr_t<vectorized_func_t> &vf,
+                    env_t *env,
+                    const datums_t &lst) {
+    return vf.has() && lst.size() > 1 && env->profile() == profile_bool_t::DONT_PROFILE;
+}
+
 class map_trans_t : public ungrouped_op_t {
 public:
     explicit map_trans_t(const map_wire_func_t &_f)
-        : f(_f.compile_wire_func()) { }
+        : f(_f.compile_wire_func()),
+          vf(vectorized_func_t::make(f)) { }
 private:
     virtual void lst_transform(
         env_t *env, datums_t *lst, const std::function<datum_t()> &) {
         try {
+            if (use_vectorized(vf, env, *lst)) {
+                vf->map(env, lst, [&](const datum_t &row) {
+                    return f->call(env, row)->as_datum();
+                });
+                return;
+            }
             for (auto it = lst->begin(); it != lst->end(); ++it) {
                 *it = f->call(env, *it)->as_datum();
             }
@@ -997,6 +1014,7 @@ private:
         }
     }
     counted_t<const func_t> f;
+    scoped_ptr_t<vectorized_func_t> vf;
 };
 
 // Note: this removes duplicates ONLY TO SAVE NETWORK TRAFFIC.  It's possible
@@ -1037,10 +1055,21 @@ public:
         : f(_f.filter_func.compile_wire_func()),
           default_val(_f.default_filter_val
                       ? _f.default_filter_val->compile_wire_func()
-                      : counted_t<const func_t>()) { }
+                      : counted_t<const func_t>()),
+          vf(vectorized_func_t::make(f)) { }
 private:
     virtual void lst_transform(
         env_t *env, datums_t *lst, const std::function<datum_t()> &) {
+        if (use_vectorized(vf, env, *lst)) {
+            try {
+                vf->filter(env, lst, [&](const datum_t &row) {
+                    return f->filter_call(env, row, default_val);
+                });
+            } catch (const datum_exc_t &e) {
+                throw exc_t(e, f->backtrace(), 1);
+            }
+            return;
+        }
         auto it = lst->begin();
         auto loc = it;
         try {
@@ -1056,6 +1085,7 @@ private:
         lst->erase(loc, lst->end());
     }
     counted_t<const func_t> f, default_val;
+    scoped_ptr_t<vectorized_func_t> vf;
 };
 
 class concatmap_trans_t : public ungrouped_op_t {
@@ -635,12 +635,33 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
     void operator()(const distribution_read_t &dg) {
         response->response = distribution_read_response_t();
         distribution_read_response_t *res = boost::get<distribution_read_response_t>(&response->response);
+        res->region = dg.region;
+        if (static_cast<bool>(dg.sindex_id)) {
+            sindex_disk_info_t sindex_info;
+            uuid_u sindex_uuid;
+            scoped_ptr_t<sindex_superblock_t> sindex_sb;
+            try {
+                sindex_sb = acquire_sindex_for_read(
+                    store, superblock, "", *dg.sindex_id, &sindex_info, &sindex_uuid);
+            } catch (const ql::exc_t &) {
+                // The index is missing or not ready yet. Distribution reads are only
+                // used for estimates, so we just return an empty sample.
+                return;
+            }
+            rdb_distribution_get(dg.max_depth, store_key_t::min(),
+                                 sindex_sb.get(), res);
+            if (dg.result_limit > 0 && res->key_counts.size() > dg.result_limit) {
+                scale_down_distribution(dg.result_limit, res);
+            }
+            return;
+        }
         rdb_distribution_get(dg.max_depth, dg.region.inner.left,
                              superblock, res);
         for (std::map<store_key_t, int64_t>::iterator it = res->key_counts.begin(); it != res->key_counts.end(); ) {
             if (!dg.region.inner.contains_key(store_key_t(it->first))) {
                 std::map<store_key_t, int64_t>::iterator tmp = it;
                 ++it;
+                res->key_bytes.erase(tmp->first);
                 res->key_counts.erase(tmp);
             } else {
                 ++it;
@@ -649,10 +670,8 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
 
         // If the result is larger than the requested limit, scale it down
         if (dg.result_limit > 0 && res->key_counts.size() > dg.result_limit) {
-            scale_down_distribution(dg.result_limit, &res->key_counts);
+            scale_down_distribution(dg.result_limit, res);
         }
-
-        res->region = dg.region;
     }
 
     void operator()(const dummy_read_t &) {
@@ -754,6 +773,7 @@ public:
                                        conflict_func);
     }
     return_changes_t should_return_changes() const { return return_changes; }
+    bool replaces_missing_rows_with_given_values() const { return true; }
 private:
     ql::env_t *env;
     const std::vector<ql::datum_t> *const datums;
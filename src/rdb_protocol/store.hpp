@@ -3,6 +3,7 @@
 #define RDB_PROTOCOL_STORE_HPP_
 
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -298,6 +299,12 @@ public:
         return secondary_index_slices.at(id).get();
     }
 
+    // Returns the deserialized definition of `sindex`. Deserializing a definition
+    // compiles the index function, so writes get it from here instead of doing that
+    // every time.
+    std::shared_ptr<const sindex_disk_info_t> get_sindex_info(
+            const secondary_index_t &sindex);
+
     void protocol_read(const read_t &read,
                        read_response_t *response,
                        real_superblock_t *superblock,
@@ -431,6 +438,13 @@ private:
 
     sindex_context_map_t sindex_context;
 
+    // Cache for `get_sindex_info()`. The definition of an index can change (see
+    // `update_sindex_last_compatible_version()`), so we also keep the serialized
+    // definition that each entry was deserialized from.
+    std::map<uuid_u, std::pair<std::vector<char>,
+                               std::shared_ptr<const sindex_disk_info_t> > >
+        sindex_info_cache;
+
     // Having a lot of writes queued up waiting for the superblock to become available
     // can stall reads for unacceptably long time periods.
     // We use this semaphore to limit the number of writes that can be in line for a
@@ -208,18 +208,23 @@ void apply_item_pair(
     }
 }
 
-/* `apply_single_key_item()` applies a `backfill_item_t` whose range is a single key wide
-and which has a `backfill_item_t::pair_t` for that key. This eliminates the need to erase
-the previous contents of the range.
-
-Note that multiple calls to `apply_single_key_item()` can be pipelined efficiently,
-because it releases the superblock as soon as it acquires the next node in the B-tree. */
-void apply_single_key_item(
+/* `apply_single_key_items()` applies a batch of consecutive `backfill_item_t`s whose
+ranges are a single key wide and which have a `backfill_item_t::pair_t` for that key.
+This eliminates the need to erase the previous contents of the ranges. The whole batch
+goes into a single transaction, which updates the metainfo only once; since the keys are
+consecutive, they are mostly in the same leaf node.
+
+Note that multiple calls to `apply_single_key_items()` can be pipelined efficiently,
+because it releases the superblock as soon as it acquires the leaf node for the last key
+in the B-tree. */
+void apply_single_key_items(
         const receive_backfill_tokens_t &tokens,
-        /* `item` is conceptually passed by move, but `std::bind()` isn't smart enough to
+        /* `items` is conceptually passed by move, but `std::bind()` isn't smart enough to
         handle that. */
-        backfill_item_t &item   // NOLINT runtime/references
+        std::vector<backfill_item_t> &items   // NOLINT runtime/references
         ) {
+    guarantee(!items.empty());
+    const key_range_t::right_bound_t &progress = items.back().range.right;
     try {
         /* Acquire the superblock */
         scoped_ptr_t<txn_t> txn;
@@ -234,22 +239,29 @@ void apply_single_key_item(
             deadlocks; acquiring `limiter` only when we also hold `btree_fifo_sink` is
             sufficient to prevent deadlocks. */
             tokens.info->limiter->prepare_for_changes(
-                1, tokens.keepalive.get_drain_signal());
+                items.size(), tokens.keepalive.get_drain_signal());
 
             get_btree_superblock_and_txn_for_writing(tokens.info->cache_conn, nullptr,
-                write_access_t::write, 1, write_durability_t::SOFT, &superblock, &txn);
+                write_access_t::write, items.size(), write_durability_t::SOFT,
+                &superblock, &txn);
 
             /* Acquire the sindex block and update the metainfo now, because we'll
             release the superblock soon */
             sindex_block = buf_lock_t(superblock->expose_buf(),
                 superblock->get_sindex_block_id(), access_t::write);
-            tokens.update_metainfo_cb(item.range.right, superblock.get());
+            tokens.update_metainfo_cb(progress, superblock.get());
         }
 
-        /* Actually apply the change, releasing the superblock in the process. */
+        /* Actually apply the changes, releasing the superblock with the last one. */
         std::vector<rdb_modification_report_t> mod_reports;
+        for (size_t i = 0; i + 1 < items.size(); ++i) {
+            promise_t<superblock_t *> pass_back_superblock;
+            apply_item_pair(tokens.info->slice, superblock.get(),
+                std::move(items[i].pairs[0]), &mod_reports, &pass_back_superblock);
+            guarantee(superblock.get() == pass_back_superblock.assert_get_value());
+        }
         apply_item_pair(tokens.info->slice, superblock.get(),
-            std::move(item.pairs[0]), &mod_reports, nullptr);
+            std::move(items.back().pairs[0]), &mod_reports, nullptr);
 
         /* Notify that we're done and update the sindexes */
         fifo_enforcer_sink_t::exit_write_t exiter(
@@ -257,7 +269,7 @@ void apply_single_key_item(
         /* Note: This must not be interruptible, or we might miss updating secondary
         indexes. */
         exiter.wait_lazily_unordered();
-        tokens.commit_cb(item.range.right, std::move(txn), std::move(sindex_block),
+        tokens.commit_cb(progress, std::move(txn), std::move(sindex_block),
             std::move(mod_reports));
 
     } catch (const interrupted_exc_t &exc) {
@@ -395,13 +407,26 @@ continue_bool_t store_t::receive_backfill(
     /* We'll set `result` to `false` to record if `item_producer` returns `ABORT`. */
     continue_bool_t result = continue_bool_t::CONTINUE;
 
+    /* When we batch up single-key items, we have to look at the item after the batch
+    before we know that the batch is over. If that item doesn't belong to the batch,
+    it's kept here for the next loop iteration. */
+    bool have_next = false;
+    bool next_is_item;
+    backfill_item_t next_item;
+    key_range_t::right_bound_t next_empty_range;
+
     /* Repeatedly request items from `item_producer` and spawn coroutines to handle them,
     but limit the number of simultaneously active coroutines. */
     while (spawn_threshold != _region.inner.right) {
         bool is_item;
         backfill_item_t item;
         key_range_t::right_bound_t empty_range;
-        if (continue_bool_t::ABORT ==
+        if (have_next) {
+            is_item = next_is_item;
+            item = std::move(next_item);
+            empty_range = next_empty_range;
+            have_next = false;
+        } else if (continue_bool_t::ABORT ==
                 item_producer->next_item(&is_item, &item, &empty_range)) {
             /* By breaking out of the loop instead of returning immediately, we ensure
             that we commit every item that we got from the item producer, as we are
@@ -410,9 +435,35 @@ continue_bool_t store_t::receive_backfill(
             break;
         }
 
+        /* Batch up consecutive single-key items, so that they're applied in a single
+        transaction. */
+        std::vector<backfill_item_t> batch;
+        if (is_item && item.is_single_key()) {
+            batch.push_back(std::move(item));
+            while (batch.size() < MAX_CHANGES_PER_TXN
+                    && batch.back().range.right != _region.inner.right) {
+                if (continue_bool_t::ABORT == item_producer->next_item(
+                        &next_is_item, &next_item, &next_empty_range)) {
+                    /* We'll break out of the loop after we spawn the batch. */
+                    result = continue_bool_t::ABORT;
+                    break;
+                }
+                if (next_is_item && next_item.is_single_key()) {
+                    batch.push_back(std::move(next_item));
+                } else {
+                    have_next = true;
+                    break;
+                }
+            }
+        }
+
         receive_backfill_tokens_t tokens(&info, interruptor);
 
-        if (is_item) {
+        if (!batch.empty()) {
+            rassert(key_range_t::right_bound_t(batch.front().get_range().left)
+                >= spawn_threshold);
+            spawn_threshold = batch.back().get_range().right;
+        } else if (is_item) {
             rassert(key_range_t::right_bound_t(item.get_range().left)
                 >= spawn_threshold);
             spawn_threshold = item.get_range().right;
@@ -475,13 +526,17 @@ continue_bool_t store_t::receive_backfill(
         if (!is_item) {
             coro_t::spawn_sometime(std::bind(
                 &apply_empty_range, std::move(tokens), empty_range));
-        } else if (item.is_single_key()) {
+        } else if (!batch.empty()) {
             coro_t::spawn_sometime(std::bind(
-                &apply_single_key_item, std::move(tokens), std::move(item)));
+                &apply_single_key_items, std::move(tokens), std::move(batch)));
         } else {
             coro_t::spawn_sometime(std::bind(
                 &apply_multi_key_item, std::move(tokens), std::move(item)));
         }
+
+        if (result == continue_bool_t::ABORT) {
+            break;
+        }
     }
 
     /* Wait for any running coroutines to finish. We construct an `exit_write_t` instead
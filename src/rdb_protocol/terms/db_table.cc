@@ -824,10 +824,12 @@ class table_term_t : public op_term_t {
 public:
     table_term_t(compile_env_t *env, const raw_term_t &term)
         : op_term_t(env, term, argspec_t(1, 2),
-                    optargspec_t({"read_mode", "use_outdated", "identifier_format"})) { }
+                    optargspec_t({"read_mode", "use_outdated", "identifier_format",
+                                  "max_staleness"})) { }
 private:
     virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
         read_mode_t read_mode = read_mode_t::SINGLE;
+        bool has_read_mode = false;
         if (scoped_ptr_t<val_t> v = args->optarg(env, "use_outdated")) {
             rfail(base_exc_t::LOGIC, "%s",
                   "The `use_outdated` optarg is no longer supported.  "
@@ -848,6 +850,25 @@ private:
                       "are \"majority\", \"single\", and \"outdated\").",
                       str.to_std().c_str());
             }
+            has_read_mode = true;
+        }
+
+        /* `max_staleness` allows the reads to go to any replica that lags at most that
+        many seconds behind the primary replica. It implies `read_mode="outdated"`.
+        The upper bound keeps the conversion to milliseconds in range; a replica that
+        lags by a day is as good as one whose lag is unknown anyway. */
+        static const double MAX_STALENESS_SECS = 24 * 60 * 60;
+        boost::optional<uint64_t> max_staleness_ms;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "max_staleness")) {
+            const double secs = v->as_num();
+            rcheck(secs >= 0 && secs <= MAX_STALENESS_SECS, base_exc_t::LOGIC,
+                   strprintf("`max_staleness` must be a number of seconds between 0 "
+                             "and %.0f (got %f).", MAX_STALENESS_SECS, secs));
+            rcheck(!has_read_mode || read_mode == read_mode_t::OUTDATED,
+                   base_exc_t::LOGIC,
+                   "`max_staleness` can only be used with `read_mode=\"outdated\"`.");
+            read_mode = read_mode_t::OUTDATED;
+            max_staleness_ms = static_cast<uint64_t>(secs * 1000);
         }
 
         auto identifier_format =
@@ -884,6 +905,9 @@ private:
                 identifier_format, env->env->interruptor, &table, &error)) {
             REQL_RETHROW(error);
         }
+        if (static_cast<bool>(max_staleness_ms)) {
+            table->set_max_staleness_ms(*max_staleness_ms);
+        }
         return new_val(make_counted<table_t>(
             std::move(table), db, table_name.str(), read_mode, backtrace()));
     }
@@ -1,12 +1,16 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/terms/terms.hpp"
 
+#include <math.h>
+
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "parsing/utf8.hpp"
+#include "rdb_protocol/distinct.hpp"
 #include "rdb_protocol/error.hpp"
+#include "rdb_protocol/filter_pushdown.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/math_utils.hpp"
 #include "rdb_protocol/op.hpp"
@@ -122,12 +126,26 @@ private:
 class count_term_t : public grouped_seq_op_term_t {
 public:
     count_term_t(compile_env_t *env, const raw_term_t &term)
-        : grouped_seq_op_term_t(env, term, argspec_t(1, 2)) { }
+        : grouped_seq_op_term_t(env, term, argspec_t(1, 2),
+                                optargspec_t({"distinct", "approximate"})) { }
 private:
     virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args,
                                           eval_flags_t) const {
         scoped_ptr_t<val_t> v0 = args->arg(env, 0);
+        bool distinct = false;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "distinct")) {
+            distinct = v->as_bool();
+        }
+        // An exact count is always an acceptable estimate, so `approximate` only
+        // changes anything for `distinct` counts.
+        bool approximate = false;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "approximate")) {
+            approximate = v->as_bool();
+        }
         if (args->num_args() == 1) {
+            if (distinct) {
+                return count_distinct(env, v0->as_seq(env->env), approximate);
+            }
             if (v0->get_type().is_convertible(val_t::type_t::DATUM)) {
                 datum_t d = v0->as_datum();
                 switch (static_cast<int>(d.get_type())) { // TODO: See issue 5177
@@ -148,23 +166,57 @@ private:
                 ->run_terminal(env->env, count_wire_func_t());
         } else {
             scoped_ptr_t<val_t> v1 = args->arg(env, 1);
+            counted_t<const func_t> f;
             if (v1->get_type().is_convertible(val_t::type_t::FUNC)) {
-                counted_t<datum_stream_t> stream = v0->as_seq(env->env);
-                stream->add_transformation(
-                        filter_wire_func_t(v1->as_func(), boost::none),
-                        backtrace());
-                return stream->run_terminal(env->env, count_wire_func_t());
+                f = v1->as_func();
             } else {
-                counted_t<const func_t> f =
-                    new_eq_comparison_func(v1->as_datum(), backtrace());
-                counted_t<datum_stream_t> stream = v0->as_seq(env->env);
-                stream->add_transformation(
-                        filter_wire_func_t(f, boost::none), backtrace());
+                f = new_eq_comparison_func(v1->as_datum(), backtrace());
+            }
+            counted_t<datum_stream_t> stream = v0->as_seq(env->env);
+            stream->add_transformation(filter_wire_func_t(f, boost::none), backtrace());
+            if (distinct) {
+                return count_distinct(env, stream, approximate);
+            }
+            return stream->run_terminal(env->env, count_wire_func_t());
+        }
+    }
 
-                return stream->run_terminal(env->env, count_wire_func_t());
+    // Counts the distinct elements of `stream` as they stream in, without building
+    // or sorting an array of them like `distinct` has to.  The approximate count
+    // uses a fixed amount of memory however many elements there are.
+    scoped_ptr_t<val_t> count_distinct(scope_env_t *env,
+                                       counted_t<datum_stream_t> stream,
+                                       bool approximate) const {
+        batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
+        profile::sampler_t sampler("Counting distinct elements.", env->env->trace);
+        if (approximate) {
+            hyperloglog_t estimator;
+            for (;;) {
+                std::vector<datum_t> batch = stream->next_batch(env->env, batchspec);
+                if (batch.empty()) {
+                    return new_val(datum_t(round(estimator.estimate())));
+                }
+                for (const datum_t &d : batch) {
+                    estimator.add(d);
+                    sampler.new_sample();
+                }
+            }
+        }
+        datum_hash_set_t seen;
+        for (;;) {
+            std::vector<datum_t> batch = stream->next_batch(env->env, batchspec);
+            if (batch.empty()) {
+                return new_val(datum_t(safe_to_double(seen.size())));
+            }
+            for (const datum_t &d : batch) {
+                if (seen.insert(d)) {
+                    rcheck_array_size(seen, env->env->limits());
+                }
+                sampler.new_sample();
             }
         }
     }
+
     virtual const char *name() const { return "count"; }
 };
 
@@ -410,7 +462,8 @@ private:
 class filter_term_t : public grouped_seq_op_term_t {
 public:
     filter_term_t(compile_env_t *env, const raw_term_t &term)
-        : grouped_seq_op_term_t(env, term, argspec_t(2), optargspec_t({"default"})),
+        : grouped_seq_op_term_t(env, term, argspec_t(2),
+                                optargspec_t({"default", "index_pushdown"})),
           default_filter_term(lazy_literal_optarg(env, "default")) { }
 
 private:
@@ -424,6 +477,31 @@ private:
             defval = wire_func_t(default_filter_term->eval_to_func(env->scope));
         }
 
+        // A `default` makes rows without the field match, and those rows are not in
+        // any secondary index, so we can only read from an index without one.
+        bool index_pushdown = !defval;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "index_pushdown")) {
+            index_pushdown = index_pushdown && v->as_bool();
+        }
+        if (index_pushdown
+            && v0->get_type().is_convertible(val_t::type_t::TABLE_SLICE)) {
+            counted_t<table_slice_t> table_slice = v0->as_table_slice();
+            counted_t<table_slice_t> slice =
+                push_down_filter(env->env, table_slice, f);
+            if (slice.has()) {
+                // The index range only narrows down the rows, the full predicate
+                // still has to be applied to them. If the index is gone or not
+                // ready by the time we read it, we read the whole table instead.
+                counted_t<datum_stream_t> seq =
+                    make_counted<index_fallback_datum_stream_t>(
+                        slice->as_seq(env->env, backtrace()),
+                        table_slice->as_seq(env->env, backtrace()),
+                        backtrace());
+                seq->add_transformation(filter_wire_func_t(f, defval), backtrace());
+                return new_val(make_counted<selection_t>(slice->get_tbl(), seq));
+            }
+        }
+
         if (v0->get_type().is_convertible(val_t::type_t::SELECTION)) {
             counted_t<selection_t> ts = v0->as_selection(env->env);
             ts->seq->add_transformation(filter_wire_func_t(f, defval), backtrace());
@@ -1,6 +1,7 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/terms/terms.hpp"
 
+#include <algorithm>
 #include <string>
 #include <utility>
 
@@ -8,6 +9,8 @@
 #include <boost/bind.hpp>
 
 #include "rdb_protocol/datum_stream.hpp"
+#include "rdb_protocol/datum_utils.hpp"
+#include "rdb_protocol/distinct.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/minidriver.hpp"
@@ -167,22 +170,24 @@ private:
         rcheck(!idx, base_exc_t::LOGIC,
                "Can only perform an indexed distinct on a TABLE.");
         counted_t<datum_stream_t> s = v->as_seq(env->env);
-        // The reql_version matters here, because we copy `results` into `toret`
-        // in ascending order.
-        std::set<datum_t, optional_datum_less_t> results;
+        // Duplicates are dropped by hash as the elements stream in, so only the
+        // distinct elements are kept and have to be sorted.
+        datum_hash_set_t seen;
+        std::vector<datum_t> toret;
         batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
         {
             profile::sampler_t sampler("Evaluating elements in distinct.",
                                        env->env->trace);
             datum_t d;
             while (d = s->next(env->env, batchspec), d.has()) {
-                results.insert(std::move(d));
-                rcheck_array_size(results, env->env->limits());
+                if (seen.insert(d)) {
+                    toret.push_back(std::move(d));
+                    rcheck_array_size(toret, env->env->limits());
+                }
                 sampler.new_sample();
             }
         }
-        std::vector<datum_t> toret;
-        std::move(results.begin(), results.end(), std::back_inserter(toret));
+        std::sort(toret.begin(), toret.end(), optional_datum_less_t());
         return new_val(datum_t(std::move(toret), env->env->limits()));
     }
 
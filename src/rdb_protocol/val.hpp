@@ -127,6 +127,8 @@ public:
     counted_t<table_slice_t> with_bounds(std::string idx, datum_range_t bounds);
     const counted_t<table_t> &get_tbl() const { return tbl; }
     const boost::optional<std::string> &get_idx() const { return idx; }
+    sorting_t get_sorting() const { return sorting; }
+    const datum_range_t &get_bounds() const { return bounds; }
     ql::changefeed::keyspec_t::range_t get_range_spec();
 private:
     friend class info_term_t;
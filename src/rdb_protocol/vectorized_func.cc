@@ -0,0 +1,208 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "rdb_protocol/vectorized_func.hpp"
+
+#include <string>
+
+#include "concurrency/interruptor.hpp"
+#include "rdb_protocol/bytecode.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/filter_pushdown.hpp"
+#include "rdb_protocol/func.hpp"
+
+namespace ql {
+
+class vectorized_func_builder_t {
+public:
+    explicit vectorized_func_builder_t(sym_t _arg) : arg(_arg) { }
+
+    // Collects the comparisons of an `and` of comparisons, in evaluation order.
+    bool add_conjunction(const raw_term_t &term) {
+        if (term.type() == Term::AND) {
+            if (term.num_args() == 0 || term.num_optargs() != 0) {
+                return false;
+            }
+            for (size_t i = 0; i < term.num_args(); ++i) {
+                if (!add_conjunction(term.arg(i))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        return add_comparison(term);
+    }
+
+    size_t add_field(const std::string &field) {
+        datum_string_t str(field);
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (fields[i] == str) {
+                return i;
+            }
+        }
+        fields.push_back(str);
+        return fields.size() - 1;
+    }
+
+    std::vector<datum_string_t> fields;
+    std::vector<std::pair<size_t, std::pair<Term::TermType, datum_t> > > comparisons;
+
+private:
+    bool add_comparison(const raw_term_t &term) {
+        boost::optional<field_comparison_t> comparison = field_comparison_of(term, arg);
+        if (!comparison) {
+            return false;
+        }
+        comparisons.push_back(std::make_pair(
+            add_field(comparison->field),
+            std::make_pair(comparison->op, std::move(comparison->value))));
+        return true;
+    }
+
+    sym_t arg;
+};
+
+scoped_ptr_t<vectorized_func_t> vectorized_func_t::make(
+        const counted_t<const func_t> &f) {
+    sym_t arg;
+    boost::optional<raw_term_t> body = single_arg_body(f, &arg);
+    if (!body) {
+        return scoped_ptr_t<vectorized_func_t>();
+    }
+
+    vectorized_func_builder_t builder(arg);
+    if (boost::optional<std::string> field = field_of_row(*body, arg)) {
+        builder.add_field(*field);
+    } else if (!builder.add_conjunction(*body)) {
+        return scoped_ptr_t<vectorized_func_t>();
+    }
+
+    scoped_ptr_t<vectorized_func_t> res(new vectorized_func_t());
+    res->fields = std::move(builder.fields);
+    for (auto &&c : builder.comparisons) {
+        res->comparisons.push_back(
+            comparison_t{c.first, c.second.first, std::move(c.second.second)});
+    }
+    return res;
+}
+
+void vectorized_func_t::evaluate(const std::vector<datum_t> &rows,
+                                 std::vector<row_state_t> *states) const {
+    r_sanity_check(!comparisons.empty());
+    const size_t n = rows.size();
+    states->assign(n, row_state_t::SELECTED);
+
+    // The rows that are still candidates, in order.
+    std::vector<uint32_t> selection;
+    selection.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (is_plain_object(rows[i])) {
+            selection.push_back(i);
+        } else {
+            (*states)[i] = row_state_t::FALLBACK;
+        }
+    }
+
+    // Columns are indexed by row, but only filled in for the rows that were still
+    // candidates when the field was first needed.  Later comparisons only look at a
+    // subset of those rows.
+    std::vector<std::vector<datum_t> > columns(fields.size());
+    for (const comparison_t &c : comparisons) {
+        std::vector<datum_t> *column = &columns[c.field];
+        if (column->empty()) {
+            column->resize(n);
+            for (uint32_t i : selection) {
+                (*column)[i] = rows[i].get_field(fields[c.field], NOTHROW);
+            }
+        }
+
+        size_t kept = 0;
+        for (uint32_t i : selection) {
+            const datum_t &v = (*column)[i];
+            if (!v.has()) {
+                // The term tree throws a non-existence error here.
+                (*states)[i] = row_state_t::FALLBACK;
+            } else if (compare_datums(c.op, v, c.value)) {
+                selection[kept++] = i;
+            } else {
+                (*states)[i] = row_state_t::REJECTED;
+            }
+        }
+        selection.resize(kept);
+        if (selection.empty()) {
+            break;
+        }
+    }
+}
+
+void vectorized_func_t::filter(
+        env_t *env,
+        std::vector<datum_t> *rows,
+        const std::function<bool(const datum_t &)> &fallback) const {
+    if (env->interruptor->is_pulsed()) {
+        throw interrupted_exc_t();
+    }
+    if (comparisons.empty()) {
+        // `filter(row(field))` keeps the rows where the field is truthy.
+        size_t loc = 0;
+        for (size_t i = 0; i < rows->size(); ++i) {
+            const datum_t &row = (*rows)[i];
+            datum_t v = is_plain_object(row)
+                ? row.get_field(fields[0], NOTHROW)
+                : datum_t();
+            if (v.has() ? v.as_bool() : fallback(row)) {
+                std::swap((*rows)[loc], (*rows)[i]);
+                ++loc;
+            }
+        }
+        rows->resize(loc);
+        return;
+    }
+
+    std::vector<row_state_t> states;
+    evaluate(*rows, &states);
+    size_t loc = 0;
+    for (size_t i = 0; i < rows->size(); ++i) {
+        if (states[i] == row_state_t::SELECTED
+            || (states[i] == row_state_t::FALLBACK && fallback((*rows)[i]))) {
+            std::swap((*rows)[loc], (*rows)[i]);
+            ++loc;
+        }
+    }
+    rows->resize(loc);
+}
+
+void vectorized_func_t::map(
+        env_t *env,
+        std::vector<datum_t> *rows,
+        const std::function<datum_t(const datum_t &)> &fallback) const {
+    if (env->interruptor->is_pulsed()) {
+        throw interrupted_exc_t();
+    }
+    if (comparisons.empty()) {
+        for (auto it = rows->begin(); it != rows->end(); ++it) {
+            datum_t v = is_plain_object(*it)
+                ? it->get_field(fields[0], NOTHROW)
+                : datum_t();
+            *it = v.has() ? std::move(v) : fallback(*it);
+        }
+        return;
+    }
+
+    std::vector<row_state_t> states;
+    evaluate(*rows, &states);
+    for (size_t i = 0; i < rows->size(); ++i) {
+        switch (states[i]) {
+        case row_state_t::SELECTED:
+            (*rows)[i] = datum_t::boolean(true);
+            break;
+        case row_state_t::REJECTED:
+            (*rows)[i] = datum_t::boolean(false);
+            break;
+        case row_state_t::FALLBACK:
+            (*rows)[i] = fallback((*rows)[i]);
+            break;
+        default: unreachable();
+        }
+    }
+}
+
+}  // namespace ql
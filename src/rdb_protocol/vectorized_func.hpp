@@ -0,0 +1,76 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_VECTORIZED_FUNC_HPP_
+#define RDB_PROTOCOL_VECTORIZED_FUNC_HPP_
+
+#include <stdint.h>
+
+#include <functional>
+#include <vector>
+
+#include "containers/counted.hpp"
+#include "containers/scoped.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/ql2.pb.h"
+
+namespace ql {
+
+class env_t;
+class func_t;
+
+/* Evaluates a function on a whole batch of rows at a time if it has one of the shapes
+that are common in `filter` and `map`:
+
+ - `row(field)`, and
+ - `row(f1) OP c1 && row(f2) OP c2 && ...`, where `OP` is one of `eq`, `ne`, `lt`,
+   `le`, `gt` and `ge` and the `c`s are datum literals (either side may be the field).
+
+For each field the values of the rows are extracted into a column first, and each
+comparison is then a tight loop over a selection vector of the rows that are still
+candidates, so there is no `val_t`, virtual call or variable scope per row.
+
+Rows for which this doesn't exactly reproduce the term tree (e.g. rows that aren't
+objects, or a missing field, which is an error that `default` may catch) are handed
+to a fallback that calls the function normally. */
+class vectorized_func_t {
+public:
+    // Returns an empty pointer if `f` doesn't have one of the above shapes.
+    static scoped_ptr_t<vectorized_func_t> make(const counted_t<const func_t> &f);
+
+    // Removes the rows for which the predicate is false, keeping the order.
+    // `fallback` decides the rows this can't handle.
+    void filter(env_t *env,
+                std::vector<datum_t> *rows,
+                const std::function<bool(const datum_t &)> &fallback) const;
+
+    // Replaces each row by the result of the function.
+    void map(env_t *env,
+             std::vector<datum_t> *rows,
+             const std::function<datum_t(const datum_t &)> &fallback) const;
+
+private:
+    struct comparison_t {
+        // Index into `fields`.
+        size_t field;
+        // The comparison is `row(field) op value`.
+        Term::TermType op;
+        datum_t value;
+    };
+
+    enum class row_state_t : uint8_t { SELECTED, REJECTED, FALLBACK };
+
+    vectorized_func_t() { }
+
+    // Sets `states` for each row of `rows`.
+    void evaluate(const std::vector<datum_t> &rows,
+                  std::vector<row_state_t> *states) const;
+
+    std::vector<datum_string_t> fields;
+    // Empty if the function is just `row(fields[0])`.
+    std::vector<comparison_t> comparisons;
+
+    DISABLE_COPYING(vectorized_func_t);
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_VECTORIZED_FUNC_HPP_
@@ -12,6 +12,7 @@
 #include <boost/optional.hpp>
 
 #include "arch/io/network.hpp"
+#include "arch/runtime/coroutines.hpp"
 #include "arch/timing.hpp"
 #include "clustering/administration/metadata.hpp"
 #include "concurrency/cross_thread_signal.hpp"
@@ -131,6 +132,66 @@ void connectivity_cluster_t::connection_t::kill_connection() {
     }
 }
 
+connectivity_cluster_t::connection_t::send_lock_t::send_lock_t(
+        connection_t *_connection, message_lane_t lane, bool _eager) :
+    connection(_connection), eager(_eager) {
+    if (connection->send_locked) {
+        const int lane_index = static_cast<int>(lane);
+        ++connection->lane_stats[lane_index]->pm_queue_depth;
+        connection->send_waiters[lane_index].push_back(coro_t::self());
+        coro_t::wait();
+        --connection->lane_stats[lane_index]->pm_queue_depth;
+    } else {
+        connection->send_locked = true;
+    }
+}
+
+connectivity_cluster_t::connection_t::send_lock_t::~send_lock_t() {
+    rassert(connection->send_locked);
+    int next_lane = -1;
+    for (int i = 0; i < num_message_lanes; ++i) {
+        if (connection->send_waiters[i].empty()) {
+            continue;
+        }
+        if (next_lane == -1
+            || connection->send_lock_passes[i] >= max_send_lock_passes) {
+            next_lane = i;
+            if (connection->send_lock_passes[i] >= max_send_lock_passes) {
+                break;
+            }
+        }
+    }
+    if (next_lane == -1) {
+        connection->send_locked = false;
+        return;
+    }
+    for (int i = 0; i < num_message_lanes; ++i) {
+        if (i == next_lane || connection->send_waiters[i].empty()) {
+            connection->send_lock_passes[i] = 0;
+        } else {
+            ++connection->send_lock_passes[i];
+        }
+    }
+    std::deque<coro_t *> *waiters = &connection->send_waiters[next_lane];
+    coro_t *next = waiters->front();
+    waiters->pop_front();
+    if (eager) {
+        next->notify_now_deprecated();
+    } else {
+        next->notify_sometime();
+    }
+}
+
+connectivity_cluster_t::connection_t::lane_stats_t::lane_stats_t(
+        perfmon_collection_t *parent, const char *name) :
+    pm_collection(),
+    pm_queue_depth(),
+    pm_bytes_sent(secs_to_ticks(1), true),
+    pm_memberships(&pm_collection,
+        &pm_queue_depth, "queue_depth",
+        &pm_bytes_sent, "bytes_sent"),
+    pm_collection_membership(parent, &pm_collection, name) { }
+
 connectivity_cluster_t::connection_t::connection_t(
         run_t *_parent,
         const peer_id_t &_peer_id,
@@ -139,11 +200,12 @@ connectivity_cluster_t::connection_t::connection_t(
         const peer_address_t &_peer_address) THROWS_NOTHING :
     conn(_conn),
     peer_address(_peer_address),
+    send_locked(false),
     flusher([&](signal_t *) {
         guarantee(this->conn != nullptr);
-        // We need to acquire the send_mutex because flushing the buffer
+        // We need to acquire the send lock because flushing the buffer
         // must not interleave with other writes (restriction of linux_tcp_conn_t).
-        mutex_t::acq_t acq(&this->send_mutex);
+        send_lock_t send_lock(this, message_lane_t::CONTROL, false);
         // We ignore the return value of flush_buffer(). Closed connections
         // must be handled elsewhere.
         this->conn->flush_buffer();
@@ -160,6 +222,13 @@ connectivity_cluster_t::connection_t::connection_t(
     server_id(_server_id),
     drainers()
 {
+    static const char *const lane_names[num_message_lanes] =
+        { "control", "replication", "bulk" };
+    for (int i = 0; i < num_message_lanes; ++i) {
+        lane_stats[i].init(new lane_stats_t(&pm_collection, lane_names[i]));
+        send_lock_passes[i] = 0;
+    }
+
     pmap(get_num_threads(), [this](int thread_id) {
         on_thread_t thread_switcher((threadnum_t(thread_id)));
         parent->parent->connections.get()->set_key_no_equals(
@@ -176,8 +245,8 @@ connectivity_cluster_t::connection_t::~connection_t() THROWS_NOTHING {
         drainers.get()->drain();
     });
 
-    /* The drainers have been destroyed, so nothing can be holding the `send_mutex`. */
-    guarantee(!send_mutex.is_locked());
+    /* The drainers have been destroyed, so nothing can be holding the send lock. */
+    guarantee(!send_locked);
 }
 
 // Helper function for the `run_t` constructor's initialization list
@@ -511,7 +580,8 @@ public:
                     /* This might block, so we have to run it in a sub-coroutine. */
                     connection->parent->parent->send_message(
                         connection, connection_keepalive,
-                        connectivity_cluster_t::heartbeat_tag, this);
+                        connectivity_cluster_t::heartbeat_tag, this,
+                        message_lane_t::CONTROL);
                 });
         }
         if (read_done) {
@@ -528,7 +598,7 @@ public:
         }
     }
 
-    void write(write_stream_t *) {
+    void write(write_message_t *) {
         /* Do nothing. The cluster will end up sending just the tag 'H' with no message
         attached, which will trigger `keepalive_read()` on the remote server. */
     }
@@ -1426,36 +1496,37 @@ connectivity_cluster_t::connection_t *connectivity_cluster_t::get_connection(
 void connectivity_cluster_t::send_message(connection_t *connection,
                                      auto_drainer_t::lock_t connection_keepalive,
                                      message_tag_t tag,
-                                     cluster_send_message_write_callback_t *callback) {
+                                     cluster_send_message_write_callback_t *callback,
+                                     message_lane_t lane) {
     // We could be on _any_ thread.
 
     /* If the connection is being closed, just drop the message now. It's not going
-    to actually get sent anyway. That way we avoid getting in line for the send_mutex. */
+    to actually get sent anyway. That way we avoid getting in line for the send lock. */
     if (connection_keepalive.get_drain_signal()->is_pulsed()) {
         return;
     }
 
-    /* We currently write the message to a vector_stream_t, then
-       serialize that as a string. It's horribly inefficient, of course. */
-    // TODO: If we don't do it this way, we (or the caller) will need
-    // to worry about having the writer run on the connection thread.
-    vector_stream_t buffer;
-    // Reserve some space to reduce overhead (especially for small messages)
-    buffer.reserve(1024);
+    /* The message is serialized into the buffers of a `write_message_t` right here,
+    because the callback may not be safe to run on the connection's thread. From then
+    on, the buffers are passed along instead of being copied again. */
+    write_message_t msg;
     {
         ASSERT_FINITE_CORO_WAITING;
-        callback->write(&buffer);
+        callback->write(&msg);
     }
 
 #ifdef CLUSTER_MESSAGE_DEBUGGING
     {
+        vector_stream_t debug_buffer;
+        int res = send_write_message(&debug_buffer, &msg);
+        guarantee(res == 0);
         printf_buffer_t buf;
         buf.appendf("from ");
         debug_print(&buf, me);
         buf.appendf(" to ");
         debug_print(&buf, dest);
         buf.appendf("\n");
-        print_hd(buffer.vector().data(), 0, buffer.vector().size());
+        print_hd(debug_buffer.vector().data(), 0, debug_buffer.vector().size());
     }
 #endif
 
@@ -1469,7 +1540,7 @@ void connectivity_cluster_t::send_message(connection_t *connection,
     }
 #endif
 
-    size_t bytes_sent = buffer.vector().size();
+    size_t bytes_sent = msg.size();
 
 #ifdef ENABLE_MESSAGE_PROFILER
     std::pair<uint64_t, uint64_t> *stats =
@@ -1480,58 +1551,49 @@ void connectivity_cluster_t::send_message(connection_t *connection,
 
     if (connection->is_loopback()) {
         // We could be on any thread here! Oh no!
+        vector_stream_t buffer;
+        buffer.reserve(bytes_sent);
+        int res = send_write_message(&buffer, &msg);
+        guarantee(res == 0);
         std::vector<char> buffer_data;
         buffer.swap(&buffer_data);
         rassert(message_handlers[tag], "No message handler for tag %" PRIu8, tag);
         message_handlers[tag]->on_local_message(connection, connection_keepalive,
             std::move(buffer_data));
     } else {
+        /* Put the tag in front of the message, without copying the message. */
+        write_message_t tagged_msg;
+        // All cluster versions use a uint8_t tag here.
+        static_assert(std::is_same<message_tag_t, uint8_t>::value,
+                      "We expect to be serializing a uint8_t -- if this has "
+                      "changed, the cluster communication format has changed and "
+                      "you need to ask yourself whether live cluster upgrades work."
+                      );
+        serialize_universal(&tagged_msg, tag);
+        tagged_msg.append(&msg);
+
         on_thread_t threader(connection->conn->home_thread());
 
-        /* Acquire the send-mutex so we don't collide with other things trying
+        /* Acquire the send lock so we don't collide with other things trying
         to send on the same connection. */
         {
             /* The `true` is for eager waiting, which is a significant performance
             optimization in this case. */
-            mutex_t::acq_t acq(&connection->send_mutex, true);
-
-            /* Write the tag to the network */
-            {
-                // All cluster versions use a uint8_t tag here.
-                write_message_t wm;
-                static_assert(std::is_same<message_tag_t, uint8_t>::value,
-                              "We expect to be serializing a uint8_t -- if this has "
-                              "changed, the cluster communication format has changed and "
-                              "you need to ask yourself whether live cluster upgrades work."
-                              );
-                serialize_universal(&wm, tag);
-                make_buffered_tcp_conn_stream_wrapper_t buffered_conn(connection->conn);
-                int res = send_write_message(&buffered_conn, &wm);
-                if (res == -1) {
-                    /* Close the other half of the connection to make sure that
-                       `connectivity_cluster_t::run_t::handle()` notices that something is
-                       up */
-                    if (connection->conn->is_read_open()) {
-                        connection->conn->shutdown_read();
-                    }
-                    return;
-                }
-            }
-
-            /* Write the message itself to the network */
-            {
-                int64_t res = connection->conn->write_buffered(buffer.vector().data(),
-                                                               buffer.vector().size());
-                if (res == -1) {
-                    if (connection->conn->is_read_open()) {
-                        connection->conn->shutdown_read();
-                    }
-                    return;
-                } else {
-                    guarantee(res == static_cast<int64_t>(buffer.vector().size()));
+            connection_t::send_lock_t send_lock(connection, lane, true);
+
+            /* Write the tag and the message to the network. Large messages are
+            handed to the connection as they are and sent with a single `writev()`. */
+            int64_t res = connection->conn->write_buffered(&tagged_msg);
+            if (res == -1) {
+                /* Close the other half of the connection to make sure that
+                   `connectivity_cluster_t::run_t::handle()` notices that something is
+                   up */
+                if (connection->conn->is_read_open()) {
+                    connection->conn->shutdown_read();
                 }
+                return;
             }
-        } /* Releases the send_mutex */
+        } /* Releases the send lock */
 
         connection->flusher.notify();
         cond_t dummy_interruptor;
@@ -1545,6 +1607,7 @@ void connectivity_cluster_t::send_message(connection_t *connection,
     }
 
     connection->pm_bytes_sent.record(bytes_sent);
+    connection->lane_stats[static_cast<int>(lane)]->pm_bytes_sent.record(bytes_sent);
 }
 
 cluster_message_handler_t::cluster_message_handler_t(
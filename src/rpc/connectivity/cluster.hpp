@@ -4,6 +4,7 @@
 
 #include <openssl/ssl.h>
 
+#include <deque>
 #include <map>
 #include <set>
 #include <string>
@@ -17,6 +18,7 @@
 #include "concurrency/watchable_map.hpp"
 #include "containers/archive/tcp_conn_stream.hpp"
 #include "containers/map_sentries.hpp"
+#include "containers/scoped.hpp"
 #include "concurrency/pump_coro.hpp"
 #include "perfmon/perfmon.hpp"
 #include "random.hpp"
@@ -48,8 +50,9 @@ class cluster_send_message_write_callback_t {
 public:
     virtual ~cluster_send_message_write_callback_t() { }
     // write() doesn't take a version argument because the version is always
-    // cluster_version_t::CLUSTER for cluster messages.
-    virtual void write(write_stream_t *stream) = 0;
+    // cluster_version_t::CLUSTER for cluster messages.  The message is sent straight
+    // from the buffers of `wm`, so there is no need to copy it anywhere else first.
+    virtual void write(write_message_t *wm) = 0;
 
 #ifdef ENABLE_MESSAGE_PROFILER
     /* This should return a string that describes the type of message being sent for
@@ -73,9 +76,31 @@ connection. Once a connection is established, messages can be sent across it in
 directions. Every message is guaranteed to eventually arrive unless the connection goes
 down. Messages cannot be duplicated.
 
-Can messages be reordered? I think the current implementation doesn't ever reorder
-messages, but don't rely on this guarantee. However, some old code may rely on this
-guarantee (I'm not sure) so don't break this property without checking first. */
+Can messages be reordered? Messages in different lanes (see `message_lane_t`) can
+overtake each other. I think the current implementation doesn't ever reorder messages
+within a lane, but don't rely on this guarantee. However, some old code may rely on
+this guarantee (I'm not sure) so don't break this property without checking first. */
+
+/* Every message is sent in one of these lanes. All lanes share the connection, but
+when several messages are waiting to be written to it, the ones in the lane that comes
+first here usually go first (see `connection_t::send_lock_t`). Messages in the same
+lane are written in the order they came in. Messages that don't ask for a lane go in
+the `REPLICATION` lane.
+This way a backfill that sends large chunks of data doesn't hold up the Raft and
+directory traffic, or the replication of writes, that goes over the same connection.
+*/
+enum class message_lane_t {
+    /* Heartbeats, directory and semilattice messages, Raft, and the messages that
+    begin, end and acknowledge backfill sessions */
+    CONTROL = 0,
+    /* Everything else, which is most mailbox messages, including writes and their
+    acknowledgements */
+    REPLICATION = 1,
+    /* Backfill pre-items and items */
+    BULK = 2
+};
+
+static const int num_message_lanes = 3;
 
 class connectivity_cluster_t :
     public home_thread_mixin_debug_only_t
@@ -157,8 +182,27 @@ public:
         cross-thread to access the routing table. */
         peer_address_t peer_address;
 
-        /* Unused for our connection to ourself */
-        mutex_t send_mutex;
+        /* Only one coroutine at a time may write to `conn`. A `send_lock_t` waits
+        for its turn, and when it's released, it hands the connection to the coroutine
+        that has been waiting longest in the first lane that has any. So that a steady
+        stream of messages in the earlier lanes can't starve a later one, a lane that
+        has been passed over `max_send_lock_passes` times in a row goes first.
+        Unused for our connection to ourself. */
+        class send_lock_t {
+        public:
+            /* If `eager` is true, the next waiter runs as soon as the lock is
+            released. */
+            send_lock_t(connection_t *connection, message_lane_t lane, bool eager);
+            ~send_lock_t();
+        private:
+            connection_t *connection;
+            bool eager;
+            DISABLE_COPYING(send_lock_t);
+        };
+        static const int max_send_lock_passes = 8;
+        bool send_locked;
+        std::deque<coro_t *> send_waiters[num_message_lanes];
+        int send_lock_passes[num_message_lanes];
 
         /* Calls `conn->flush_buffer()`. Can be used for making sure that a
         buffered write makes it to the TCP stack. */
@@ -168,6 +212,19 @@ public:
         perfmon_sampler_t pm_bytes_sent;
         perfmon_membership_t pm_collection_membership, pm_bytes_sent_membership;
 
+        /* The number of messages that are waiting for the `send_lock_t`, and the bytes
+        sent, for each lane. */
+        class lane_stats_t {
+        public:
+            lane_stats_t(perfmon_collection_t *parent, const char *name);
+            perfmon_collection_t pm_collection;
+            perfmon_counter_t pm_queue_depth;
+            perfmon_sampler_t pm_bytes_sent;
+            perfmon_multi_membership_t pm_memberships;
+            perfmon_membership_t pm_collection_membership;
+        };
+        scoped_ptr_t<lane_stats_t> lane_stats[num_message_lanes];
+
         /* We only hold this information so we can deregister ourself */
         run_t *parent;
 
@@ -343,11 +400,13 @@ public:
 
     /* Sends a message to the other server. The message is associated with a "tag",
     which determines which message handler on the other server will receive the message.
-    */
+    `lane` decides which messages it may overtake, or be overtaken by, while it waits to
+    be written to the connection. */
     void send_message(connection_t *connection,
                       auto_drainer_t::lock_t connection_keepalive,
                       message_tag_t tag,
-                      cluster_send_message_write_callback_t *callback);
+                      cluster_send_message_write_callback_t *callback,
+                      message_lane_t lane = message_lane_t::REPLICATION);
 
 private:
     friend class cluster_message_handler_t;
@@ -48,15 +48,10 @@ public:
             uint64_t _timestamp, const key_t &_key, boost::optional<value_t> &&_value) :
         timestamp(_timestamp), key(_key), value(std::move(_value)) { }
 
-    void write(write_stream_t *s) {
-        write_message_t wm;
-        serialize<cluster_version_t::CLUSTER>(&wm, timestamp);
-        serialize<cluster_version_t::CLUSTER>(&wm, key);
-        serialize<cluster_version_t::CLUSTER>(&wm, value);
-        int res = send_write_message(s, &wm);
-        if (res) {
-            throw fake_archive_exc_t();
-        }
+    void write(write_message_t *wm) {
+        serialize<cluster_version_t::CLUSTER>(wm, timestamp);
+        serialize<cluster_version_t::CLUSTER>(wm, key);
+        serialize<cluster_version_t::CLUSTER>(wm, value);
     }
 
 #ifdef ENABLE_MESSAGE_PROFILER
@@ -128,7 +123,8 @@ void directory_map_write_manager_t<key_t, value_t>::stream_to_conn(
                 conns_entry->second.dirty_keys.erase(key);
                 update_writer_t writer(timestamp, key, value->get_key(key));
                 connectivity_cluster->send_message(
-                    connection, connection_keepalive, message_tag, &writer);
+                    connection, connection_keepalive, message_tag, &writer,
+                    message_lane_t::CONTROL);
             }
         }
     } catch (const interrupted_exc_t &) {
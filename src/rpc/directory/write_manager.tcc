@@ -51,7 +51,8 @@ void directory_write_manager_t<metadata_t>::on_connection_change(
                 acq.acquisition_signal()->wait();
                 initialization_writer_t writer(initial_value, initial_state);
                 connectivity_cluster->send_message(connection, connection_keepalive,
-                        message_tag, &writer);
+                        message_tag, &writer,
+                        message_lane_t::CONTROL);
             });
     }
     if (pair == nullptr && last_connections.count(peer_id) == 1) {
@@ -74,7 +75,8 @@ void directory_write_manager_t<metadata_t>::on_value_change() THROWS_NOTHING {
                     current_value, token]() {
                 update_writer_t writer(current_value, token);
                 connectivity_cluster->send_message(connection, connection_keepalive,
-                        message_tag, &writer);
+                        message_tag, &writer,
+                        message_lane_t::CONTROL);
             });
     }
 }
@@ -89,17 +91,12 @@ public:
         initial_value(_initial_value), metadata_fifo_state(_metadata_fifo_state) { }
     ~initialization_writer_t() { }
 
-    void write(write_stream_t *stream) {
-        write_message_t wm;
+    void write(write_message_t *wm) {
         // All cluster versions use a uint8_t code.
         const uint8_t code = 'I';
-        serialize_universal(&wm, code);
-        serialize<cluster_version_t::CLUSTER>(&wm, initial_value);
-        serialize<cluster_version_t::CLUSTER>(&wm, metadata_fifo_state);
-        int res = send_write_message(stream, &wm);
-        if (res) {
-            throw fake_archive_exc_t();
-        }
+        serialize_universal(wm, code);
+        serialize<cluster_version_t::CLUSTER>(wm, initial_value);
+        serialize<cluster_version_t::CLUSTER>(wm, metadata_fifo_state);
     }
 
 #ifdef ENABLE_MESSAGE_PROFILER
@@ -125,17 +122,12 @@ public:
         new_value(_new_value), metadata_fifo_token(_metadata_fifo_token) { }
     ~update_writer_t() { }
 
-    void write(write_stream_t *stream) {
-        write_message_t wm;
+    void write(write_message_t *wm) {
         // All cluster versions use a uint8_t code.
         const uint8_t code = 'U';
-        serialize_universal(&wm, code);
-        serialize<cluster_version_t::CLUSTER>(&wm, new_value);
-        serialize<cluster_version_t::CLUSTER>(&wm, metadata_fifo_token);
-        int res = send_write_message(stream, &wm);
-        if (res) {
-            throw fake_archive_exc_t();
-        }
+        serialize_universal(wm, code);
+        serialize<cluster_version_t::CLUSTER>(wm, new_value);
+        serialize<cluster_version_t::CLUSTER>(wm, metadata_fifo_token);
     }
 
 #ifdef ENABLE_MESSAGE_PROFILER
@@ -74,7 +74,7 @@ public:
         subwriter(_subwriter) { }
     virtual ~raw_mailbox_writer_t() { }
 
-    void write(write_stream_t *stream) {
+    void write(write_message_t *msg) {
         write_message_t wm;
         // Right now, we serialize this length/thread/mailbox information the same
         // way irrespective of version. (Serialization methods for primitive types
@@ -87,17 +87,10 @@ public:
 
         subwriter->write(cluster_version_t::CLUSTER, &wm);
 
-        // Prepend the message length.
-        // TODO: It would be more efficient if we could make this part of `msg`.
-        //  e.g. with a `prepend()` method on write_message_t.
-        write_message_t length_msg;
-        serialize_universal(&length_msg,
-                            static_cast<uint64_t>(wm.size()) - prefix_length);
-
-        int res = send_write_message(stream, &length_msg);
-        if (res) { throw fake_archive_exc_t(); }
-        res = send_write_message(stream, &wm);
-        if (res) { throw fake_archive_exc_t(); }
+        // Prepend the message length.  Appending `wm` moves its buffers over without
+        // copying them.
+        serialize_universal(msg, static_cast<uint64_t>(wm.size()) - prefix_length);
+        msg->append(&wm);
     }
 
 #ifdef ENABLE_MESSAGE_PROFILER
@@ -113,10 +106,29 @@ private:
 };
 
 void send_write(mailbox_manager_t *src, raw_mailbox_t::address_t dest,
-                mailbox_write_callback_t *callback) {
+                mailbox_write_callback_t *callback, message_lane_t lane) {
     guarantee(src);
     guarantee(!dest.is_nil());
-    new_semaphore_in_line_t acq(src->semaphores.get(), 1);
+
+    /* Messages to a mailbox on this thread don't need to be serialized, and they don't
+    take up any room in the connection either. We still check that the loopback
+    connection exists, so they get dropped in the same cases as other messages. */
+    if (dest.peer == src->get_connectivity_cluster()->get_me()
+            && dest.thread == get_thread_id().threadnum) {
+        scoped_ptr_t<mailbox_local_message_t> local_message =
+            callback->copy_for_local();
+        if (local_message.has()) {
+            auto_drainer_t::lock_t connection_keepalive;
+            if (src->get_connectivity_cluster()->get_connection(
+                    dest.peer, &connection_keepalive) != nullptr) {
+                src->deliver_local_message(dest.mailbox_id, std::move(local_message));
+            }
+            return;
+        }
+    }
+
+    new_semaphore_in_line_t acq(
+        src->semaphores[static_cast<int>(lane)]->get(), 1);
     acq.acquisition_signal()->wait();
     connectivity_cluster_t::connection_t *connection;
     auto_drainer_t::lock_t connection_keepalive;
@@ -126,16 +138,19 @@ void send_write(mailbox_manager_t *src, raw_mailbox_t::address_t dest,
     }
     raw_mailbox_writer_t writer(dest.thread, dest.mailbox_id, callback);
     src->get_connectivity_cluster()->send_message(connection, connection_keepalive,
-        src->get_message_tag(), &writer);
+        src->get_message_tag(), &writer, lane);
 }
 
 static const int MAX_OUTSTANDING_MAILBOX_WRITES_PER_THREAD = 4;
 
 mailbox_manager_t::mailbox_manager_t(connectivity_cluster_t *_connectivity_cluster,
         connectivity_cluster_t::message_tag_t message_tag) :
-    cluster_message_handler_t(_connectivity_cluster, message_tag),
-    semaphores(MAX_OUTSTANDING_MAILBOX_WRITES_PER_THREAD)
-    { }
+    cluster_message_handler_t(_connectivity_cluster, message_tag) {
+    for (int i = 0; i < num_message_lanes; ++i) {
+        semaphores[i].init(new one_per_thread_t<new_semaphore_t>(
+            MAX_OUTSTANDING_MAILBOX_WRITES_PER_THREAD));
+    }
+}
 
 mailbox_manager_t::mailbox_table_t::mailbox_table_t() {
     next_mailbox_id = (UINT64_MAX / get_num_threads()) * get_thread_id().threadnum;
@@ -217,6 +232,30 @@ void mailbox_manager_t::on_local_message(
         });
 }
 
+void mailbox_manager_t::deliver_local_message(
+        raw_mailbox_t::id_t dest_mailbox_id,
+        scoped_ptr_t<mailbox_local_message_t> &&message) {
+    // The coroutine can't take ownership of a `scoped_ptr_t` directly, so it gets the
+    // raw pointer. Spawning it later rather than now also keeps the mailbox's callback
+    // from running inside of `send_write()`, like for the other local messages.
+    mailbox_local_message_t *raw_message = message.release();
+    coro_t::spawn_sometime([this, dest_mailbox_id, raw_message]() {
+        scoped_ptr_t<mailbox_local_message_t> local_message(raw_message);
+        raw_mailbox_t *mbox = mailbox_tables.get()->find_mailbox(dest_mailbox_id);
+        if (mbox != nullptr) {
+            try {
+                auto_drainer_t::lock_t keepalive(&mbox->drainer);
+                mbox->callback->read_local(
+                    local_message.get(), keepalive.get_drain_signal());
+            } catch (const interrupted_exc_t &) {
+                /* Do nothing. It's no longer safe to access `mbox` (because the
+                destructor is running) but otherwise we don't need to take any
+                special action. */
+            }
+        }
+    });
+}
+
 void mailbox_manager_t::on_message(
         UNUSED connectivity_cluster_t::connection_t *connection,
         UNUSED auto_drainer_t::lock_t connection_keepalive,
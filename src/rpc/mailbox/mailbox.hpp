@@ -10,6 +10,7 @@
 #include "concurrency/new_semaphore.hpp"
 #include "containers/archive/archive.hpp"
 #include "containers/archive/vector_stream.hpp"
+#include "containers/scoped.hpp"
 #include "rpc/connectivity/cluster.hpp"
 #include "rpc/semilattice/joins/macros.hpp"
 
@@ -19,11 +20,28 @@ class mailbox_manager_t;
 to handle messages it receives. To send messages to the mailbox, call the
 `get_address()` method and then call `send_write()` on the address it returns. */
 
+/* A copy of the contents of a message for a mailbox on the thread it's sent from.
+Such messages are handed to the mailbox as they are, instead of being serialized and
+deserialized again. */
+class mailbox_local_message_t {
+public:
+    virtual ~mailbox_local_message_t() { }
+};
+
 class mailbox_write_callback_t {
 public:
     virtual ~mailbox_write_callback_t() { }
     virtual void write(cluster_version_t cluster_version,
                        write_message_t *wm) = 0;
+
+    /* Returns a copy of the message for a mailbox on the current thread, or an empty
+    pointer if the message has to be serialized even then. The copy can't be sent to
+    another thread, because the objects in it may share data that isn't thread-safe
+    with the ones the message was copied from. */
+    virtual scoped_ptr_t<mailbox_local_message_t> copy_for_local() {
+        return scoped_ptr_t<mailbox_local_message_t>();
+    }
+
 #ifdef ENABLE_MESSAGE_PROFILER
     virtual const char *message_profiler_tag() const = 0;
 #endif
@@ -39,6 +57,14 @@ public:
         read_stream_t *stream,
         /* `interruptor` will be pulsed if the mailbox is destroyed. */
         signal_t *interruptor) = 0;
+
+    /* Like `read()`, but for a message that the `mailbox_write_callback_t` of the same
+    type returned from `copy_for_local()`. */
+    virtual void read_local(
+            UNUSED mailbox_local_message_t *message,
+            UNUSED signal_t *interruptor) {
+        unreachable();
+    }
 };
 
 struct raw_mailbox_t : public home_thread_mixin_t {
@@ -53,7 +79,8 @@ public:
 private:
     friend class mailbox_manager_t;
     friend class raw_mailbox_writer_t;
-    friend void send_write(mailbox_manager_t *, address_t, mailbox_write_callback_t *);
+    friend void send_write(mailbox_manager_t *, address_t, mailbox_write_callback_t *,
+                           message_lane_t);
 
     mailbox_manager_t *manager;
 
@@ -98,7 +125,8 @@ public:
         RDB_MAKE_ME_SERIALIZABLE_3(address_t, peer, thread, mailbox_id);
 
     private:
-        friend void send_write(mailbox_manager_t *, raw_mailbox_t::address_t, mailbox_write_callback_t *callback);
+        friend void send_write(mailbox_manager_t *, raw_mailbox_t::address_t,
+                               mailbox_write_callback_t *callback, message_lane_t);
         friend struct raw_mailbox_t;
         friend class mailbox_manager_t;
 
@@ -127,11 +155,18 @@ public:
 
 /* `send_write()` sends a message to a mailbox. `send_write()` can block and must be called
 in a coroutine. If the mailbox does not exist or the peer is disconnected, `send_write()`
-will silently fail. Mailbox messages are not necessarily delivered in order. */
+will silently fail. If the mailbox is on the current thread, and `callback` can copy the
+message, then the copy is handed to the mailbox without serializing it. Mailbox messages
+are not necessarily delivered in order. Most mailbox messages go in the `REPLICATION`
+lane, which is the default; Raft messages should be sent in the `CONTROL` lane and
+backfills in the `BULK` lane. Messages in different lanes can overtake each other even
+when they go to the same peer, so a protocol whose messages must arrive in the order
+they were sent has to send all of them in the same lane. */
 
 void send_write(mailbox_manager_t *src,
                 raw_mailbox_t::address_t dest,
-                mailbox_write_callback_t *callback);
+                mailbox_write_callback_t *callback,
+                message_lane_t lane = message_lane_t::REPLICATION);
 
 /* `mailbox_manager_t` is a `cluster_message_handler_t` that takes care
 of actually routing messages to mailboxes. */
@@ -143,7 +178,8 @@ public:
 
 private:
     friend struct raw_mailbox_t;
-    friend void send_write(mailbox_manager_t *, raw_mailbox_t::address_t, mailbox_write_callback_t *callback);
+    friend void send_write(mailbox_manager_t *, raw_mailbox_t::address_t,
+                           mailbox_write_callback_t *callback, message_lane_t);
 
     struct mailbox_table_t {
         mailbox_table_t();
@@ -157,8 +193,9 @@ private:
 
     /* We must acquire one of these semaphores whenever we want to send a message over a
     mailbox. This prevents mailbox messages from starving directory and semilattice
-    messages. */
-    one_per_thread_t<new_semaphore_t> semaphores;
+    messages. Each lane has its own semaphores, so that a backfill can't hold up the
+    messages in the other lanes. */
+    scoped_ptr_t<one_per_thread_t<new_semaphore_t> > semaphores[num_message_lanes];
 
     raw_mailbox_t::id_t generate_mailbox_id();
 
@@ -177,6 +214,11 @@ private:
                           auto_drainer_t::lock_t connection_keepalive,
                           std::vector<char> &&data);
 
+    /* Delivers a message from `mailbox_write_callback_t::copy_for_local()` to a mailbox
+    on the current thread, in a new coroutine. */
+    void deliver_local_message(raw_mailbox_t::id_t dest_mailbox_id,
+                               scoped_ptr_t<mailbox_local_message_t> &&message);
+
     enum force_yield_t {FORCE_YIELD, MAYBE_YIELD};
     void mailbox_read_coroutine(threadnum_t dest_thread,
                                 raw_mailbox_t::id_t dest_mailbox_id,
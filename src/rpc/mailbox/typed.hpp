@@ -29,48 +29,48 @@ public:
     RDB_MAKE_ME_EQUALITY_COMPARABLE_1(mailbox_addr_t<T>, addr);
 
 private:
-    friend void send(mailbox_manager_t *, mailbox_addr_t<void()>);
+    friend void send(mailbox_manager_t *, message_lane_t, mailbox_addr_t<void()>);
     template <class a0_t>
-    friend void send(mailbox_manager_t *,
+    friend void send(mailbox_manager_t *, message_lane_t,
                      typename mailbox_t< void(a0_t) >::address_t, const a0_t&);
     template <class a0_t, class a1_t>
-    friend void send(mailbox_manager_t *,
+    friend void send(mailbox_manager_t *, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t) >::address_t, const a0_t&, const a1_t&);
     template <class a0_t, class a1_t, class a2_t>
-    friend void send(mailbox_manager_t *,
+    friend void send(mailbox_manager_t *, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t) >::address_t, const a0_t&, const a1_t&, const a2_t&);
     template <class a0_t, class a1_t, class a2_t, class a3_t>
-    friend void send(mailbox_manager_t *,
+    friend void send(mailbox_manager_t *, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&);
     template <class a0_t, class a1_t, class a2_t, class a3_t, class a4_t>
-    friend void send(mailbox_manager_t *,
+    friend void send(mailbox_manager_t *, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&);
     template <class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t>
-    friend void send(mailbox_manager_t *,
+    friend void send(mailbox_manager_t *, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&);
     template <class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t, class a6_t>
-    friend void send(mailbox_manager_t *,
+    friend void send(mailbox_manager_t *, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t, a6_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&, const a6_t&);
     template <class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t, class a6_t, class a7_t>
-    friend void send(mailbox_manager_t *,
+    friend void send(mailbox_manager_t *, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t, a6_t, a7_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&, const a6_t&, const a7_t&);
     template <class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t, class a6_t, class a7_t, class a8_t>
-    friend void send(mailbox_manager_t *,
+    friend void send(mailbox_manager_t *, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t, a6_t, a7_t, a8_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&, const a6_t&, const a7_t&, const a8_t&);
     template <class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t, class a6_t, class a7_t, class a8_t, class a9_t>
-    friend void send(mailbox_manager_t *,
+    friend void send(mailbox_manager_t *, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t, a6_t, a7_t, a8_t, a9_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&, const a6_t&, const a7_t&, const a8_t&, const a9_t&);
     template <class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t, class a6_t, class a7_t, class a8_t, class a9_t, class a10_t>
-    friend void send(mailbox_manager_t *,
+    friend void send(mailbox_manager_t *, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t, a6_t, a7_t, a8_t, a9_t, a10_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&, const a6_t&, const a7_t&, const a8_t&, const a9_t&, const a10_t&);
     template <class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t, class a6_t, class a7_t, class a8_t, class a9_t, class a10_t, class a11_t>
-    friend void send(mailbox_manager_t *,
+    friend void send(mailbox_manager_t *, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t, a6_t, a7_t, a8_t, a9_t, a10_t, a11_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&, const a6_t&, const a7_t&, const a8_t&, const a9_t&, const a10_t&, const a11_t&);
     template <class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t, class a6_t, class a7_t, class a8_t, class a9_t, class a10_t, class a11_t, class a12_t>
-    friend void send(mailbox_manager_t *,
+    friend void send(mailbox_manager_t *, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t, a6_t, a7_t, a8_t, a9_t, a10_t, a11_t, a12_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&, const a6_t&, const a7_t&, const a8_t&, const a9_t&, const a10_t&, const a11_t&, const a12_t&);
     template <class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t, class a6_t, class a7_t, class a8_t, class a9_t, class a10_t, class a11_t, class a12_t, class a13_t>
-    friend void send(mailbox_manager_t *,
+    friend void send(mailbox_manager_t *, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t, a6_t, a7_t, a8_t, a9_t, a10_t, a11_t, a12_t, a13_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&, const a6_t&, const a7_t&, const a8_t&, const a9_t&, const a10_t&, const a11_t&, const a12_t&, const a13_t&);
 
     raw_mailbox_t::address_t addr;
@@ -78,12 +78,21 @@ private:
 
 template<>
 class mailbox_t< void() > {
+    class local_message_t : public mailbox_local_message_t {
+    public:
+        local_message_t() { }
+    };
+
     class write_impl_t : public mailbox_write_callback_t {
     public:
         write_impl_t() { }
         void write(DEBUG_VAR cluster_version_t cluster_version, write_message_t *) {
             rassert(cluster_version == cluster_version_t::CLUSTER);
         }
+        scoped_ptr_t<mailbox_local_message_t> copy_for_local() {
+            return scoped_ptr_t<mailbox_local_message_t>(
+                new local_message_t());
+        }
 #ifdef ENABLE_MESSAGE_PROFILER
         const char *message_profiler_tag() const {
             return "mailbox<>";
@@ -97,6 +106,10 @@ class mailbox_t< void() > {
         void read(UNUSED read_stream_t *stream, signal_t *interruptor) {
             parent->fun(interruptor);
         }
+        void read_local(UNUSED mailbox_local_message_t *message,
+                        signal_t *interruptor) {
+            parent->fun(interruptor);
+        }
     private:
         mailbox_t< void() > *parent;
     };
@@ -122,7 +135,7 @@ public:
     }
 
 private:
-    friend void send(mailbox_manager_t*, address_t);
+    friend void send(mailbox_manager_t*, message_lane_t, address_t);
 
     std::function< void(signal_t *) > fun;
     raw_mailbox_t mailbox;
@@ -130,14 +143,29 @@ private:
 
 inline
 void send(mailbox_manager_t *src,
+          message_lane_t lane,
            mailbox_t< void() >::address_t dest) {
     mailbox_t< void() >::write_impl_t writer;
-    send_write(src, dest.addr, &writer);
+    send_write(src, dest.addr, &writer, lane);
+}
+
+inline
+void send(mailbox_manager_t *src,
+           mailbox_t< void() >::address_t dest) {
+    send(src, message_lane_t::REPLICATION, dest);
 }
 
 
 template<class arg0_t>
 class mailbox_t< void(arg0_t) > {
+    class local_message_t : public mailbox_local_message_t {
+    public:
+        explicit local_message_t(const arg0_t &_arg0) :
+            arg0(_arg0)
+        { }
+        arg0_t arg0;
+    };
+
     class write_impl_t : public mailbox_write_callback_t {
     private:
         const arg0_t &arg0;
@@ -149,6 +177,10 @@ class mailbox_t< void(arg0_t) > {
             rassert(cluster_version == cluster_version_t::CLUSTER);
             serialize<cluster_version_t::CLUSTER>(wm, arg0);
         }
+        scoped_ptr_t<mailbox_local_message_t> copy_for_local() {
+            return scoped_ptr_t<mailbox_local_message_t>(
+                new local_message_t(arg0));
+        }
 #ifdef ENABLE_MESSAGE_PROFILER
         const char *message_profiler_tag() const {
             static const std::string tag = 
@@ -167,6 +199,11 @@ class mailbox_t< void(arg0_t) > {
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0));
         }
+        void read_local(mailbox_local_message_t *message,
+                        signal_t *interruptor) {
+            local_message_t *m = static_cast<local_message_t *>(message);
+            parent->fun(interruptor, std::move(m->arg0));
+        }
     private:
         mailbox_t< void(arg0_t) > *parent;
     };
@@ -193,7 +230,7 @@ public:
 
 private:
     template<class a0_t>
-    friend void send(mailbox_manager_t*,
+    friend void send(mailbox_manager_t*, message_lane_t,
                      typename mailbox_t< void(a0_t) >::address_t, const a0_t&);
 
     std::function< void(signal_t *, arg0_t) > fun;
@@ -202,14 +239,30 @@ private:
 
 template<class arg0_t>
 void send(mailbox_manager_t *src,
+          message_lane_t lane,
           typename mailbox_t< void(arg0_t) >::address_t dest, const arg0_t &arg0) {
     typename mailbox_t< void(arg0_t) >::write_impl_t writer(arg0);
-    send_write(src, dest.addr, &writer);
+    send_write(src, dest.addr, &writer, lane);
+}
+
+template<class arg0_t>
+void send(mailbox_manager_t *src,
+          typename mailbox_t< void(arg0_t) >::address_t dest, const arg0_t &arg0) {
+    send(src, message_lane_t::REPLICATION, dest, arg0);
 }
 
 
 template<class arg0_t, class arg1_t>
 class mailbox_t< void(arg0_t, arg1_t) > {
+    class local_message_t : public mailbox_local_message_t {
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1) :
+            arg0(_arg0), arg1(_arg1)
+        { }
+        arg0_t arg0;
+        arg1_t arg1;
+    };
+
     class write_impl_t : public mailbox_write_callback_t {
     private:
         const arg0_t &arg0;
@@ -223,6 +276,10 @@ class mailbox_t< void(arg0_t, arg1_t) > {
             serialize<cluster_version_t::CLUSTER>(wm, arg0);
             serialize<cluster_version_t::CLUSTER>(wm, arg1);
         }
+        scoped_ptr_t<mailbox_local_message_t> copy_for_local() {
+            return scoped_ptr_t<mailbox_local_message_t>(
+                new local_message_t(arg0, arg1));
+        }
 #ifdef ENABLE_MESSAGE_PROFILER
         const char *message_profiler_tag() const {
             static const std::string tag = 
@@ -244,6 +301,11 @@ class mailbox_t< void(arg0_t, arg1_t) > {
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1));
         }
+        void read_local(mailbox_local_message_t *message,
+                        signal_t *interruptor) {
+            local_message_t *m = static_cast<local_message_t *>(message);
+            parent->fun(interruptor, std::move(m->arg0), std::move(m->arg1));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t) > *parent;
     };
@@ -270,7 +332,7 @@ public:
 
 private:
     template<class a0_t, class a1_t>
-    friend void send(mailbox_manager_t*,
+    friend void send(mailbox_manager_t*, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t) >::address_t, const a0_t&, const a1_t&);
 
     std::function< void(signal_t *, arg0_t, arg1_t) > fun;
@@ -279,14 +341,31 @@ private:
 
 template<class arg0_t, class arg1_t>
 void send(mailbox_manager_t *src,
+          message_lane_t lane,
           typename mailbox_t< void(arg0_t, arg1_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1) {
     typename mailbox_t< void(arg0_t, arg1_t) >::write_impl_t writer(arg0, arg1);
-    send_write(src, dest.addr, &writer);
+    send_write(src, dest.addr, &writer, lane);
+}
+
+template<class arg0_t, class arg1_t>
+void send(mailbox_manager_t *src,
+          typename mailbox_t< void(arg0_t, arg1_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1) {
+    send(src, message_lane_t::REPLICATION, dest, arg0, arg1);
 }
 
 
 template<class arg0_t, class arg1_t, class arg2_t>
 class mailbox_t< void(arg0_t, arg1_t, arg2_t) > {
+    class local_message_t : public mailbox_local_message_t {
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2)
+        { }
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+    };
+
     class write_impl_t : public mailbox_write_callback_t {
     private:
         const arg0_t &arg0;
@@ -302,6 +381,10 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t) > {
             serialize<cluster_version_t::CLUSTER>(wm, arg1);
             serialize<cluster_version_t::CLUSTER>(wm, arg2);
         }
+        scoped_ptr_t<mailbox_local_message_t> copy_for_local() {
+            return scoped_ptr_t<mailbox_local_message_t>(
+                new local_message_t(arg0, arg1, arg2));
+        }
 #ifdef ENABLE_MESSAGE_PROFILER
         const char *message_profiler_tag() const {
             static const std::string tag = 
@@ -326,6 +409,11 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t) > {
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2));
         }
+        void read_local(mailbox_local_message_t *message,
+                        signal_t *interruptor) {
+            local_message_t *m = static_cast<local_message_t *>(message);
+            parent->fun(interruptor, std::move(m->arg0), std::move(m->arg1), std::move(m->arg2));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t) > *parent;
     };
@@ -352,7 +440,7 @@ public:
 
 private:
     template<class a0_t, class a1_t, class a2_t>
-    friend void send(mailbox_manager_t*,
+    friend void send(mailbox_manager_t*, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t) >::address_t, const a0_t&, const a1_t&, const a2_t&);
 
     std::function< void(signal_t *, arg0_t, arg1_t, arg2_t) > fun;
@@ -361,14 +449,32 @@ private:
 
 template<class arg0_t, class arg1_t, class arg2_t>
 void send(mailbox_manager_t *src,
+          message_lane_t lane,
           typename mailbox_t< void(arg0_t, arg1_t, arg2_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2) {
     typename mailbox_t< void(arg0_t, arg1_t, arg2_t) >::write_impl_t writer(arg0, arg1, arg2);
-    send_write(src, dest.addr, &writer);
+    send_write(src, dest.addr, &writer, lane);
+}
+
+template<class arg0_t, class arg1_t, class arg2_t>
+void send(mailbox_manager_t *src,
+          typename mailbox_t< void(arg0_t, arg1_t, arg2_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2) {
+    send(src, message_lane_t::REPLICATION, dest, arg0, arg1, arg2);
 }
 
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t>
 class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t) > {
+    class local_message_t : public mailbox_local_message_t {
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3)
+        { }
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+    };
+
     class write_impl_t : public mailbox_write_callback_t {
     private:
         const arg0_t &arg0;
@@ -386,6 +492,10 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t) > {
             serialize<cluster_version_t::CLUSTER>(wm, arg2);
             serialize<cluster_version_t::CLUSTER>(wm, arg3);
         }
+        scoped_ptr_t<mailbox_local_message_t> copy_for_local() {
+            return scoped_ptr_t<mailbox_local_message_t>(
+                new local_message_t(arg0, arg1, arg2, arg3));
+        }
 #ifdef ENABLE_MESSAGE_PROFILER
         const char *message_profiler_tag() const {
             static const std::string tag = 
@@ -413,6 +523,11 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t) > {
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3));
         }
+        void read_local(mailbox_local_message_t *message,
+                        signal_t *interruptor) {
+            local_message_t *m = static_cast<local_message_t *>(message);
+            parent->fun(interruptor, std::move(m->arg0), std::move(m->arg1), std::move(m->arg2), std::move(m->arg3));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t) > *parent;
     };
@@ -439,7 +554,7 @@ public:
 
 private:
     template<class a0_t, class a1_t, class a2_t, class a3_t>
-    friend void send(mailbox_manager_t*,
+    friend void send(mailbox_manager_t*, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&);
 
     std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t) > fun;
@@ -448,14 +563,33 @@ private:
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t>
 void send(mailbox_manager_t *src,
+          message_lane_t lane,
           typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3) {
     typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t) >::write_impl_t writer(arg0, arg1, arg2, arg3);
-    send_write(src, dest.addr, &writer);
+    send_write(src, dest.addr, &writer, lane);
+}
+
+template<class arg0_t, class arg1_t, class arg2_t, class arg3_t>
+void send(mailbox_manager_t *src,
+          typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3) {
+    send(src, message_lane_t::REPLICATION, dest, arg0, arg1, arg2, arg3);
 }
 
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t>
 class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t) > {
+    class local_message_t : public mailbox_local_message_t {
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4)
+        { }
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+    };
+
     class write_impl_t : public mailbox_write_callback_t {
     private:
         const arg0_t &arg0;
@@ -475,6 +609,10 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t) > {
             serialize<cluster_version_t::CLUSTER>(wm, arg3);
             serialize<cluster_version_t::CLUSTER>(wm, arg4);
         }
+        scoped_ptr_t<mailbox_local_message_t> copy_for_local() {
+            return scoped_ptr_t<mailbox_local_message_t>(
+                new local_message_t(arg0, arg1, arg2, arg3, arg4));
+        }
 #ifdef ENABLE_MESSAGE_PROFILER
         const char *message_profiler_tag() const {
             static const std::string tag = 
@@ -505,6 +643,11 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t) > {
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4));
         }
+        void read_local(mailbox_local_message_t *message,
+                        signal_t *interruptor) {
+            local_message_t *m = static_cast<local_message_t *>(message);
+            parent->fun(interruptor, std::move(m->arg0), std::move(m->arg1), std::move(m->arg2), std::move(m->arg3), std::move(m->arg4));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t) > *parent;
     };
@@ -531,7 +674,7 @@ public:
 
 private:
     template<class a0_t, class a1_t, class a2_t, class a3_t, class a4_t>
-    friend void send(mailbox_manager_t*,
+    friend void send(mailbox_manager_t*, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&);
 
     std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t) > fun;
@@ -540,14 +683,34 @@ private:
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t>
 void send(mailbox_manager_t *src,
+          message_lane_t lane,
           typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4) {
     typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t) >::write_impl_t writer(arg0, arg1, arg2, arg3, arg4);
-    send_write(src, dest.addr, &writer);
+    send_write(src, dest.addr, &writer, lane);
+}
+
+template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t>
+void send(mailbox_manager_t *src,
+          typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4) {
+    send(src, message_lane_t::REPLICATION, dest, arg0, arg1, arg2, arg3, arg4);
 }
 
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t>
 class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t) > {
+    class local_message_t : public mailbox_local_message_t {
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5)
+        { }
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+    };
+
     class write_impl_t : public mailbox_write_callback_t {
     private:
         const arg0_t &arg0;
@@ -569,6 +732,10 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t) > {
             serialize<cluster_version_t::CLUSTER>(wm, arg4);
             serialize<cluster_version_t::CLUSTER>(wm, arg5);
         }
+        scoped_ptr_t<mailbox_local_message_t> copy_for_local() {
+            return scoped_ptr_t<mailbox_local_message_t>(
+                new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5));
+        }
 #ifdef ENABLE_MESSAGE_PROFILER
         const char *message_profiler_tag() const {
             static const std::string tag = 
@@ -602,6 +769,11 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t) > {
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5));
         }
+        void read_local(mailbox_local_message_t *message,
+                        signal_t *interruptor) {
+            local_message_t *m = static_cast<local_message_t *>(message);
+            parent->fun(interruptor, std::move(m->arg0), std::move(m->arg1), std::move(m->arg2), std::move(m->arg3), std::move(m->arg4), std::move(m->arg5));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t) > *parent;
     };
@@ -628,7 +800,7 @@ public:
 
 private:
     template<class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t>
-    friend void send(mailbox_manager_t*,
+    friend void send(mailbox_manager_t*, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&);
 
     std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t) > fun;
@@ -637,14 +809,35 @@ private:
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t>
 void send(mailbox_manager_t *src,
+          message_lane_t lane,
           typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5) {
     typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t) >::write_impl_t writer(arg0, arg1, arg2, arg3, arg4, arg5);
-    send_write(src, dest.addr, &writer);
+    send_write(src, dest.addr, &writer, lane);
+}
+
+template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t>
+void send(mailbox_manager_t *src,
+          typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5) {
+    send(src, message_lane_t::REPLICATION, dest, arg0, arg1, arg2, arg3, arg4, arg5);
 }
 
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t>
 class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t) > {
+    class local_message_t : public mailbox_local_message_t {
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5, const arg6_t &_arg6) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5), arg6(_arg6)
+        { }
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+        arg6_t arg6;
+    };
+
     class write_impl_t : public mailbox_write_callback_t {
     private:
         const arg0_t &arg0;
@@ -668,6 +861,10 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t) >
             serialize<cluster_version_t::CLUSTER>(wm, arg5);
             serialize<cluster_version_t::CLUSTER>(wm, arg6);
         }
+        scoped_ptr_t<mailbox_local_message_t> copy_for_local() {
+            return scoped_ptr_t<mailbox_local_message_t>(
+                new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5, arg6));
+        }
 #ifdef ENABLE_MESSAGE_PROFILER
         const char *message_profiler_tag() const {
             static const std::string tag = 
@@ -704,6 +901,11 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t) >
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6));
         }
+        void read_local(mailbox_local_message_t *message,
+                        signal_t *interruptor) {
+            local_message_t *m = static_cast<local_message_t *>(message);
+            parent->fun(interruptor, std::move(m->arg0), std::move(m->arg1), std::move(m->arg2), std::move(m->arg3), std::move(m->arg4), std::move(m->arg5), std::move(m->arg6));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t) > *parent;
     };
@@ -730,7 +932,7 @@ public:
 
 private:
     template<class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t, class a6_t>
-    friend void send(mailbox_manager_t*,
+    friend void send(mailbox_manager_t*, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t, a6_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&, const a6_t&);
 
     std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t) > fun;
@@ -739,14 +941,36 @@ private:
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t>
 void send(mailbox_manager_t *src,
+          message_lane_t lane,
           typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5, const arg6_t &arg6) {
     typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t) >::write_impl_t writer(arg0, arg1, arg2, arg3, arg4, arg5, arg6);
-    send_write(src, dest.addr, &writer);
+    send_write(src, dest.addr, &writer, lane);
+}
+
+template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t>
+void send(mailbox_manager_t *src,
+          typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5, const arg6_t &arg6) {
+    send(src, message_lane_t::REPLICATION, dest, arg0, arg1, arg2, arg3, arg4, arg5, arg6);
 }
 
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t>
 class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t) > {
+    class local_message_t : public mailbox_local_message_t {
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5, const arg6_t &_arg6, const arg7_t &_arg7) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5), arg6(_arg6), arg7(_arg7)
+        { }
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+        arg6_t arg6;
+        arg7_t arg7;
+    };
+
     class write_impl_t : public mailbox_write_callback_t {
     private:
         const arg0_t &arg0;
@@ -772,6 +996,10 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             serialize<cluster_version_t::CLUSTER>(wm, arg6);
             serialize<cluster_version_t::CLUSTER>(wm, arg7);
         }
+        scoped_ptr_t<mailbox_local_message_t> copy_for_local() {
+            return scoped_ptr_t<mailbox_local_message_t>(
+                new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7));
+        }
 #ifdef ENABLE_MESSAGE_PROFILER
         const char *message_profiler_tag() const {
             static const std::string tag = 
@@ -811,6 +1039,11 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7));
         }
+        void read_local(mailbox_local_message_t *message,
+                        signal_t *interruptor) {
+            local_message_t *m = static_cast<local_message_t *>(message);
+            parent->fun(interruptor, std::move(m->arg0), std::move(m->arg1), std::move(m->arg2), std::move(m->arg3), std::move(m->arg4), std::move(m->arg5), std::move(m->arg6), std::move(m->arg7));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t) > *parent;
     };
@@ -837,7 +1070,7 @@ public:
 
 private:
     template<class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t, class a6_t, class a7_t>
-    friend void send(mailbox_manager_t*,
+    friend void send(mailbox_manager_t*, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t, a6_t, a7_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&, const a6_t&, const a7_t&);
 
     std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t) > fun;
@@ -846,14 +1079,37 @@ private:
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t>
 void send(mailbox_manager_t *src,
+          message_lane_t lane,
           typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5, const arg6_t &arg6, const arg7_t &arg7) {
     typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t) >::write_impl_t writer(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7);
-    send_write(src, dest.addr, &writer);
+    send_write(src, dest.addr, &writer, lane);
+}
+
+template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t>
+void send(mailbox_manager_t *src,
+          typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5, const arg6_t &arg6, const arg7_t &arg7) {
+    send(src, message_lane_t::REPLICATION, dest, arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7);
 }
 
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t>
 class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t) > {
+    class local_message_t : public mailbox_local_message_t {
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5, const arg6_t &_arg6, const arg7_t &_arg7, const arg8_t &_arg8) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5), arg6(_arg6), arg7(_arg7), arg8(_arg8)
+        { }
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+        arg6_t arg6;
+        arg7_t arg7;
+        arg8_t arg8;
+    };
+
     class write_impl_t : public mailbox_write_callback_t {
     private:
         const arg0_t &arg0;
@@ -881,6 +1137,10 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             serialize<cluster_version_t::CLUSTER>(wm, arg7);
             serialize<cluster_version_t::CLUSTER>(wm, arg8);
         }
+        scoped_ptr_t<mailbox_local_message_t> copy_for_local() {
+            return scoped_ptr_t<mailbox_local_message_t>(
+                new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8));
+        }
 #ifdef ENABLE_MESSAGE_PROFILER
         const char *message_profiler_tag() const {
             static const std::string tag = 
@@ -923,6 +1183,11 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8));
         }
+        void read_local(mailbox_local_message_t *message,
+                        signal_t *interruptor) {
+            local_message_t *m = static_cast<local_message_t *>(message);
+            parent->fun(interruptor, std::move(m->arg0), std::move(m->arg1), std::move(m->arg2), std::move(m->arg3), std::move(m->arg4), std::move(m->arg5), std::move(m->arg6), std::move(m->arg7), std::move(m->arg8));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t) > *parent;
     };
@@ -949,7 +1214,7 @@ public:
 
 private:
     template<class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t, class a6_t, class a7_t, class a8_t>
-    friend void send(mailbox_manager_t*,
+    friend void send(mailbox_manager_t*, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t, a6_t, a7_t, a8_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&, const a6_t&, const a7_t&, const a8_t&);
 
     std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t) > fun;
@@ -958,14 +1223,38 @@ private:
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t>
 void send(mailbox_manager_t *src,
+          message_lane_t lane,
           typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5, const arg6_t &arg6, const arg7_t &arg7, const arg8_t &arg8) {
     typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t) >::write_impl_t writer(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8);
-    send_write(src, dest.addr, &writer);
+    send_write(src, dest.addr, &writer, lane);
+}
+
+template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t>
+void send(mailbox_manager_t *src,
+          typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5, const arg6_t &arg6, const arg7_t &arg7, const arg8_t &arg8) {
+    send(src, message_lane_t::REPLICATION, dest, arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8);
 }
 
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t, class arg9_t>
 class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t) > {
+    class local_message_t : public mailbox_local_message_t {
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5, const arg6_t &_arg6, const arg7_t &_arg7, const arg8_t &_arg8, const arg9_t &_arg9) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5), arg6(_arg6), arg7(_arg7), arg8(_arg8), arg9(_arg9)
+        { }
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+        arg6_t arg6;
+        arg7_t arg7;
+        arg8_t arg8;
+        arg9_t arg9;
+    };
+
     class write_impl_t : public mailbox_write_callback_t {
     private:
         const arg0_t &arg0;
@@ -995,6 +1284,10 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             serialize<cluster_version_t::CLUSTER>(wm, arg8);
             serialize<cluster_version_t::CLUSTER>(wm, arg9);
         }
+        scoped_ptr_t<mailbox_local_message_t> copy_for_local() {
+            return scoped_ptr_t<mailbox_local_message_t>(
+                new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9));
+        }
 #ifdef ENABLE_MESSAGE_PROFILER
         const char *message_profiler_tag() const {
             static const std::string tag = 
@@ -1040,6 +1333,11 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9));
         }
+        void read_local(mailbox_local_message_t *message,
+                        signal_t *interruptor) {
+            local_message_t *m = static_cast<local_message_t *>(message);
+            parent->fun(interruptor, std::move(m->arg0), std::move(m->arg1), std::move(m->arg2), std::move(m->arg3), std::move(m->arg4), std::move(m->arg5), std::move(m->arg6), std::move(m->arg7), std::move(m->arg8), std::move(m->arg9));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t) > *parent;
     };
@@ -1066,7 +1364,7 @@ public:
 
 private:
     template<class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t, class a6_t, class a7_t, class a8_t, class a9_t>
-    friend void send(mailbox_manager_t*,
+    friend void send(mailbox_manager_t*, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t, a6_t, a7_t, a8_t, a9_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&, const a6_t&, const a7_t&, const a8_t&, const a9_t&);
 
     std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t) > fun;
@@ -1075,14 +1373,39 @@ private:
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t, class arg9_t>
 void send(mailbox_manager_t *src,
+          message_lane_t lane,
           typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5, const arg6_t &arg6, const arg7_t &arg7, const arg8_t &arg8, const arg9_t &arg9) {
     typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t) >::write_impl_t writer(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9);
-    send_write(src, dest.addr, &writer);
+    send_write(src, dest.addr, &writer, lane);
+}
+
+template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t, class arg9_t>
+void send(mailbox_manager_t *src,
+          typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5, const arg6_t &arg6, const arg7_t &arg7, const arg8_t &arg8, const arg9_t &arg9) {
+    send(src, message_lane_t::REPLICATION, dest, arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9);
 }
 
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t, class arg9_t, class arg10_t>
 class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t) > {
+    class local_message_t : public mailbox_local_message_t {
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5, const arg6_t &_arg6, const arg7_t &_arg7, const arg8_t &_arg8, const arg9_t &_arg9, const arg10_t &_arg10) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5), arg6(_arg6), arg7(_arg7), arg8(_arg8), arg9(_arg9), arg10(_arg10)
+        { }
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+        arg6_t arg6;
+        arg7_t arg7;
+        arg8_t arg8;
+        arg9_t arg9;
+        arg10_t arg10;
+    };
+
     class write_impl_t : public mailbox_write_callback_t {
     private:
         const arg0_t &arg0;
@@ -1114,6 +1437,10 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             serialize<cluster_version_t::CLUSTER>(wm, arg9);
             serialize<cluster_version_t::CLUSTER>(wm, arg10);
         }
+        scoped_ptr_t<mailbox_local_message_t> copy_for_local() {
+            return scoped_ptr_t<mailbox_local_message_t>(
+                new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10));
+        }
 #ifdef ENABLE_MESSAGE_PROFILER
         const char *message_profiler_tag() const {
             static const std::string tag = 
@@ -1162,6 +1489,11 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9), std::move(arg10));
         }
+        void read_local(mailbox_local_message_t *message,
+                        signal_t *interruptor) {
+            local_message_t *m = static_cast<local_message_t *>(message);
+            parent->fun(interruptor, std::move(m->arg0), std::move(m->arg1), std::move(m->arg2), std::move(m->arg3), std::move(m->arg4), std::move(m->arg5), std::move(m->arg6), std::move(m->arg7), std::move(m->arg8), std::move(m->arg9), std::move(m->arg10));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t) > *parent;
     };
@@ -1188,7 +1520,7 @@ public:
 
 private:
     template<class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t, class a6_t, class a7_t, class a8_t, class a9_t, class a10_t>
-    friend void send(mailbox_manager_t*,
+    friend void send(mailbox_manager_t*, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t, a6_t, a7_t, a8_t, a9_t, a10_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&, const a6_t&, const a7_t&, const a8_t&, const a9_t&, const a10_t&);
 
     std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t) > fun;
@@ -1197,14 +1529,40 @@ private:
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t, class arg9_t, class arg10_t>
 void send(mailbox_manager_t *src,
+          message_lane_t lane,
           typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5, const arg6_t &arg6, const arg7_t &arg7, const arg8_t &arg8, const arg9_t &arg9, const arg10_t &arg10) {
     typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t) >::write_impl_t writer(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10);
-    send_write(src, dest.addr, &writer);
+    send_write(src, dest.addr, &writer, lane);
+}
+
+template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t, class arg9_t, class arg10_t>
+void send(mailbox_manager_t *src,
+          typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5, const arg6_t &arg6, const arg7_t &arg7, const arg8_t &arg8, const arg9_t &arg9, const arg10_t &arg10) {
+    send(src, message_lane_t::REPLICATION, dest, arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10);
 }
 
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t, class arg9_t, class arg10_t, class arg11_t>
 class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t) > {
+    class local_message_t : public mailbox_local_message_t {
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5, const arg6_t &_arg6, const arg7_t &_arg7, const arg8_t &_arg8, const arg9_t &_arg9, const arg10_t &_arg10, const arg11_t &_arg11) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5), arg6(_arg6), arg7(_arg7), arg8(_arg8), arg9(_arg9), arg10(_arg10), arg11(_arg11)
+        { }
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+        arg6_t arg6;
+        arg7_t arg7;
+        arg8_t arg8;
+        arg9_t arg9;
+        arg10_t arg10;
+        arg11_t arg11;
+    };
+
     class write_impl_t : public mailbox_write_callback_t {
     private:
         const arg0_t &arg0;
@@ -1238,6 +1596,10 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             serialize<cluster_version_t::CLUSTER>(wm, arg10);
             serialize<cluster_version_t::CLUSTER>(wm, arg11);
         }
+        scoped_ptr_t<mailbox_local_message_t> copy_for_local() {
+            return scoped_ptr_t<mailbox_local_message_t>(
+                new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11));
+        }
 #ifdef ENABLE_MESSAGE_PROFILER
         const char *message_profiler_tag() const {
             static const std::string tag = 
@@ -1289,6 +1651,11 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9), std::move(arg10), std::move(arg11));
         }
+        void read_local(mailbox_local_message_t *message,
+                        signal_t *interruptor) {
+            local_message_t *m = static_cast<local_message_t *>(message);
+            parent->fun(interruptor, std::move(m->arg0), std::move(m->arg1), std::move(m->arg2), std::move(m->arg3), std::move(m->arg4), std::move(m->arg5), std::move(m->arg6), std::move(m->arg7), std::move(m->arg8), std::move(m->arg9), std::move(m->arg10), std::move(m->arg11));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t) > *parent;
     };
@@ -1315,7 +1682,7 @@ public:
 
 private:
     template<class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t, class a6_t, class a7_t, class a8_t, class a9_t, class a10_t, class a11_t>
-    friend void send(mailbox_manager_t*,
+    friend void send(mailbox_manager_t*, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t, a6_t, a7_t, a8_t, a9_t, a10_t, a11_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&, const a6_t&, const a7_t&, const a8_t&, const a9_t&, const a10_t&, const a11_t&);
 
     std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t) > fun;
@@ -1324,14 +1691,41 @@ private:
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t, class arg9_t, class arg10_t, class arg11_t>
 void send(mailbox_manager_t *src,
+          message_lane_t lane,
           typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5, const arg6_t &arg6, const arg7_t &arg7, const arg8_t &arg8, const arg9_t &arg9, const arg10_t &arg10, const arg11_t &arg11) {
     typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t) >::write_impl_t writer(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11);
-    send_write(src, dest.addr, &writer);
+    send_write(src, dest.addr, &writer, lane);
+}
+
+template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t, class arg9_t, class arg10_t, class arg11_t>
+void send(mailbox_manager_t *src,
+          typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5, const arg6_t &arg6, const arg7_t &arg7, const arg8_t &arg8, const arg9_t &arg9, const arg10_t &arg10, const arg11_t &arg11) {
+    send(src, message_lane_t::REPLICATION, dest, arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11);
 }
 
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t, class arg9_t, class arg10_t, class arg11_t, class arg12_t>
 class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t) > {
+    class local_message_t : public mailbox_local_message_t {
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5, const arg6_t &_arg6, const arg7_t &_arg7, const arg8_t &_arg8, const arg9_t &_arg9, const arg10_t &_arg10, const arg11_t &_arg11, const arg12_t &_arg12) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5), arg6(_arg6), arg7(_arg7), arg8(_arg8), arg9(_arg9), arg10(_arg10), arg11(_arg11), arg12(_arg12)
+        { }
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+        arg6_t arg6;
+        arg7_t arg7;
+        arg8_t arg8;
+        arg9_t arg9;
+        arg10_t arg10;
+        arg11_t arg11;
+        arg12_t arg12;
+    };
+
     class write_impl_t : public mailbox_write_callback_t {
     private:
         const arg0_t &arg0;
@@ -1367,6 +1761,10 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             serialize<cluster_version_t::CLUSTER>(wm, arg11);
             serialize<cluster_version_t::CLUSTER>(wm, arg12);
         }
+        scoped_ptr_t<mailbox_local_message_t> copy_for_local() {
+            return scoped_ptr_t<mailbox_local_message_t>(
+                new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11, arg12));
+        }
 #ifdef ENABLE_MESSAGE_PROFILER
         const char *message_profiler_tag() const {
             static const std::string tag = 
@@ -1421,6 +1819,11 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9), std::move(arg10), std::move(arg11), std::move(arg12));
         }
+        void read_local(mailbox_local_message_t *message,
+                        signal_t *interruptor) {
+            local_message_t *m = static_cast<local_message_t *>(message);
+            parent->fun(interruptor, std::move(m->arg0), std::move(m->arg1), std::move(m->arg2), std::move(m->arg3), std::move(m->arg4), std::move(m->arg5), std::move(m->arg6), std::move(m->arg7), std::move(m->arg8), std::move(m->arg9), std::move(m->arg10), std::move(m->arg11), std::move(m->arg12));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t) > *parent;
     };
@@ -1447,7 +1850,7 @@ public:
 
 private:
     template<class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t, class a6_t, class a7_t, class a8_t, class a9_t, class a10_t, class a11_t, class a12_t>
-    friend void send(mailbox_manager_t*,
+    friend void send(mailbox_manager_t*, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t, a6_t, a7_t, a8_t, a9_t, a10_t, a11_t, a12_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&, const a6_t&, const a7_t&, const a8_t&, const a9_t&, const a10_t&, const a11_t&, const a12_t&);
 
     std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t) > fun;
@@ -1456,14 +1859,42 @@ private:
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t, class arg9_t, class arg10_t, class arg11_t, class arg12_t>
 void send(mailbox_manager_t *src,
+          message_lane_t lane,
           typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5, const arg6_t &arg6, const arg7_t &arg7, const arg8_t &arg8, const arg9_t &arg9, const arg10_t &arg10, const arg11_t &arg11, const arg12_t &arg12) {
     typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t) >::write_impl_t writer(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11, arg12);
-    send_write(src, dest.addr, &writer);
+    send_write(src, dest.addr, &writer, lane);
+}
+
+template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t, class arg9_t, class arg10_t, class arg11_t, class arg12_t>
+void send(mailbox_manager_t *src,
+          typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5, const arg6_t &arg6, const arg7_t &arg7, const arg8_t &arg8, const arg9_t &arg9, const arg10_t &arg10, const arg11_t &arg11, const arg12_t &arg12) {
+    send(src, message_lane_t::REPLICATION, dest, arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11, arg12);
 }
 
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t, class arg9_t, class arg10_t, class arg11_t, class arg12_t, class arg13_t>
 class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t, arg13_t) > {
+    class local_message_t : public mailbox_local_message_t {
+    public:
+        local_message_t(const arg0_t &_arg0, const arg1_t &_arg1, const arg2_t &_arg2, const arg3_t &_arg3, const arg4_t &_arg4, const arg5_t &_arg5, const arg6_t &_arg6, const arg7_t &_arg7, const arg8_t &_arg8, const arg9_t &_arg9, const arg10_t &_arg10, const arg11_t &_arg11, const arg12_t &_arg12, const arg13_t &_arg13) :
+            arg0(_arg0), arg1(_arg1), arg2(_arg2), arg3(_arg3), arg4(_arg4), arg5(_arg5), arg6(_arg6), arg7(_arg7), arg8(_arg8), arg9(_arg9), arg10(_arg10), arg11(_arg11), arg12(_arg12), arg13(_arg13)
+        { }
+        arg0_t arg0;
+        arg1_t arg1;
+        arg2_t arg2;
+        arg3_t arg3;
+        arg4_t arg4;
+        arg5_t arg5;
+        arg6_t arg6;
+        arg7_t arg7;
+        arg8_t arg8;
+        arg9_t arg9;
+        arg10_t arg10;
+        arg11_t arg11;
+        arg12_t arg12;
+        arg13_t arg13;
+    };
+
     class write_impl_t : public mailbox_write_callback_t {
     private:
         const arg0_t &arg0;
@@ -1501,6 +1932,10 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             serialize<cluster_version_t::CLUSTER>(wm, arg12);
             serialize<cluster_version_t::CLUSTER>(wm, arg13);
         }
+        scoped_ptr_t<mailbox_local_message_t> copy_for_local() {
+            return scoped_ptr_t<mailbox_local_message_t>(
+                new local_message_t(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11, arg12, arg13));
+        }
 #ifdef ENABLE_MESSAGE_PROFILER
         const char *message_profiler_tag() const {
             static const std::string tag = 
@@ -1558,6 +1993,11 @@ class mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, ar
             if (bad(res)) { throw fake_archive_exc_t(); }
             parent->fun(interruptor, std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5), std::move(arg6), std::move(arg7), std::move(arg8), std::move(arg9), std::move(arg10), std::move(arg11), std::move(arg12), std::move(arg13));
         }
+        void read_local(mailbox_local_message_t *message,
+                        signal_t *interruptor) {
+            local_message_t *m = static_cast<local_message_t *>(message);
+            parent->fun(interruptor, std::move(m->arg0), std::move(m->arg1), std::move(m->arg2), std::move(m->arg3), std::move(m->arg4), std::move(m->arg5), std::move(m->arg6), std::move(m->arg7), std::move(m->arg8), std::move(m->arg9), std::move(m->arg10), std::move(m->arg11), std::move(m->arg12), std::move(m->arg13));
+        }
     private:
         mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t, arg13_t) > *parent;
     };
@@ -1584,7 +2024,7 @@ public:
 
 private:
     template<class a0_t, class a1_t, class a2_t, class a3_t, class a4_t, class a5_t, class a6_t, class a7_t, class a8_t, class a9_t, class a10_t, class a11_t, class a12_t, class a13_t>
-    friend void send(mailbox_manager_t*,
+    friend void send(mailbox_manager_t*, message_lane_t,
                      typename mailbox_t< void(a0_t, a1_t, a2_t, a3_t, a4_t, a5_t, a6_t, a7_t, a8_t, a9_t, a10_t, a11_t, a12_t, a13_t) >::address_t, const a0_t&, const a1_t&, const a2_t&, const a3_t&, const a4_t&, const a5_t&, const a6_t&, const a7_t&, const a8_t&, const a9_t&, const a10_t&, const a11_t&, const a12_t&, const a13_t&);
 
     std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t, arg13_t) > fun;
@@ -1593,9 +2033,16 @@ private:
 
 template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t, class arg9_t, class arg10_t, class arg11_t, class arg12_t, class arg13_t>
 void send(mailbox_manager_t *src,
+          message_lane_t lane,
           typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t, arg13_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5, const arg6_t &arg6, const arg7_t &arg7, const arg8_t &arg8, const arg9_t &arg9, const arg10_t &arg10, const arg11_t &arg11, const arg12_t &arg12, const arg13_t &arg13) {
     typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t, arg13_t) >::write_impl_t writer(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11, arg12, arg13);
-    send_write(src, dest.addr, &writer);
+    send_write(src, dest.addr, &writer, lane);
+}
+
+template<class arg0_t, class arg1_t, class arg2_t, class arg3_t, class arg4_t, class arg5_t, class arg6_t, class arg7_t, class arg8_t, class arg9_t, class arg10_t, class arg11_t, class arg12_t, class arg13_t>
+void send(mailbox_manager_t *src,
+          typename mailbox_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t, arg13_t) >::address_t dest, const arg0_t &arg0, const arg1_t &arg1, const arg2_t &arg2, const arg3_t &arg3, const arg4_t &arg4, const arg5_t &arg5, const arg6_t &arg6, const arg7_t &arg7, const arg8_t &arg8, const arg9_t &arg9, const arg10_t &arg10, const arg11_t &arg11, const arg12_t &arg12, const arg13_t &arg13) {
+    send(src, message_lane_t::REPLICATION, dest, arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11, arg12, arg13);
 }
 
 #endif // RPC_MAILBOX_TYPED_HPP_
@@ -12,11 +12,23 @@
 
 
 merger_serializer_t::merger_serializer_t(scoped_ptr_t<serializer_t> _inner,
-                                         int _max_active_writes) :
+                                         int _max_active_writes,
+                                         perfmon_collection_t *perfmon_parent) :
     inner(std::move(_inner)),
     block_writes_io_account(make_io_account(MERGER_BLOCK_WRITE_IO_PRIORITY)),
+    outstanding_index_writes(0),
+    pm_index_writes_per_commit(secs_to_ticks(1), false),
+    pm_index_write_latency(secs_to_ticks(1)),
+    stats_membership(&perfmon_collection,
+        &pm_index_writes_per_commit, "index_writes_per_commit",
+        &pm_index_write_latency, "index_write_latency"),
     write_committer(std::bind(&merger_serializer_t::do_index_write, this),
-                    _max_active_writes) { }
+                    _max_active_writes) {
+    if (perfmon_parent != nullptr) {
+        parent_membership.init(new perfmon_membership_t(
+            perfmon_parent, &perfmon_collection, "serializer_merger"));
+    }
+}
 
 merger_serializer_t::~merger_serializer_t() {
     assert_thread();
@@ -41,6 +53,7 @@ void merger_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                                       const std::vector<index_write_op_t> &write_ops) {
     rassert(coro_t::self() != nullptr);
     assert_thread();
+    block_pm_duration latency_timer(&pm_index_write_latency);
 
     // Apply our set of write ops atomically
     {
@@ -48,6 +61,7 @@ void merger_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
         for (auto op = write_ops.begin(); op != write_ops.end(); ++op) {
             push_index_write_op(*op);
         }
+        ++outstanding_index_writes;
     }
 
     // Changes are now visible for subsequent `index_read()` calls.
@@ -90,6 +104,10 @@ void merger_serializer_t::do_index_write() {
             // we can reset outstanding_index_write_ops and allow new write ops to
             // get in line.
             outstanding_index_write_ops.clear();
+            if (outstanding_index_writes != 0) {
+                pm_index_writes_per_commit.record(outstanding_index_writes);
+                outstanding_index_writes = 0;
+            }
             outstanding_mutex_acq.reset();
         },
         write_ops);
@@ -10,6 +10,7 @@
 #include "concurrency/new_mutex.hpp"
 #include "concurrency/pump_coro.hpp"
 #include "containers/scoped.hpp"
+#include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
 #include "serializer/serializer.hpp"
 
@@ -22,6 +23,11 @@
  * hash shards) can be merged together, improving efficiency and significantly
  * reducing the number of disk seeks on rotational drives.
  *
+ * This is how writes with hard durability get committed as a group: the index
+ * writes of all transactions that become ready while a commit is in progress are
+ * committed together by the next one, so each commit (and its metablock write)
+ * covers as many transactions as arrived during the previous one.
+ *
  * As an additional optimization, merger_serializer_t uses a common file account
  * for all block_writes, so reduce the amount of random disk seeks that can
  * occur when writes from multiple different accounts get interleaved (see
@@ -30,7 +36,10 @@
 
 class merger_serializer_t : public serializer_t {
 public:
-    merger_serializer_t(scoped_ptr_t<serializer_t> _inner, int _max_active_writes);
+    // `perfmon_parent` may be null.
+    merger_serializer_t(scoped_ptr_t<serializer_t> _inner,
+                        int _max_active_writes,
+                        perfmon_collection_t *perfmon_parent);
     ~merger_serializer_t();
 
 
@@ -139,6 +148,17 @@ private:
     // and before they have become visible to `index_read()` calls on the inner
     // serializer.
     new_mutex_t outstanding_index_write_mutex;
+    // The number of `index_write()` calls whose ops are in
+    // `outstanding_index_write_ops`.
+    int64_t outstanding_index_writes;
+
+    perfmon_collection_t perfmon_collection;
+    // How many `index_write()` calls each write to the inner serializer commits, and
+    // how long the calls take, including the wait for other calls to join them.
+    perfmon_sampler_t pm_index_writes_per_commit;
+    perfmon_duration_sampler_t pm_index_write_latency;
+    perfmon_multi_membership_t stats_membership;
+    scoped_ptr_t<perfmon_membership_t> parent_membership;
 
     pump_coro_t write_committer;
 
@@ -4,7 +4,9 @@
 #include "unittest/gtest.hpp"
 
 #include "containers/archive/boost_types.hpp"
+#include "containers/archive/compression.hpp"
 #include "containers/archive/stl_types.hpp"
+#include "unittest/unittest_utils.hpp"
 
 namespace unittest {
 
@@ -34,6 +36,60 @@ TEST(WriteMessageTest, Variant) {
     ASSERT_EQ(15u, s.size());
 }
 
+TPTEST(WriteMessageTest, Compressed) {
+    std::string data;
+    for (int i = 0; i < 10000; ++i) {
+        data += strprintf("{\"id\": %d, \"name\": \"document number %d\"}", i, i);
+    }
+
+    for (compression_t compression :
+             {compression_t::NONE, compression_t::FAST, compression_t::SMALL}) {
+        write_message_t wm;
+        serialize<cluster_version_t::CLUSTER>(
+            &wm, compressed_t<std::string>(compression, std::string(data)));
+        std::string s;
+        dump_to_string(&wm, &s);
+        if (compression == compression_t::NONE) {
+            ASSERT_GT(s.size(), data.size());
+        } else {
+            ASSERT_LT(s.size(), data.size() / 4);
+        }
+
+        compressed_t<std::string> out;
+        buffer_read_stream_t stream(s.data(), s.size());
+        ASSERT_EQ(archive_result_t::SUCCESS,
+                  deserialize<cluster_version_t::CLUSTER>(&stream, &out));
+        EXPECT_TRUE(out.compression == compression);
+        EXPECT_EQ(data, out.value);
+        EXPECT_EQ(static_cast<int64_t>(s.size()), stream.tell());
+
+        if (compression != compression_t::NONE) {
+            /* A corrupted message is rejected rather than decompressed. */
+            s[s.size() / 2] ^= 0x55;
+            compressed_t<std::string> corrupted;
+            buffer_read_stream_t corrupted_stream(s.data(), s.size());
+            EXPECT_TRUE(bad(deserialize<cluster_version_t::CLUSTER>(
+                &corrupted_stream, &corrupted)));
+        }
+    }
+}
 
+TPTEST(WriteMessageTest, BuffersReused) {
+    const std::string data(3 * write_buffer_t::DATA_SIZE, 'x');
+    write_buffer_t *last_buffer;
+    {
+        write_message_t wm;
+        wm.append(data.data(), data.size());
+        last_buffer = wm.unsafe_expose_buffers()->tail();
+    }
+
+    /* The last buffer freed is the first one handed out again, emptied. */
+    write_message_t wm;
+    wm.append("abc", 3);
+    std::string s;
+    dump_to_string(&wm, &s);
+    EXPECT_EQ("abc", s);
+    EXPECT_TRUE(wm.unsafe_expose_buffers()->head() == last_buffer);
+}
 
 }  // namespace unittest
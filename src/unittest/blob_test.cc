@@ -130,10 +130,30 @@ public:
         check(txn);
     }
 
+    // The blob must be empty.
+    void write_reusing_blocks(txn_t *txn, const blob_tracker_t &old,
+                              const std::string &x) {
+        SCOPED_TRACE(strprintf("write_reusing_blocks (%zu)", x.size()));
+        blob_.write_reusing_blocks(buf_parent_t(txn), old.blob_, x);
+        expected_ = x;
+        check(txn);
+    }
+
+    void clear_unshared(txn_t *txn, const blob_tracker_t &replacement) {
+        SCOPED_TRACE("clear_unshared");
+        blob_.clear_unshared(buf_parent_t(txn), replacement.blob_);
+        expected_.clear();
+        check(txn);
+    }
+
     size_t refsize(max_block_size_t block_size) const {
         return blob_.refsize(block_size);
     }
 
+    const char *ref() const {
+        return buf_.data();
+    }
+
 private:
     std::string expected_;
     scoped_array_t<char> buf_;
@@ -263,6 +283,49 @@ void combinations_test(cache_t *cache) {
     }
 }
 
+void reuse_blocks_test(cache_t *cache) {
+    SCOPED_TRACE("reuse_blocks_test");
+    cache_conn_t cache_conn(cache);
+    txn_t txn(&cache_conn, write_durability_t::SOFT, 0);
+
+    // Three level 2 subtrees, the last one of which is not full.
+    const int64_t l2_sz = size_after_magic * (size_after_magic / sizeof(block_id_t));
+    std::string old_value;
+    for (int64_t i = 0; i < 2 * l2_sz + 1000; ++i) {
+        old_value.push_back('a' + i % 26);
+    }
+
+    std::string one_byte_changed = old_value;
+    one_byte_changed[l2_sz + 5] = 'Z';
+    std::vector<std::string> new_values{
+        old_value,
+        one_byte_changed,
+        old_value + "appended",
+        old_value.substr(0, old_value.size() - 1),
+        old_value.substr(0, size_after_magic * 3),
+        std::string(old_value.size(), 'b')};
+
+    for (const std::string &new_value : new_values) {
+        blob_tracker_t old_tk(251);
+        old_tk.append(&txn, old_value);
+        blob_tracker_t new_tk(251);
+        new_tk.write_reusing_blocks(&txn, old_tk, new_value);
+        old_tk.check(&txn);
+
+        if (&new_value == &new_values[1]) {
+            // Only the subtree with the changed byte is new.
+            const block_id_t *old_ids = blob::block_ids(old_tk.ref(), 251);
+            const block_id_t *new_ids = blob::block_ids(new_tk.ref(), 251);
+            EXPECT_EQ(old_ids[0], new_ids[0]);
+            EXPECT_NE(old_ids[1], new_ids[1]);
+            EXPECT_EQ(old_ids[2], new_ids[2]);
+        }
+
+        old_tk.clear_unshared(&txn, new_tk);
+        new_tk.check(&txn);
+        new_tk.clear(&txn);
+    }
+}
 
 void run_tests(cache_t *cache) {
     // The tests above hard-code constants related to these numbers.
@@ -276,6 +339,7 @@ void run_tests(cache_t *cache) {
     small_value_test(cache);
     small_value_boundary_test(cache);
     combinations_test(cache);
+    reuse_blocks_test(cache);
 }
 
 TPTEST(BlobTest, all_tests) {
@@ -2,12 +2,16 @@
 
 #include "arch/io/disk.hpp"
 #include "arch/types.hpp"
+#include "btree/bulk_load.hpp"
+#include "btree/internal_node.hpp"
 #include "btree/reql_specific.hpp"
 #include "buffer_cache/cache_balancer.hpp"
+#include "concurrency/promise.hpp"
 #include "rdb_protocol/btree.hpp"
 #include "repli_timestamp.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "serializer/merger.hpp"
+#include "time.hpp"
 #include "unittest/btree_utils.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
@@ -52,7 +56,8 @@ public:
 
         serializer = make_scoped<merger_serializer_t>(
                 std::move(inner_serializer),
-                MERGER_SERIALIZER_MAX_ACTIVE_WRITES);
+                MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+                &get_global_perfmon_collection());
 
         cache = make_scoped<cache_t>(serializer.get(), &balancer, &get_global_perfmon_collection());
         cache_conn = make_scoped<cache_conn_t>(cache.get());
@@ -205,6 +210,108 @@ public:
         remove(key, repli_timestamp_t::distant_past);
     }
 
+    // Sets the keys that have a value and removes the others in a single
+    // transaction, in key order.  If `leaf_grouped` is true, it only walks down the
+    // tree when `move_keyvalue_location_for_write` can't get to the next key from the
+    // leaf node of the previous one.  Returns the number of walks.
+    size_t apply_batch(
+            const std::map<store_key_t, boost::optional<std::string> > &changes,
+            bool leaf_grouped) {
+        size_t walks = 0;
+        run_txn_fn(true, [&](scoped_ptr_t<real_superblock_t> &&superblock){
+            profile::trace_t trace;
+            noop_value_deleter_t deleter;
+            null_key_modification_callback_t null_cb;
+            const repli_timestamp_t timestamp = repli_timestamp_t::distant_past;
+
+            superblock_t *current_superblock = superblock.get();
+            auto it = changes.begin();
+            while (it != changes.end()) {
+                promise_t<superblock_t *> superblock_promise;
+                {
+                    keyvalue_location_t kv_location;
+                    find_keyvalue_location_for_write(
+                        sizer.get(),
+                        current_superblock,
+                        it->first.btree_key(),
+                        timestamp,
+                        &deleter,
+                        &kv_location,
+                        &trace,
+                        &superblock_promise);
+                    ++walks;
+                    do {
+                        if (it->second) {
+                            short_value_buffer_t buf(*it->second);
+                            char *data = reinterpret_cast<char *>(buf.data());
+                            kv_location.value = scoped_malloc_t<void>(data, buf.size());
+                        } else {
+                            kv_location.value.reset();
+                        }
+                        apply_keyvalue_change(
+                            sizer.get(),
+                            &kv_location,
+                            it->first.btree_key(),
+                            timestamp,
+                            &deleter,
+                            &null_cb,
+                            delete_mode_t::REGULAR_QUERY);
+                        ++it;
+                    } while (leaf_grouped
+                             && it != changes.end()
+                             && move_keyvalue_location_for_write(
+                                 sizer.get(), it->first.btree_key(), &kv_location));
+                }
+                current_superblock = superblock_promise.wait();
+            }
+        });
+
+        for (const auto &change : changes) {
+            if (change.second) {
+                kv[change.first] = *change.second;
+            } else {
+                kv.erase(change.first);
+            }
+        }
+        return walks;
+    }
+
+    // Builds the B-tree, which must be empty, with `btree_bulk_loader_t`.
+    void bulk_load(const std::map<store_key_t, std::string> &entries,
+                   double fill_factor) {
+        run_txn_fn(true, [&](scoped_ptr_t<real_superblock_t> &&superblock){
+            btree_bulk_loader_t loader(sizer.get(),
+                                       superblock.get(),
+                                       repli_timestamp_t::distant_past,
+                                       fill_factor);
+            for (const auto &entry : entries) {
+                loader.add(entry.first.btree_key(), [&](buf_parent_t, void *value_out) {
+                    short_value_buffer_t buf(entry.second);
+                    memcpy(value_out, buf.data(), buf.size());
+                });
+            }
+            loader.finish();
+        });
+
+        for (const auto &entry : entries) {
+            kv[entry.first] = entry.second;
+        }
+    }
+
+    // The number of leaf and internal nodes in the B-tree.
+    size_t count_nodes() {
+        size_t count = 0;
+        run_txn_fn(false, [&](scoped_ptr_t<real_superblock_t> &&superblock){
+            const block_id_t root_id = superblock->get_root_block_id();
+            if (root_id != NULL_BLOCK_ID) {
+                buf_lock_t root(superblock->expose_buf(), root_id, access_t::read);
+                superblock->release();
+                count = count_nodes(&root);
+            }
+        });
+        return count;
+    }
+
     void range(const key_range_t &_range) {
         std::map<store_key_t, std::string> bt_map;
 
@@ -303,6 +410,27 @@ public:
     }
 
 private:
+    size_t count_nodes(buf_lock_t *buf) {
+        std::vector<block_id_t> children;
+        {
+            buf_read_t read(buf);
+            auto node = static_cast<const node_t *>(read.get_data_read());
+            if (node::is_leaf(node)) {
+                return 1;
+            }
+            auto internal = reinterpret_cast<const internal_node_t *>(node);
+            for (int i = 0; i < internal->npairs; ++i) {
+                children.push_back(internal_node::get_pair_by_index(internal, i)->lnode);
+            }
+        }
+        size_t count = 1;
+        for (block_id_t child_id : children) {
+            buf_lock_t child(buf, child_id, access_t::read);
+            count += count_nodes(&child);
+        }
+        return count;
+    }
+
     temp_file_t temp_file;
     io_backender_t io_backender;
     filepath_file_opener_t file_opener;
@@ -498,4 +626,161 @@ TPTEST(BTree, RemoveRandomOrder) {
     ctx.verify();
 }
 
+std::string sequential_key(int i) {
+    return strprintf("%08d", i);
+}
+
+TPTEST(BTree, LeafGroupedBatchSequential) {
+    BTreeTestContext ctx;
+    rng_t rng;
+
+    const int num_keys = 3000;
+    const int batch_size = 250;
+    size_t walks = 0;
+    for (int i = 0; i < num_keys; i += batch_size) {
+        std::map<store_key_t, boost::optional<std::string> > batch;
+        for (int j = i; j < i + batch_size; ++j) {
+            batch[store_key_t(sequential_key(j))] = random_letter_string(&rng, 0, 250);
+        }
+        walks += ctx.apply_batch(batch, true);
+        ctx.verify();
+    }
+    // Appending to the last leaf only needs a walk when its parent is full.
+    EXPECT_LT(walks * 10, static_cast<size_t>(num_keys));
+
+    // Removing ranges of keys merges and levels leaf nodes.
+    for (int i = 0; i < num_keys; i += 2 * batch_size) {
+        std::map<store_key_t, boost::optional<std::string> > batch;
+        for (int j = i; j < i + batch_size; ++j) {
+            batch[store_key_t(sequential_key(j))] = boost::none;
+        }
+        ctx.apply_batch(batch, true);
+        ctx.verify();
+    }
+}
+
+TPTEST(BTree, LeafGroupedBatchRandom) {
+    BTreeTestContext ctx;
+    rng_t rng;
+
+    for (int i = 0; i < 40; ++i) {
+        std::map<store_key_t, boost::optional<std::string> > batch;
+        for (int j = 0; j < 100; ++j) {
+            if (!ctx.is_empty() && rng.randint(3) == 0) {
+                store_key_t key = ctx.pick_random_key(&rng);
+                if (rng.randint(2) == 0) {
+                    batch[key] = boost::none;
+                } else {
+                    batch[key] = random_letter_string(&rng, 0, 250);
+                }
+            } else {
+                batch[store_key_t(random_letter_string(&rng, 1, 250))]
+                    = random_letter_string(&rng, 0, 250);
+            }
+        }
+        ctx.apply_batch(batch, true);
+        ctx.verify();
+    }
+
+    // Leave behind sparse leaf nodes, and then empty most of them.
+    while (!ctx.is_empty()) {
+        std::map<store_key_t, boost::optional<std::string> > batch;
+        for (int j = 0; j < 100 && !ctx.is_empty(); ++j) {
+            batch[ctx.pick_random_key(&rng)] = boost::none;
+        }
+        ctx.apply_batch(batch, true);
+        ctx.verify();
+    }
+}
+
+TPTEST(BTree, BulkLoad) {
+    rng_t rng;
+    for (int num_keys : {0, 1, 100, 20000}) {
+        for (double fill_factor : {0.5, 1.0}) {
+            BTreeTestContext ctx;
+            std::map<store_key_t, std::string> entries;
+            while (entries.size() < static_cast<size_t>(num_keys)) {
+                entries[store_key_t(random_letter_string(&rng, 1, 250))]
+                    = random_letter_string(&rng, 0, 250);
+            }
+            ctx.bulk_load(entries, fill_factor);
+            ctx.verify();
+
+            // The result is an ordinary B-tree.
+            for (int i = 0; i < 300; ++i) {
+                if (!ctx.is_empty() && rng.randint(2) == 0) {
+                    ctx.remove(ctx.pick_random_key(&rng));
+                } else {
+                    ctx.set(store_key_t(random_letter_string(&rng, 1, 250)),
+                            random_letter_string(&rng, 0, 250));
+                }
+            }
+            ctx.verify();
+        }
+    }
+}
+
+#ifdef NDEBUG
+TPTEST(BTree, BulkLoadBenchmark) {
+    const int num_keys = 200000;
+    rng_t rng;
+    std::map<store_key_t, std::string> entries;
+    while (entries.size() < static_cast<size_t>(num_keys)) {
+        entries[store_key_t(sequential_key(rng.randint(1000000000)))]
+            = std::string(100, 'x');
+    }
+
+    {
+        BTreeTestContext ctx;
+        ticks_t start_ticks = get_ticks();
+        ctx.bulk_load(entries, 0.9);
+        double dur = ticks_to_secs(get_ticks() - start_ticks);
+        printf("bulk load: %f us per key, %zu nodes\n",
+               dur / num_keys * 1000000, ctx.count_nodes());
+    }
+    {
+        // Random order, as if the keys came in one at a time.
+        std::vector<std::pair<store_key_t, std::string> > shuffled(
+            entries.begin(), entries.end());
+        for (size_t i = shuffled.size(); i > 1; --i) {
+            std::swap(shuffled[i - 1], shuffled[rng.randint(i)]);
+        }
+        BTreeTestContext ctx;
+        ticks_t start_ticks = get_ticks();
+        for (const auto &entry : shuffled) {
+            ctx.set(entry.first, entry.second);
+        }
+        double dur = ticks_to_secs(get_ticks() - start_ticks);
+        printf("one insert at a time: %f us per key, %zu nodes\n",
+               dur / num_keys * 1000000, ctx.count_nodes());
+    }
+}
+
+TPTEST(BTree, LeafGroupedBatchBenchmark) {
+    const int num_keys = 200000;
+    const int batch_size = 1000;
+    for (bool random_keys : {false, true}) {
+        for (bool leaf_grouped : {false, true}) {
+            BTreeTestContext ctx;
+            rng_t rng;
+            size_t walks = 0;
+            ticks_t start_ticks = get_ticks();
+            for (int i = 0; i < num_keys; i += batch_size) {
+                std::map<store_key_t, boost::optional<std::string> > batch;
+                for (int j = i; j < i + batch_size; ++j) {
+                    int k = random_keys ? rng.randint(1000000000) : j;
+                    batch[store_key_t(sequential_key(k))] = std::string(100, 'x');
+                }
+                walks += ctx.apply_batch(batch, leaf_grouped);
+            }
+            double dur = ticks_to_secs(get_ticks() - start_ticks);
+            printf("%s keys, %s: %f us per insert, %zu walks down the tree\n",
+                   random_keys ? "random" : "sequential",
+                   leaf_grouped ? "leaf-grouped" : "one walk per key",
+                   dur / num_keys * 1000000, walks);
+        }
+    }
+}
+#endif  // NDEBUG
+
 } // namespace unittest
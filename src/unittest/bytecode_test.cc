@@ -0,0 +1,185 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "concurrency/cond_var.hpp"
+#include "rdb_protocol/bytecode.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/term.hpp"
+#include "rdb_protocol/val.hpp"
+#include "rdb_protocol/wire_func.hpp"
+#include "time.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+counted_t<const ql::reql_func_t> make_reql_func(ql::minidriver_t::reql_t body) {
+    ql::sym_t one(1);
+    counted_t<const ql::func_t> f =
+        ql::wire_func_t(body.root_term(), make_vector(one)).compile_wire_func();
+    const ql::reql_func_t *reql_func = dynamic_cast<const ql::reql_func_t *>(f.get());
+    guarantee(reql_func != nullptr);
+    return counted_t<const ql::reql_func_t>(reql_func);
+}
+
+bool is_compiled(const counted_t<const ql::reql_func_t> &f) {
+    return ql::bytecode_program_t::compile(
+        f->get_arg_names(), f->get_body()->get_src(), f->get_body().get()).has();
+}
+
+// Either the result or the error message, prefixed with the error type.
+std::string describe_result(const std::function<ql::datum_t()> &fn) {
+    try {
+        return fn().print();
+    } catch (const ql::base_exc_t &e) {
+        return strprintf("error %d: %s", static_cast<int>(e.get_type()), e.what());
+    }
+}
+
+std::string call_tree(ql::env_t *env,
+                      const counted_t<const ql::reql_func_t> &f,
+                      ql::datum_t row) {
+    return describe_result([&]() {
+        ql::scope_env_t scope_env(
+            env, ql::var_scope_t().with_func_arg_list(f->get_arg_names(),
+                                                      make_vector(row)));
+        return f->get_body()->eval(&scope_env)->as_datum();
+    });
+}
+
+std::string call_func(ql::env_t *env,
+                      const counted_t<const ql::reql_func_t> &f,
+                      ql::datum_t row) {
+    const ql::func_t *func = f.get();
+    return describe_result([&]() { return func->call(env, row)->as_datum(); });
+}
+
+std::vector<ql::datum_t> make_rows() {
+    std::vector<ql::datum_t> rows;
+    for (int i = 0; i < 6; ++i) {
+        ql::datum_object_builder_t row;
+        row.overwrite("id", ql::datum_t(static_cast<double>(i)));
+        row.overwrite("age", i == 4
+                      ? ql::datum_t::null()
+                      : ql::datum_t(static_cast<double>(10 * i)));
+        if (i != 5) {
+            row.overwrite("name", ql::datum_t(strprintf("n%d", i).c_str()));
+        }
+        ql::datum_object_builder_t nested;
+        nested.overwrite("x", ql::datum_t(static_cast<double>(i % 2)));
+        row.overwrite("nested", std::move(nested).to_datum());
+        rows.push_back(std::move(row).to_datum());
+    }
+    return rows;
+}
+
+std::vector<ql::minidriver_t::reql_t> make_compiled_bodies(ql::minidriver_t *r) {
+    ql::sym_t one(1);
+    ql::datum_object_builder_t extra;
+    extra.overwrite("extra", ql::datum_t::boolean(true));
+    ql::datum_t extra_datum = std::move(extra).to_datum();
+
+    return std::vector<ql::minidriver_t::reql_t>{
+        (r->var(one)["age"] > 15.0) && (r->var(one)["age"] <= 40.0),
+        r->var(one)["age"] == 20.0,
+        !(r->var(one)["name"] == std::string("n1")),
+        // Value semantics of `and`, and errors on missing fields and `null`.
+        r->var(one)["age"] && r->var(one)["name"],
+        (r->var(one)["age"] + 1.0) / 2.0,
+        r->var(one)["age"] / r->var(one)["id"],
+        r->var(one)["name"] + std::string("!"),
+        r->var(one)["nested"]["x"] == 1.0,
+        r->var(one)["name"].default_(std::string("none")),
+        (r->var(one)["name"] > std::string("n2")).default_(false),
+        r->var(one).merge(extra_datum).pluck(std::string("id"), std::string("extra")),
+        r->var(one).bracket(std::string("missing")),
+        // Registers that are reused across nested terms.
+        !(r->var(one)["age"] > 15.0)
+            && (r->var(one)["nested"]["x"].default_(0.0) + r->var(one)["id"] > 2.0),
+        r->var(one),
+    };
+}
+
+TPTEST(Bytecode, MatchesTermTree) {
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    std::vector<ql::datum_t> rows = make_rows();
+
+    for (const auto &body : make_compiled_bodies(&r)) {
+        counted_t<const ql::reql_func_t> f = make_reql_func(body);
+        EXPECT_TRUE(is_compiled(f)) << f->print_source();
+        for (const auto &row : rows) {
+            EXPECT_EQ(call_tree(&env, f, row), call_func(&env, f, row))
+                << f->print_source() << " on " << row.print();
+        }
+    }
+}
+
+TEST(Bytecode, DoesNotCompileOtherTerms) {
+    ql::sym_t one(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    EXPECT_FALSE(is_compiled(make_reql_func(r.array(r.var(one)["a"]))));
+    EXPECT_FALSE(is_compiled(make_reql_func(
+        r.var(one)["a"].default_(r.fun(r.expr(1.0))))));
+    EXPECT_FALSE(is_compiled(make_reql_func(r.var(one).count())));
+}
+
+TEST(Bytecode, OperandsNeedNoInstructions) {
+    ql::sym_t one(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    counted_t<const ql::reql_func_t> f = make_reql_func(r.var(one)["age"] > 30.0);
+    counted_t<const ql::bytecode_program_t> program =
+        ql::bytecode_program_t::compile(
+            f->get_arg_names(), f->get_body()->get_src(), f->get_body().get());
+    ASSERT_TRUE(program.has());
+    // The field access and the comparison with the literal.
+    EXPECT_EQ(2u, program->size());
+}
+
+#ifdef NDEBUG
+TPTEST(Bytecode, Benchmark) {
+    const int NUM_REPETITIONS = 100000;
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    ql::sym_t one(1);
+    ql::datum_t row = make_rows()[2];
+
+    std::vector<std::pair<const char *, ql::minidriver_t::reql_t> > bodies{
+        std::make_pair("filter",
+                       (r.var(one)["age"] > 15.0) && (r.var(one)["age"] <= 40.0)),
+        std::make_pair("map", (r.var(one)["age"] + 1.0) / 2.0)};
+    for (const auto &pair : bodies) {
+        counted_t<const ql::reql_func_t> f = make_reql_func(pair.second);
+        ql::var_scope_t scope =
+            ql::var_scope_t().with_func_arg_list(f->get_arg_names(), make_vector(row));
+
+        ticks_t start_ticks = get_ticks();
+        for (int i = 0; i < NUM_REPETITIONS; ++i) {
+            ql::scope_env_t scope_env(&env, ql::var_scope_t(scope));
+            f->get_body()->eval(&scope_env);
+        }
+        double dur_tree = ticks_to_secs(get_ticks() - start_ticks);
+
+        const ql::func_t *func = f.get();
+        start_ticks = get_ticks();
+        for (int i = 0; i < NUM_REPETITIONS; ++i) {
+            func->call(&env, row);
+        }
+        double dur_bytecode = ticks_to_secs(get_ticks() - start_ticks);
+
+        printf("%s: %f us per row with the term tree, %f us with bytecode\n",
+               pair.first,
+               dur_tree / NUM_REPETITIONS * 1000000,
+               dur_bytecode / NUM_REPETITIONS * 1000000);
+    }
+}
+#endif  // NDEBUG
+
+}  // namespace unittest
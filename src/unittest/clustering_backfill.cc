@@ -117,6 +117,11 @@ TPTEST(ClusteringBackfill, BackfillTest) {
                 return true;
             }
         } callback;
+        /* Copy what we can in parallel range sessions first, like a new replica does */
+        EXPECT_TRUE(backfillee.copy(
+            &callback,
+            key_range_t::right_bound_t(backfillee_store.get_region().inner.left),
+            &non_interruptor));
         backfillee.go(
             &callback,
             key_range_t::right_bound_t(backfillee_store.get_region().inner.left),
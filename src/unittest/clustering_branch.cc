@@ -1,16 +1,24 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "unittest/gtest.hpp"
 
+#include "clustering/administration/metadata.hpp"
 #include "clustering/immediate_consistency/local_replicator.hpp"
 #include "clustering/immediate_consistency/primary_dispatcher.hpp"
 #include "clustering/immediate_consistency/remote_replicator_client.hpp"
 #include "clustering/immediate_consistency/remote_replicator_server.hpp"
+#include "clustering/immediate_consistency/replication_lag_tracker.hpp"
 #include "clustering/immediate_consistency/standard_backfill_throttler.hpp"
+#include "clustering/query_routing/direct_query_server.hpp"
 #include "clustering/table_manager/backfill_progress_tracker.hpp"
+#include "concurrency/pmap.hpp"
+#include "concurrency/promise.hpp"
 #include "containers/uuid.hpp"
+#include "extproc/extproc_pool.hpp"
+#include "rdb_protocol/env.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "unittest/branch_history_manager.hpp"
 #include "unittest/clustering_utils.hpp"
+#include "unittest/dummy_metadata_controller.hpp"
 #include "unittest/unittest_utils.hpp"
 
 namespace unittest {
@@ -48,6 +56,28 @@ void run_with_primary(
         &order_source);
 }
 
+/* Sends `read` to a `direct_query_server_t`. Returns `false` if the server turned it
+down. */
+bool send_direct_read(
+        mailbox_manager_t *mailbox_manager,
+        const direct_query_bcard_t &bcard,
+        const read_t &read,
+        read_response_t *response_out) {
+    typedef boost::variant<read_response_t, cannot_perform_query_exc_t> reply_t;
+    promise_t<reply_t> reply;
+    mailbox_t<void(reply_t, direct_query_load_t)> reply_mailbox(mailbox_manager,
+        [&](signal_t *, const reply_t &r, const direct_query_load_t &) {
+            reply.pulse(r);
+        });
+    send(mailbox_manager, bcard.read_mailbox, read, reply_mailbox.get_address());
+    const read_response_t *response = boost::get<read_response_t>(&reply.wait());
+    if (response == nullptr) {
+        return false;
+    }
+    *response_out = *response;
+    return true;
+}
+
 }   /* anonymous namespace */
 
 /* The `ReadWrite` test just sends some reads and writes via the dispatcher to the single
@@ -168,6 +198,7 @@ void run_backfill_test(
         server_id_t::generate_server_id(),
         &store2,
         &bhm2,
+        nullptr,
         &interruptor);
 
     nap(100);
@@ -188,4 +219,222 @@ TPTEST(ClusteringBranch, Backfill) {
     run_with_primary(&run_backfill_test);
 }
 
+/* The `BoundedStaleness` test checks that a secondary replica serves reads with a
+`max_staleness` bound only while it's streaming writes from the primary. */
+
+void run_bounded_staleness_test(
+        simple_mailbox_cluster_t *cluster,
+        primary_dispatcher_t *dispatcher,
+        UNUSED mock_store_t *store1,
+        local_replicator_t *local_replicator,
+        order_source_t *order_source) {
+    remote_replicator_server_t remote_replicator_server(
+        cluster->get_mailbox_manager(),
+        dispatcher);
+
+    mock_store_t store2((binary_blob_t(version_t::zero())));
+    replication_lag_tracker_t lag_tracker;
+    direct_query_server_t direct_query_server(
+        cluster->get_mailbox_manager(), &store2, &lag_tracker);
+
+    read_t outdated_read = mock_read("a");
+    outdated_read.read_mode = read_mode_t::OUTDATED;
+    read_t bounded_read = outdated_read;
+    bounded_read.max_staleness_ms = 10 * 1000;
+    read_response_t response;
+
+    /* Before the secondary has backfilled, it can't tell how far behind it is. */
+    EXPECT_FALSE(send_direct_read(cluster->get_mailbox_manager(),
+        direct_query_server.get_bcard(), bounded_read, &response));
+
+    auto write = [&](const std::string &value) {
+        simple_write_callback_t write_callback;
+        dispatcher->spawn_write(
+            mock_overwrite("a", value),
+            order_source->check_in("run_bounded_staleness_test"),
+            &write_callback);
+        write_callback.wait_lazily_unordered();
+    };
+    write("1");
+
+    {
+        standard_backfill_throttler_t backfill_throttler;
+        backfill_progress_tracker_t backfill_progress_tracker;
+        in_memory_branch_history_manager_t bhm2;
+        cond_t interruptor;
+        remote_replicator_client_t remote_replicator_client(
+            &backfill_throttler,
+            backfill_config_t(),
+            &backfill_progress_tracker,
+            cluster->get_mailbox_manager(),
+            server_id_t::generate_server_id(),
+            backfill_throttler_t::priority_t::critical_t::NO,
+            dispatcher->get_branch_id(),
+            remote_replicator_server.get_bcard(),
+            local_replicator->get_replica_bcard(),
+            server_id_t::generate_server_id(),
+            &store2,
+            &bhm2,
+            &lag_tracker,
+            &interruptor);
+
+        /* Give the primary time to send a heartbeat. */
+        nap(1000);
+        EXPECT_TRUE(send_direct_read(cluster->get_mailbox_manager(),
+            direct_query_server.get_bcard(), bounded_read, &response));
+        EXPECT_EQ("1", mock_parse_read_response(response));
+
+        /* The write is acked by the secondary too, so the bounded read sees it. */
+        write("2");
+        EXPECT_TRUE(send_direct_read(cluster->get_mailbox_manager(),
+            direct_query_server.get_bcard(), bounded_read, &response));
+        EXPECT_EQ("2", mock_parse_read_response(response));
+    }
+
+    /* Once the secondary stops streaming, it can't tell anymore. Reads without a bound
+    still go through. */
+    EXPECT_FALSE(send_direct_read(cluster->get_mailbox_manager(),
+        direct_query_server.get_bcard(), bounded_read, &response));
+    EXPECT_TRUE(send_direct_read(cluster->get_mailbox_manager(),
+        direct_query_server.get_bcard(), outdated_read, &response));
+    EXPECT_EQ("2", mock_parse_read_response(response));
+}
+TPTEST(ClusteringBranch, BoundedStaleness) {
+    run_with_primary(&run_bounded_staleness_test);
+}
+
+#ifdef NDEBUG
+/* Measures how many small writes per second the dispatcher can replicate to three
+replicas: the primary's own store and two remote replicas. A thousand writes are in
+flight at a time, so the writes to the remote replicas go out in batches. */
+TPTEST(ClusteringBranch, ReplicatedWriteBenchmark) {
+    order_source_t order_source;
+    simple_mailbox_cluster_t cluster;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    extproc_pool_t extproc_pool(2);
+    dummy_semilattice_controller_t<auth_semilattice_metadata_t> auth_manager;
+    rdb_context_t ctx(&extproc_pool, nullptr, auth_manager.get_view());
+    cond_t non_interruptor;
+
+    in_memory_branch_history_manager_t bhm;
+    test_store_t store1(&io_backender, &order_source, &ctx);
+    test_store_t store2(&io_backender, &order_source, &ctx);
+    test_store_t store3(&io_backender, &order_source, &ctx);
+
+    primary_dispatcher_t dispatcher(
+        &get_global_perfmon_collection(),
+        region_map_t<version_t>(region_t::universe(), version_t::zero()));
+    local_replicator_t local_replicator(
+        cluster.get_mailbox_manager(), server_id_t::generate_server_id(),
+        &dispatcher, &store1.store, &bhm, &non_interruptor);
+    remote_replicator_server_t remote_replicator_server(
+        cluster.get_mailbox_manager(), &dispatcher);
+
+    standard_backfill_throttler_t backfill_throttler;
+    backfill_progress_tracker_t backfill_progress_tracker;
+    std::vector<scoped_ptr_t<remote_replicator_client_t> > clients;
+    for (test_store_t *store : {&store2, &store3}) {
+        clients.push_back(make_scoped<remote_replicator_client_t>(
+            &backfill_throttler, backfill_config_t(), &backfill_progress_tracker,
+            cluster.get_mailbox_manager(), server_id_t::generate_server_id(),
+            backfill_throttler_t::priority_t::critical_t::NO,
+            dispatcher.get_branch_id(), remote_replicator_server.get_bcard(),
+            local_replicator.get_replica_bcard(), server_id_t::generate_server_id(),
+            &store->store, &bhm, nullptr, &non_interruptor));
+    }
+    dispatcher.get_ready_dispatchees()->run_until_satisfied(
+        [](const std::set<server_id_t> &ready) { return ready.size() == 3; },
+        &non_interruptor);
+
+    class ack_counter_t : public primary_dispatcher_t::write_callback_t {
+    public:
+        ack_counter_t() : acks(0) { }
+        write_durability_t get_default_write_durability() {
+            return write_durability_t::SOFT;
+        }
+        void on_ack(const server_id_t &, write_response_t &&) {
+            ++acks;
+        }
+        void on_end() {
+            done.pulse();
+        }
+        int acks;
+        cond_t done;
+    };
+
+    const int num_writes = 50000;
+    const int num_in_flight = 1000;
+    ticks_t start = get_ticks();
+    for (int i = 0; i < num_writes; i += num_in_flight) {
+        std::vector<scoped_ptr_t<ack_counter_t> > callbacks;
+        for (int j = i; j < i + num_in_flight; ++j) {
+            callbacks.push_back(make_scoped<ack_counter_t>());
+            dispatcher.spawn_write(
+                mock_overwrite(strprintf("%08d", j), "x"),
+                order_source.check_in("ReplicatedWriteBenchmark"),
+                callbacks.back().get());
+        }
+        for (const auto &callback : callbacks) {
+            callback->done.wait_lazily_unordered();
+            EXPECT_EQ(3, callback->acks);
+        }
+    }
+    double secs = ticks_to_secs(get_ticks() - start);
+    printf("%d writes at replication factor 3: %f s, %f writes/s\n",
+           num_writes, secs, num_writes / secs);
+}
+
+/* Measures how many reads with a `max_staleness` bound per second one to four replicas
+on different threads can serve together. Each read goes to a random replica, like
+`table_query_client_t` picks one among the remote replicas that are recent enough. */
+TPTEST(ClusteringBranch, BoundedStalenessReadBenchmark, 4) {
+    simple_mailbox_cluster_t cluster;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    extproc_pool_t extproc_pool(2);
+    dummy_semilattice_controller_t<auth_semilattice_metadata_t> auth_manager;
+    rdb_context_t ctx(&extproc_pool, nullptr, auth_manager.get_view());
+
+    const int max_replicas = 4;
+    std::vector<scoped_ptr_t<test_store_t> > stores(max_replicas);
+    std::vector<scoped_ptr_t<replication_lag_tracker_t> > lag_trackers(max_replicas);
+    std::vector<scoped_ptr_t<direct_query_server_t> > servers(max_replicas);
+    std::vector<direct_query_bcard_t> bcards(max_replicas);
+    for (int i = 0; i < max_replicas; ++i) {
+        on_thread_t thread_switcher((threadnum_t(i)));
+        order_source_t order_source;
+        stores[i].init(new test_store_t(&io_backender, &order_source, &ctx));
+        lag_trackers[i].init(new replication_lag_tracker_t);
+        lag_trackers[i]->note_up_to_date_as_of(get_ticks());
+        servers[i].init(new direct_query_server_t(
+            cluster.get_mailbox_manager(), &stores[i]->store, lag_trackers[i].get()));
+        bcards[i] = servers[i]->get_bcard();
+    }
+
+    read_t read = mock_read("a");
+    read.read_mode = read_mode_t::OUTDATED;
+    read.max_staleness_ms = 60 * 1000;
+    const int num_reads = 100000;
+    const int num_in_flight = 64;
+    for (int num_replicas = 1; num_replicas <= max_replicas; ++num_replicas) {
+        ticks_t start = get_ticks();
+        pmap(num_in_flight, [&](int) {
+            for (int i = 0; i < num_reads / num_in_flight; ++i) {
+                read_response_t response;
+                EXPECT_TRUE(send_direct_read(cluster.get_mailbox_manager(),
+                    bcards[randint(num_replicas)], read, &response));
+            }
+        });
+        double secs = ticks_to_secs(get_ticks() - start);
+        printf("%d replicas: %f reads/s\n", num_replicas, num_reads / secs);
+    }
+
+    for (int i = 0; i < max_replicas; ++i) {
+        on_thread_t thread_switcher((threadnum_t(i)));
+        servers[i].reset();
+        lag_trackers[i].reset();
+        stores[i].reset();
+    }
+}
+#endif  // NDEBUG
+
 }   /* namespace unittest */
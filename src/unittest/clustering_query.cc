@@ -1,12 +1,21 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "unittest/gtest.hpp"
 
+#include <algorithm>
+
 #include "clustering/administration/admin_op_exc.hpp"
+#include "clustering/query_routing/direct_query_server.hpp"
 #include "clustering/query_routing/primary_query_client.hpp"
 #include "clustering/query_routing/primary_query_server.hpp"
+#include "clustering/query_routing/replica_load_tracker.hpp"
+#include "concurrency/pmap.hpp"
+#include "concurrency/promise.hpp"
+#include "extproc/extproc_pool.hpp"
+#include "rdb_protocol/env.hpp"
 #include "unittest/branch_history_manager.hpp"
 #include "unittest/clustering_utils.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "unittest/dummy_metadata_controller.hpp"
 #include "unittest/mock_store.hpp"
 #include "unittest/unittest_utils.hpp"
 
@@ -170,5 +179,204 @@ TPTEST(ClusteringQuery, Failure) {
     }
 }
 
+/* `ReplicaLoadTracker` checks how `replica_load_tracker_t` estimates the latency of a
+replica, and that `choose()` picks the cheaper one of two replicas. */
+TPTEST(ClusteringQuery, ReplicaLoadTracker) {
+    replica_load_tracker_t slow, fast;
+    EXPECT_EQ(0, slow.get_expected_latency_us(get_ticks()));
+
+    slow.on_send();
+    slow.on_reply(1000 * THOUSAND, direct_query_load_t(0, 500));
+    fast.on_send();
+    fast.on_reply(100 * THOUSAND, direct_query_load_t(0, 50));
+    EXPECT_EQ(1000, slow.get_expected_latency_us(get_ticks()));
+    EXPECT_EQ(100, fast.get_expected_latency_us(get_ticks()));
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(1u, replica_load_tracker_t::choose({&slow, &fast}));
+        EXPECT_EQ(0u, replica_load_tracker_t::choose({&fast, &slow}));
+    }
+
+    /* The local replica is always one of the two choices, but it still loses to a
+    faster one. */
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(0u, replica_load_tracker_t::choose({&fast, &slow, &slow}, 0));
+        EXPECT_EQ(1u, replica_load_tracker_t::choose({&slow, &fast}, 0));
+    }
+
+    /* Our own reads in flight and the reads that the replica reported as in progress
+    both count as queued up, but they might be the same reads. */
+    slow.on_send();
+    slow.on_send();
+    EXPECT_EQ(1000 + 2 * 500, slow.get_expected_latency_us(get_ticks()));
+    slow.on_no_reply();
+    slow.on_reply(1000 * THOUSAND, direct_query_load_t(4, 500));
+    EXPECT_EQ(1000 + 4 * 500, slow.get_expected_latency_us(get_ticks()));
+
+    /* A replica that we haven't heard from in a while gets another chance. */
+    EXPECT_EQ(0, slow.get_expected_latency_us(get_ticks() + 2 * BILLION));
+    slow.on_send();
+    EXPECT_LT(0, slow.get_expected_latency_us(get_ticks() + 2 * BILLION));
+    slow.on_no_reply();
+
+    replica_load_tracker_t single;
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(0u, replica_load_tracker_t::choose({&single}));
+    }
+}
+
+#ifdef NDEBUG
+/* Measures point reads and writes through a `primary_query_client_t` and a
+`primary_query_server_t` on the same server, once with the client on the server's
+thread, where the messages aren't serialized, and once with it on another thread. */
+TPTEST_MULTITHREAD(ClusteringQuery, LocalRoutingBenchmark, 2) {
+    simple_mailbox_cluster_t cluster;
+    query_counter_t query_counter;
+    primary_query_server_t server(
+        cluster.get_mailbox_manager(), region_t::universe(), &query_counter);
+
+    const int num_queries = 100000;
+    for (int thread : {0, 1}) {
+        on_thread_t thread_switcher((threadnum_t(thread)));
+        order_source_t order_source;
+        cond_t non_interruptor;
+        primary_query_client_t client(
+            cluster.get_mailbox_manager(),
+            server.get_bcard(),
+            &non_interruptor);
+
+        ticks_t start_ticks = get_ticks();
+        for (int i = 0; i < num_queries; ++i) {
+            fifo_enforcer_sink_t::exit_write_t token;
+            client.new_write_token(&token);
+            write_t write;
+            write.write = dummy_write_t();
+            write_response_t res;
+            client.write(
+                write,
+                &res,
+                order_source.check_in("ClusteringQuery.LocalRoutingBenchmark.write"),
+                &token,
+                &non_interruptor);
+        }
+        const double write_secs = ticks_to_secs(get_ticks() - start_ticks);
+
+        start_ticks = get_ticks();
+        for (int i = 0; i < num_queries; ++i) {
+            fifo_enforcer_sink_t::exit_read_t token;
+            client.new_read_token(&token);
+            read_t read;
+            read.read = dummy_read_t();
+            read_response_t res;
+            client.read(
+                read,
+                &res,
+                order_source.check_in("ClusteringQuery.LocalRoutingBenchmark.read")
+                    .with_read_mode(),
+                &token,
+                &non_interruptor);
+        }
+        const double read_secs = ticks_to_secs(get_ticks() - start_ticks);
+
+        printf("Client on %s thread: %f us per write, %f us per read\n",
+               thread == 0 ? "the server's" : "another",
+               write_secs / num_queries * 1e6,
+               read_secs / num_queries * 1e6);
+    }
+}
+
+/* Measures the latency of outdated reads to three replicas, one of which is slowed down
+artificially, once when each read goes to a random replica and once when
+`replica_load_tracker_t::choose()` picks the replica. The fast replicas are real
+B-tree stores; the slow one is a `mock_store_t`, which naps for up to 10 ms on half of
+its reads. */
+TPTEST(ClusteringQuery, LoadAwareRoutingBenchmark, 3) {
+    simple_mailbox_cluster_t cluster;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    extproc_pool_t extproc_pool(2);
+    dummy_semilattice_controller_t<auth_semilattice_metadata_t> auth_manager;
+    rdb_context_t ctx(&extproc_pool, nullptr, auth_manager.get_view());
+
+    const int num_replicas = 3;
+    std::vector<scoped_ptr_t<test_store_t> > fast_stores(num_replicas - 1);
+    scoped_ptr_t<mock_store_t> slow_store;
+    std::vector<scoped_ptr_t<direct_query_server_t> > servers(num_replicas);
+    std::vector<direct_query_bcard_t> bcards(num_replicas);
+    for (int i = 0; i < num_replicas; ++i) {
+        on_thread_t thread_switcher((threadnum_t(i)));
+        store_view_t *store;
+        if (i < num_replicas - 1) {
+            order_source_t order_source;
+            fast_stores[i].init(new test_store_t(&io_backender, &order_source, &ctx));
+            store = &fast_stores[i]->store;
+        } else {
+            slow_store.init(new mock_store_t());
+            store = slow_store.get();
+        }
+        servers[i].init(
+            new direct_query_server_t(cluster.get_mailbox_manager(), store, nullptr));
+        bcards[i] = servers[i]->get_bcard();
+    }
+
+    typedef boost::variant<read_response_t, cannot_perform_query_exc_t> reply_t;
+    read_t read = mock_read("a");
+    read.read_mode = read_mode_t::OUTDATED;
+    const int num_reads = 20000;
+    const int num_in_flight = 16;
+    for (bool load_aware : {false, true}) {
+        std::vector<replica_load_tracker_t> loads(num_replicas);
+        std::vector<const replica_load_tracker_t *> candidates;
+        for (const replica_load_tracker_t &load : loads) {
+            candidates.push_back(&load);
+        }
+        std::vector<ticks_t> latencies;
+        int slow_reads = 0;
+        pmap(num_in_flight, [&](int) {
+            for (int i = 0; i < num_reads / num_in_flight; ++i) {
+                const size_t replica = load_aware
+                    ? replica_load_tracker_t::choose(candidates)
+                    : randsize(num_replicas);
+                if (replica == static_cast<size_t>(num_replicas - 1)) {
+                    ++slow_reads;
+                }
+                promise_t<direct_query_load_t> reply;
+                mailbox_t<void(reply_t, direct_query_load_t)> reply_mailbox(
+                    cluster.get_mailbox_manager(),
+                    [&](signal_t *, const reply_t &, const direct_query_load_t &l) {
+                        reply.pulse(l);
+                    });
+                const ticks_t start_ticks = get_ticks();
+                loads[replica].on_send();
+                send(cluster.get_mailbox_manager(), bcards[replica].read_mailbox,
+                    read, reply_mailbox.get_address());
+                const direct_query_load_t load = reply.wait();
+                const ticks_t latency = get_ticks() - start_ticks;
+                loads[replica].on_reply(latency, load);
+                latencies.push_back(latency);
+            }
+        });
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile_ms = [&](double p) {
+            return ticks_to_secs(latencies[static_cast<size_t>(
+                p * (latencies.size() - 1))]) * 1000;
+        };
+        printf("%s routing: %.1f%% of reads to the slow replica, "
+               "p50 %f ms, p99 %f ms, p99.9 %f ms\n",
+               load_aware ? "Load-aware" : "Random",
+               100.0 * slow_reads / latencies.size(),
+               percentile_ms(0.5), percentile_ms(0.99), percentile_ms(0.999));
+    }
+
+    for (int i = 0; i < num_replicas; ++i) {
+        on_thread_t thread_switcher((threadnum_t(i)));
+        servers[i].reset();
+        if (i < num_replicas - 1) {
+            fast_stores[i].reset();
+        } else {
+            slow_store.reset();
+        }
+    }
+}
+#endif  // NDEBUG
+
 }   /* namespace unittest */
 
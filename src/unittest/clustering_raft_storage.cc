@@ -7,6 +7,7 @@
 #include "clustering/administration/persist/raft_storage_interface.hpp"
 #include "clustering/administration/tables/split_points.hpp"
 #include "clustering/table_contract/contract_metadata.hpp"
+#include "concurrency/pmap.hpp"
 #include "unittest/clustering_utils_raft.hpp"
 #include "unittest/unittest_utils.hpp"
 
@@ -372,5 +373,133 @@ TPTEST(ClusteringRaft, StorageWriteSnapshot) {
         raft_persistent_state);
 }
 
+/* `StorageGroupedWrites` checks that the writes of many tables that share a transaction
+in `metadata_file_t::write_grouped()` all end up in the metadata file. */
+TPTEST(ClusteringRaft, StorageGroupedWrites) {
+    temp_directory_t temp_dir;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    cond_t non_interruptor;
+
+    table_raft_state_t table_raft_state =
+        make_new_table_raft_state(make_table_config_and_shards());
+    raft_member_id_t raft_member_id(generate_uuid());
+    raft_config_t raft_config;
+    raft_config.voting_members.insert(raft_member_id);
+    raft_persistent_state_t<table_raft_state_t> raft_persistent_state =
+        raft_persistent_state_t<table_raft_state_t>::make_initial(
+            table_raft_state, raft_config);
+
+    raft_log_entry_t<table_raft_state_t> raft_log_entry;
+    raft_log_entry.type = raft_log_entry_type_t::regular;
+    raft_log_entry.term = 1;
+    table_raft_state_t::change_t::set_table_config_t set_table_config;
+    set_table_config.new_config = make_table_config_and_shards();
+    raft_log_entry.change = set_table_config;
+
+    const size_t num_tables = 20;
+    std::vector<namespace_id_t> table_ids;
+    for (size_t i = 0; i < num_tables; ++i) {
+        table_ids.push_back(generate_uuid());
+    }
+
+    {
+        metadata_file_t metadata_file(
+            &io_backender,
+            temp_dir.path(),
+            &get_global_perfmon_collection(),
+            [&](metadata_file_t::write_txn_t *, signal_t *) { },
+            &non_interruptor);
+        std::vector<scoped_ptr_t<table_raft_storage_interface_t> > storages(num_tables);
+        {
+            metadata_file_t::write_txn_t write_txn(&metadata_file, &non_interruptor);
+            for (size_t i = 0; i < num_tables; ++i) {
+                storages[i].init(new table_raft_storage_interface_t(
+                    &metadata_file,
+                    &write_txn,
+                    table_ids[i],
+                    raft_persistent_state));
+            }
+        }
+
+        pmap(num_tables, [&](size_t i) {
+            storages[i]->write_log_append_one(raft_log_entry);
+            storages[i]->write_commit_index(1);
+        });
+    }
+
+    raft_persistent_state.log.append(raft_log_entry);
+    raft_persistent_state.commit_index = 1;
+
+    for (const namespace_id_t &table_id : table_ids) {
+        EXPECT_EQ(
+            raft_persistent_state_from_metadata_file(temp_dir, table_id),
+            raft_persistent_state);
+    }
+}
+
+#ifdef NDEBUG
+/* Measures the Raft log writes of a `reconfigure` of 500 tables, that is appending a
+`set_table_config_t` entry and committing it for each table. Once the tables are
+reconfigured one at a time, so that every write has a transaction of its own, and once
+all at the same time, so that `metadata_file_t::write_grouped()` can group them. */
+TPTEST(ClusteringRaft, StorageReconfigureBenchmark) {
+    temp_directory_t temp_dir;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    cond_t non_interruptor;
+
+    table_raft_state_t table_raft_state =
+        make_new_table_raft_state(make_table_config_and_shards());
+    raft_member_id_t raft_member_id(generate_uuid());
+    raft_config_t raft_config;
+    raft_config.voting_members.insert(raft_member_id);
+    raft_persistent_state_t<table_raft_state_t> raft_persistent_state =
+        raft_persistent_state_t<table_raft_state_t>::make_initial(
+            table_raft_state, raft_config);
+
+    metadata_file_t metadata_file(
+        &io_backender,
+        temp_dir.path(),
+        &get_global_perfmon_collection(),
+        [&](metadata_file_t::write_txn_t *, signal_t *) { },
+        &non_interruptor);
+    const size_t num_tables = 500;
+    std::vector<scoped_ptr_t<table_raft_storage_interface_t> > storages(num_tables);
+    {
+        metadata_file_t::write_txn_t write_txn(&metadata_file, &non_interruptor);
+        for (size_t i = 0; i < num_tables; ++i) {
+            storages[i].init(new table_raft_storage_interface_t(
+                &metadata_file,
+                &write_txn,
+                generate_uuid(),
+                raft_persistent_state));
+        }
+    }
+
+    auto reconfigure = [&](size_t i, raft_term_t term) {
+        raft_log_entry_t<table_raft_state_t> raft_log_entry;
+        raft_log_entry.type = raft_log_entry_type_t::regular;
+        raft_log_entry.term = term;
+        table_raft_state_t::change_t::set_table_config_t set_table_config;
+        set_table_config.new_config = make_table_config_and_shards();
+        raft_log_entry.change = set_table_config;
+        storages[i]->write_log_append_one(raft_log_entry);
+        storages[i]->write_commit_index(storages[i]->get()->log.get_latest_index());
+    };
+
+    ticks_t start = get_ticks();
+    for (size_t i = 0; i < num_tables; ++i) {
+        reconfigure(i, 1);
+    }
+    const double sequential_secs = ticks_to_secs(get_ticks() - start);
+
+    start = get_ticks();
+    pmap(num_tables, [&](size_t i) { reconfigure(i, 2); });
+    const double grouped_secs = ticks_to_secs(get_ticks() - start);
+
+    printf("Reconfiguring %zu tables: %f ms one at a time, %f ms at once\n",
+           num_tables, sequential_secs * 1000, grouped_secs * 1000);
+}
+#endif  // NDEBUG
+
 }   /* namespace unittest */
 
@@ -1,9 +1,13 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 
+#include <algorithm>
+
 #include "containers/archive/string_stream.hpp"
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/datum_string.hpp"
 #include "rdb_protocol/env.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
+#include "time.hpp"
 #include "unittest/gtest.hpp"
 
 
@@ -205,4 +209,135 @@ TEST(DatumTest, OffsetScaling) {
     }
 }
 
+std::string serialize_datum_to_string(const ql::datum_t &datum) {
+    string_stream_t write_stream;
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, datum);
+    int write_res = send_write_message(&write_stream, &wm);
+    guarantee(write_res == 0);
+    return write_stream.str();
+}
+
+ql::datum_t deserialize_fields_from_string(const std::string &serialized,
+                                           const std::vector<std::string> &fields,
+                                           size_t *bytes_read_out) {
+    std::vector<datum_string_t> field_strings;
+    for (const std::string &field : fields) {
+        field_strings.push_back(datum_string_t(field));
+    }
+    return ql::datum_deserialize_fields(
+        serialized.size(),
+        [&](size_t offset, size_t size, char *out) {
+            ASSERT_LE(offset + size, serialized.size());
+            memcpy(out, serialized.data() + offset, size);
+        },
+        field_strings,
+        bytes_read_out);
+}
+
+// An object with `num_fields` fields `f0`, `f1`, ..., some of which are large strings
+// or nested objects.
+ql::datum_t make_wide_object(size_t num_fields) {
+    ql::datum_object_builder_t builder;
+    for (size_t i = 0; i < num_fields; ++i) {
+        ql::datum_t value;
+        switch (i % 3) {
+        case 0: value = ql::datum_t(static_cast<double>(i)); break;
+        case 1: value = ql::datum_t(datum_string_t(std::string(100 + i, 'x'))); break;
+        case 2: {
+            ql::datum_object_builder_t nested;
+            nested.overwrite("n", ql::datum_t(static_cast<double>(i)));
+            value = std::move(nested).to_datum();
+        } break;
+        default: unreachable();
+        }
+        builder.overwrite(datum_string_t(strprintf("f%zu", i)), value);
+    }
+    return std::move(builder).to_datum();
+}
+
+TEST(DatumTest, FieldDeserialization) {
+    // Objects of different sizes use different offset sizes.
+    for (size_t num_fields : {1, 2, 5, 50, 1000}) {
+        ql::datum_t object = make_wide_object(num_fields);
+        std::string serialized = serialize_datum_to_string(object);
+
+        std::vector<std::string> fields;
+        for (size_t i = 0; i < num_fields; i += 1 + num_fields / 4) {
+            fields.push_back(strprintf("f%zu", i));
+        }
+        std::sort(fields.begin(), fields.end());
+        ql::datum_object_builder_t expected;
+        for (const std::string &field : fields) {
+            expected.overwrite(datum_string_t(field),
+                               object.get_field(datum_string_t(field)));
+        }
+
+        size_t bytes_read;
+        ql::datum_t res = deserialize_fields_from_string(serialized, fields, &bytes_read);
+        ASSERT_TRUE(res.has());
+        EXPECT_EQ(std::move(expected).to_datum(), res);
+        if (num_fields == 1000) {
+            EXPECT_LT(bytes_read, serialized.size() / 10);
+        }
+
+        // A missing field makes it give up.
+        fields.push_back("g");
+        EXPECT_FALSE(
+            deserialize_fields_from_string(serialized, fields, &bytes_read).has());
+    }
+
+    size_t bytes_read;
+    EXPECT_FALSE(deserialize_fields_from_string(
+        serialize_datum_to_string(ql::datum_t(1.0)), {"f0"}, &bytes_read).has());
+    EXPECT_FALSE(deserialize_fields_from_string(
+        serialize_datum_to_string(ql::datum_t::empty_object()), {"f0"}, &bytes_read)
+            .has());
+    ql::datum_object_builder_t ptype;
+    ptype.overwrite("$reql_type$", ql::datum_t("TIME"));
+    ptype.overwrite("epoch_time", ql::datum_t(1.0));
+    ptype.overwrite("timezone", ql::datum_t("+00:00"));
+    EXPECT_FALSE(deserialize_fields_from_string(
+        serialize_datum_to_string(std::move(ptype).to_datum()), {"epoch_time"},
+        &bytes_read).has());
+}
+
+#ifdef NDEBUG
+TEST(DatumTest, FieldDeserializationBenchmark) {
+    const int NUM_REPETITIONS = 10000;
+    std::string serialized = serialize_datum_to_string(make_wide_object(1000));
+    std::vector<std::string> fields{"f1", "f500"};
+    std::vector<datum_string_t> field_strings{datum_string_t("f1"),
+                                              datum_string_t("f500")};
+
+    ticks_t start_ticks = get_ticks();
+    for (int i = 0; i < NUM_REPETITIONS; ++i) {
+        string_read_stream_t read_stream(std::string(serialized), 0);
+        ql::datum_t full;
+        guarantee_deserialization(
+            deserialize<cluster_version_t::LATEST_OVERALL>(&read_stream, &full),
+            "datum");
+        ql::datum_object_builder_t projected;
+        for (const auto &field : field_strings) {
+            projected.overwrite(field, full.get_field(field));
+        }
+    }
+    double dur_full = ticks_to_secs(get_ticks() - start_ticks);
+
+    size_t bytes_read = 0;
+    start_ticks = get_ticks();
+    for (int i = 0; i < NUM_REPETITIONS; ++i) {
+        deserialize_fields_from_string(serialized, fields, &bytes_read);
+    }
+    double dur_fields = ticks_to_secs(get_ticks() - start_ticks);
+
+    printf("%zu byte object: %f us per row reading all of it, "
+           "%f us reading %zu bytes for 2 fields\n",
+           serialized.size(),
+           dur_full / NUM_REPETITIONS * 1000000,
+           dur_fields / NUM_REPETITIONS * 1000000,
+           bytes_read);
+}
+#endif  // NDEBUG
+
 }  // namespace unittest
@@ -0,0 +1,70 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <math.h>
+
+#include "containers/archive/string_stream.hpp"
+#include "rdb_protocol/distinct.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/pseudo_time.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+// Returns `d` after a round trip through serialization, which gives objects and
+// arrays their buffer representation.
+ql::datum_t reserialize(const ql::datum_t &d) {
+    string_stream_t write_stream;
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, d);
+    int write_res = send_write_message(&write_stream, &wm);
+    guarantee(write_res == 0);
+    string_read_stream_t read_stream(std::move(write_stream.str()), 0);
+    ql::datum_t res;
+    guarantee_deserialization(
+        deserialize<cluster_version_t::LATEST_OVERALL>(&read_stream, &res), "datum");
+    return res;
+}
+
+TEST(Distinct, EqualDatumsHaveEqualHashes) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("a", ql::datum_t(1.0));
+    builder.overwrite("b", ql::datum_t(std::vector<ql::datum_t>{
+        ql::datum_t("x"), ql::datum_t::null()}, ql::configured_limits_t()));
+    ql::datum_t object = std::move(builder).to_datum();
+
+    std::vector<std::pair<ql::datum_t, ql::datum_t> > equal_pairs{
+        std::make_pair(ql::datum_t(0.0), ql::datum_t(-0.0)),
+        std::make_pair(object, reserialize(object)),
+        std::make_pair(ql::pseudo::make_time(1000.0, "+00:00"),
+                       ql::pseudo::make_time(1000.0, "+02:00"))};
+    for (const auto &pair : equal_pairs) {
+        ASSERT_EQ(pair.first, pair.second);
+        EXPECT_EQ(ql::datum_hash(pair.first), ql::datum_hash(pair.second))
+            << pair.first.print();
+    }
+
+    EXPECT_NE(ql::datum_hash(ql::datum_t(1.0)), ql::datum_hash(ql::datum_t("1")));
+    EXPECT_NE(ql::datum_hash(ql::datum_t(1.0)), ql::datum_hash(ql::datum_t(2.0)));
+}
+
+TEST(Distinct, HashSet) {
+    ql::datum_hash_set_t set;
+    EXPECT_TRUE(set.insert(ql::datum_t(1.0)));
+    EXPECT_TRUE(set.insert(ql::datum_t("1")));
+    EXPECT_FALSE(set.insert(ql::datum_t(1.0)));
+    EXPECT_TRUE(set.insert(ql::datum_t::null()));
+    EXPECT_EQ(3u, set.size());
+}
+
+TEST(Distinct, HyperLogLogAccuracy) {
+    for (size_t n : {0, 10, 1000, 100000}) {
+        ql::hyperloglog_t estimator;
+        // Every element is added twice.
+        for (size_t i = 0; i < 2 * n; ++i) {
+            estimator.add(ql::datum_t(static_cast<double>(i % n)));
+        }
+        double estimate = estimator.estimate();
+        EXPECT_LE(fabs(estimate - n), 0.03 * n + 0.5) << n;
+    }
+}
+
+}  // namespace unittest
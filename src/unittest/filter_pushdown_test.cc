@@ -0,0 +1,164 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "rdb_protocol/context.hpp"
+#include "rdb_protocol/filter_pushdown.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/wire_func.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+counted_t<const ql::func_t> make_predicate(ql::minidriver_t::reql_t body) {
+    ql::sym_t one(1);
+    return ql::wire_func_t(body.root_term(), make_vector(one)).compile_wire_func();
+}
+
+TEST(FilterPushdown, ExtractRanges) {
+    ql::sym_t one(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+
+    std::vector<ql::field_range_t> ranges = ql::extract_field_ranges(
+        make_predicate((r.var(one)["age"] > 30.0) && (r.var(one)["age"] <= 40.0)));
+    ASSERT_EQ(1u, ranges.size());
+    EXPECT_EQ("age", ranges[0].field);
+    EXPECT_FALSE(ranges[0].range.contains(ql::datum_t(30.0)));
+    EXPECT_TRUE(ranges[0].range.contains(ql::datum_t(35.0)));
+    EXPECT_TRUE(ranges[0].range.contains(ql::datum_t(40.0)));
+    EXPECT_FALSE(ranges[0].range.contains(ql::datum_t(41.0)));
+
+    // Reversed comparisons and equality.
+    ranges = ql::extract_field_ranges(
+        make_predicate(r.expr(std::string("b")) == r.var(one).bracket("name")));
+    ASSERT_EQ(1u, ranges.size());
+    EXPECT_EQ("name", ranges[0].field);
+    EXPECT_TRUE(ranges[0].range.contains(ql::datum_t("b")));
+    EXPECT_FALSE(ranges[0].range.contains(ql::datum_t("c")));
+
+    // One-sided string ranges only contain strings.
+    ranges = ql::extract_field_ranges(
+        make_predicate(r.var(one)["name"] >= std::string("m")));
+    ASSERT_EQ(1u, ranges.size());
+    EXPECT_TRUE(ranges[0].range.contains(ql::datum_t("z")));
+}
+
+TEST(FilterPushdown, RejectsUnsafeRanges) {
+    ql::sym_t one(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+
+    // Numbers sort before objects and after `null`, neither of which is indexable.
+    EXPECT_TRUE(ql::extract_field_ranges(
+        make_predicate(r.var(one)["age"] > 30.0)).empty());
+    EXPECT_TRUE(ql::extract_field_ranges(
+        make_predicate(r.var(one)["age"] < 30.0)).empty());
+    // Mixed-type bounds span non-indexable types.
+    EXPECT_TRUE(ql::extract_field_ranges(
+        make_predicate((r.var(one)["age"] > 30.0)
+                       && (r.var(one)["age"] < std::string("z")))).empty());
+    // Comparisons between two fields can't be turned into a range.
+    EXPECT_TRUE(ql::extract_field_ranges(
+        make_predicate(r.var(one)["a"] == r.var(one)["b"])).empty());
+}
+
+TEST(FilterPushdown, SimpleSindexField) {
+    ql::sym_t one(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+
+    sindex_config_t simple(
+        ql::map_wire_func_t(r.var(one)["age"].root_term(), make_vector(one)),
+        reql_version_t::LATEST,
+        sindex_multi_bool_t::SINGLE,
+        sindex_geo_bool_t::REGULAR);
+    boost::optional<std::string> field = ql::simple_sindex_field(simple);
+    ASSERT_TRUE(static_cast<bool>(field));
+    EXPECT_EQ("age", *field);
+
+    sindex_config_t multi(
+        ql::map_wire_func_t(r.var(one)["age"].root_term(), make_vector(one)),
+        reql_version_t::LATEST,
+        sindex_multi_bool_t::MULTI,
+        sindex_geo_bool_t::REGULAR);
+    EXPECT_FALSE(static_cast<bool>(ql::simple_sindex_field(multi)));
+
+    sindex_config_t compound(
+        ql::map_wire_func_t(
+            r.array(r.var(one)["a"], r.var(one)["b"]).root_term(), make_vector(one)),
+        reql_version_t::LATEST,
+        sindex_multi_bool_t::SINGLE,
+        sindex_geo_bool_t::REGULAR);
+    EXPECT_FALSE(static_cast<bool>(ql::simple_sindex_field(compound)));
+}
+
+sindex_config_t make_field_sindex(const char *field) {
+    ql::sym_t one(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    return sindex_config_t(
+        ql::map_wire_func_t(r.var(one)[field].root_term(), make_vector(one)),
+        reql_version_t::LATEST,
+        sindex_multi_bool_t::SINGLE,
+        sindex_geo_bool_t::REGULAR);
+}
+
+/* Simulates indexes that are changed through another server while the query
+planning cache still has the old definitions. */
+TPTEST(FilterPushdown, SindexChangedBehindCache) {
+    const namespace_id_t table_id = generate_uuid();
+    sindex_status_t ready;
+    sindex_planning_cache_t::sindexes_t sindexes;
+    sindexes["by_age"] = std::make_pair(make_field_sindex("age"), ready);
+    sindexes["by_name"] = std::make_pair(make_field_sindex("name"), ready);
+
+    sindex_planning_cache_t cache;
+    cache.set_sindexes(table_id, sindexes);
+    sindex_planning_cache_t::sindexes_t cached;
+    ASSERT_TRUE(cache.get_sindexes(table_id, &cached));
+
+    std::map<std::string, sindex_config_t> configs;
+    configs["by_age"] = make_field_sindex("age");
+    configs["by_name"] = make_field_sindex("name");
+    EXPECT_TRUE(ql::sindex_configs_match(cached, configs));
+
+    // Recreated under the same name with a different function.
+    configs["by_age"] = make_field_sindex("height");
+    EXPECT_FALSE(ql::sindex_configs_match(cached, configs));
+
+    // Dropped.
+    configs.erase("by_age");
+    EXPECT_FALSE(ql::sindex_configs_match(cached, configs));
+
+    // Renamed.
+    configs["by_height"] = make_field_sindex("age");
+    EXPECT_FALSE(ql::sindex_configs_match(cached, configs));
+
+    // Added.
+    configs.erase("by_height");
+    configs["by_age"] = make_field_sindex("age");
+    configs["by_height"] = make_field_sindex("height");
+    EXPECT_FALSE(ql::sindex_configs_match(cached, configs));
+}
+
+TEST(FilterPushdown, EstimateRangeFraction) {
+    std::map<store_key_t, int64_t> distribution;
+    EXPECT_FALSE(static_cast<bool>(ql::estimate_range_fraction(
+        distribution, key_range_t::universe())));
+
+    distribution[store_key_t::min()] = 10;
+    distribution[store_key_t("c")] = 10;
+    distribution[store_key_t("e")] = 20;
+
+    EXPECT_EQ(1.0, *ql::estimate_range_fraction(
+        distribution, key_range_t::universe()));
+    // Overlaps the `["c", "e")` bucket only.
+    EXPECT_EQ(0.25, *ql::estimate_range_fraction(
+        distribution,
+        key_range_t(key_range_t::closed, store_key_t("c"),
+                    key_range_t::open, store_key_t("d"))));
+    // Overlaps the last bucket, which is unbounded on the right.
+    EXPECT_EQ(0.5, *ql::estimate_range_fraction(
+        distribution,
+        key_range_t(key_range_t::closed, store_key_t("x"),
+                    key_range_t::none, store_key_t())));
+}
+
+}  // namespace unittest
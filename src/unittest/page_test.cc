@@ -7,6 +7,8 @@
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/pmap.hpp"
 #include "containers/scoped.hpp"
+#include "perfmon/collect.hpp"
+#include "random.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/mock_file.hpp"
@@ -52,12 +54,16 @@ class test_cache_t : public page_cache_t {
 public:
     test_cache_t(serializer_t *_serializer,
                  cache_balancer_t *balancer,
-                 alt_txn_throttler_t *throttler)
-        : page_cache_t(_serializer, balancer, throttler),
+                 alt_txn_throttler_t *throttler,
+                 int64_t soft_durability_flush_delay_ms
+                     = DEFAULT_SOFT_DURABILITY_FLUSH_DELAY_MS)
+        : page_cache_t(_serializer, balancer, throttler,
+                       soft_durability_flush_delay_ms),
           throttler_(throttler) { }
 
-    void flush(scoped_ptr_t<test_txn_t> txn) {
-        flush_and_destroy_txn(std::move(txn), &reset_throttler_acq);
+    void flush(scoped_ptr_t<test_txn_t> txn,
+               write_durability_t durability = write_durability_t::HARD) {
+        flush_and_destroy_txn(std::move(txn), durability, &reset_throttler_acq);
     }
 
     alt::throttler_acq_t make_throttler_acq() {
@@ -1181,4 +1187,100 @@ TPTEST(PageTest, BiggerTestNoMemory, 4) {
     test.run();
 }
 
+double serializer_stat(const char *name) {
+    return perfmon_get_stats().get_field("serializer").get_field(name).as_num();
+}
+
+std::vector<block_id_t> create_blocks(mock_ser_t *mock, int num_blocks) {
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    test_cache_t cache(mock->ser.get(), &balancer, mock->throttler.get());
+    std::vector<block_id_t> block_ids;
+    auto txn = make_scoped<test_txn_t>(&cache);
+    for (int i = 0; i < num_blocks; ++i) {
+        current_test_acq_t acq(txn.get(), alt_create_t::create);
+        test_acq_t page_acq;
+        page_acq.init(acq.current_page_for_write(), &cache);
+        memset(page_acq.get_buf_write(), 0, cache.max_block_size().value());
+        block_ids.push_back(acq.block_id());
+    }
+    cache.flush(std::move(txn));
+    return block_ids;
+}
+
+// Runs `num_updates` txns with the given durability, that each modify one of the
+// blocks.  The blocks are picked with probability proportional to `1 / (i + 1)`,
+// like the hot keys of a Zipf distribution.  Returns the number of blocks the
+// serializer wrote for the updates.
+double run_skewed_updates(mock_ser_t *mock,
+                          const std::vector<block_id_t> &block_ids,
+                          int num_updates,
+                          write_durability_t durability,
+                          int64_t soft_durability_flush_delay_ms
+                              = DEFAULT_SOFT_DURABILITY_FLUSH_DELAY_MS) {
+    std::vector<double> cumulative_weights;
+    double total_weight = 0;
+    for (size_t i = 0; i < block_ids.size(); ++i) {
+        total_weight += 1.0 / (i + 1);
+        cumulative_weights.push_back(total_weight);
+    }
+
+    const double block_writes_before = serializer_stat("serializer_block_writes");
+    {
+        dummy_cache_balancer_t balancer(GIGABYTE);
+        test_cache_t cache(mock->ser.get(), &balancer, mock->throttler.get(),
+                           soft_durability_flush_delay_ms);
+        for (int i = 0; i < num_updates; ++i) {
+            const size_t index = std::upper_bound(cumulative_weights.begin(),
+                                                  cumulative_weights.end() - 1,
+                                                  randdouble() * total_weight)
+                - cumulative_weights.begin();
+            auto txn = make_scoped<test_txn_t>(&cache);
+            {
+                current_test_acq_t acq(txn.get(), block_ids[index], access_t::write);
+                test_acq_t page_acq;
+                page_acq.init(acq.current_page_for_write(), &cache);
+                ++*static_cast<uint64_t *>(page_acq.get_buf_write());
+            }
+            cache.flush(std::move(txn), durability);
+        }
+        // Destroying the cache waits for all the flushes.
+    }
+    return serializer_stat("serializer_block_writes") - block_writes_before;
+}
+
+TPTEST(PageTest, SoftDurabilityCoalescesWrites, 4) {
+    mock_ser_t mock;
+    std::vector<block_id_t> block_ids = create_blocks(&mock, 1);
+    const int num_updates = 100;
+    double block_writes = run_skewed_updates(&mock, block_ids, num_updates,
+                                             write_durability_t::SOFT);
+    EXPECT_LE(1, block_writes);
+    EXPECT_GT(num_updates / 2, block_writes);
+
+    block_writes = run_skewed_updates(&mock, block_ids, num_updates,
+                                      write_durability_t::HARD);
+    EXPECT_EQ(num_updates, block_writes);
+
+    // Without a delay, soft durability txns are flushed one by one too.
+    block_writes = run_skewed_updates(&mock, block_ids, num_updates,
+                                      write_durability_t::SOFT, 0);
+    EXPECT_EQ(num_updates, block_writes);
+}
+
+#ifdef NDEBUG
+TPTEST(PageTest, SkewedUpdatesBenchmark, 4) {
+    mock_ser_t mock;
+    std::vector<block_id_t> block_ids = create_blocks(&mock, 1000);
+    const int num_updates = 20000;
+    for (write_durability_t durability : {write_durability_t::HARD,
+                                          write_durability_t::SOFT}) {
+        const double block_writes
+            = run_skewed_updates(&mock, block_ids, num_updates, durability);
+        printf("%s durability: %f bytes written per update\n",
+               durability == write_durability_t::HARD ? "hard" : "soft",
+               block_writes * mock.ser->max_block_size().value() / num_updates);
+    }
+}
+#endif  // NDEBUG
+
 }  // namespace unittest
@@ -1,6 +1,7 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "unittest/gtest.hpp"
 
+#include "arch/timing.hpp"
 #include "btree/backfill_debug.hpp"
 #include "clustering/administration/metadata.hpp"
 #include "clustering/immediate_consistency/backfill_throttler.hpp"
@@ -9,12 +10,15 @@
 #include "clustering/immediate_consistency/remote_replicator_client.hpp"
 #include "clustering/immediate_consistency/remote_replicator_server.hpp"
 #include "clustering/table_manager/backfill_progress_tracker.hpp"
+#include "containers/archive/compression.hpp"
+#include "containers/archive/vector_stream.hpp"
 #include "extproc/extproc_pool.hpp"
 #include "extproc/extproc_spawner.hpp"
 #include "rapidjson/document.h"
 #include "rdb_protocol/minidriver.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
 #include "rdb_protocol/store.hpp"
 #include "rdb_protocol/sym.hpp"
 #include "rpc/directory/read_manager.hpp"
@@ -148,7 +152,8 @@ public:
         num_step_writes(100),
         stream_during_backfill(true),
         min_preempt_ms(200),
-        max_preempt_ms(1000)
+        max_preempt_ms(1000),
+        max_interrupt_ms(0)
         { }
 
     /* `value_padding_length` is the amount of extra padding to add to each document, in
@@ -170,6 +175,10 @@ public:
     `min_preempt_ms` and `max_preempt_ms` before being preempted. */
     int min_preempt_ms, max_preempt_ms;
 
+    /* If `max_interrupt_ms` isn't zero, each backfill will be interrupted after a
+    random time of up to `max_interrupt_ms` and then started over, until it finishes. */
+    int max_interrupt_ms;
+
     /* This controls the queue sizes, etc. in the backfill logic. */
     backfill_config_t backfill;
 };
@@ -211,6 +220,47 @@ private:
     std::map<lock_t *, scoped_ptr_t<auto_drainer_t> > drainers;
 };
 
+/* If every backfill attempt makes progress, a few dozen are enough even for the
+larger tests. Any more means that each attempt is starting over. */
+static const int MAX_BACKFILL_ATTEMPTS = 100;
+
+/* `backfill_into_store()` creates a `remote_replicator_client_t` for `store`, which
+backfills it from `dispatcher`. It interrupts the backfill and starts over as often as
+`cfg.max_interrupt_ms` says. */
+scoped_ptr_t<remote_replicator_client_t> backfill_into_store(
+        const backfill_test_config_t &cfg,
+        mailbox_manager_t *mailbox_manager,
+        primary_dispatcher_t *dispatcher,
+        remote_replicator_server_t *remote_replicator_server,
+        local_replicator_t *local_replicator,
+        store_view_t *store,
+        branch_history_manager_t *bhm) {
+    stress_backfill_throttler_t backfill_throttler(cfg);
+    backfill_progress_tracker_t backfill_progress_tracker;
+    for (int attempt = 1; ; ++attempt) {
+        cond_t non_interruptor;
+        scoped_ptr_t<signal_timer_t> interruptor;
+        if (cfg.max_interrupt_ms != 0) {
+            interruptor.init(new signal_timer_t(randint(cfg.max_interrupt_ms + 1)));
+        }
+        try {
+            return make_scoped<remote_replicator_client_t>(&backfill_throttler,
+                cfg.backfill, &backfill_progress_tracker, mailbox_manager,
+                server_id_t::generate_server_id(),
+                backfill_throttler_t::priority_t::critical_t::NO,
+                dispatcher->get_branch_id(), remote_replicator_server->get_bcard(),
+                local_replicator->get_replica_bcard(), server_id_t::generate_server_id(),
+                store, bhm, nullptr,
+                interruptor.has() ? static_cast<signal_t *>(interruptor.get())
+                    : &non_interruptor);
+        } catch (const interrupted_exc_t &) {
+            backfill_debug_all(strprintf("interrupted backfill attempt %d", attempt));
+            guarantee(attempt < MAX_BACKFILL_ATTEMPTS,
+                "The backfill didn't finish after %d attempts", attempt);
+        }
+    }
+}
+
 void run_backfill_test(const backfill_test_config_t &cfg) {
 
     backfill_debug_clear_log();
@@ -258,25 +308,15 @@ void run_backfill_test(const backfill_test_config_t &cfg) {
                 cluster.get_mailbox_manager(),
                 &dispatcher);
 
-            stress_backfill_throttler_t backfill_throttler(cfg);
             backfill_debug_all("begin backfill store1 -> store2");
-            backfill_progress_tracker_t backfill_progress_tracker;
-            remote_replicator_client_t remote_replicator_client_2(&backfill_throttler,
-                cfg.backfill, &backfill_progress_tracker, cluster.get_mailbox_manager(),
-                server_id_t::generate_server_id(),
-                backfill_throttler_t::priority_t::critical_t::NO,
-                dispatcher.get_branch_id(), remote_replicator_server.get_bcard(),
-                local_replicator.get_replica_bcard(), server_id_t::generate_server_id(),
-                &store2.store, &bhm, &non_interruptor);
+            scoped_ptr_t<remote_replicator_client_t> remote_replicator_client_2 =
+                backfill_into_store(cfg, cluster.get_mailbox_manager(), &dispatcher,
+                    &remote_replicator_server, &local_replicator, &store2.store, &bhm);
             backfill_debug_all("end backfill store1 -> store2");
             backfill_debug_all("begin backfill store1 -> store3");
-            remote_replicator_client_t remote_replicator_client_3(&backfill_throttler,
-                cfg.backfill, &backfill_progress_tracker, cluster.get_mailbox_manager(),
-                server_id_t::generate_server_id(),
-                backfill_throttler_t::priority_t::critical_t::NO,
-                dispatcher.get_branch_id(), remote_replicator_server.get_bcard(),
-                local_replicator.get_replica_bcard(), server_id_t::generate_server_id(),
-                &store3.store, &bhm, &non_interruptor);
+            scoped_ptr_t<remote_replicator_client_t> remote_replicator_client_3 =
+                backfill_into_store(cfg, cluster.get_mailbox_manager(), &dispatcher,
+                    &remote_replicator_server, &local_replicator, &store3.store, &bhm);
             backfill_debug_all("end backfill store1 -> store3");
 
             if (cfg.stream_during_backfill) {
@@ -331,16 +371,10 @@ void run_backfill_test(const backfill_test_config_t &cfg) {
             cluster.get_mailbox_manager(),
             &dispatcher);
 
-        stress_backfill_throttler_t backfill_throttler(cfg);
         backfill_debug_all("begin backfill store2 -> store1");
-        backfill_progress_tracker_t backfill_progress_tracker;
-        remote_replicator_client_t remote_replicator_client(&backfill_throttler,
-            cfg.backfill, &backfill_progress_tracker, cluster.get_mailbox_manager(),
-            server_id_t::generate_server_id(),
-            backfill_throttler_t::priority_t::critical_t::NO,
-            dispatcher.get_branch_id(), remote_replicator_server.get_bcard(),
-            local_replicator.get_replica_bcard(), server_id_t::generate_server_id(),
-            &store1.store, &bhm, &non_interruptor);
+        scoped_ptr_t<remote_replicator_client_t> remote_replicator_client =
+            backfill_into_store(cfg, cluster.get_mailbox_manager(), &dispatcher,
+                &remote_replicator_server, &local_replicator, &store1.store, &bhm);
         backfill_debug_all("end backfill store2 -> store1");
 
         if (cfg.stream_during_backfill) {
@@ -377,16 +411,10 @@ void run_backfill_test(const backfill_test_config_t &cfg) {
             cluster.get_mailbox_manager(),
             &dispatcher);
 
-        stress_backfill_throttler_t backfill_throttler(cfg);
         backfill_debug_all("begin backfill store1 -> store3");
-        backfill_progress_tracker_t backfill_progress_tracker;
-        remote_replicator_client_t remote_replicator_client(&backfill_throttler,
-            cfg.backfill, &backfill_progress_tracker, cluster.get_mailbox_manager(),
-            server_id_t::generate_server_id(),
-            backfill_throttler_t::priority_t::critical_t::NO,
-            dispatcher.get_branch_id(), remote_replicator_server.get_bcard(),
-            local_replicator.get_replica_bcard(), server_id_t::generate_server_id(),
-            &store3.store, &bhm, &non_interruptor);
+        scoped_ptr_t<remote_replicator_client_t> remote_replicator_client =
+            backfill_into_store(cfg, cluster.get_mailbox_manager(), &dispatcher,
+                &remote_replicator_server, &local_replicator, &store3.store, &bhm);
         backfill_debug_all("end backfill store1 -> store3");
 
         if (cfg.stream_during_backfill) {
@@ -543,5 +571,253 @@ TPTEST(RDBBackfill, FillBothQueuesAndPreemptOften) {
     run_backfill_test(cfg);
 }
 
+TPTEST(RDBBackfill, InterruptOften) {
+    /* Interrupt every backfill after at most 300 ms, as if the connection to the primary
+    dropped. Each new attempt has to pick up where the last one left off, or else the
+    larger backfills would never finish. */
+    backfill_test_config_t cfg;
+    cfg.max_interrupt_ms = 300;
+    cfg.backfill.checkpoint_interval_ms = 20;
+    cfg.num_initial_writes = 2000;
+    cfg.num_step_writes = 500;
+    run_backfill_test(cfg);
+}
+
+/* `total_keys_set()` returns how many keys have been written to the primary B-tree of
+`store` since it was opened, including the ones that a backfill wrote. */
+int64_t total_keys_set(store_t *store) {
+    perfmon_collection_t *stats = &store->perfmon_collection;
+    void *data = stats->begin_stats();
+    /* The test runs in a single thread, so it's the only one with stats to visit */
+    stats->visit_stats(data);
+    return stats->end_stats(data).get_field("btree-primary")
+        .get_field("total_keys_set").as_int();
+}
+
+TPTEST(RDBBackfill, ResumeAfterRestart) {
+    /* Interrupt a backfill once it has copied half of the table, then close and reopen
+    the store it was copying into. The next attempt should only copy what the first
+    one didn't. */
+    backfill_test_config_t cfg;
+    cfg.backfill.checkpoint_interval_ms = 10;
+    /* Send one item at a time, so that the backfill can't get far past the halfway
+    point before we interrupt it */
+    cfg.backfill.item_queue_mem_size = 1;
+    cfg.backfill.item_chunk_mem_size = 1;
+    cfg.num_initial_writes = 2000;
+    cfg.min_preempt_ms = cfg.max_preempt_ms = 60 * 60 * 1000;
+
+    order_source_t order_source;
+    simple_mailbox_cluster_t cluster;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    extproc_pool_t extproc_pool(2);
+    dummy_semilattice_controller_t<auth_semilattice_metadata_t> auth_manager;
+    rdb_context_t ctx(&extproc_pool, nullptr, auth_manager.get_view());
+    cond_t non_interruptor;
+
+    in_memory_branch_history_manager_t bhm;
+    test_store_t store1(&io_backender, &order_source, &ctx);
+
+    /* `store2` is opened by hand so that we can close it and open it again */
+    temp_file_t temp_file;
+    scoped_ptr_t<merger_serializer_t> serializer(
+        create_and_construct_serializer(&temp_file, &io_backender));
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    auto open_store = [&](bool create) {
+        return make_scoped<store_t>(region_t::universe(), serializer.get(), &balancer,
+            temp_file.name().permanent_path(), create,
+            &get_global_perfmon_collection(), &ctx, &io_backender, base_path_t("."),
+            generate_uuid(), update_sindexes_t::UPDATE);
+    };
+    scoped_ptr_t<store_t> store2 = open_store(true);
+    {
+        write_token_t token;
+        store2->new_write_token(&token);
+        store2->set_metainfo(
+            region_map_t<binary_blob_t>(region_t::universe(),
+                binary_blob_t(version_t::zero())),
+            order_source.check_in("ResumeAfterRestart"), &token,
+            write_durability_t::SOFT, &non_interruptor);
+    }
+
+    std::map<std::string, std::string> inserter_state;
+
+    {
+        primary_dispatcher_t dispatcher(
+            &get_global_perfmon_collection(),
+            region_map_t<version_t>(region_t::universe(), version_t::zero()));
+
+        local_replicator_t local_replicator(
+            cluster.get_mailbox_manager(), server_id_t::generate_server_id(),
+            &dispatcher, &store1.store, &bhm, &non_interruptor);
+
+        dispatcher_inserter_t inserter(
+            &dispatcher, &order_source, cfg.value_padding_length, &inserter_state,
+            false);
+        inserter.insert(cfg.num_initial_writes);
+
+        remote_replicator_server_t remote_replicator_server(
+            cluster.get_mailbox_manager(), &dispatcher);
+        stress_backfill_throttler_t backfill_throttler(cfg);
+        backfill_progress_tracker_t backfill_progress_tracker;
+        auto attempt = [&](signal_t *interruptor) {
+            return make_scoped<remote_replicator_client_t>(&backfill_throttler,
+                cfg.backfill, &backfill_progress_tracker, cluster.get_mailbox_manager(),
+                server_id_t::generate_server_id(),
+                backfill_throttler_t::priority_t::critical_t::NO,
+                dispatcher.get_branch_id(), remote_replicator_server.get_bcard(),
+                local_replicator.get_replica_bcard(), server_id_t::generate_server_id(),
+                store2.get(), &bhm, nullptr, interruptor);
+        };
+
+        /* Interrupt the first attempt once it has copied half of the documents */
+        {
+            cond_t halfway;
+            repeating_timer_t timer(1, [&]() {
+                if (!halfway.is_pulsed()
+                        && total_keys_set(store2.get()) >= cfg.num_initial_writes / 2) {
+                    halfway.pulse();
+                }
+            });
+            EXPECT_THROW(attempt(&halfway), interrupted_exc_t);
+        }
+        int64_t first_keys_set = total_keys_set(store2.get());
+        EXPECT_GE(first_keys_set, cfg.num_initial_writes / 2);
+        EXPECT_LT(first_keys_set, cfg.num_initial_writes);
+
+        store2.reset();
+        store2 = open_store(false);
+
+        scoped_ptr_t<remote_replicator_client_t> remote_replicator_client =
+            attempt(&non_interruptor);
+        EXPECT_LT(total_keys_set(store2.get()), cfg.num_initial_writes);
+    }
+
+    {
+        /* Make sure that the two attempts together copied everything */
+        primary_dispatcher_t dispatcher(
+            &get_global_perfmon_collection(),
+            get_store_version_map(store2.get()));
+
+        local_replicator_t local_replicator(
+            cluster.get_mailbox_manager(), server_id_t::generate_server_id(),
+            &dispatcher, store2.get(), &bhm, &non_interruptor);
+
+        dispatcher_inserter_t inserter(
+            &dispatcher, &order_source, cfg.value_padding_length, &inserter_state,
+            false);
+        inserter.validate();
+    }
+}
+
+TPTEST(RDBBackfill, SingleRangeSession) {
+    /* Copy the data in a single ordered session, without the parallel range sessions
+    that a new replica usually starts with. */
+    backfill_test_config_t cfg;
+    cfg.backfill.num_range_sessions = 1;
+    run_backfill_test(cfg);
+}
+
+TPTEST(RDBBackfill, ManyRangeSessions) {
+    /* Split the copy into more range sessions than there are distribution buckets in
+    the small tables, and make their queues small. */
+    backfill_test_config_t cfg;
+    cfg.backfill.num_range_sessions = 64;
+    cfg.backfill.item_queue_mem_size = 1;
+    cfg.backfill.item_chunk_mem_size = 1;
+    cfg.num_initial_writes = 1000;
+    cfg.num_step_writes = 10;
+    run_backfill_test(cfg);
+}
+
+#ifdef NDEBUG
+/* Compares how long the backfills of a large table take with a single session and
+with parallel range sessions. */
+TPTEST(RDBBackfill, RangeSessionThroughputBenchmark) {
+    for (size_t num_range_sessions : {1, 4}) {
+        backfill_test_config_t cfg;
+        cfg.backfill.num_range_sessions = num_range_sessions;
+        cfg.num_initial_writes = 50000;
+        cfg.num_step_writes = 1000;
+        cfg.stream_during_backfill = false;
+        cfg.min_preempt_ms = cfg.max_preempt_ms = 60 * 60 * 1000;
+        ticks_t start = get_ticks();
+        run_backfill_test(cfg);
+        double secs = ticks_to_secs(get_ticks() - start);
+        printf("%zu range sessions: %f s, %f rows/s\n", num_range_sessions, secs,
+               cfg.num_initial_writes / secs);
+    }
+}
+
+/* Measures how long it takes to send a chunk of backfill items over a link with
+limited bandwidth, for each kind of compression. The transfer time is simulated from
+the size of the serialized chunk; the compression time is measured. */
+TPTEST(RDBBackfill, CompressionBandwidthBenchmark) {
+    const int num_docs = 20000;
+    backfill_item_seq_t<backfill_item_t> items(
+        0, HASH_REGION_HASH_SIZE, key_range_t::right_bound_t(store_key_t::min()));
+    for (int i = 0; i < num_docs; ++i) {
+        std::string key = strprintf("%08d", i);
+        ql::datum_object_builder_t doc;
+        doc.overwrite("id", ql::datum_t(datum_string_t(key)));
+        doc.overwrite("name", ql::datum_t(datum_string_t(
+            strprintf("customer %d", randint(100000)))));
+        doc.overwrite("email", ql::datum_t(datum_string_t(
+            strprintf("user%d@example.com", randint(100000)))));
+        doc.overwrite("balance", ql::datum_t(static_cast<double>(randint(1000000))));
+        doc.overwrite("status", ql::datum_t(datum_string_t(
+            randint(2) == 0 ? "active" : "inactive")));
+        write_message_t value_wm;
+        ql::datum_serialize(&value_wm, std::move(doc).to_datum(),
+                            ql::check_datum_serialization_errors_t::NO);
+        vector_stream_t value;
+        guarantee(send_write_message(&value, &value_wm) == 0);
+
+        backfill_item_t item;
+        item.range = key_range_t(key_range_t::closed, store_key_t(key),
+                                 key_range_t::closed, store_key_t(key));
+        backfill_item_t::pair_t pair;
+        pair.key = store_key_t(key);
+        pair.recency = repli_timestamp_t::distant_past;
+        pair.value = value.vector();
+        item.pairs.push_back(std::move(pair));
+        item.min_deletion_timestamp = repli_timestamp_t::distant_past;
+        items.push_back(std::move(item));
+    }
+    items.push_back_nothing(key_range_t::right_bound_t());
+
+    const double mbits_per_sec[] = {100, 1000};
+    for (compression_t compression :
+             {compression_t::NONE, compression_t::FAST, compression_t::SMALL}) {
+        ticks_t start = get_ticks();
+        write_message_t wm;
+        serialize<cluster_version_t::CLUSTER>(&wm,
+            compressed_t<backfill_item_seq_t<backfill_item_t> >(
+                compression, backfill_item_seq_t<backfill_item_t>(items)));
+        vector_stream_t s;
+        guarantee(send_write_message(&s, &wm) == 0);
+        double compress_secs = ticks_to_secs(get_ticks() - start);
+
+        start = get_ticks();
+        compressed_t<backfill_item_seq_t<backfill_item_t> > out;
+        buffer_read_stream_t stream(s.vector().data(), s.vector().size());
+        ASSERT_EQ(archive_result_t::SUCCESS,
+                  deserialize<cluster_version_t::CLUSTER>(&stream, &out));
+        double decompress_secs = ticks_to_secs(get_ticks() - start);
+        ASSERT_EQ(items.get_mem_size(), out.value.get_mem_size());
+
+        const char *name = compression == compression_t::NONE ? "none"
+            : compression == compression_t::FAST ? "fast" : "small";
+        for (double mbits : mbits_per_sec) {
+            double transfer_secs = s.vector().size() * 8 / (mbits * 1000000);
+            printf("%s compression at %.0f Mbit/s: %zu bytes, %f s to serialize, "
+                   "%f s to deserialize, %f s in total\n",
+                   name, mbits, s.vector().size(), compress_secs, decompress_secs,
+                   compress_secs + transfer_secs + decompress_secs);
+        }
+    }
+}
+#endif  // NDEBUG
+
 }   /* namespace unittest */
 
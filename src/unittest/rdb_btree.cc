@@ -1,4 +1,5 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <algorithm>
 #include <functional>
 
 #include "arch/io/disk.hpp"
@@ -7,9 +8,13 @@
 #include "btree/operations.hpp"
 #include "btree/reql_specific.hpp"
 #include "buffer_cache/cache_balancer.hpp"
+#include "clustering/immediate_consistency/history.hpp"
+#include "clustering/administration/tables/split_points.hpp"
+#include "clustering/administration/tables/table_metadata.hpp"
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "containers/uuid.hpp"
+#include "perfmon/collect.hpp"
 #include "rapidjson/document.h"
 #include "rdb_protocol/btree.hpp"
 #include "rdb_protocol/env.hpp"
@@ -28,50 +33,55 @@
 
 namespace unittest {
 
-void insert_rows(int start, int finish, store_t *store) {
+// Writes the row with the given id and JSON data, and updates the secondary indexes.
+void write_row(store_t *store, int id, const std::string &data, bool overwrite,
+               write_durability_t durability = write_durability_t::SOFT) {
     ql::configured_limits_t limits;
+    cond_t dummy_interruptor;
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    write_token_t token;
+    store->new_write_token(&token);
+    store->acquire_superblock_for_write(
+        1, durability,
+        &token, &txn, &superblock, &dummy_interruptor);
+    buf_lock_t sindex_block(superblock->expose_buf(),
+                            superblock->get_sindex_block_id(),
+                            access_t::write);
+
+    point_write_response_t response;
+
+    store_key_t pk(ql::datum_t(static_cast<double>(id)).print_primary());
+    rdb_modification_report_t mod_report(pk);
+    rdb_live_deletion_context_t deletion_context;
+    rapidjson::Document doc;
+    doc.Parse(data.c_str());
+    rdb_set(pk,
+            ql::to_datum(doc, limits, reql_version_t::LATEST),
+            overwrite, store->btree.get(), repli_timestamp_t::distant_past,
+            superblock.get(), &deletion_context, &response, &mod_report.info,
+            static_cast<profile::trace_t *>(NULL));
+
+    store_t::sindex_access_vector_t sindexes;
+    store->acquire_all_sindex_superblocks_for_write(&sindex_block, &sindexes);
+    rdb_update_sindexes(store,
+                        sindexes,
+                        &mod_report,
+                        txn.get(),
+                        &deletion_context,
+                        nullptr,
+                        nullptr,
+                        nullptr);
+
+    new_mutex_in_line_t acq = store->get_in_line_for_sindex_queue(&sindex_block);
+    store->sindex_queue_push(mod_report, &acq);
+}
 
+void insert_rows(int start, int finish, store_t *store) {
     guarantee(start <= finish);
     for (int i = start; i < finish; ++i) {
-        cond_t dummy_interruptor;
-        scoped_ptr_t<txn_t> txn;
-        scoped_ptr_t<real_superblock_t> superblock;
-        write_token_t token;
-        store->new_write_token(&token);
-        store->acquire_superblock_for_write(
-            1, write_durability_t::SOFT,
-            &token, &txn, &superblock, &dummy_interruptor);
-        buf_lock_t sindex_block(superblock->expose_buf(),
-                                superblock->get_sindex_block_id(),
-                                access_t::write);
-
         std::string data = strprintf("{\"id\" : %d, \"sid\" : %d}", i, i * i);
-        point_write_response_t response;
-
-        store_key_t pk(ql::datum_t(static_cast<double>(i)).print_primary());
-        rdb_modification_report_t mod_report(pk);
-        rdb_live_deletion_context_t deletion_context;
-        rapidjson::Document doc;
-        doc.Parse(data.c_str());
-        rdb_set(pk,
-                ql::to_datum(doc, limits, reql_version_t::LATEST),
-                false, store->btree.get(), repli_timestamp_t::distant_past,
-                superblock.get(), &deletion_context, &response, &mod_report.info,
-                static_cast<profile::trace_t *>(NULL));
-
-        store_t::sindex_access_vector_t sindexes;
-        store->acquire_all_sindex_superblocks_for_write(&sindex_block, &sindexes);
-        rdb_update_sindexes(store,
-                            sindexes,
-                            &mod_report,
-                            txn.get(),
-                            &deletion_context,
-                            nullptr,
-                            nullptr,
-                            nullptr);
-
-        new_mutex_in_line_t acq = store->get_in_line_for_sindex_queue(&sindex_block);
-        store->sindex_queue_push(mod_report, &acq);
+        write_row(store, i, data, false);
     }
 }
 
@@ -98,16 +108,40 @@ sindex_name_t create_sindex(store_t *store) {
     return sindex_name_t(name);
 }
 
+// Creates a multi index that maps every row to `sid` and `sid + MULTI_SINDEX_OFFSET`.
+#define MULTI_SINDEX_OFFSET 1000000
+sindex_name_t create_multi_sindex(store_t *store) {
+    std::string name = uuid_to_str(generate_uuid());
+    ql::sym_t one(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    ql::raw_term_t mapping = r.array(
+        r.var(one)["sid"],
+        r.var(one)["sid"] + static_cast<double>(MULTI_SINDEX_OFFSET)).root_term();
+    sindex_config_t config(
+        ql::map_wire_func_t(mapping, make_vector(one)),
+        reql_version_t::LATEST,
+        sindex_multi_bool_t::MULTI,
+        sindex_geo_bool_t::REGULAR);
+
+    cond_t non_interruptor;
+    store->sindex_create(name, config, &non_interruptor);
+
+    return sindex_name_t(name);
+}
+
 void spawn_writes(store_t *store, cond_t *background_inserts_done) {
     coro_t::spawn_sometime(std::bind(&insert_rows_and_pulse_when_done,
                 (TOTAL_KEYS_TO_INSERT * 9) / 10, TOTAL_KEYS_TO_INSERT,
                 store, background_inserts_done));
 }
 
-ql::grouped_t<ql::stream_t> read_row_via_sindex(
+// Runs a range read over `datum_range` of the given secondary index.
+rget_read_response_t rget_via_sindex(
         store_t *store,
         const sindex_name_t &sindex_name,
-        int sindex_value) {
+        const ql::datum_range_t &datum_range,
+        const std::vector<ql::transform_variant_t> &transforms,
+        const boost::optional<ql::terminal_variant_t> &terminal) {
     cond_t dummy_interruptor;
     read_token_t token;
     store->new_read_token(&token);
@@ -140,7 +174,6 @@ ql::grouped_t<ql::stream_t> read_row_via_sindex(
     }
 
     rget_read_response_t res;
-    ql::datum_range_t datum_range(ql::datum_t(static_cast<double>(sindex_value)));
     /* The only thing this does is have a NULL `profile::trace_t *` in it which
      * prevents to profiling code from crashing. */
     ql::env_t dummy_env(&dummy_interruptor,
@@ -155,15 +188,27 @@ ql::grouped_t<ql::stream_t> read_row_via_sindex(
         sindex_sb.get(),
         &dummy_env, // env_t
         ql::batchspec_t::default_for(ql::batch_type_t::NORMAL),
-        std::vector<ql::transform_variant_t>(),
-        boost::optional<ql::terminal_variant_t>(),
+        transforms,
+        terminal,
         key_range_t::universe(),
         sorting_t::ASCENDING,
         require_sindexes_t::NO,
         sindex_info,
         &res,
         release_superblock_t::RELEASE);
+    return res;
+}
 
+ql::grouped_t<ql::stream_t> read_row_via_sindex(
+        store_t *store,
+        const sindex_name_t &sindex_name,
+        int sindex_value) {
+    rget_read_response_t res = rget_via_sindex(
+        store,
+        sindex_name,
+        ql::datum_range_t(ql::datum_t(static_cast<double>(sindex_value))),
+        std::vector<ql::transform_variant_t>(),
+        boost::optional<ql::terminal_variant_t>());
     ql::grouped_t<ql::stream_t> *groups =
         boost::get<ql::grouped_t<ql::stream_t> >(&res.result);
     guarantee(groups != nullptr);
@@ -171,11 +216,12 @@ ql::grouped_t<ql::stream_t> read_row_via_sindex(
 }
 
 void _check_keys_are_present(store_t *store,
-        sindex_name_t sindex_name) {
+        sindex_name_t sindex_name,
+        int sindex_value_offset) {
     ql::configured_limits_t limits;
     for (int i = 0; i < TOTAL_KEYS_TO_INSERT; ++i) {
         ql::grouped_t<ql::stream_t> groups =
-            read_row_via_sindex(store, sindex_name, i * i);
+            read_row_via_sindex(store, sindex_name, i * i + sindex_value_offset);
         ASSERT_EQ(1, groups.size());
         // The order of `groups` doesn't matter because this is a small unit test.
         ql::stream_t *stream = &groups.begin()->second;
@@ -193,10 +239,11 @@ void _check_keys_are_present(store_t *store,
 }
 
 void check_keys_are_present(store_t *store,
-        sindex_name_t sindex_name) {
+        sindex_name_t sindex_name,
+        int sindex_value_offset = 0) {
     for (int i = 0; i < MAX_RETRIES_FOR_SINDEX_POSTCONSTRUCT; ++i) {
         try {
-            _check_keys_are_present(store, sindex_name);
+            _check_keys_are_present(store, sindex_name, sindex_value_offset);
             return;
         } catch (const sindex_not_ready_exc_t&) { }
         /* Unfortunately we don't have an easy way right now to tell if the
@@ -278,6 +325,808 @@ TPTEST(RDBBtree, SindexPostConstruct) {
     check_keys_are_present(&store, sindex_name);
 }
 
+TPTEST(RDBBtree, SindexPostConstructMulti) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE);
+
+    cond_t dummy_interruptor;
+
+    insert_rows(0, (TOTAL_KEYS_TO_INSERT * 9) / 10, &store);
+
+    // The entries of each chunk of rows have to be sorted before they are inserted
+    // into the index, because the two keys of each row are far apart.
+    sindex_name_t sindex_name = create_multi_sindex(&store);
+
+    cond_t background_inserts_done;
+    spawn_writes(&store, &background_inserts_done);
+    background_inserts_done.wait();
+
+    check_keys_are_present(&store, sindex_name);
+    check_keys_are_present(&store, sindex_name, MULTI_SINDEX_OFFSET);
+}
+
+TPTEST(RDBBtree, SindexUpdate) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE);
+
+    insert_rows(0, TOTAL_KEYS_TO_INSERT, &store);
+    sindex_name_t sindex_name = create_sindex(&store);
+    check_keys_are_present(&store, sindex_name);
+
+    // Even rows keep their index key and odd rows get a new one, which is never the
+    // old key of another row.
+    ql::configured_limits_t limits;
+    std::vector<ql::datum_t> new_docs;
+    for (int i = 0; i < TOTAL_KEYS_TO_INSERT; ++i) {
+        const int sid = i % 2 == 0 ? i * i : -i * i;
+        std::string data =
+            strprintf("{\"id\" : %d, \"sid\" : %d, \"x\" : %d}", i, sid, i);
+        write_row(&store, i, data, true);
+        rapidjson::Document doc;
+        doc.Parse(data.c_str());
+        new_docs.push_back(ql::to_datum(doc, limits, reql_version_t::LATEST));
+    }
+
+    for (int i = 0; i < TOTAL_KEYS_TO_INSERT; ++i) {
+        const int sid = i % 2 == 0 ? i * i : -i * i;
+        ql::grouped_t<ql::stream_t> groups =
+            read_row_via_sindex(&store, sindex_name, sid);
+        ASSERT_EQ(1, groups.size());
+        ql::stream_t *stream = &groups.begin()->second;
+        ASSERT_EQ(1ul, stream->substreams.size());
+        ql::raw_stream_t *raw_stream = &stream->substreams.begin()->second.stream;
+        ASSERT_EQ(1ul, raw_stream->size());
+        // The index entry must refer to the new version of the row, even if its key
+        // didn't change.
+        ASSERT_EQ(new_docs[i], raw_stream->front().data);
+
+        if (i % 2 == 1) {
+            ASSERT_EQ(0, read_row_via_sindex(&store, sindex_name, i * i).size());
+        }
+    }
+}
+
+// Returns a row whose `big` field is too large to be stored in a leaf node.
+std::string large_row(int id, int x, char big_char, size_t big_size) {
+    return strprintf("{\"id\" : %d, \"sid\" : %d, \"big\" : \"%s\", \"x\" : %d}",
+                     id, id * id, std::string(big_size, big_char).c_str(), x);
+}
+
+TPTEST(RDBBtree, LargeRowUpdate) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE);
+
+    sindex_name_t sindex_name = create_sindex(&store);
+    for (int i = 0; i < MAX_RETRIES_FOR_SINDEX_POSTCONSTRUCT; ++i) {
+        try {
+            read_row_via_sindex(&store, sindex_name, 0);
+            break;
+        } catch (const sindex_not_ready_exc_t &) { }
+        nap(500);
+    }
+
+    // Updates of large rows share the blocks that don't change with the old version
+    // of the row, which must stay readable through the secondary index.
+    const int num_rows = 10;
+    const size_t big_size = 100 * KILOBYTE;
+    for (int x = 0; x < 3; ++x) {
+        for (int i = 0; i < num_rows; ++i) {
+            write_row(&store, i, large_row(i, x, 'a', big_size), true);
+        }
+    }
+    write_row(&store, 0, large_row(0, 0, 'b', big_size), true);
+
+    ql::configured_limits_t limits;
+    for (int i = 0; i < num_rows; ++i) {
+        ql::grouped_t<ql::stream_t> groups =
+            read_row_via_sindex(&store, sindex_name, i * i);
+        ASSERT_EQ(1, groups.size());
+        ql::stream_t *stream = &groups.begin()->second;
+        ASSERT_EQ(1ul, stream->substreams.size());
+        ql::raw_stream_t *raw_stream = &stream->substreams.begin()->second.stream;
+        ASSERT_EQ(1ul, raw_stream->size());
+
+        rapidjson::Document expected;
+        expected.Parse(large_row(i, i == 0 ? 0 : 2, i == 0 ? 'b' : 'a',
+                                 big_size).c_str());
+        ASSERT_EQ(ql::to_datum(expected, limits, reql_version_t::LATEST),
+                  raw_stream->front().data);
+    }
+}
+
+#ifdef NDEBUG
+TPTEST(RDBBtree, LargeRowUpdateBenchmark) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE);
+
+    const size_t big_size = 4 * MEGABYTE;
+    write_row(&store, 0, large_row(0, 0, 'a', big_size), true,
+              write_durability_t::HARD);
+
+    // Hard durability makes every update get flushed on its own.
+    const int num_updates = 20;
+    for (bool small_edit : {true, false}) {
+        const double bytes_before = perfmon_get_stats().get_field("serializer")
+            .get_field("serializer_written_bytes_total").as_num();
+        for (int i = 1; i <= num_updates; ++i) {
+            std::string data = small_edit
+                ? large_row(0, i, 'a', big_size)
+                : large_row(0, 0, 'a' + i % 26, big_size);
+            write_row(&store, 0, data, true, write_durability_t::HARD);
+        }
+        const double bytes = perfmon_get_stats().get_field("serializer")
+            .get_field("serializer_written_bytes_total").as_num() - bytes_before;
+        printf("%s of a 4 MB row: %f bytes written per update\n",
+               small_edit ? "Small edit" : "Rewrite", bytes / num_updates);
+    }
+}
+#endif  // NDEBUG
+
+// Returns the result of a read with the `count` terminal.
+uint64_t get_count(rget_read_response_t *res) {
+    ql::grouped_t<uint64_t> *groups = boost::get<ql::grouped_t<uint64_t> >(&res->result);
+    guarantee(groups != nullptr);
+    return groups->size() == 0 ? 0 : groups->begin()->second;
+}
+
+// With an identity `map` in front of it, the `count` terminal has to look at every
+// row like any other terminal.
+std::vector<ql::transform_variant_t> count_transforms(bool slow) {
+    std::vector<ql::transform_variant_t> transforms;
+    if (slow) {
+        ql::sym_t one(1);
+        ql::minidriver_t r(ql::backtrace_id_t::empty());
+        transforms.push_back(
+            ql::map_wire_func_t(r.var(one).root_term(), make_vector(one)));
+    }
+    return transforms;
+}
+
+uint64_t count_rows(store_t *store, const key_range_t &range, bool slow = false) {
+    cond_t dummy_interruptor;
+    read_token_t token;
+    store->new_read_token(&token);
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    store->acquire_superblock_for_read(
+            &token, &txn, &superblock,
+            &dummy_interruptor, true);
+
+    ql::env_t dummy_env(&dummy_interruptor,
+                        ql::return_empty_normal_batches_t::NO,
+                        reql_version_t::LATEST);
+    rget_read_response_t res;
+    rdb_rget_slice(
+        store->btree.get(),
+        region_t(),
+        range,
+        boost::none,
+        superblock.get(),
+        &dummy_env,
+        ql::batchspec_t::default_for(ql::batch_type_t::NORMAL),
+        count_transforms(slow),
+        boost::optional<ql::terminal_variant_t>(ql::count_wire_func_t()),
+        sorting_t::UNORDERED,
+        &res,
+        release_superblock_t::RELEASE);
+    return get_count(&res);
+}
+
+uint64_t count_rows_via_sindex(store_t *store,
+                               const sindex_name_t &sindex_name,
+                               const ql::datum_range_t &datum_range,
+                               bool slow = false) {
+    rget_read_response_t res = rget_via_sindex(
+        store, sindex_name, datum_range, count_transforms(slow),
+        boost::optional<ql::terminal_variant_t>(ql::count_wire_func_t()));
+    return get_count(&res);
+}
+
+key_range_t primary_range(int left_id, int right_id) {
+    return key_range_t(
+        key_range_t::closed,
+        store_key_t(ql::datum_t(static_cast<double>(left_id)).print_primary()),
+        key_range_t::open,
+        store_key_t(ql::datum_t(static_cast<double>(right_id)).print_primary()));
+}
+
+ql::datum_range_t sid_range(int left, key_range_t::bound_t left_type,
+                            int right, key_range_t::bound_t right_type) {
+    return ql::datum_range_t(ql::datum_t(static_cast<double>(left)), left_type,
+                             ql::datum_t(static_cast<double>(right)), right_type);
+}
+
+TPTEST(RDBBtree, Count) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE);
+
+    sindex_name_t sindex_name = create_sindex(&store);
+    for (int i = 0; i < MAX_RETRIES_FOR_SINDEX_POSTCONSTRUCT; ++i) {
+        try {
+            read_row_via_sindex(&store, sindex_name, 0);
+            break;
+        } catch (const sindex_not_ready_exc_t &) { }
+        nap(500);
+    }
+
+    EXPECT_EQ(0u, count_rows(&store, key_range_t::universe()));
+    insert_rows(0, TOTAL_KEYS_TO_INSERT, &store);
+    // Overwriting rows doesn't change the count.
+    insert_rows(0, 10, &store);
+
+    // Ranges are counted a leaf node at a time.
+    EXPECT_EQ(static_cast<uint64_t>(TOTAL_KEYS_TO_INSERT),
+              count_rows(&store, key_range_t::universe()));
+    EXPECT_EQ(count_rows(&store, key_range_t::universe(), true),
+              count_rows(&store, key_range_t::universe()));
+    EXPECT_EQ(490u, count_rows(&store, primary_range(10, 500)));
+    EXPECT_EQ(count_rows(&store, primary_range(10, 500), true),
+              count_rows(&store, primary_range(10, 500)));
+    EXPECT_EQ(0u, count_rows(&store, primary_range(5000, 6000)));
+
+    // `sid` is `id * id`.
+    struct sindex_case_t {
+        ql::datum_range_t range;
+        uint64_t expected;
+    };
+    std::vector<sindex_case_t> cases{
+        {ql::datum_range_t::universe(), TOTAL_KEYS_TO_INSERT},
+        {sid_range(100, key_range_t::closed, 10000, key_range_t::open), 90},
+        {sid_range(100, key_range_t::open, 10000, key_range_t::closed), 90},
+        {sid_range(100, key_range_t::closed, 10000, key_range_t::closed), 91},
+        {sid_range(100, key_range_t::open, 10000, key_range_t::open), 89},
+        {sid_range(101, key_range_t::closed, 120, key_range_t::closed), 0}};
+    for (const auto &c : cases) {
+        EXPECT_EQ(c.expected, count_rows_via_sindex(&store, sindex_name, c.range))
+            << c.range.print();
+        EXPECT_EQ(count_rows_via_sindex(&store, sindex_name, c.range, true),
+                  count_rows_via_sindex(&store, sindex_name, c.range))
+            << c.range.print();
+    }
+}
+
+#ifdef NDEBUG
+TPTEST(RDBBtree, CountBenchmark) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE);
+
+    int num_rows = 0;
+    for (int table_size : {1000, 10000, 100000}) {
+        insert_rows(num_rows, table_size, &store);
+        num_rows = table_size;
+
+        ticks_t start_ticks = get_ticks();
+        EXPECT_EQ(static_cast<uint64_t>(table_size),
+                  count_rows(&store, key_range_t::universe()));
+        const double dur_keys = ticks_to_secs(get_ticks() - start_ticks);
+        start_ticks = get_ticks();
+        EXPECT_EQ(static_cast<uint64_t>(table_size),
+                  count_rows(&store, key_range_t::universe(), true));
+        const double dur_rows = ticks_to_secs(get_ticks() - start_ticks);
+        printf("%d rows: count from leaf keys %f ms, count row by row %f ms\n",
+               table_size, dur_keys * 1000, dur_rows * 1000);
+    }
+}
+#endif  // NDEBUG
+
+// Returns the estimated distribution of the primary B-tree.  If `max_depth` is at least
+// the depth of the B-tree, every key gets its own bucket and the sizes are exact.
+distribution_read_response_t get_distribution(store_t *store, int max_depth) {
+    cond_t dummy_interruptor;
+    read_token_t token;
+    store->new_read_token(&token);
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    store->acquire_superblock_for_read(
+            &token, &txn, &superblock,
+            &dummy_interruptor, true);
+
+    distribution_read_response_t res;
+    rdb_distribution_get(max_depth, store_key_t::min(), superblock.get(), &res);
+    return res;
+}
+
+int64_t distribution_total(const std::map<store_key_t, int64_t> &distribution) {
+    int64_t total = 0;
+    for (const auto &pair : distribution) {
+        total += pair.second;
+    }
+    return total;
+}
+
+// Splits the table into `num_shards` shards by `weights`, and returns the size of the
+// largest shard according to `exact_bytes`, relative to the size of an even split.
+double shard_size_imbalance(const std::map<store_key_t, int64_t> &exact_bytes,
+                            const std::map<store_key_t, int64_t> &weights,
+                            size_t num_shards) {
+    table_shard_scheme_t shard_scheme;
+    guarantee(calculate_split_points_with_distribution(
+        weights, num_shards, &shard_scheme));
+    std::vector<int64_t> shard_bytes(num_shards, 0);
+    for (const auto &pair : exact_bytes) {
+        shard_bytes[shard_scheme.find_shard_for_key(pair.first)] += pair.second;
+    }
+    return static_cast<double>(
+            *std::max_element(shard_bytes.begin(), shard_bytes.end()) * num_shards)
+        / distribution_total(exact_bytes);
+}
+
+// The last quarter of the rows is about twenty times as large as the others.
+void insert_skewed_rows(int start, int finish, int num_rows, store_t *store) {
+    for (int i = start; i < finish; ++i) {
+        write_row(store, i, large_row(i, 0, 'a', 4 * i < 3 * num_rows ? 10 : 1000),
+                  false);
+    }
+}
+
+TPTEST(RDBBtree, Distribution) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE);
+
+    const int num_rows = 2000;
+    insert_skewed_rows(0, num_rows, num_rows, &store);
+
+    distribution_read_response_t exact = get_distribution(&store, 100);
+    ASSERT_EQ(static_cast<size_t>(num_rows), exact.key_counts.size());
+    ASSERT_EQ(exact.key_counts.size(), exact.key_bytes.size());
+    EXPECT_EQ(num_rows, distribution_total(exact.key_counts));
+
+    // The counts add up to the population in the stat block, up to rounding.
+    distribution_read_response_t estimate = get_distribution(&store, 1);
+    ASSERT_LT(1u, estimate.key_counts.size());
+    EXPECT_NEAR(num_rows, distribution_total(estimate.key_counts),
+                estimate.key_counts.size());
+    const int64_t total_bytes = distribution_total(exact.key_bytes);
+    EXPECT_NEAR(total_bytes, distribution_total(estimate.key_bytes),
+                0.1 * total_bytes);
+
+    // Splitting by the number of documents puts all of the large rows into the last
+    // shard, while splitting by bytes keeps the shards about equally large.
+    const double imbalance_by_counts =
+        shard_size_imbalance(exact.key_bytes, estimate.key_counts, 4);
+    const double imbalance_by_bytes =
+        shard_size_imbalance(exact.key_bytes, estimate.key_bytes, 4);
+    EXPECT_GT(imbalance_by_counts, 2.0);
+    EXPECT_LT(imbalance_by_bytes, 1.5);
+}
+
+#ifdef NDEBUG
+TPTEST(RDBBtree, DistributionBenchmark) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE);
+
+    const int num_rows = 100000;
+    insert_skewed_rows(0, num_rows, num_rows, &store);
+
+    ticks_t start_ticks = get_ticks();
+    distribution_read_response_t exact = get_distribution(&store, 100);
+    const double dur_exact = ticks_to_secs(get_ticks() - start_ticks);
+    const int64_t total_bytes = distribution_total(exact.key_bytes);
+    for (int max_depth : {1, 2}) {
+        start_ticks = get_ticks();
+        distribution_read_response_t estimate = get_distribution(&store, max_depth);
+        const double dur_estimate = ticks_to_secs(get_ticks() - start_ticks);
+        const double bytes_error =
+            static_cast<double>(distribution_total(estimate.key_bytes) - total_bytes)
+            / total_bytes;
+        printf("Depth %d: %zu buckets in %f ms (every key: %f ms), "
+               "bytes off by %f%%, largest of 8 shards by counts %fx, "
+               "by bytes %fx of an even split\n",
+               max_depth, estimate.key_counts.size(), dur_estimate * 1000,
+               dur_exact * 1000, bytes_error * 100,
+               shard_size_imbalance(exact.key_bytes, estimate.key_counts, 8),
+               shard_size_imbalance(exact.key_bytes, estimate.key_bytes, 8));
+    }
+}
+#endif  // NDEBUG
+
+TPTEST(RDBBtree, ResetData) {
+    for (bool with_sindex : {true, false}) {
+        recreate_temporary_directory(base_path_t("."));
+        temp_file_t temp_file;
+
+        io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+        dummy_cache_balancer_t balancer(GIGABYTE);
+
+        filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+        log_serializer_t::create(
+            &file_opener,
+            log_serializer_t::static_config_t());
+
+        log_serializer_t serializer(
+            log_serializer_t::dynamic_config_t(),
+            &file_opener,
+            &get_global_perfmon_collection());
+
+        store_t store(
+                region_t::universe(),
+                &serializer,
+                &balancer,
+                "unit_test_store",
+                true,
+                &get_global_perfmon_collection(),
+                nullptr,
+                &io_backender,
+                base_path_t("."),
+                generate_uuid(),
+                update_sindexes_t::UPDATE);
+
+        sindex_name_t sindex_name;
+        if (with_sindex) {
+            sindex_name = create_sindex(&store);
+            for (int i = 0; i < MAX_RETRIES_FOR_SINDEX_POSTCONSTRUCT; ++i) {
+                try {
+                    read_row_via_sindex(&store, sindex_name, 0);
+                    break;
+                } catch (const sindex_not_ready_exc_t &) { }
+                nap(500);
+            }
+        }
+
+        // Enough rows for a few levels of internal nodes, some of them in blobs.
+        const int num_rows = 3000;
+        insert_rows(0, num_rows, &store);
+        for (int i = 0; i < num_rows; i += 100) {
+            write_row(&store, i, large_row(i, 0, 'a', 10 * KILOBYTE), true);
+        }
+
+        // Whole leaf nodes in the middle of the range are taken out of the B-tree,
+        // and the ones at its ends are erased key by key.
+        cond_t non_interruptor;
+        store.reset_data(binary_blob_t(version_t::zero()),
+                         region_t(primary_range(500, 2500)),
+                         write_durability_t::SOFT,
+                         &non_interruptor);
+        EXPECT_EQ(500u, count_rows(&store, primary_range(0, 500), true));
+        EXPECT_EQ(0u, count_rows(&store, primary_range(500, 2500), true));
+        EXPECT_EQ(500u, count_rows(&store, primary_range(2500, num_rows), true));
+        // Erased leaf nodes aren't counted anymore.
+        EXPECT_EQ(1000u, count_rows(&store, key_range_t::universe()));
+        if (with_sindex) {
+            // `sid` is `id * id`.
+            EXPECT_EQ(1000u, count_rows_via_sindex(
+                &store, sindex_name, ql::datum_range_t::universe(), true));
+            EXPECT_EQ(0u, count_rows_via_sindex(
+                &store, sindex_name,
+                sid_range(500 * 500, key_range_t::closed,
+                          2500 * 2500, key_range_t::open),
+                true));
+        }
+
+        store.reset_data(binary_blob_t(version_t::zero()),
+                         region_t::universe(),
+                         write_durability_t::SOFT,
+                         &non_interruptor);
+        EXPECT_EQ(0u, count_rows(&store, key_range_t::universe(), true));
+        EXPECT_EQ(0u, count_rows(&store, key_range_t::universe()));
+        if (with_sindex) {
+            EXPECT_EQ(0u, count_rows_via_sindex(
+                &store, sindex_name, ql::datum_range_t::universe(), true));
+        }
+    }
+}
+
+#ifdef NDEBUG
+// Erases `range` in passes of up to 100 keys, like `reset_data()` used to do.
+void erase_rows_key_by_key(store_t *store, const key_range_t &range) {
+    always_true_key_tester_t key_tester;
+    for (continue_bool_t done_erasing = continue_bool_t::CONTINUE;
+         done_erasing == continue_bool_t::CONTINUE;) {
+        cond_t non_interruptor;
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        write_token_t token;
+        store->new_write_token(&token);
+        store->acquire_superblock_for_write(
+            102, write_durability_t::SOFT, &token, &txn, &superblock,
+            &non_interruptor);
+        buf_lock_t sindex_block(superblock->expose_buf(),
+                                superblock->get_sindex_block_id(),
+                                access_t::write);
+        rdb_live_deletion_context_t deletion_context;
+        std::vector<rdb_modification_report_t> mod_reports;
+        key_range_t deleted_range;
+        done_erasing = rdb_erase_small_range(store->btree.get(),
+                                             &key_tester,
+                                             range,
+                                             superblock.get(),
+                                             &deletion_context,
+                                             &non_interruptor,
+                                             100,
+                                             &mod_reports,
+                                             &deleted_range);
+        superblock.reset();
+        if (!mod_reports.empty()) {
+            store->update_sindexes(txn.get(), &sindex_block, mod_reports, true);
+        }
+    }
+}
+
+// Writes rows outside of the erased range until `stop` is pulsed, and records how
+// long each write took.
+void time_foreground_writes(store_t *store, cond_t *stop, cond_t *done,
+                            std::vector<double> *latencies_out) {
+    for (int i = 0; !stop->is_pulsed(); ++i) {
+        const ticks_t start_ticks = get_ticks();
+        write_row(store, -1 - i % 1000, strprintf("{\"id\" : %d}", -1 - i % 1000),
+                  true);
+        latencies_out->push_back(ticks_to_secs(get_ticks() - start_ticks));
+        coro_t::yield();
+    }
+    done->pulse();
+}
+
+TPTEST(RDBBtree, ResetDataBenchmark) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE);
+
+    const int num_rows = 100000;
+    for (bool by_leaves : {false, true}) {
+        insert_rows(0, num_rows, &store);
+        cond_t stop_writes, writes_done;
+        std::vector<double> latencies;
+        coro_t::spawn_sometime(std::bind(&time_foreground_writes, &store,
+                                         &stop_writes, &writes_done, &latencies));
+        const ticks_t start_ticks = get_ticks();
+        if (by_leaves) {
+            cond_t non_interruptor;
+            store.reset_data(binary_blob_t(version_t::zero()),
+                             region_t(primary_range(0, num_rows)),
+                             write_durability_t::SOFT,
+                             &non_interruptor);
+        } else {
+            erase_rows_key_by_key(&store, primary_range(0, num_rows));
+        }
+        const double duration = ticks_to_secs(get_ticks() - start_ticks);
+        stop_writes.pulse();
+        writes_done.wait();
+        EXPECT_EQ(0u, count_rows(&store, primary_range(0, num_rows), true));
+
+        std::sort(latencies.begin(), latencies.end());
+        const double median = latencies.empty() ? 0 : latencies[latencies.size() / 2];
+        const double worst = latencies.empty() ? 0 : latencies.back();
+        printf("Erase %d rows %s: %f s, %zu foreground writes, "
+               "median latency %f ms, maximum latency %f ms\n",
+               num_rows, by_leaves ? "by leaf nodes" : "key by key", duration,
+               latencies.size(), median * 1000, worst * 1000);
+    }
+}
+#endif  // NDEBUG
+
 TPTEST(RDBBtree, SindexEraseRange) {
     recreate_temporary_directory(base_path_t("."));
     temp_file_t temp_file;
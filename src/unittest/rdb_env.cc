@@ -719,4 +719,16 @@ bool test_rdb_env_t::instance_t::sindex_list(
     return false;
 }
 
+bool test_rdb_env_t::instance_t::sindex_configs(
+        UNUSED counted_t<const ql::db_t> db,
+        UNUSED const name_string_t &table,
+        UNUSED signal_t *local_interruptor,
+        admin_err_t *error_out,
+        UNUSED std::map<std::string, sindex_config_t> *configs_out) {
+    *error_out = admin_err_t{
+        "test_rdb_env_t::instance_t doesn't support sindex_configs()",
+        query_state_t::FAILED};
+    return false;
+}
+
 }  // namespace unittest
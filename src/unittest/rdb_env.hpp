@@ -343,6 +343,12 @@ public:
                 admin_err_t *error_out,
                 std::map<std::string, std::pair<sindex_config_t, sindex_status_t> >
                     *configs_and_statuses_out);
+        bool sindex_configs(
+                counted_t<const ql::db_t> db,
+                const name_string_t &table,
+                signal_t *interruptor,
+                admin_err_t *error_out,
+                std::map<std::string, sindex_config_t> *configs_out);
 
     private:
         extproc_pool_t extproc_pool;
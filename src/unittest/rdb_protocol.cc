@@ -71,7 +71,8 @@ void run_with_namespace_interface(
             new log_serializer_t(log_serializer_t::dynamic_config_t(),
                                  &file_opener,
                                  &get_global_perfmon_collection()));
-        serializers[i].init(new merger_serializer_t(std::move(log_ser), 1));
+        serializers[i].init(new merger_serializer_t(
+            std::move(log_ser), 1, &get_global_perfmon_collection()));
     }
 
     extproc_pool_t extproc_pool(2);
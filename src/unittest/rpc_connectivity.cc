@@ -5,10 +5,12 @@
 
 #else
 
+#include <algorithm>
 #include <functional>
 
 #include "arch/runtime/thread_pool.hpp"
 #include "arch/timing.hpp"
+#include "concurrency/pmap.hpp"
 #include "containers/scoped.hpp"
 #include "containers/archive/socket_stream.hpp"
 #include "unittest/clustering_utils.hpp"
@@ -46,11 +48,8 @@ public:
         public:
             explicit writer_t(int _data) : data(_data) { }
             virtual ~writer_t() { }
-            void write(write_stream_t *stream) {
-                write_message_t wm;
-                serialize<cluster_version_t::CLUSTER>(&wm, data);
-                int res = send_write_message(stream, &wm);
-                if (res) { throw fake_archive_exc_t(); }
+            void write(write_message_t *wm) {
+                serialize<cluster_version_t::CLUSTER>(wm, data);
             }
 #ifdef ENABLE_MESSAGE_PROFILER
             const char *message_profiler_tag() const {
@@ -400,13 +399,12 @@ public:
             public cluster_send_message_write_callback_t {
         public:
             virtual ~dump_spectrum_writer_t() { }
-            void write(write_stream_t *stream) {
+            void write(write_message_t *wm) {
                 char spectrum[CHAR_MAX - CHAR_MIN + 1];
                 for (int i = CHAR_MIN; i <= CHAR_MAX; i++) {
                     spectrum[i - CHAR_MIN] = i;
                 }
-                int64_t res = stream->write(spectrum, CHAR_MAX - CHAR_MIN + 1);
-                if (res != CHAR_MAX - CHAR_MIN + 1) { throw fake_archive_exc_t(); }
+                wm->append(spectrum, CHAR_MAX - CHAR_MIN + 1);
             }
 #ifdef ENABLE_MESSAGE_PROFILER
             const char *message_profiler_tag() const {
@@ -452,6 +450,260 @@ TPTEST_MULTITHREAD(RPCConnectivityTest, BinaryData, 3) {
     EXPECT_TRUE(a2.got_spectrum);
 }
 
+/* `string_test_application_t` sends strings of any size and keeps track of the ones it
+has received, in order. */
+
+class string_test_application_t :
+    public home_thread_mixin_t,
+    public cluster_message_handler_t
+{
+public:
+    explicit string_test_application_t(connectivity_cluster_t *cm,
+                                       connectivity_cluster_t::message_tag_t _tag = 'S') :
+        cluster_message_handler_t(cm, _tag),
+        keep(true),
+        bytes_received(0),
+        bytes_waiting_for(0),
+        bytes_waiter(nullptr)
+        { }
+    void send(const std::string *data, peer_id_t peer,
+              message_lane_t lane = message_lane_t::CONTROL) {
+        class writer_t : public cluster_send_message_write_callback_t {
+        public:
+            explicit writer_t(const std::string *_data) : data(_data) { }
+            virtual ~writer_t() { }
+            void write(write_message_t *wm) {
+                serialize<cluster_version_t::CLUSTER>(wm, *data);
+            }
+#ifdef ENABLE_MESSAGE_PROFILER
+            const char *message_profiler_tag() const {
+                return "unittest";
+            }
+#endif
+            const std::string *data;
+        } writer(data);
+        auto_drainer_t::lock_t connection_keepalive;
+        connectivity_cluster_t::connection_t *connection =
+            get_connectivity_cluster()->get_connection(peer, &connection_keepalive);
+        ASSERT_TRUE(connection != nullptr);
+        get_connectivity_cluster()->send_message(connection, connection_keepalive,
+            get_message_tag(), &writer, lane);
+    }
+    void wait_for_bytes(int64_t bytes) {
+        assert_thread();
+        if (bytes_received < bytes) {
+            cond_t got_bytes;
+            bytes_waiting_for = bytes;
+            bytes_waiter = &got_bytes;
+            got_bytes.wait();
+        }
+    }
+
+    /* If `keep` is false, only the number of bytes received is kept track of. */
+    bool keep;
+    std::vector<std::string> received;
+    int64_t bytes_received;
+
+private:
+    void on_message(connectivity_cluster_t::connection_t *,
+                    auto_drainer_t::lock_t,
+                    read_stream_t *stream) {
+        std::string data;
+        archive_result_t res = deserialize<cluster_version_t::CLUSTER>(stream, &data);
+        if (bad(res)) { throw fake_archive_exc_t(); }
+        on_thread_t th(home_thread());
+        bytes_received += data.size();
+        if (keep) {
+            received.push_back(std::move(data));
+        }
+        if (bytes_waiter != nullptr && bytes_received >= bytes_waiting_for) {
+            bytes_waiter->pulse();
+            bytes_waiter = nullptr;
+        }
+    }
+
+    int64_t bytes_waiting_for;
+    cond_t *bytes_waiter;
+};
+
+/* `LargeMessage` sends messages that are larger than the connection's write buffer,
+which are sent without being copied into it, between small ones that are. */
+TPTEST_MULTITHREAD(RPCConnectivityTest, LargeMessage, 3) {
+    connectivity_cluster_t c1, c2;
+    string_test_application_t a1(&c1), a2(&c2);
+    test_cluster_run_t cr1(&c1);
+    test_cluster_run_t cr2(&c2);
+    cr1.join(get_cluster_local_address(&c2), 0);
+
+    let_stuff_happen();
+
+    std::vector<std::string> sent;
+    for (size_t size : {10, 1000000, 20, 100000, 8191, 8192, 30}) {
+        std::string data(size, '\0');
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<char>(i * 7 + size);
+        }
+        sent.push_back(std::move(data));
+    }
+    int64_t total_bytes = 0;
+    for (const std::string &data : sent) {
+        a1.send(&data, c2.get_me());
+        total_bytes += data.size();
+    }
+    a2.wait_for_bytes(total_bytes);
+
+    EXPECT_TRUE(sent == a2.received);
+}
+
+/* `Lanes` checks that a message in the control lane doesn't have to wait for the
+messages in the bulk lane that were waiting to be sent before it. */
+TPTEST_MULTITHREAD(RPCConnectivityTest, Lanes, 3) {
+    connectivity_cluster_t c1, c2;
+    string_test_application_t a1(&c1), a2(&c2);
+    test_cluster_run_t cr1(&c1);
+    test_cluster_run_t cr2(&c2);
+    cr1.join(get_cluster_local_address(&c2), 0);
+
+    let_stuff_happen();
+
+    const int num_bulk = 64;
+    const std::string bulk(MEGABYTE, 'b');
+    const std::string control("control");
+    cond_t bulk_sent;
+    coro_t::spawn_sometime([&]() {
+        pmap(num_bulk, [&](int) {
+            a1.send(&bulk, c2.get_me(), message_lane_t::BULK);
+        });
+        bulk_sent.pulse();
+    });
+    /* Give the bulk messages time to get in line for the connection. */
+    nap(1);
+    a1.send(&control, c2.get_me(), message_lane_t::CONTROL);
+    bulk_sent.wait();
+    a2.wait_for_bytes(num_bulk * bulk.size() + control.size());
+
+    auto it = std::find(a2.received.begin(), a2.received.end(), control);
+    ASSERT_TRUE(it != a2.received.end());
+    EXPECT_LT(it - a2.received.begin(), num_bulk / 2);
+}
+
+/* `LanesDontStarve` checks that a message in the bulk lane gets its turn while more
+and more messages in the control lane are waiting. */
+TPTEST_MULTITHREAD(RPCConnectivityTest, LanesDontStarve, 3) {
+    connectivity_cluster_t c1, c2;
+    string_test_application_t a1(&c1), a2(&c2);
+    test_cluster_run_t cr1(&c1);
+    test_cluster_run_t cr2(&c2);
+    cr1.join(get_cluster_local_address(&c2), 0);
+
+    let_stuff_happen();
+
+    const int num_control = 64;
+    const std::string control(MEGABYTE, 'c');
+    const std::string bulk("bulk");
+    cond_t control_sent;
+    coro_t::spawn_sometime([&]() {
+        pmap(num_control, [&](int) {
+            a1.send(&control, c2.get_me(), message_lane_t::CONTROL);
+        });
+        control_sent.pulse();
+    });
+    /* Give the control messages time to get in line for the connection. */
+    nap(1);
+    a1.send(&bulk, c2.get_me(), message_lane_t::BULK);
+    control_sent.wait();
+    a2.wait_for_bytes(num_control * control.size() + bulk.size());
+
+    auto it = std::find(a2.received.begin(), a2.received.end(), bulk);
+    ASSERT_TRUE(it != a2.received.end());
+    EXPECT_LT(it - a2.received.begin(), num_control / 2);
+}
+
+#ifdef NDEBUG
+TPTEST_MULTITHREAD(RPCConnectivityTest, SendThroughputBenchmark, 3) {
+    connectivity_cluster_t c1, c2;
+    string_test_application_t a1(&c1), a2(&c2);
+    test_cluster_run_t cr1(&c1);
+    test_cluster_run_t cr2(&c2);
+    cr1.join(get_cluster_local_address(&c2), 0);
+
+    let_stuff_happen();
+
+    a2.keep = false;
+    const int64_t bytes_per_size = 256 * MEGABYTE;
+    const int num_senders = 16;
+    for (size_t size : std::vector<size_t>{100, 10 * KILOBYTE, MEGABYTE}) {
+        const std::string data(size, 'a');
+        const int64_t num_messages = bytes_per_size / size;
+        const int64_t bytes_before = a2.bytes_received;
+        const ticks_t start_ticks = get_ticks();
+        pmap(num_senders, [&](int sender) {
+            for (int64_t i = sender; i < num_messages; i += num_senders) {
+                a1.send(&data, c2.get_me());
+            }
+        });
+        a2.wait_for_bytes(bytes_before + num_messages * size);
+        const double duration = ticks_to_secs(get_ticks() - start_ticks);
+        printf("%zu byte messages: %f messages/s, %f MB/s\n",
+               size, num_messages / duration,
+               num_messages * size / duration / MEGABYTE);
+    }
+}
+
+/* Measures how long small messages take to arrive while a backfill-like stream of
+large messages is sent over the same connection, first with the small messages in the
+same lane as the large ones, and then with them in the replication lane. */
+TPTEST_MULTITHREAD(RPCConnectivityTest, LaneLatencyBenchmark, 3) {
+    connectivity_cluster_t c1, c2;
+    string_test_application_t bulk1(&c1, 'S'), bulk2(&c2, 'S');
+    string_test_application_t small1(&c1, 'R'), small2(&c2, 'R');
+    test_cluster_run_t cr1(&c1);
+    test_cluster_run_t cr2(&c2);
+    cr1.join(get_cluster_local_address(&c2), 0);
+
+    let_stuff_happen();
+
+    bulk2.keep = false;
+    small2.keep = false;
+    const std::string bulk(MEGABYTE, 'b');
+    const std::string small(100, 's');
+    const int num_bulk_senders = 16;
+    const int num_small = 200;
+    for (message_lane_t lane : std::vector<message_lane_t>{
+             message_lane_t::BULK, message_lane_t::REPLICATION}) {
+        bool stop = false;
+        cond_t bulk_stopped;
+        coro_t::spawn_sometime([&]() {
+            pmap(num_bulk_senders, [&](int) {
+                while (!stop) {
+                    bulk1.send(&bulk, c2.get_me(), message_lane_t::BULK);
+                }
+            });
+            bulk_stopped.pulse();
+        });
+        nap(100);
+
+        std::vector<double> latencies;
+        for (int i = 0; i < num_small; ++i) {
+            const int64_t bytes_before = small2.bytes_received;
+            const ticks_t start_ticks = get_ticks();
+            small1.send(&small, c2.get_me(), lane);
+            small2.wait_for_bytes(bytes_before + small.size());
+            latencies.push_back(ticks_to_secs(get_ticks() - start_ticks) * 1000);
+        }
+        stop = true;
+        bulk_stopped.wait();
+
+        std::sort(latencies.begin(), latencies.end());
+        printf("%s lane under bulk load: median %f ms, p99 %f ms, max %f ms\n",
+               lane == message_lane_t::BULK ? "bulk" : "replication",
+               latencies[latencies.size() / 2],
+               latencies[latencies.size() * 99 / 100],
+               latencies.back());
+    }
+}
+#endif  // NDEBUG
+
 /* `PeerIDSemantics` makes sure that `peer_id_t::is_nil()` works as expected. */
 TPTEST_MULTITHREAD(RPCConnectivityTest, PeerIDSemantics, 3) {
     peer_id_t nil_peer;
@@ -1,8 +1,12 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "unittest/gtest.hpp"
 
+#include <algorithm>
+
 #include "arch/timing.hpp"
 #include "clustering/administration/metadata.hpp"
+#include "concurrency/fifo_enforcer.hpp"
+#include "concurrency/pmap.hpp"
 #include "unittest/clustering_utils.hpp"
 #include "unittest/dummy_metadata_controller.hpp"
 #include "unittest/unittest_utils.hpp"
@@ -177,4 +181,135 @@ TPTEST_MULTITHREAD(RPCMailboxTest, TypedMailbox, 3) {
     }
 }
 
+/* `FifoTokensAcrossLanes` checks that messages that carry order tokens from the same
+`fifo_enforcer_source_t` are processed in the order they were sent, even though a
+message in the control lane overtakes the ones in the bulk lane on the wire. The
+backfiller and backfillee rely on this. */
+TPTEST_MULTITHREAD(RPCMailboxTest, FifoTokensAcrossLanes, 3) {
+    connectivity_cluster_t c1, c2;
+    mailbox_manager_t m1(&c1, 'M'), m2(&c2, 'M');
+    test_cluster_run_t r1(&c1);
+    test_cluster_run_t r2(&c2);
+    r1.join(get_cluster_local_address(&c2), 0);
+    let_stuff_happen();
+
+    const int num_bulk = 32;
+    fifo_enforcer_source_t fifo_source;
+    fifo_enforcer_sink_t fifo_sink;
+    std::vector<int> arrived, processed;
+    cond_t all_processed;
+    mailbox_t<void(fifo_enforcer_write_token_t, int, std::string)> mbox(&m2,
+        [&](signal_t *interruptor, const fifo_enforcer_write_token_t &token, int i,
+                const std::string &) {
+            arrived.push_back(i);
+            fifo_enforcer_sink_t::exit_write_t exit_write(&fifo_sink, token);
+            wait_interruptible(&exit_write, interruptor);
+            processed.push_back(i);
+            if (processed.size() == static_cast<size_t>(num_bulk) + 1) {
+                all_processed.pulse();
+            }
+        });
+
+    const std::string bulk(MEGABYTE, 'b');
+    coro_t::spawn_sometime([&]() {
+        pmap(num_bulk, [&](int i) {
+            /* Taking the token and getting in line for the connection happen without
+            blocking, so the bulk messages are sent in the order of their tokens. */
+            send(&m1, message_lane_t::BULK, mbox.get_address(),
+                fifo_source.enter_write(), i, bulk);
+        });
+    });
+    /* Give the bulk messages time to get in line for the connection. */
+    nap(1);
+    send(&m1, message_lane_t::CONTROL, mbox.get_address(), fifo_source.enter_write(),
+        static_cast<int>(num_bulk), std::string("control"));
+    all_processed.wait();
+
+    std::vector<int> expected;
+    for (int i = 0; i <= num_bulk; ++i) {
+        expected.push_back(i);
+    }
+    EXPECT_EQ(expected, processed);
+    auto it = std::find(arrived.begin(), arrived.end(), num_bulk);
+    ASSERT_TRUE(it != arrived.end());
+    EXPECT_LT(it - arrived.begin(), num_bulk);
+}
+
+namespace {
+
+/* `serialization_counter_t` counts how often it gets serialized. */
+struct serialization_counter_t {
+    serialization_counter_t() : value(0) { }
+    explicit serialization_counter_t(int32_t _value) : value(_value) { }
+    int32_t value;
+    static int num_serialized;
+};
+
+int serialization_counter_t::num_serialized = 0;
+
+template <cluster_version_t W>
+void serialize(write_message_t *wm, const serialization_counter_t &counter) {
+    ++serialization_counter_t::num_serialized;
+    serialize<W>(wm, counter.value);
+}
+
+template <cluster_version_t W>
+MUST_USE archive_result_t deserialize(read_stream_t *s,
+                                      serialization_counter_t *counter) {
+    return deserialize<W>(s, &counter->value);
+}
+
+}   /* anonymous namespace */
+
+/* `LocalMailbox` checks that messages to a mailbox on the same thread are delivered
+without serializing them, and that messages to another thread still are. */
+TPTEST_MULTITHREAD(RPCMailboxTest, LocalMailbox, 3) {
+    connectivity_cluster_t c;
+    mailbox_manager_t m(&c, 'M');
+    test_cluster_run_t r(&c);
+    serialization_counter_t::num_serialized = 0;
+
+    std::vector<int32_t> inbox;
+    mailbox_t<void(serialization_counter_t)> mbox(&m,
+        [&](signal_t *, const serialization_counter_t &counter) {
+            inbox.push_back(counter.value);
+        });
+    send(&m, mbox.get_address(), serialization_counter_t(1));
+    send(&m, mbox.get_address(), serialization_counter_t(2));
+
+    /* A message to a mailbox that goes away before it's delivered is dropped. */
+    {
+        mailbox_t<void(serialization_counter_t)> short_lived_mbox(&m,
+            [&](signal_t *, const serialization_counter_t &) {
+                ADD_FAILURE() << "The mailbox should be gone by now.";
+            });
+        send(&m, short_lived_mbox.get_address(), serialization_counter_t(3));
+    }
+
+    let_stuff_happen();
+
+    EXPECT_EQ(std::vector<int32_t>({1, 2}), inbox);
+    EXPECT_EQ(0, serialization_counter_t::num_serialized);
+
+    std::vector<int32_t> other_inbox;
+    scoped_ptr_t<mailbox_t<void(serialization_counter_t)> > other_mbox;
+    {
+        on_thread_t thread_switcher((threadnum_t(1)));
+        other_mbox.init(new mailbox_t<void(serialization_counter_t)>(&m,
+            [&](signal_t *, const serialization_counter_t &counter) {
+                other_inbox.push_back(counter.value);
+            }));
+    }
+    send(&m, other_mbox->get_address(), serialization_counter_t(4));
+
+    let_stuff_happen();
+
+    EXPECT_EQ(1, serialization_counter_t::num_serialized);
+    {
+        on_thread_t thread_switcher((threadnum_t(1)));
+        EXPECT_EQ(std::vector<int32_t>({4}), other_inbox);
+        other_mbox.reset();
+    }
+}
+
 }   /* namespace unittest */
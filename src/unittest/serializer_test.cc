@@ -1,9 +1,14 @@
 #include <functional>
 
+#include "arch/io/disk.hpp"
 #include "arch/runtime/starter.hpp"
+#include "arch/timing.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "concurrency/pmap.hpp"
+#include "config/args.hpp"
 #include "serializer/buf_ptr.hpp"
 #include "serializer/log/log_serializer.hpp"
+#include "serializer/merger.hpp"
 #include "unittest/mock_file.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
@@ -90,5 +95,81 @@ TEST(SerializerTest, AddDeleteRepeatedlyWithIndex) {
     run_in_thread_pool(std::bind(run_AddDeleteRepeatedly, true), 4);
 }
 
+// Runs `num_writers` coroutines that each write `writes_per_writer` blocks, with one
+// index write per block, like concurrent transactions with hard durability do.
+void run_concurrent_index_writes(serializer_t *ser,
+                                 int num_writers,
+                                 int writes_per_writer) {
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser->max_block_size());
+    scoped_ptr_t<file_account_t> account(ser->make_io_account(1));
+
+    pmap(num_writers, [&](int writer) {
+        for (int i = 0; i < writes_per_writer; ++i) {
+            const block_id_t block_id = writer * writes_per_writer + i;
+            std::vector<buf_write_info_t> infos;
+            infos.push_back(
+                buf_write_info_t(buf.ser_buffer(), buf.block_size(), block_id));
+
+            struct : public iocallback_t, public cond_t {
+                void on_io_complete() {
+                    pulse();
+                }
+            } cb;
+            std::vector<counted_t<standard_block_token_t> > tokens
+                = ser->block_writes(infos, account.get(), &cb);
+            cb.wait();
+
+            std::vector<index_write_op_t> write_ops;
+            write_ops.push_back(index_write_op_t(block_id, tokens[0],
+                                                 repli_timestamp_t::distant_past));
+            // Ordering between the writers doesn't matter here.
+            new_mutex_in_line_t dummy_acq;
+            ser->index_write(&dummy_acq, []{ }, write_ops);
+        }
+    });
+}
+
+TPTEST(SerializerTest, MergedConcurrentIndexWrites, 4) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    merger_serializer_t ser(
+        make_scoped<log_serializer_t>(log_serializer_t::dynamic_config_t(),
+                                      &file_opener,
+                                      &get_global_perfmon_collection()),
+        MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+        &get_global_perfmon_collection());
+
+    const int num_writers = 16;
+    const int writes_per_writer = 20;
+    run_concurrent_index_writes(&ser, num_writers, writes_per_writer);
+
+    for (block_id_t id = 0; id < num_writers * writes_per_writer; ++id) {
+        EXPECT_TRUE(ser.index_read(id).has()) << id;
+    }
+}
+
+#ifdef NDEBUG
+TPTEST(SerializerTest, MergedIndexWritesBenchmark) {
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    const int total_writes = 2048;
+    for (int num_writers : {1, 16, 256}) {
+        temp_file_t temp_file;
+        filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+        log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+        merger_serializer_t ser(
+            make_scoped<log_serializer_t>(log_serializer_t::dynamic_config_t(),
+                                          &file_opener,
+                                          &get_global_perfmon_collection()),
+            MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+            &get_global_perfmon_collection());
+
+        ticks_t start_ticks = get_ticks();
+        run_concurrent_index_writes(&ser, num_writers, total_writes / num_writers);
+        double dur = ticks_to_secs(get_ticks() - start_ticks);
+        printf("%d concurrent writers: %f index writes per second\n",
+               num_writers, total_writes / dur);
+    }
+}
+#endif  // NDEBUG
 
 }  // namespace unittest
@@ -0,0 +1,168 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "concurrency/cond_var.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/val.hpp"
+#include "rdb_protocol/vectorized_func.hpp"
+#include "rdb_protocol/wire_func.hpp"
+#include "time.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+counted_t<const ql::func_t> make_vectorizable_func(ql::minidriver_t::reql_t body) {
+    ql::sym_t one(1);
+    return ql::wire_func_t(body.root_term(), make_vector(one)).compile_wire_func();
+}
+
+// Row `i` has `{id: i, age: i % 100}`, except that every seventh row has no `age`,
+// and every eleventh row is a number instead of an object.
+std::vector<ql::datum_t> make_vectorized_rows(size_t n) {
+    std::vector<ql::datum_t> rows;
+    for (size_t i = 0; i < n; ++i) {
+        if (i % 11 == 10) {
+            rows.push_back(ql::datum_t(static_cast<double>(i)));
+            continue;
+        }
+        ql::datum_object_builder_t row;
+        row.overwrite("id", ql::datum_t(static_cast<double>(i)));
+        if (i % 7 != 6) {
+            row.overwrite("age", ql::datum_t(static_cast<double>(i % 100)));
+        }
+        rows.push_back(std::move(row).to_datum());
+    }
+    return rows;
+}
+
+std::vector<ql::datum_t> filter_per_row(ql::env_t *env,
+                                        const counted_t<const ql::func_t> &f,
+                                        const std::vector<ql::datum_t> &rows) {
+    std::vector<ql::datum_t> res;
+    for (const auto &row : rows) {
+        if (f->filter_call(env, row, counted_t<const ql::func_t>())) {
+            res.push_back(row);
+        }
+    }
+    return res;
+}
+
+std::vector<ql::datum_t> filter_vectorized(ql::env_t *env,
+                                           const counted_t<const ql::func_t> &f,
+                                           std::vector<ql::datum_t> rows) {
+    scoped_ptr_t<ql::vectorized_func_t> vf = ql::vectorized_func_t::make(f);
+    guarantee(vf.has());
+    vf->filter(env, &rows, [&](const ql::datum_t &row) {
+        return f->filter_call(env, row, counted_t<const ql::func_t>());
+    });
+    return rows;
+}
+
+TPTEST(VectorizedFunc, FilterMatchesPerRow) {
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    ql::sym_t one(1);
+    std::vector<ql::datum_t> rows = make_vectorized_rows(500);
+
+    std::vector<ql::minidriver_t::reql_t> predicates{
+        r.var(one)["age"] == 42.0,
+        (r.var(one)["age"] >= 10.0) && (r.var(one)["age"] < 20.0),
+        (r.var(one)["id"] > 100.0) && (r.var(one)["age"] <= 50.0),
+        r.expr(50.0) < r.var(one)["age"],
+        r.var(one)["age"]};
+    for (const auto &predicate : predicates) {
+        counted_t<const ql::func_t> f = make_vectorizable_func(predicate);
+        std::vector<ql::datum_t> expected = filter_per_row(&env, f, rows);
+        EXPECT_EQ(expected, filter_vectorized(&env, f, rows)) << f->print_source();
+    }
+}
+
+TPTEST(VectorizedFunc, MapMatchesPerRow) {
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    ql::sym_t one(1);
+
+    // Leave out the rows without `age`, which make `map` fail.
+    std::vector<ql::datum_t> rows;
+    for (const auto &row : make_vectorized_rows(100)) {
+        if (row.get_type() == ql::datum_t::R_OBJECT
+            && row.get_field("age", ql::NOTHROW).has()) {
+            rows.push_back(row);
+        }
+    }
+
+    std::vector<ql::minidriver_t::reql_t> bodies{
+        r.var(one)["age"],
+        r.var(one)["age"] > 30.0};
+    for (const auto &body : bodies) {
+        counted_t<const ql::func_t> f = make_vectorizable_func(body);
+        scoped_ptr_t<ql::vectorized_func_t> vf = ql::vectorized_func_t::make(f);
+        ASSERT_TRUE(vf.has());
+        std::vector<ql::datum_t> expected;
+        for (const auto &row : rows) {
+            expected.push_back(f->call(&env, row)->as_datum());
+        }
+        std::vector<ql::datum_t> actual = rows;
+        vf->map(&env, &actual, [&](const ql::datum_t &row) {
+            return f->call(&env, row)->as_datum();
+        });
+        EXPECT_EQ(expected, actual) << f->print_source();
+    }
+}
+
+TEST(VectorizedFunc, OtherShapes) {
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    ql::sym_t one(1);
+    EXPECT_FALSE(ql::vectorized_func_t::make(make_vectorizable_func(
+        r.var(one)["a"] + 1.0)).has());
+    EXPECT_FALSE(ql::vectorized_func_t::make(make_vectorizable_func(
+        r.var(one)["a"] == r.var(one)["b"])).has());
+    EXPECT_FALSE(ql::vectorized_func_t::make(make_vectorizable_func(
+        (r.var(one)["a"] == 1.0) && (r.var(one)["b"] + 1.0))).has());
+}
+
+#ifdef NDEBUG
+TPTEST(VectorizedFunc, FilterBenchmark) {
+    const size_t NUM_ROWS = 100000;
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    ql::sym_t one(1);
+    std::vector<ql::datum_t> rows = make_vectorized_rows(NUM_ROWS);
+
+    std::vector<std::pair<const char *, ql::minidriver_t::reql_t> > predicates{
+        std::make_pair("selective", r.var(one)["age"] == 42.0),
+        std::make_pair("non-selective",
+                       (r.var(one)["age"] >= 5.0) && (r.var(one)["age"] < 95.0))};
+    for (const auto &pair : predicates) {
+        counted_t<const ql::func_t> f = make_vectorizable_func(pair.second);
+
+        ticks_t start_ticks = get_ticks();
+        size_t per_row = filter_per_row(&env, f, rows).size();
+        double dur_per_row = ticks_to_secs(get_ticks() - start_ticks);
+
+        start_ticks = get_ticks();
+        size_t vectorized = filter_vectorized(&env, f, rows).size();
+        double dur_vectorized = ticks_to_secs(get_ticks() - start_ticks);
+
+        EXPECT_EQ(per_row, vectorized);
+        printf("%s filter (%zu of %zu rows): %f us per row one at a time, "
+               "%f us vectorized\n",
+               pair.first, vectorized, NUM_ROWS,
+               dur_per_row / NUM_ROWS * 1000000,
+               dur_vectorized / NUM_ROWS * 1000000);
+    }
+}
+#endif  // NDEBUG
+
+}  // namespace unittest